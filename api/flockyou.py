@@ -2,7 +2,7 @@ from flask import Flask, render_template, request, jsonify, send_file
 import json
 import csv
 import os
-from datetime import datetime
+from datetime import datetime, timezone
 import time
 from flask_socketio import SocketIO, emit, join_room, leave_room
 import threading
@@ -39,6 +39,10 @@ connection_lock = threading.Lock()
 serial_queue = queue.Queue()
 next_detection_id = 1  # Unique ID counter
 settings = {'gps_port': '', 'flock_port': '', 'filter': 'all'}
+console_lock = threading.Lock()  # Device parameter console ('@' lines)
+console_pending = {}  # Request id -> {'lines': [...], 'done': Event}
+console_next_id = 1
+CONSOLE_TIMEOUT = 3  # Seconds to wait for a console reply
 
 # Data storage paths
 DATA_DIR = Path('data')
@@ -230,6 +234,14 @@ def gps_reader():
                             # Keep only recent GPS readings
                             if len(gps_history) > MAX_GPS_HISTORY:
                                 gps_history.pop(0)
+                            
+                            # Relay the fix so the device can pre-alert on known camera sites
+                            if flock_serial_connection and flock_serial_connection.is_open:
+                                try:
+                                    flock_serial_connection.write(
+                                        f"POS {parsed['latitude']:.7f} {parsed['longitude']:.7f}\n".encode())
+                                except Exception as e:
+                                    print(f"Position relay error: {e}")
                         
                         safe_socket_emit('gps_update', parsed)
                         
@@ -266,6 +278,11 @@ def flock_reader():
                             safe_socket_emit('serial_data', line, room='serial_terminal')
                             print(f"Serial data sent to terminal: {line}")
                             
+                            # Parameter console reply, not a record
+                            if line.startswith('@'):
+                                handle_console_reply(line)
+                                continue
+                            
                             # Try to parse as detection data
                             try:
                                 data = json.loads(line)
@@ -288,6 +305,50 @@ def flock_reader():
                     break
             time.sleep(0.1)
 
+def handle_console_reply(line):
+    """Hand an '@<id> <tag> ...' reply line to the request waiting for it"""
+    head, _, rest = line[1:].partition(' ')
+    if not head.isdigit():
+        return  # Reply to a command typed without an id
+    with console_lock:
+        pending = console_pending.get(int(head))
+    if pending is None:
+        return
+    tag, _, items = rest.partition(' ')
+    pending['lines'].append((tag, items))
+    if tag in ('ok', 'err'):
+        pending['done'].set()
+
+def parse_console_items(items):
+    """'a=1 b=on' -> {'a': 1, 'b': 'on'}"""
+    result = {}
+    for item in items.split():
+        key, sep, value = item.partition('=')
+        if sep:
+            result[key] = int(value) if value.isdigit() else value
+    return result
+
+def send_console_command(command):
+    """Send a parameter console command to the device and wait for its reply.
+    Returns (ok, lines) with lines the (tag, items) pairs received; the last
+    one is the 'ok' or 'err' line."""
+    global console_next_id
+    if not (flock_serial_connection and flock_serial_connection.is_open):
+        return False, [('err', 'device not connected')]
+    with console_lock:
+        request_id = console_next_id
+        console_next_id += 1
+        pending = {'lines': [], 'done': threading.Event()}
+        console_pending[request_id] = pending
+    try:
+        flock_serial_connection.write(f"@{request_id} {command}\n".encode())
+        if not pending['done'].wait(CONSOLE_TIMEOUT):
+            return False, pending['lines'] + [('err', 'timeout (firmware without the @ console?)')]
+        return pending['lines'][-1][0] == 'ok', pending['lines']
+    finally:
+        with console_lock:
+            console_pending.pop(request_id, None)
+
 def find_best_gps_match(detection_timestamp):
     """Find the GPS reading closest in time to the detection timestamp"""
     global gps_history
@@ -356,9 +417,28 @@ def add_detection_from_serial(data):
     system_time = time.time()
     data['server_timestamp'] = datetime.fromtimestamp(system_time).isoformat()
     
-    # Try to find the best GPS match for this detection's timestamp
-    best_gps = find_best_gps_match(system_time)
+    # A position the device recorded itself (its own GPS or a relayed fix)
+    # beats matching on arrival time
+    geotag = data.get('geotag')
     preferred_timestamp = None
+    if geotag and geotag.get('lat') is not None and geotag.get('lon') is not None:
+        utc = geotag.get('utc')
+        data['gps'] = {
+            'latitude': geotag['lat'],
+            'longitude': geotag['lon'],
+            'altitude': None,
+            'timestamp': datetime.fromtimestamp(utc, timezone.utc).isoformat() if utc else None,
+            'satellites': None,
+            'fix_quality': 1,
+            'time_diff': 0,
+            'match_quality': 'device'
+        }
+        if utc:
+            preferred_timestamp = data['gps']['timestamp']
+        print(f"✓ Device geotag for MAC {data.get('mac_address', 'unknown')}")
+    
+    # Try to find the best GPS match for this detection's timestamp
+    best_gps = None if data.get('gps') else find_best_gps_match(system_time)
     
     if best_gps:
         # Validate GPS data before using it
@@ -386,7 +466,7 @@ def add_detection_from_serial(data):
             best_gps = None
     
     # Fallback to current GPS if no good temporal match
-    if not best_gps and gps_data and gps_data.get('fix_quality') > 0:
+    if not best_gps and not data.get('gps') and gps_data and gps_data.get('fix_quality') > 0:
         is_valid, validation_msg = validate_gps_data(gps_data)
         if is_valid:
             data['gps'] = {
@@ -756,6 +836,43 @@ def disconnect_flock():
     
     return jsonify({'status': 'success', 'message': 'Flock You device disconnected'})
 
+@app.route('/api/params', methods=['GET'])
+def get_params():
+    """List the device's runtime parameters"""
+    ok, lines = send_console_command('list')
+    if not ok:
+        return jsonify({'status': 'error', 'message': lines[-1][1]}), 400
+    params = [parse_console_items(items) for tag, items in lines if tag == 'param']
+    for param in params:
+        param['flags'] = param['flags'].split(',') if 'flags' in param else []
+    return jsonify({'params': params, **parse_console_items(lines[-1][1])})
+
+@app.route('/api/params', methods=['POST'])
+def update_params():
+    """Change device parameters: {"defaults": bool, "set": {name: value}, "save": bool}.
+    All values in "set" are applied together or not at all."""
+    data = request.json or {}
+    commands = []
+    if data.get('defaults'):
+        commands.append('defaults')
+    assigns = data.get('set', {})
+    if assigns:
+        values = {k: ('on' if v else 'off') if isinstance(v, bool) else v for k, v in assigns.items()}
+        commands.append('set ' + ' '.join(f"{k}={v}" for k, v in values.items()))
+    if data.get('save'):
+        commands.append('save')
+    if not commands:
+        return jsonify({'status': 'error', 'message': 'nothing to do'}), 400
+
+    applied = {}
+    for command in commands:
+        ok, lines = send_console_command(command)
+        if not ok:
+            return jsonify({'status': 'error', 'command': command.split()[0], 'message': lines[-1][1],
+                            'applied': applied}), 400
+        applied.update(parse_console_items(lines[-1][1]))
+    return jsonify({'status': 'success', 'applied': applied})
+
 @app.route('/api/status', methods=['GET'])
 def get_status():
     """Get connection status of both devices"""
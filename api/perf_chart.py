@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+Performance registry charts.
+
+Polls a Flock You board with the serial "PERF" command (or reads a capture
+of its serial output) and charts the "perf" records it answers with:
+latency percentiles per histogram over time, counter rates, per-task CPU
+share and stack headroom, and the latest bucket distribution.
+
+By default every poll is followed by "PERF RESET", so each record covers
+one interval and the percentiles are per interval; --cumulative keeps the
+firmware's window running since boot instead. The board's port can only be
+open in one program, so stop api/flockyou.py first.
+
+    --port DEV   poll a board (e.g. /dev/ttyUSB0) every --interval seconds
+                 for --duration seconds; --save FILE keeps the records
+    --log FILE   chart perf records from a capture or a --save file
+    -o FILE      write the chart (PNG/SVG/PDF, needs matplotlib); without
+                 it a text summary of the last record is printed
+
+Usage:
+    python3 api/perf_chart.py --port /dev/ttyUSB0 --duration 300 -o perf.png
+    python3 api/perf_chart.py --port /dev/ttyUSB0 --duration 60 --save perf.jsonl
+    python3 api/perf_chart.py --log perf.jsonl -o perf.png
+"""
+
+import argparse
+import json
+import sys
+import time
+
+
+def parse_records(lines):
+    """Perf records among serial output lines (other lines are skipped)"""
+    records = []
+    for line in lines:
+        line = line.strip()
+        if not line.startswith('{') or '"perf"' not in line:
+            continue
+        try:
+            rec = json.loads(line)
+        except json.JSONDecodeError:
+            continue  # Cut short by a reset or interleaved output
+        if rec.get('type') == 'perf':
+            records.append(rec)
+    return records
+
+
+def poll_board(port, baud, interval, duration, cumulative):
+    import serial  # pyserial, see requirements.txt
+
+    records = []
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        if not cumulative:
+            ser.write(b'PERF RESET\n')
+        deadline = time.time() + duration
+        next_poll = time.time() + interval
+        buf = b''
+        while time.time() < deadline or buf:
+            if time.time() >= next_poll:
+                ser.write(b'PERF\n' if cumulative else b'PERF\nPERF RESET\n')
+                next_poll += interval
+            chunk = ser.read(4096)
+            if not chunk and time.time() >= deadline:
+                break
+            buf += chunk
+            *lines, buf = buf.split(b'\n')
+            for rec in parse_records(l.decode('utf-8', errors='ignore') for l in lines):
+                records.append(rec)
+                print(f"[{len(records)}] t={rec['timestamp'] / 1000:.0f}s window={rec['window_ms']}ms", file=sys.stderr)
+    return records
+
+
+def summary(rec):
+    print(f"t={rec['timestamp'] / 1000:.1f}s window={rec['window_ms']} ms cpu={rec.get('cpu_mhz')} MHz")
+    print(f"{'histogram':<18} {'unit':>4} {'count':>8} {'mean':>8} {'p50':>8} {'p90':>8} {'p99':>8} {'max':>8}")
+    for name, h in rec.get('histograms', {}).items():
+        print(f"{name:<18} {h['unit']:>4} {h['count']:>8} {h['mean']:>8} {h['p50']:>8} {h['p90']:>8} "
+              f"{h['p99']:>8} {h['max']:>8}")
+    for name, g in rec.get('gauges', {}).items():
+        print(f"gauge {name}: {g['value']} (max {g['max']}) {g['unit']}")
+    print('counters: ' + ', '.join(f"{k}={v}" for k, v in rec.get('counters', {}).items()))
+    busy = rec.get('busy_pct', {})
+    if busy:
+        print('busy: ' + ', '.join(f"{k} {v}%" for k, v in busy.items()))
+    for t in rec.get('tasks', []):
+        cpu = f" cpu {t['cpu_pct']}%" if 'cpu_pct' in t else ''
+        core = f" core {t['core']}" if 'core' in t else ''
+        print(f"task {t['name']:<16} stack_free {t['stack_free']:>6}{core}{cpu}")
+    heap = rec.get('heap', {})
+    if heap:
+        print(f"heap free {heap['free']} min {heap['min_free']} largest {heap['largest']}")
+
+
+def chart(records, out):
+    try:
+        import matplotlib
+        matplotlib.use('Agg')
+        import matplotlib.pyplot as plt
+    except ImportError:
+        sys.exit('matplotlib is needed for charts: pip install matplotlib')
+
+    last = records[-1]
+    hist_names = list(last.get('histograms', {}))
+    t = [(r['timestamp'] - records[0]['timestamp']) / 1000 for r in records]
+
+    rows = len(hist_names) + 2
+    fig, axes = plt.subplots(rows, 2, figsize=(13, 2.6 * rows), squeeze=False)
+
+    # Percentiles over time and the latest bucket distribution, per histogram
+    for i, name in enumerate(hist_names):
+        ax = axes[i][0]
+        unit = last['histograms'][name]['unit']
+        for key, style in (('p50', '-'), ('p90', '--'), ('p99', ':'), ('max', '-.')):
+            ys = [r['histograms'].get(name, {}).get(key) for r in records]
+            ax.plot(t, ys, style, label=key)
+        ax.set_yscale('log')
+        ax.set_title(f"{name} ({unit})", fontsize=9)
+        ax.legend(fontsize=7, loc='upper left')
+        ax.grid(alpha=0.3)
+
+        ax = axes[i][1]
+        buckets = last['histograms'][name]['buckets']
+        labels = ['0'] + [f"<{1 << b}" for b in range(1, len(buckets))]
+        ax.bar(range(len(buckets)), buckets)
+        ax.set_xticks(range(len(buckets)))
+        ax.set_xticklabels(labels, rotation=60, fontsize=6)
+        ax.set_title(f"{name}: latest window, {last['histograms'][name]['count']} samples", fontsize=9)
+
+    # Counter rates between successive records
+    ax = axes[rows - 2][0]
+    for name in last.get('counters', {}):
+        rates = []
+        for a, b in zip(records, records[1:]):
+            dt = (b['timestamp'] - a['timestamp']) / 1000
+            rates.append((b['counters'][name] - a['counters'][name]) / dt if dt > 0 else 0)
+        ax.plot(t[1:], rates, label=name)
+    ax.set_yscale('symlog', linthresh=1)
+    ax.set_title('counters (per second)', fontsize=9)
+    ax.legend(fontsize=7, loc='upper left')
+    ax.grid(alpha=0.3)
+
+    # Gauges and busy share over time
+    ax = axes[rows - 2][1]
+    for name in last.get('gauges', {}):
+        ax.plot(t, [r['gauges'][name]['max'] for r in records], label=f"{name} max")
+    for name in last.get('busy_pct', {}):
+        ax.plot(t, [r.get('busy_pct', {}).get(name) for r in records], '--', label=f"{name} busy %")
+    ax.set_title('gauges and busy share', fontsize=9)
+    ax.legend(fontsize=7, loc='upper left')
+    ax.grid(alpha=0.3)
+
+    # Tasks in the latest record
+    tasks = sorted(last.get('tasks', []), key=lambda x: x['name'])
+    names = [x['name'] for x in tasks]
+    ax = axes[rows - 1][0]
+    if any('cpu_pct' in x for x in tasks):
+        ax.barh(names, [x.get('cpu_pct', 0) for x in tasks])
+        ax.set_title('task CPU (% of one core, last interval)', fontsize=9)
+    else:
+        busy = last.get('busy_pct', {})
+        ax.barh(list(busy), list(busy.values()))
+        ax.set_title('busy % (firmware built without run-time stats)', fontsize=9)
+    ax.tick_params(labelsize=7)
+    ax = axes[rows - 1][1]
+    ax.barh(names, [x['stack_free'] for x in tasks])
+    ax.set_title('stack high-water mark (bytes never used)', fontsize=9)
+    ax.tick_params(labelsize=7)
+
+    fig.tight_layout()
+    fig.savefig(out, dpi=110)
+    print(f"Wrote {out} ({len(records)} records)")
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Chart the firmware performance registry')
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument('--port', help='serial port of the board')
+    src.add_argument('--log', help='serial capture or --save file to read')
+    ap.add_argument('--baud', type=int, default=115200)
+    ap.add_argument('--interval', type=float, default=5.0, help='seconds between polls')
+    ap.add_argument('--duration', type=float, default=60.0, help='seconds to poll for')
+    ap.add_argument('--cumulative', action='store_true', help='do not reset the window after each poll')
+    ap.add_argument('--save', help='write the records as JSON lines')
+    ap.add_argument('-o', '--output', help='chart file (PNG/SVG/PDF)')
+    args = ap.parse_args()
+
+    if args.port:
+        records = poll_board(args.port, args.baud, args.interval, args.duration, args.cumulative)
+    else:
+        with open(args.log, encoding='utf-8', errors='ignore') as f:
+            records = parse_records(f)
+    if not records:
+        sys.exit('No perf records (is the firmware new enough to answer "PERF"?)')
+
+    if args.save:
+        with open(args.save, 'w') as f:
+            for rec in records:
+                f.write(json.dumps(rec) + '\n')
+    if args.output:
+        chart(records, args.output)
+    else:
+        summary(records[-1])
+
+
+if __name__ == '__main__':
+    main()
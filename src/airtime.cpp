@@ -0,0 +1,184 @@
+/**
+ * @file airtime.cpp
+ * @brief Radio airtime ledger implementation
+ *
+ * @see airtime.h for accounting rules
+ */
+
+#include "airtime.h"
+#include <string.h>
+
+// ============================================================================
+// WINDOW HELPERS
+// ============================================================================
+
+uint32_t AirtimeWindow::totalListenUs() const {
+    uint32_t total = 0;
+    for (int ch = 1; ch <= AIRTIME_CHANNELS; ch++) total += listen_us[ch];
+    return total;
+}
+
+uint32_t AirtimeWindow::totalFrames() const {
+    uint32_t total = 0;
+    for (int ch = 1; ch <= AIRTIME_CHANNELS; ch++) total += frames[ch];
+    return total;
+}
+
+float AirtimeWindow::framesPerMs(uint8_t channel) const {
+    if (channel < 1 || channel > AIRTIME_CHANNELS || listen_us[channel] == 0) return 0;
+    return frames[channel] * 1000.0f / listen_us[channel];
+}
+
+float AirtimeWindow::advertsPerMs() const {
+    return ble_us ? adverts * 1000.0f / ble_us : 0.0f;
+}
+
+void AirtimeWindow::clear() {
+    memset(this, 0, sizeof(*this));
+}
+
+void AirtimeWindow::add(const AirtimeWindow& o) {
+    span_us += o.span_us;
+    for (int ch = 0; ch <= AIRTIME_CHANNELS; ch++) {
+        listen_us[ch] += o.listen_us[ch];
+        frames[ch] += o.frames[ch];
+    }
+    switch_us += o.switch_us;
+    switches += o.switches;
+    ble_us += o.ble_us;
+    ble_windows += o.ble_windows;
+    adverts += o.adverts;
+    overlap_us += o.overlap_us;
+    sleep_us += o.sleep_us;
+}
+
+// ============================================================================
+// LEDGER
+// ============================================================================
+
+AirtimeLedger::AirtimeLedger() {
+    current.clear();
+    for (int i = 0; i < AIRTIME_HISTORY; i++) history[i].clear();
+    history_head = 0;
+    history_count = 0;
+    window_start_us = 0;
+    last_event_us = 0;
+    channel = 0;
+    ble_active = false;
+    sleeping = false;
+    for (int ch = 0; ch <= AIRTIME_CHANNELS; ch++) {
+        frame_count[ch] = 0;
+        frame_base[ch] = 0;
+    }
+    advert_count = 0;
+    advert_base = 0;
+    lifetime_listen_ms = 0;
+    lifetime_ble_ms = 0;
+    lifetime_switch_ms = 0;
+}
+
+void AirtimeLedger::begin(uint8_t ch, uint32_t now_us) {
+    channel = ch;
+    window_start_us = now_us;
+    last_event_us = now_us;
+}
+
+// Charge time since the previous event to the current radio state
+void AirtimeLedger::accrue(uint32_t now_us) {
+    uint32_t elapsed = now_us - last_event_us;
+    last_event_us = now_us;
+
+    if (channel >= 1 && channel <= AIRTIME_CHANNELS) {
+        current.listen_us[channel] += elapsed;
+        if (ble_active) current.overlap_us += elapsed;
+    }
+    if (ble_active) current.ble_us += elapsed;
+    if (sleeping) current.sleep_us += elapsed;
+}
+
+void AirtimeLedger::switchStart(uint32_t now_us) {
+    accrue(now_us);
+    channel = 0;  // Deaf until switchEnd()
+}
+
+void AirtimeLedger::switchEnd(uint8_t new_channel, uint32_t now_us) {
+    uint32_t cost = now_us - last_event_us;
+    accrue(now_us);
+    current.switch_us += cost;
+    current.switches++;
+    channel = new_channel;
+}
+
+void AirtimeLedger::bleStart(uint32_t now_us) {
+    if (ble_active) return;
+    accrue(now_us);
+    ble_active = true;
+    current.ble_windows++;
+}
+
+void AirtimeLedger::bleStop(uint32_t now_us) {
+    if (!ble_active) return;
+    accrue(now_us);
+    ble_active = false;
+}
+
+void AirtimeLedger::radiosOff(uint32_t now_us) {
+    accrue(now_us);
+    channel = 0;
+    sleeping = true;
+}
+
+void AirtimeLedger::radiosOn(uint8_t ch, uint32_t now_us) {
+    accrue(now_us);
+    sleeping = false;
+    channel = ch;
+}
+
+void AirtimeLedger::wifiPause(uint32_t now_us) {
+    accrue(now_us);
+    channel = 0;
+}
+
+void AirtimeLedger::wifiResume(uint8_t ch, uint32_t now_us) {
+    accrue(now_us);
+    channel = ch;
+}
+
+bool AirtimeLedger::roll(uint32_t now_us) {
+    if (now_us - window_start_us < (uint32_t)AIRTIME_WINDOW_MS * 1000) return false;
+
+    accrue(now_us);
+    current.span_us = now_us - window_start_us;
+    for (int ch = 1; ch <= AIRTIME_CHANNELS; ch++) {
+        uint32_t count = frame_count[ch];
+        current.frames[ch] = count - frame_base[ch];
+        frame_base[ch] = count;
+    }
+    uint32_t adverts = advert_count;
+    current.adverts = adverts - advert_base;
+    advert_base = adverts;
+
+    lifetime_listen_ms += current.totalListenUs() / 1000;
+    lifetime_ble_ms += current.ble_us / 1000;
+    lifetime_switch_ms += current.switch_us / 1000;
+
+    history[history_head] = current;
+    history_head = (history_head + 1) % AIRTIME_HISTORY;
+    if (history_count < AIRTIME_HISTORY) history_count++;
+
+    current.clear();
+    window_start_us = now_us;
+    return true;
+}
+
+const AirtimeWindow& AirtimeLedger::last() const {
+    return history[(history_head + AIRTIME_HISTORY - 1) % AIRTIME_HISTORY];
+}
+
+void AirtimeLedger::sum(uint8_t count, AirtimeWindow& out) const {
+    out.clear();
+    if (count > history_count) count = history_count;
+    for (uint8_t i = 1; i <= count; i++) {
+        out.add(history[(history_head + AIRTIME_HISTORY - i) % AIRTIME_HISTORY]);
+    }
+}
@@ -0,0 +1,123 @@
+/**
+ * @file airtime.h
+ * @brief Radio airtime ledger and duty-cycle telemetry
+ *
+ * Accounts where the radio's time goes: per-channel WiFi listen time,
+ * channel switch overhead (esp_wifi_set_channel), BLE scan windows, and
+ * how much WiFi listening overlapped a BLE window (shared RF front end).
+ * Frames per channel come from the sniffer and adverts from the BLE
+ * callback, so yield can be expressed as frames per ms of listening and
+ * adverts per ms of scan window.
+ *
+ * Time is accrued lazily: every state change (channel switch, BLE window
+ * start/stop, window roll) charges the elapsed time since the previous
+ * change to whatever the radio was doing. Closed windows are kept in a
+ * small ring so callers can report the last window or a rolling minute.
+ *
+ * All state changes happen on Core 1 (loop); only addFrame() and
+ * addAdvert() are called from the WiFi and BLE host tasks. No Arduino dependencies.
+ */
+
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+
+#define AIRTIME_CHANNELS   13
+#define AIRTIME_WINDOW_MS  5000   // One window per [STATS] period
+#define AIRTIME_HISTORY    12     // Closed windows kept (rolling minute)
+
+struct AirtimeWindow {
+    uint32_t span_us;                              // Wall time covered
+    uint32_t listen_us[AIRTIME_CHANNELS + 1];      // WiFi tuned time per channel
+    uint32_t frames[AIRTIME_CHANNELS + 1];         // Frames received per channel
+    uint32_t switch_us;                            // Time spent inside channel switches
+    uint32_t switches;                             // Channel switches
+    uint32_t ble_us;                               // BLE scan window time
+    uint32_t ble_windows;                          // BLE scan windows started
+    uint32_t adverts;                              // BLE advertisements received
+    uint32_t overlap_us;                           // WiFi listening during a BLE window
+    uint32_t sleep_us;                             // Radios off (patrol mode)
+
+    uint32_t totalListenUs() const;
+    uint32_t totalFrames() const;
+    // Frames per ms of listening (0 when the channel wasn't visited)
+    float framesPerMs(uint8_t channel) const;
+    // BLE adverts per ms of scan window
+    float advertsPerMs() const;
+    void clear();
+    void add(const AirtimeWindow& other);
+};
+
+class AirtimeLedger {
+public:
+    AirtimeLedger();
+
+    void begin(uint8_t channel, uint32_t now_us);
+
+    // Channel switch: call switchStart() right before esp_wifi_set_channel()
+    // and switchEnd() right after it returns.
+    void switchStart(uint32_t now_us);
+    void switchEnd(uint8_t new_channel, uint32_t now_us);
+
+    void bleStart(uint32_t now_us);
+    void bleStop(uint32_t now_us);
+    bool bleActive() const { return ble_active; }
+
+    // Patrol sleep: radios off from radiosOff() (BLE window already stopped)
+    // until radiosOn() retunes to `channel`
+    void radiosOff(uint32_t now_us);
+    void radiosOn(uint8_t channel, uint32_t now_us);
+
+    // WiFi capture off for a BLE slot (promiscuous RX disabled) until
+    // wifiResume() picks `channel` up again
+    void wifiPause(uint32_t now_us);
+    void wifiResume(uint8_t channel, uint32_t now_us);
+
+    // Sniffer hot path (WiFi task): one relaxed increment
+    inline void addFrame(uint8_t channel) {
+        if (channel >= 1 && channel <= AIRTIME_CHANNELS) frame_count[channel]++;
+    }
+
+    // BLE host task: one relaxed increment per advertisement
+    inline void addAdvert() { advert_count++; }
+    uint32_t advertCount() const { return advert_count; }
+
+    // Close the current window if AIRTIME_WINDOW_MS has elapsed. Returns true
+    // when a new window was closed.
+    bool roll(uint32_t now_us);
+
+    // Most recently closed window (zeroed until the first roll)
+    const AirtimeWindow& last() const;
+    // Sum of the newest `count` closed windows (capped at AIRTIME_HISTORY)
+    void sum(uint8_t count, AirtimeWindow& out) const;
+    // Lifetime totals in ms
+    uint32_t lifetimeListenMs() const { return lifetime_listen_ms; }
+    uint32_t lifetimeBleMs() const { return lifetime_ble_ms; }
+    uint32_t lifetimeSwitchMs() const { return lifetime_switch_ms; }
+
+private:
+    void accrue(uint32_t now_us);
+
+    AirtimeWindow current;
+    AirtimeWindow history[AIRTIME_HISTORY];
+    uint8_t history_head;       // Next slot to write
+    uint8_t history_count;
+
+    uint32_t window_start_us;
+    uint32_t last_event_us;
+    uint8_t  channel;           // 0 while switching or sleeping
+    bool     ble_active;
+    bool     sleeping;
+
+    volatile uint32_t frame_count[AIRTIME_CHANNELS + 1];  // Monotonic, written by sniffer
+    uint32_t frame_base[AIRTIME_CHANNELS + 1];            // frame_count at window start
+    volatile uint32_t advert_count;                       // Monotonic, written by BLE host
+    uint32_t advert_base;
+
+    uint32_t lifetime_listen_ms;
+    uint32_t lifetime_ble_ms;
+    uint32_t lifetime_switch_ms;
+};
+
+#endif // AIRTIME_H
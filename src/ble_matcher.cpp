@@ -0,0 +1,147 @@
+/**
+ * @file ble_matcher.cpp
+ * @brief BLE advertisement payload signature matcher implementation
+ *
+ * @see ble_matcher.h for rule kinds and table layout
+ */
+
+#include "ble_matcher.h"
+#include <string.h>
+
+// AD types (Bluetooth Assigned Numbers, Generic Access Profile)
+#define AD_UUID16_INCOMPLETE   0x02
+#define AD_UUID16_COMPLETE     0x03
+#define AD_NAME_SHORT          0x08
+#define AD_NAME_COMPLETE       0x09
+#define AD_SERVICE_DATA16      0x16
+#define AD_MANUFACTURER        0xFF
+
+#define SPACE_COMPANY  0u
+#define SPACE_SERVICE  1u
+
+static uint32_t rule_key(const BleRule& r) {
+    uint32_t space = (r.kind == BLE_RULE_MFG_ID || r.kind == BLE_RULE_MFG_DATA)
+                     ? SPACE_COMPANY : SPACE_SERVICE;
+    return (space << 16) | r.id;
+}
+
+BleMatcher::BleMatcher() {
+    rule_count = 0;
+}
+
+bool BleMatcher::compile(const BleRule* rules, uint16_t count) {
+    rule_count = 0;
+    if (count > BLE_MATCHER_MAX_RULES) return false;
+
+    // Insertion sort by key; stable so rules sharing an ID keep table order
+    for (uint16_t i = 0; i < count; i++) {
+        Slot s = { rule_key(rules[i]), &rules[i] };
+        uint16_t j = rule_count;
+        while (j > 0 && slots[j - 1].key > s.key) {
+            slots[j] = slots[j - 1];
+            j--;
+        }
+        slots[j] = s;
+        rule_count++;
+    }
+    return true;
+}
+
+// Masked compare of rule bytes against the data following the ID
+static bool bytes_match(const BleRule& r, const uint8_t* data, uint8_t data_len) {
+    if (r.len == 0) return true;
+    if (r.offset + r.len > data_len) return false;
+    for (uint8_t i = 0; i < r.len; i++) {
+        if ((data[r.offset + i] & r.mask[i]) != (r.value[i] & r.mask[i])) return false;
+    }
+    return true;
+}
+
+// Binary search for the first slot with `key`, then test each rule on it.
+// service_list: the UUID came from a UUID list (no data, only SERVICE_UUID rules apply).
+const BleRule* BleMatcher::lookup(uint32_t key, const uint8_t* data, uint8_t data_len,
+                                  bool service_list) const {
+    uint16_t lo = 0, hi = rule_count;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (slots[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (uint16_t i = lo; i < rule_count && slots[i].key == key; i++) {
+        const BleRule& r = *slots[i].rule;
+        switch (r.kind) {
+        case BLE_RULE_MFG_ID:
+            return &r;
+        case BLE_RULE_MFG_DATA:
+            if (bytes_match(r, data, data_len)) return &r;
+            break;
+        case BLE_RULE_SERVICE_UUID:
+            if (service_list) return &r;
+            break;
+        case BLE_RULE_SERVICE_DATA:
+            if (!service_list && bytes_match(r, data, data_len)) return &r;
+            break;
+        }
+    }
+    return nullptr;
+}
+
+const BleRule* BleMatcher::match(const uint8_t* payload, size_t len,
+                                 char* name_out, size_t name_size,
+                                 int32_t* company_out) const {
+    const BleRule* hit = nullptr;
+    bool have_complete_name = false;
+    int32_t company_id = -1;
+    name_out[0] = '\0';
+
+    size_t pos = 0;
+    while (pos + 1 < len) {
+        uint8_t field_len = payload[pos];
+        if (field_len == 0 || pos + 1 + field_len > len) break;  // Padding or truncated
+        uint8_t ad_type = payload[pos + 1];
+        const uint8_t* data = &payload[pos + 2];
+        uint8_t data_len = field_len - 1;
+
+        switch (ad_type) {
+        case AD_NAME_COMPLETE:
+        case AD_NAME_SHORT:
+            if (!have_complete_name) {
+                size_t n = data_len < name_size - 1 ? data_len : name_size - 1;
+                memcpy(name_out, data, n);
+                name_out[n] = '\0';
+                have_complete_name = (ad_type == AD_NAME_COMPLETE);
+            }
+            break;
+
+        case AD_MANUFACTURER:
+            if (data_len >= 2 && (!hit || company_id < 0)) {
+                uint16_t company = data[0] | (data[1] << 8);  // Little-endian
+                if (company_id < 0) company_id = company;
+                if (!hit) hit = lookup((SPACE_COMPANY << 16) | company, data + 2, data_len - 2, false);
+            }
+            break;
+
+        case AD_UUID16_INCOMPLETE:
+        case AD_UUID16_COMPLETE:
+            for (uint8_t i = 0; !hit && i + 1 < data_len; i += 2) {
+                uint16_t uuid = data[i] | (data[i + 1] << 8);
+                hit = lookup((SPACE_SERVICE << 16) | uuid, nullptr, 0, true);
+            }
+            break;
+
+        case AD_SERVICE_DATA16:
+            if (!hit && data_len >= 2) {
+                uint16_t uuid = data[0] | (data[1] << 8);
+                hit = lookup((SPACE_SERVICE << 16) | uuid, data + 2, data_len - 2, false);
+            }
+            break;
+        }
+
+        // Keep walking after a hit only to pick up the name (and company)
+        if (hit && have_complete_name && (company_id >= 0 || !company_out)) break;
+        pos += 1 + field_len;
+    }
+    if (company_out) *company_out = company_id;
+    return hit;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file ble_matcher.h
+ * @brief BLE advertisement payload signature matcher
+ *
+ * Matches raw advertisement payloads against rules on what the device
+ * advertises rather than who it claims to be:
+ *
+ * - BLE_RULE_MFG_ID:       manufacturer specific data with a company ID
+ * - BLE_RULE_MFG_DATA:     company ID + masked bytes after the ID
+ * - BLE_RULE_SERVICE_UUID: 16-bit service UUID in the (in)complete list
+ * - BLE_RULE_SERVICE_DATA: service data for a 16-bit UUID, optionally with
+ *                          masked bytes after the UUID
+ *
+ * Penguin units, for example, use random non-OUI addresses but always
+ * advertise company ID 0x09C8 (wigle mfgrId 2504).
+ *
+ * compile() sorts the rules into a lookup table keyed by company ID (and
+ * a second one keyed by service UUID), so match() walks the AD structures
+ * once and does one binary search per manufacturer/service field. The same
+ * pass extracts the local name so onResult() never re-parses the payload.
+ *
+ * No Arduino dependencies, no allocation.
+ */
+
+#ifndef BLE_MATCHER_H
+#define BLE_MATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BLE_MATCHER_MAX_RULES  32
+#define BLE_RULE_MAX_BYTES      8
+
+#define BLE_RULE_MFG_ID        0
+#define BLE_RULE_MFG_DATA      1
+#define BLE_RULE_SERVICE_UUID  2
+#define BLE_RULE_SERVICE_DATA  3
+
+struct BleRule {
+    const char* name;                    // Reported as the matched rule
+    uint8_t  kind;                       // BLE_RULE_*
+    uint16_t id;                         // Company ID or 16-bit service UUID
+    uint8_t  offset;                     // Data offset after the ID
+    uint8_t  len;                        // Bytes compared (0 = ID alone)
+    uint8_t  value[BLE_RULE_MAX_BYTES];
+    uint8_t  mask[BLE_RULE_MAX_BYTES];   // 0xFF = must match, 0x00 = don't care
+};
+
+class BleMatcher {
+public:
+    BleMatcher();
+
+    // Build the lookup tables. Rules must outlive the matcher.
+    // Returns false (and matches nothing) if there are too many rules.
+    bool compile(const BleRule* rules, uint16_t count);
+
+    // Single pass over the AD structures. Returns the first matching rule
+    // (nullptr if none) and copies the local name (Complete preferred over
+    // Shortened) into name_out, NUL-terminated, empty if absent. If given,
+    // company_out gets the first manufacturer data company ID (-1 if none).
+    const BleRule* match(const uint8_t* payload, size_t len,
+                         char* name_out, size_t name_size,
+                         int32_t* company_out = nullptr) const;
+
+    uint16_t ruleCount() const { return rule_count; }
+
+private:
+    // Sorted by key: (space << 16) | id, space 0 = company ID, 1 = service UUID
+    struct Slot {
+        uint32_t key;
+        const BleRule* rule;
+    };
+
+    const BleRule* lookup(uint32_t key, const uint8_t* data, uint8_t data_len,
+                          bool service_list) const;
+
+    Slot slots[BLE_MATCHER_MAX_RULES];
+    uint16_t rule_count;
+};
+
+#endif // BLE_MATCHER_H
@@ -0,0 +1,64 @@
+/**
+ * @file ble_seen_cache.cpp
+ * @brief Host-side BLE advertisement seen-cache implementation
+ *
+ * @see ble_seen_cache.h for the forwarding rule
+ */
+
+#include "ble_seen_cache.h"
+#include <string.h>
+
+BleSeenCache::BleSeenCache() {
+    clear();
+}
+
+void BleSeenCache::clear() {
+    memset(table, 0, sizeof(table));
+}
+
+// FNV-1a over the 6 address bytes followed by the raw payload
+uint32_t BleSeenCache::hashAdvert(const uint8_t* addr, const uint8_t* payload, uint8_t len) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        hash ^= addr[i];
+        hash *= 16777619u;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        hash ^= payload[i];
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;  // 0 = empty slot sentinel
+}
+
+bool BleSeenCache::check(const uint8_t* addr, const uint8_t* payload, uint8_t len, uint32_t now) {
+    uint32_t key = hashAdvert(addr, payload, len);
+    uint32_t base = key & (BLE_SEEN_SLOTS - 1);
+    Entry* victim = nullptr;
+
+    for (uint32_t i = 0; i < BLE_SEEN_PROBE; i++) {
+        Entry& e = table[(base + i) & (BLE_SEEN_SLOTS - 1)];
+        if (e.key == key) {
+            if (now - e.last_ms < ttl_ms) return false;
+            e.last_ms = now;
+            return true;
+        }
+        // Prefer an empty slot, then the stalest one
+        if (e.key == 0) {
+            if (!victim || victim->key != 0) victim = &e;
+        } else if (!victim || (victim->key != 0 && now - e.last_ms > now - victim->last_ms)) {
+            victim = &e;
+        }
+    }
+
+    victim->key = key;
+    victim->last_ms = now;
+    return true;
+}
+
+uint16_t BleSeenCache::occupancy() const {
+    uint16_t n = 0;
+    for (int i = 0; i < BLE_SEEN_SLOTS; i++) {
+        if (table[i].key) n++;
+    }
+    return n;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file ble_seen_cache.h
+ * @brief Host-side BLE advertisement seen-cache
+ *
+ * The controller duplicate filter drops repeats by address only and is
+ * reset periodically, so between resets a device that changes its payload
+ * can be lost and right after a reset every advertiser floods onResult()
+ * again. The seen-cache sits at the top of onResult() and forwards an
+ * advertisement only when its (address, payload) pair hasn't been
+ * forwarded within the TTL:
+ *
+ * - a new advertiser, or a known one with a new payload, passes at once
+ * - an unchanged repeat passes at most once per TTL, which keeps RSSI
+ *   updates flowing to tracked devices at a bounded rate
+ *
+ * Entries are 32-bit FNV-1a hashes of address + payload in a small open
+ * addressed table with a bounded probe; when the probe window is full the
+ * oldest entry is evicted. Fixed memory, no allocation.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef BLE_SEEN_CACHE_H
+#define BLE_SEEN_CACHE_H
+
+#include <stdint.h>
+
+#define BLE_SEEN_SLOTS    256    // Power of two
+#define BLE_SEEN_PROBE      4    // Slots inspected per lookup
+#define BLE_SEEN_TTL_MS  1000    // Forward an unchanged repeat at most this often
+
+class BleSeenCache {
+public:
+    BleSeenCache();
+
+    // True if the advert should be forwarded (new, changed, or TTL expired).
+    // Records it as seen at `now` when forwarded.
+    bool check(const uint8_t* addr, const uint8_t* payload, uint8_t len, uint32_t now);
+
+    void clear();
+    uint16_t occupancy() const;
+
+    uint32_t ttl_ms = BLE_SEEN_TTL_MS;
+
+private:
+    struct Entry {
+        uint32_t key;       // 0 = empty
+        uint32_t last_ms;
+    };
+
+    static uint32_t hashAdvert(const uint8_t* addr, const uint8_t* payload, uint8_t len);
+
+    Entry table[BLE_SEEN_SLOTS];
+};
+
+#endif // BLE_SEEN_CACHE_H
@@ -6,6 +6,8 @@
 #ifdef WAVESHARE_147
 
 #include "display_handler_147.h"
+#include "trace_ring.h"
+#include "status_led.h"
 #include <Arduino.h>
 
 // Global instance
@@ -17,6 +19,8 @@ DisplayHandler::DisplayHandler() :
     lastUpdate(0),
     brightness(200),
     currentPage(PAGE_MAIN),
+    awake(true),
+    lastInput(0),
     buttonPressed(false),
     buttonPressTime(0),
     longPressHandled(false),
@@ -32,17 +36,16 @@ DisplayHandler::DisplayHandler() :
     scrollOffset(0),
     lastScrollTime(0),
     scrollPaused(false),
+    toasts(),
+    overlayId(0),
+    overlayStep(0),
+    overlayDirty(false),
     currentChannel(1),
     bleScanning(false),
     sdCardPresent(false),
     lastSdCheck(0),
     detectionsLogged(0),
-    ledState(1),
-    lastLedUpdate(0),
-    lastDetectionTime(0),
-    alertStartTime(0),
-    ledFlashState(false),
-    detectionRssi(-100)
+    sdTiming(nullptr)
 {
 }
 
@@ -54,10 +57,17 @@ void DisplayHandler::setupBacklightPWM() {
 }
 
 void DisplayHandler::applyBrightness() {
-    ledcWrite(0, brightness);
+    ledcWrite(0, awake ? brightness : 0);
 }
 
-bool DisplayHandler::begin() {
+void DisplayHandler::setAwake(bool on) {
+    if (on == awake) return;
+    awake = on;
+    applyBrightness();
+    if (on) needsRedraw = true;
+}
+
+bool DisplayHandler::begin(bool fastBoot) {
     Serial.println("Waveshare 1.47\" Display initializing...");
 
     // Initialize stats
@@ -78,16 +88,6 @@ bool DisplayHandler::begin() {
     setupBacklightPWM();
     Serial.println("  Backlight done");
 
-    // Initialize FastLED for WS2812
-    Serial.println("  FastLED init...");
-    Serial.flush();
-    delay(10);
-    FastLED.addLeds<WS2812B, RGB_LED_PIN, RGB>(leds, NUM_LEDS);
-    FastLED.setBrightness(rgbBrightness);
-    leds[0] = CRGB(0, 128, 0);  // Start green (scanning)
-    FastLED.show();
-    Serial.println("  FastLED done");
-
     // Initialize SD Card (SDMMC)
     Serial.println("  SD init...");
     initSDCard();
@@ -98,10 +98,13 @@ bool DisplayHandler::begin() {
         Serial.println("  Loading settings...");
         loadSettings();
     }
+    status_led.setScale(rgbBrightness);
 
-    // Show boot animation
-    Serial.println("  Boot animation...");
-    showBootAnimation();
+    // Show boot animation (skipped by a fast boot)
+    if (!fastBoot) {
+        Serial.println("  Boot animation...");
+        showBootAnimation();
+    }
 
     needsRedraw = true;
     Serial.println("Display ready!");
@@ -207,9 +210,7 @@ void DisplayHandler::update() {
 
     // Check SD card periodically
     checkSDCard();
-
-    // Update LED state
-    updateLED();
+    if (!awake) return;
 
     // Auto-scroll detection list every 3 seconds
     if (currentPage == PAGE_LIST &&
@@ -252,7 +253,10 @@ void DisplayHandler::update() {
         }
         lastUpdate = now;
         needsRedraw = false;
+        overlayDirty = true;
     }
+
+    drawOverlay(now);
 }
 
 void DisplayHandler::handleButton() {
@@ -264,6 +268,12 @@ void DisplayHandler::handleButton() {
         buttonPressed = true;
         buttonPressTime = now;
         longPressHandled = false;
+        lastInput = now;
+        if (!awake) {
+            // Wake only: neither the tap nor a hold acts
+            setAwake(true);
+            longPressHandled = true;
+        }
     }
     else if (currentState && buttonPressed) {
         // Button held - check for long press
@@ -303,8 +313,7 @@ void DisplayHandler::handleButton() {
                     applyBrightness();
                 } else {
                     rgbBrightness = (rgbBrightness >= 245) ? 25 : rgbBrightness + 25;
-                    FastLED.setBrightness(rgbBrightness);
-                    FastLED.show();
+                    status_led.setScale(rgbBrightness);
                 }
                 saveSettings();
                 needsRedraw = true;
@@ -522,6 +531,11 @@ void DisplayHandler::drawLatestDetection() {
         tft.print("WiFi");
     }
 
+    // Drive-by phase from the proximity filter, bottom left
+    tft.setTextColor(flashOn ? BG_DARK : (d.phase == RSSI_PHASE_APPROACHING ? ALERT_WARN : TEXT_DIM));
+    tft.setCursor(CONTENT_X + 10, startY + panelH - 12);
+    tft.print(rssi_phase_name((RssiPhase)d.phase));
+
     // Total count at bottom right of panel
     tft.setTextColor(flashOn ? BG_DARK : TEXT_DIM);
     tft.setCursor(CONTENT_X + CONTENT_WIDTH - 80, startY + panelH - 12);
@@ -1027,8 +1041,7 @@ void DisplayHandler::setBrightness(uint8_t level) {
 
 void DisplayHandler::setRgbBrightness(uint8_t level) {
     rgbBrightness = level;
-    FastLED.setBrightness(rgbBrightness);
-    FastLED.show();
+    status_led.setScale(rgbBrightness);
     saveSettings();
 }
 
@@ -1064,7 +1077,6 @@ bool DisplayHandler::loadSettings() {
 
     // Apply loaded settings
     applyBrightness();
-    FastLED.setBrightness(rgbBrightness);
 
     Serial.printf("  Settings loaded: brightness=%d, rgbBrightness=%d\n", brightness, rgbBrightness);
     return true;
@@ -1165,6 +1177,8 @@ void DisplayHandler::checkSDCard() {
 void DisplayHandler::logDetection(const String& ssid, const String& mac, int8_t rssi, const String& type) {
     if (!sdCardPresent) return;
 
+    uint32_t started = micros();
+    TRACE_BEGIN_ARG(TRACE_SD_FLUSH, 1);
     fs::File file = SD_MMC.open(logFileName, FILE_APPEND);
     if (file) {
         String vendor = lookupOUI(mac);
@@ -1178,6 +1192,8 @@ void DisplayHandler::logDetection(const String& ssid, const String& mac, int8_t
         file.close();
         detectionsLogged++;
     }
+    TRACE_END(TRACE_SD_FLUSH);
+    if (sdTiming) sdTiming->record(micros() - started);
 }
 
 void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String type) {
@@ -1213,6 +1229,7 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
             t.type = type;
             t.timestamp = millis();
             t.hitCount = 1;
+            t.phase = RSSI_PHASE_IDLE;
             t.isNew = true;
             threats.insert(threats.begin(), t);
         }
@@ -1231,7 +1248,6 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
                 lastThreatTime = millis();
                 hadThreat = true;
                 if (rssi > closestThreatRssi) closestThreatRssi = rssi;
-                setLEDDetection(rssi);
             }
             needsRedraw = true;
             return;
@@ -1247,6 +1263,7 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
     d.type = type;
     d.timestamp = millis();
     d.hitCount = 1;
+    d.phase = RSSI_PHASE_IDLE;
     d.isNew = true;
 
     detections.insert(detections.begin(), d);
@@ -1257,8 +1274,7 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
         lastThreatTime = millis();
         hadThreat = true;
         if (rssi > closestThreatRssi) closestThreatRssi = rssi;
-        setLEDDetection(rssi);
-    } else if (type == "ble") {
+    } else if (type == "BLE") {
         bleDetections++;
     }
 
@@ -1278,6 +1294,79 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
     needsRedraw = true;
 }
 
+// Proximity event for an already listed device: filtered level and phase
+void DisplayHandler::updateProximity(const String& mac, int8_t rssi, RssiPhase phase) {
+    for (auto& d : detections) {
+        if (d.mac == mac) {
+            d.rssi = rssi;
+            d.phase = phase;
+            needsRedraw = true;
+            return;
+        }
+    }
+}
+
+// Stats record, then the threat log and the detection list newest first
+// (list 1 / 0), so a full snapshot drops the oldest detections
+void DisplayHandler::saveSnapshot(SnapshotWriter& w, uint32_t now) {
+    w.beginSection(SNAP_SEC_DISPLAY, DISPLAY_SNAPSHOT_VERSION);
+    w.put32(totalDetections);
+    w.put32(flockDetections);
+    w.put32(bleDetections);
+    w.put8((uint8_t)closestThreatRssi);
+    w.put8(hadThreat);
+    w.put32(now - lastThreatTime);
+    for (int ch = 1; ch <= 13; ch++) w.put16(channelCounts[ch]);
+    w.endRecord();
+    for (int list = 1; list >= 0; list--) {
+        for (const Detection& d : list ? threats : detections) {
+            w.put8(list);
+            w.putStr(d.ssid.c_str());
+            w.putStr(d.mac.c_str());
+            w.putStr(d.vendor.c_str());
+            w.putStr(d.type.c_str());
+            w.put8((uint8_t)d.rssi);
+            w.put8(d.phase);
+            w.put16(d.hitCount);
+            w.put32(now - d.timestamp);
+            w.endRecord();
+        }
+    }
+    w.endSection();
+}
+
+uint16_t DisplayHandler::restoreSnapshot(SnapshotReader& r, uint8_t version, uint16_t count, uint32_t base) {
+    if (version != DISPLAY_SNAPSHOT_VERSION || count == 0) return 0;
+    totalDetections = r.get32();
+    flockDetections = r.get32();
+    bleDetections = r.get32();
+    closestThreatRssi = (int8_t)r.get8();
+    hadThreat = r.get8() != 0;
+    lastThreatTime = base - r.get32();
+    for (int ch = 1; ch <= 13; ch++) channelCounts[ch] = r.get16();
+
+    uint16_t kept = 0;
+    char buf[40];
+    for (uint16_t i = 1; i < count; i++) {
+        Detection d;
+        uint8_t list = r.get8();
+        r.getStr(buf, sizeof(buf)); d.ssid = buf;
+        r.getStr(buf, sizeof(buf)); d.mac = buf;
+        r.getStr(buf, sizeof(buf)); d.vendor = buf;
+        r.getStr(buf, sizeof(buf)); d.type = buf;
+        d.rssi = (int8_t)r.get8();
+        d.phase = r.get8();
+        d.hitCount = r.get16();
+        d.timestamp = base - r.get32();
+        d.isNew = false;
+        if (!r.ok()) break;
+        (list ? threats : detections).push_back(d);
+        kept++;
+    }
+    needsRedraw = true;
+    return kept;
+}
+
 void DisplayHandler::clearDetections() {
     detections.clear();
     threats.clear();
@@ -1382,79 +1471,51 @@ String DisplayHandler::lookupOUIFromSD(const String& prefix) {
     return "";
 }
 
-void DisplayHandler::updateLED() {
-    uint32_t now = millis();
-
-    switch (ledState) {
-        case 1:  // Scanning - solid green
-            leds[0] = CRGB(0, 128, 0);
-            break;
-
-        case 2:  // Detection - flashing red, rate based on RSSI
-            {
-                int flashInterval = map(constrain(detectionRssi, -90, -30), -90, -30, 400, 50);
-                if (now - lastLedUpdate > (uint32_t)flashInterval) {
-                    ledFlashState = !ledFlashState;
-                    lastLedUpdate = now;
-                }
-                leds[0] = ledFlashState ? CRGB::Red : CRGB::Black;
-
-                // No new detection for 10s -> signal lost, transition to orange
-                if (now - lastDetectionTime > 10000) {
-                    ledState = 3;
-                    alertStartTime = now;
-                }
-            }
-            break;
-
-        case 3:  // Alert - solid orange (signal lost, persistent until reboot)
-            leds[0] = CRGB(255, 100, 0);
-            break;
-
-        default:  // Off
-            leds[0] = CRGB::Black;
-            break;
-    }
-
-    FastLED.show();
-}
-
-void DisplayHandler::setLEDScanning() {
-    ledState = 1;
+void DisplayHandler::showAlert(String message, uint16_t color, ToastPriority priority, uint32_t durationMs) {
+    toasts.post(message.c_str(), color, priority, durationMs, millis());
 }
 
-void DisplayHandler::setLEDDetection(int8_t rssi) {
-    ledState = 2;
-    detectionRssi = rssi;
-    lastDetectionTime = millis();
+void DisplayHandler::showInfo(String message) {
+    showAlert(message, ACCENT_COLOR, TOAST_INFO);
 }
 
-void DisplayHandler::setLEDAlert() {
-    ledState = 3;
-    alertStartTime = millis();
-}
+// Toast box in the middle of the content area, revealed from the centre out
+// over a few frames; redrawn only when the toast, its reveal step or the
+// page under it changed. The band is cleared and the page redrawn when the
+// last toast goes.
+void DisplayHandler::drawOverlay(uint32_t now) {
+    const int alertH = 36;
+    const int y = CONTENT_Y + (CONTENT_HEIGHT - alertH) / 2;
+
+    const Toast* t = toasts.frame(now);
+    if (!t) {
+        if (overlayId) {
+            overlayId = 0;
+            tft.fillRect(CONTENT_X, y, CONTENT_WIDTH, alertH, BG_COLOR);
+            needsRedraw = true;
+        }
+        return;
+    }
 
-void DisplayHandler::setLEDOff() {
-    ledState = 0;
-}
+    uint8_t step = toasts.revealStep(*t, now);
+    if (t->id == overlayId && step == overlayStep && !overlayDirty) return;
+    overlayId = t->id;
+    overlayStep = step;
+    overlayDirty = false;
 
-void DisplayHandler::showAlert(String message, uint16_t color) {
-    int alertW = 200;
-    int alertH = 36;
+    int len = strlen(t->text);
+    int alertW = constrain(len * 6 + 24, 200, CONTENT_WIDTH);
     int x = CONTENT_X + (CONTENT_WIDTH - alertW) / 2;
-    int y = CONTENT_Y + (CONTENT_HEIGHT - alertH) / 2;
-    tft.fillRect(x, y, alertW, alertH, BG_DARK);
-    tft.drawRect(x, y, alertW, alertH, color);
-    tft.drawRect(x + 1, y + 1, alertW - 2, alertH - 2, color);
-    tft.setTextSize(1);
-    tft.setTextColor(color);
-    int textX = x + (alertW - message.length() * 6) / 2;
-    tft.setCursor(textX, y + 14);
-    tft.print(message);
-}
+    int w = alertW * step / TOAST_ANIM_STEPS;
+    tft.fillRect(x + (alertW - w) / 2, y, w, alertH, BG_DARK);
+    if (step < TOAST_ANIM_STEPS) return;
 
-void DisplayHandler::showInfo(String message) {
-    showAlert(message, ACCENT_COLOR);
+    tft.drawRect(x, y, alertW, alertH, t->color);
+    tft.drawRect(x + 1, y + 1, alertW - 2, alertH - 2, t->color);
+    tft.setTextSize(1);
+    tft.setTextColor(t->color);
+    tft.setCursor(x + (alertW - len * 6) / 2, y + 14);
+    tft.print(t->text);
 }
 
 void DisplayHandler::updateChannelInfo(uint8_t channel) {
@@ -1468,9 +1529,8 @@ void DisplayHandler::updateScanMode(bool isBLE) {
 }
 
 void DisplayHandler::updateScanStatus(bool isScanning) {
-    if (isScanning) {
-        setLEDScanning();
-    }
+    // The status LED plays the scan effect from boot (main.cpp)
+    (void)isScanning;
 }
 
 void DisplayHandler::showDebugSSID(String ssid, int8_t rssi, uint8_t channel) {
@@ -10,7 +10,7 @@
  *
  * Hardware notes:
  * - Display: ST7789 172x320 on SPI (MOSI=45, SCLK=40, CS=42, DC=41, RST=39, BL=48)
- * - RGB LED: WS2812 addressable on GPIO 38
+ * - RGB LED: WS2812 addressable on GPIO 38, driven over RMT by status_led.h
  * - SD Card: SDMMC interface (CMD=15, CLK=14, D0=16, D1=18, D2=17, D3=21)
  * - Boot button: GPIO 0 (active LOW)
  */
@@ -24,13 +24,15 @@
 #include <SPI.h>
 #include <SD_MMC.h>
 #include <FS.h>
-#include <FastLED.h>
 #include <vector>
 #include <string>
+#include "rssi_track.h"
+#include "warm_snapshot.h"
+#include "perf_registry.h"
+#include "toast_queue.h"
 
 // RGB LED (WS2812)
 #define RGB_LED_PIN 38
-#define NUM_LEDS 1
 
 // Boot button (GPIO 0)
 #define BOOT_BUTTON_PIN 0
@@ -39,6 +41,7 @@
 
 // Settings persistence
 #define SETTINGS_FILE "/settings.txt"
+#define DISPLAY_SNAPSHOT_VERSION 2  // SNAP_SEC_DISPLAY layout written by this handler
 
 // Modern dark theme color scheme (RGB565)
 #define BG_COLOR      0x0841          // Deep charcoal
@@ -70,13 +73,14 @@
 class DisplayHandler {
 private:
     TFT_eSPI tft;
-    CRGB leds[NUM_LEDS];
 
     // Display state
     bool needsRedraw;
     uint32_t lastUpdate;
     uint8_t brightness;
     uint8_t currentPage;
+    bool awake;               // Backlight off and nothing drawn while false (patrol mode)
+    uint32_t lastInput;       // millis() of the last button press
 
     // Button handling
     bool buttonPressed;
@@ -95,6 +99,7 @@ private:
         String type;
         uint32_t timestamp;
         uint16_t hitCount;
+        uint8_t phase;       // RssiPhase from the proximity filter
         bool isNew;
     };
 
@@ -117,6 +122,13 @@ private:
     uint32_t lastScrollTime;
     bool scrollPaused;
 
+    // Toast overlay, composited over the page by update()
+    ToastQueue toasts;
+    uint32_t overlayId;     // Toast on screen (0: none)
+    uint8_t overlayStep;    // Its reveal step as drawn
+    bool overlayDirty;      // Page drawn over it since
+    void drawOverlay(uint32_t now);
+
     // Scan state
     uint8_t currentChannel;
     bool bleScanning;
@@ -126,6 +138,7 @@ private:
     String logFileName;
     uint32_t lastSdCheck;
     uint32_t detectionsLogged;
+    PerfHistogram* sdTiming;  // Log append durations (us), when set
     void checkSDCard();
 
     // Brightness control (PWM for backlight)
@@ -142,15 +155,6 @@ private:
     String lookupOUIFromSD(const String& prefix);
     static const char* lookupEmbeddedOUI(const char* prefix);
 
-    // LED control
-    uint8_t ledState;  // 0=off, 1=scanning, 2=detection, 3=alert
-    uint32_t lastLedUpdate;
-    uint32_t lastDetectionTime;   // When last detection LED was triggered
-    uint32_t alertStartTime;      // When alert (orange) state began
-    bool ledFlashState;
-    int8_t detectionRssi;
-    void updateLED();
-
     // Private drawing methods
     void showBootAnimation();
     void drawHeader();
@@ -172,7 +176,7 @@ public:
     };
 
     DisplayHandler();
-    bool begin();
+    bool begin(bool fastBoot = false);   // fastBoot: no boot animation
     void update();
     void clear();
     void setBrightness(uint8_t level);
@@ -180,6 +184,12 @@ public:
     void setRgbBrightness(uint8_t level);
     uint8_t getRgbBrightness() { return rgbBrightness; }
 
+    // Patrol mode: asleep, the backlight is off and pages are not drawn. A
+    // button press only wakes the display.
+    void setAwake(bool on);
+    bool isAwake() { return awake; }
+    uint32_t lastInputMs() { return lastInput; }
+
     // Page navigation
     void nextPage();
     void setPage(DisplayPage page);
@@ -190,28 +200,31 @@ public:
     void logDetection(const String& ssid, const String& mac, int8_t rssi, const String& type);
     bool isSDCardPresent() { return sdCardPresent; }
     uint32_t getDetectionsLogged() { return detectionsLogged; }
+    void setSdTiming(PerfHistogram* hist) { sdTiming = hist; }
 
     // Data management
     void addDetection(String ssid, String mac, int8_t rssi, String type);
+    void updateProximity(const String& mac, int8_t rssi, RssiPhase phase);
     void clearDetections();
+
+    // Warm restart (warm_snapshot.h): threat log, detection list and stats.
+    // Restore returns the entries kept; other boards' sections are ignored.
+    void saveSnapshot(SnapshotWriter& w, uint32_t now);
+    uint16_t restoreSnapshot(SnapshotReader& r, uint8_t version, uint16_t count, uint32_t base);
     uint32_t getDetectionCount() { return totalDetections; }
     uint32_t getFlockCount() { return flockDetections; }
     uint32_t getBLECount() { return bleDetections; }
 
     // Status displays
-    void showAlert(String message, uint16_t color = TFT_RED);
+    // Toasts: queued and drawn over the page for durationMs, never blocking
+    void showAlert(String message, uint16_t color = TFT_RED, ToastPriority priority = TOAST_ALERT,
+                   uint32_t durationMs = TOAST_DEFAULT_MS);
     void showInfo(String message);
     void updateChannelInfo(uint8_t channel);
     void updateScanMode(bool isBLE);
     void updateScanStatus(bool isScanning);
     void showDebugSSID(String ssid, int8_t rssi, uint8_t channel);
     void showDebugBLE(String name, String mac, int8_t rssi);
-
-    // LED control
-    void setLEDScanning();
-    void setLEDDetection(int8_t rssi);
-    void setLEDAlert();
-    void setLEDOff();
 };
 
 // Global instance
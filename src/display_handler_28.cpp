@@ -11,6 +11,8 @@
 #ifdef CYD_DISPLAY
 
 #include "display_handler_28.h"
+#include "trace_ring.h"
+#include "status_led.h"
 #include <SPI.h>
 
 // Global instance
@@ -31,30 +33,78 @@ void onBrightnessMax() { display.setBrightness(255); }
 void onSoundVolumeMax() { display.setSoundVolume(255); }
 void onRgbBrightnessMax() { display.setRgbBrightness(255); }
 void onCalibratePress() { display.setPage(DisplayHandler::PAGE_CALIBRATE); }
-void onCalibrateSave() {
-    if (display.saveCalibration()) {
-        display.setPage(DisplayHandler::PAGE_MAIN);
-    }
-}
 void onLedAlertToggle() { display.toggleLedAlerts(); }
 void onSoundToggle() { display.toggleSound(); }
 void onSoundVolumeUp() { display.increaseSoundVolume(); }
 void onSoundVolumeDown() { display.decreaseSoundVolume(); }
 
+// Every touch target, by page. CALIBRATE hit-tests its own buttons on raw
+// coordinates (see handleCalibrationTouch). At most 32 zones (grid bitmasks).
+#define PAGES_ALL      0x0F
+#define PAGE_BIT(p)    (1 << DisplayHandler::p)
+#define NAV_X(i)       (NAV_BUTTON_GAP + (i) * (NAV_BUTTON_W + NAV_BUTTON_GAP))
+#define NAV_Y          (240 - FOOTER_HEIGHT + 3)
+#define CLR_X          ((320 - CLEAR_BUTTON_W) / 2)
+#define CLR_Y          (240 - FOOTER_HEIGHT - CLEAR_BUTTON_H - 5)
+#define CFG_PLUS_X     (CFG_MINUS_X + CFG_BUTTON_W + 4)
+#define CFG_MAXB_X     (CFG_PLUS_X + CFG_BUTTON_W + 4)
+#define CFG_Y(row)     (CFG_ROW_Y + (row) * CFG_ROW_H)
+#define CFG_ROW_ZONES(row, toggle, down, up, max, l0, l1, l2, l3) \
+    { CFG_TOGGLE_X, CFG_Y(row), CFG_TOGGLE_X + CFG_TOGGLE_W, CFG_Y(row) + CFG_BUTTON_H, PAGE_BIT(PAGE_SETTINGS), toggle, l0 }, \
+    { CFG_MINUS_X, CFG_Y(row), CFG_MINUS_X + CFG_BUTTON_W, CFG_Y(row) + CFG_BUTTON_H, PAGE_BIT(PAGE_SETTINGS), down, l1 }, \
+    { CFG_PLUS_X, CFG_Y(row), CFG_PLUS_X + CFG_BUTTON_W, CFG_Y(row) + CFG_BUTTON_H, PAGE_BIT(PAGE_SETTINGS), up, l2 }, \
+    { CFG_MAXB_X, CFG_Y(row), CFG_MAXB_X + CFG_MAX_W, CFG_Y(row) + CFG_BUTTON_H, PAGE_BIT(PAGE_SETTINGS), max, l3 }
+
+static const TouchZone touchZones[] = {
+    { NAV_X(0), NAV_Y, NAV_X(0) + NAV_BUTTON_W, 240, PAGES_ALL, onMainButtonPress, "HOME" },
+    { NAV_X(1), NAV_Y, NAV_X(1) + NAV_BUTTON_W, 240, PAGES_ALL, onListButtonPress, "LIST" },
+    { NAV_X(2), NAV_Y, NAV_X(2) + NAV_BUTTON_W, 240, PAGES_ALL, onStatsButtonPress, "STATS" },
+    { NAV_X(3), NAV_Y, NAV_X(3) + NAV_BUTTON_W, 240, PAGES_ALL, onSettingsButtonPress, "CONFIG" },
+    { CLR_X, CLR_Y, CLR_X + CLEAR_BUTTON_W, CLR_Y + CLEAR_BUTTON_H, PAGE_BIT(PAGE_STATS), onClearButtonPress, "CLR" },
+    CFG_ROW_ZONES(0, onAutoBrightnessToggle, onBrightnessDown, onBrightnessUp, onBrightnessMax, "AUTO", "BR-", "BR+", "BRMAX"),
+    CFG_ROW_ZONES(1, onSoundToggle, onSoundVolumeDown, onSoundVolumeUp, onSoundVolumeMax, "SND", "SND-", "SND+", "SNDMAX"),
+    CFG_ROW_ZONES(2, onLedAlertToggle, onRgbBrightnessDown, onRgbBrightnessUp, onRgbBrightnessMax, "LED", "RGB-", "RGB+", "RGBMAX"),
+    { (320 - CFG_CAL_W) / 2, CFG_CAL_Y, (320 + CFG_CAL_W) / 2, CFG_CAL_Y + CFG_CAL_H, PAGE_BIT(PAGE_SETTINGS), onCalibratePress, "CAL" },
+};
+static const uint8_t TOUCH_ZONE_COUNT = sizeof(touchZones) / sizeof(touchZones[0]);
+static_assert(sizeof(touchZones) / sizeof(touchZones[0]) <= 32, "touch grid cells are 32-bit zone masks");
+
+// Pen interrupt -> touch task
+static TaskHandle_t touchTaskHandle = nullptr;
+
+static void IRAM_ATTR touchIsr() {
+    BaseType_t woken = pdFALSE;
+    if (touchTaskHandle) vTaskNotifyGiveFromISR(touchTaskHandle, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
 DisplayHandler::DisplayHandler() : tft(), touchSPI(HSPI) {
     needsRedraw = true;
     lastUpdate = 0;
     currentPage = PAGE_MAIN;
     brightness = 255;  // Start at 100%
+    awake = true;
+    lastInput = 0;
     totalDetections = 0;
     flockDetections = 0;
     bleDetections = 0;
-    lastTouchTime = 0;
-    touchDebounce = false;
+    touchEvents = nullptr;
+    memset(touchGrid, 0, sizeof(touchGrid));
+    listScroll = 0;
+    detail.dev = nullptr;
+    detailLaidOut = false;
+    detailHead = 0;
+    detailNewest = RSSI_HIST_NONE;
+    detailFold = 0;
+    overlayId = 0;
+    overlayStep = 0;
+    overlayDirty = false;
     currentChannel = 1;
     bleScanning = false;
     sdCardPresent = false;
+    vendorIndex = nullptr;
     detectionsLogged = 0;
+    sdTiming = nullptr;
     lastSdCheck = 0;
     pendingLogCount = 0;
     lastFlushTime = 0;
@@ -73,7 +123,7 @@ DisplayHandler::DisplayHandler() : tft(), touchSPI(HSPI) {
     calStep = 0;
 }
 
-bool DisplayHandler::begin() {
+bool DisplayHandler::begin(bool fastBoot) {
     // Setup backlight with PWM for brightness control
     setupBacklightPWM();
 
@@ -88,6 +138,16 @@ bool DisplayHandler::begin() {
     pinMode(TOUCH_IRQ, INPUT);  // GPIO36 is input-only, no pullup
     touchSPI.begin(TOUCH_CLK, TOUCH_MISO, TOUCH_MOSI, TOUCH_CS);
 
+    // Touch reader: woken by the pen interrupt (IRQ goes LOW on contact).
+    // Priority above loop() so a tap is read while loop() is busy.
+    buildTouchGrid();
+    touchEvents = xQueueCreate(TOUCH_QUEUE_LEN, sizeof(TouchEvent));
+    if (touchEvents && xTaskCreatePinnedToCore(touchTaskEntry, "touch", 3072, this, 2, &touchTaskHandle, 1) == pdPASS) {
+        attachInterrupt(digitalPinToInterrupt(TOUCH_IRQ), touchIsr, FALLING);
+    } else {
+        Serial.println("Touch: failed to start the touch task");
+    }
+
     // Generate session ID
     sessionId = esp_random();
 
@@ -98,6 +158,7 @@ bool DisplayHandler::begin() {
     if (sdCardPresent) {
         loadSettings();
     }
+    applyLedSettings();
 
     // Initialize LDR for auto brightness
     pinMode(LDR_PIN, INPUT);
@@ -105,9 +166,28 @@ bool DisplayHandler::begin() {
     // Initialize speaker
     setupSpeaker();
 
-    // Play boot tone
-    playBootTone();
+    // Boot tone and splash (about 4 s); a fast boot goes straight to the UI
+    if (!fastBoot) {
+        playBootTone();
+        showBootSplash();
+    }
+
+    // Try to load calibration from SD card
+    if (sdCardPresent && loadCalibration()) {
+        // Calibration loaded, go to main page
+        Serial.println("Touch calibration loaded from SD card");
+        currentPage = PAGE_MAIN;
+        clear();
+    } else {
+        // No calibration file, start in calibration mode
+        Serial.println("No calibration file, starting calibration");
+        currentPage = PAGE_CALIBRATE;
+        startCalibration();
+    }
+    return true;
+}
 
+void DisplayHandler::showBootSplash() {
     // === STREAMLINED BOOT SCREEN ===
     tft.fillScreen(BG_COLOR);
 
@@ -211,20 +291,6 @@ bool DisplayHandler::begin() {
     tft.print("Looking for surveillance devices...");
 
     delay(500);
-
-    // Try to load calibration from SD card
-    if (sdCardPresent && loadCalibration()) {
-        // Calibration loaded, go to main page
-        Serial.println("Touch calibration loaded from SD card");
-        currentPage = PAGE_MAIN;
-        clear();
-    } else {
-        // No calibration file, start in calibration mode
-        Serial.println("No calibration file, starting calibration");
-        currentPage = PAGE_CALIBRATE;
-        startCalibration();
-    }
-    return true;
 }
 
 void DisplayHandler::update() {
@@ -241,36 +307,43 @@ void DisplayHandler::update() {
     // Update auto brightness if enabled
     updateAutoBrightness();
 
-    // Calibration mode has special touch handling - no UI interference
-    if (currentPage == PAGE_CALIBRATE) {
-        if (digitalRead(TOUCH_IRQ) == LOW && !touchDebounce) {
-            handleCalibrationTouch();
-            touchDebounce = true;
-            lastTouchTime = now;
-        }
-        if (touchDebounce && (now - lastTouchTime > 300)) {
-            touchDebounce = false;
+    // Gestures from the touch task; the first one only wakes a sleeping display
+    TouchEvent ev;
+    while (touchEvents && xQueueReceive(touchEvents, &ev, 0) == pdTRUE) {
+        lastInput = now;
+        if (!awake) {
+            setAwake(true);
+            continue;
         }
-        return;  // Skip normal UI updates in calibration mode
+        handleGesture(ev);
     }
+    if (!awake) return;
 
-    // Check for touch input using IRQ (GPIO36 goes LOW when touched)
-    if (digitalRead(TOUCH_IRQ) == LOW && !touchDebounce) {
-        handleTouch();
-        touchDebounce = true;
-        lastTouchTime = now;
+    // Calibration mode has special touch handling - no UI interference
+    if (currentPage == PAGE_CALIBRATE) {
+        drawOverlay(now);
+        return;  // Skip normal UI updates in calibration mode
     }
 
-    // Reset touch debounce after 200ms
-    if (touchDebounce && (now - lastTouchTime > 200)) {
-        touchDebounce = false;
+    // Device detail: no periodic full redraw, frames append to the sparklines.
+    // Nothing is drawn under a toast; taking it down redraws the page.
+    if (currentPage == PAGE_DETAIL) {
+        if (needsRedraw) {
+            drawHeader();
+            drawStatusBar();
+            drawFooter();
+            detailLaidOut = false;
+            needsRedraw = false;
+            lastUpdate = now;
+            overlayDirty = true;
+        }
+        if (!overlayId) drawDetailPage(now);
+        drawOverlay(now);
+        return;
     }
 
     // Update display if needed
     if (needsRedraw || (now - lastUpdate > 1000)) {
-        // Clear touch zones at start of redraw cycle
-        clearTouchZones();
-
         // Note: Don't clear content area - each draw function fills its own background
         // This prevents screen flashing on updates
 
@@ -286,7 +359,7 @@ void DisplayHandler::update() {
             }
         }
 
-        // Then draw page content (may add additional touch zones)
+        // Then draw page content
         switch (currentPage) {
             case PAGE_MAIN:
                 drawMainPage();
@@ -306,11 +379,15 @@ void DisplayHandler::update() {
 
         needsRedraw = false;
         lastUpdate = now;
+        overlayDirty = true;
     }
+
+    drawOverlay(now);
 }
 
 void DisplayHandler::clear() {
     tft.fillScreen(BG_COLOR);
+    overlayDirty = true;
 }
 
 void DisplayHandler::drawHeader() {
@@ -392,6 +469,9 @@ void DisplayHandler::drawStatusBar() {
     } else if (currentPage == PAGE_SETTINGS) {
         bgColor = SUCCESS_COLOR;
         statusText = "Config";
+    } else if (currentPage == PAGE_DETAIL) {
+        bgColor = SUCCESS_COLOR;
+        statusText = "Device Detail";
     } else {
         return;  // No status bar for calibration page
     }
@@ -470,15 +550,13 @@ void DisplayHandler::drawFooter() {
     // Draw footer background (black)
     tft.fillRect(0, y, tft.width(), FOOTER_HEIGHT, FOOTER_COLOR);
 
-    // Draw navigation buttons (4 buttons)
-    uint16_t buttonWidth = 78;
-    uint16_t padding = 2;
-    uint16_t startX = 2;
+    // Draw navigation buttons (4 buttons, touch zones 0-3)
+    uint16_t buttonWidth = NAV_BUTTON_W;
+    uint16_t padding = NAV_BUTTON_GAP;
+    uint16_t startX = NAV_BUTTON_GAP;
 
     // Button labels: HOME, LIST, STATS, CONFIG
     const char* labels[] = {"HOME", "LIST", "STATS", "CONFIG"};
-    void (*callbacks[])() = {onMainButtonPress, onListButtonPress, onStatsButtonPress,
-                             onSettingsButtonPress};
 
     for (int i = 0; i < 4; i++) {
         uint16_t x = startX + i * (buttonWidth + padding);
@@ -486,7 +564,7 @@ void DisplayHandler::drawFooter() {
         uint16_t btnH = FOOTER_HEIGHT - 6;
 
         // Determine button style
-        bool isActive = (i == currentPage);
+        bool isActive = (i == currentPage) || (i == PAGE_LIST && currentPage == PAGE_DETAIL);
         uint16_t bgColor = isActive ? BUTTON_ACTIVE : BG_COLOR;
         uint16_t borderColor = BUTTON_BORDER;
         uint16_t textColor = TEXT_COLOR;
@@ -503,9 +581,6 @@ void DisplayHandler::drawFooter() {
         int16_t textY = btnY + (btnH - 8) / 2;
         tft.setCursor(textX, textY);
         tft.print(labels[i]);
-
-        // Touch zone
-        addTouchZone(x, btnY, x + buttonWidth, tft.height(), callbacks[i], labels[i]);
     }
 }
 
@@ -567,6 +642,13 @@ void DisplayHandler::drawMainPage() {
         tft.printf("%ddBm ", latestDetection->rssi);
         drawSignalStrength(100, yStart + 78, latestDetection->rssi);
 
+        // Drive-by phase from the proximity filter
+        tft.setTextColor(TEXT_DIM);
+        tft.setCursor(20, yStart + 95);
+        tft.print("Range: ");
+        tft.setTextColor(latestDetection->phase == RSSI_PHASE_APPROACHING ? ALERT_COLOR : TEXT_COLOR);
+        tft.print(rssi_phase_name((RssiPhase)latestDetection->phase));
+
     } else if (!detections.empty() && latestDetection != nullptr) {
         // === STATE 2: SCANNING with recent detection ===
         tft.fillRect(10, yStart + 5, 300, contentHeight - 10, PANEL_COLOR);
@@ -608,6 +690,9 @@ void DisplayHandler::drawMainPage() {
         tft.setCursor(180, yStart + 80);
         tft.printf("Total: %d", totalDetections);
 
+        tft.setCursor(20, yStart + 95);
+        tft.printf("Range: %s", rssi_phase_name((RssiPhase)latestDetection->phase));
+
     } else {
         // === STATE 1: NO DETECTIONS ===
         tft.fillRect(10, yStart + 10, 300, contentHeight - 20, PANEL_COLOR);
@@ -628,10 +713,8 @@ void DisplayHandler::drawMainPage() {
 void DisplayHandler::drawListPage() {
     // Start below status bar - no LED row on this page, so more room
     uint16_t yPos = HEADER_HEIGHT + STATUS_BAR_HEIGHT + 2;
-    // Calculate available list height (extends to just above footer)
-    uint16_t listBottom = 240 - FOOTER_HEIGHT - 14;  // Leave room for count
-    uint16_t listHeight = listBottom - yPos;
-    uint16_t maxItems = listHeight / LIST_ITEM_HEIGHT;
+    // Available list height extends to just above the count line
+    uint16_t maxItems = LIST_VISIBLE_ROWS;
 
     tft.setTextSize(1);
 
@@ -645,11 +728,7 @@ void DisplayHandler::drawListPage() {
         return;
     }
 
-    // Calculate starting index for pagination (show newest first)
-    uint16_t startIdx = 0;
-    if (detections.size() > maxItems) {
-        startIdx = detections.size() - maxItems;
-    }
+    uint16_t startIdx = listStart();
 
     // Draw detection list
     for (size_t i = startIdx; i < detections.size() && i < startIdx + maxItems; i++) {
@@ -694,15 +773,139 @@ void DisplayHandler::drawListPage() {
         yPos += LIST_ITEM_HEIGHT;
     }
 
-    // Show count at bottom (just above footer)
+    // Show count at bottom (just above footer); the range when scrolled back
+    size_t shown = min((size_t)maxItems, detections.size());
+    tft.fillRect(0, 240 - FOOTER_HEIGHT - 13, 320, 10, BG_COLOR);
     tft.setTextColor(TEXT_DIM);
     tft.setCursor(5, 240 - FOOTER_HEIGHT - 12);
     tft.print("Showing ");
-    tft.print(min((size_t)maxItems, detections.size()));
+    if (startIdx + shown < detections.size()) {
+        tft.printf("%u-%u", startIdx + 1, (unsigned)(startIdx + shown));
+    } else {
+        tft.print(shown);
+    }
     tft.print(" of ");
     tft.print(detections.size());
 }
 
+// Colour of drawSignalStrength()'s bars for a level; panel grey for an
+// empty history bucket
+static uint16_t signalColor(int8_t rssi) {
+    if (rssi == RSSI_HIST_NONE) return PANEL_COLOR;
+    return rssi >= -60 ? SUCCESS_COLOR : (rssi >= -80 ? WARNING_COLOR : ALERT_COLOR);
+}
+
+// Device detail: what the list row shows, the filter's live numbers and two
+// sparklines. LIVE is the last 32 s as a sweep: the column of a new second
+// overwrites the one 32 s older and the newest is drawn white, so a frame
+// draws a column or two instead of the strip. HIST is the whole 6 min of
+// rssi_history (16 s, 4 s and 1 s buckets, marked off) and is redrawn when
+// its mid ring moves, every 4 s.
+void DisplayHandler::drawDetailPage(uint32_t now) {
+    const TrackedDevice* dev = detail.dev;
+
+    if (!detailLaidOut) {
+        int16_t top = HEADER_HEIGHT + STATUS_BAR_HEIGHT;
+        tft.fillRect(0, top, 320, 240 - FOOTER_HEIGHT - top, BG_COLOR);
+        tft.setTextSize(1);
+        tft.setTextColor(TEXT_COLOR);
+        tft.setCursor(8, DETAIL_NAME_Y);
+        tft.print(detail.ssid.substring(0, 30));
+        tft.setTextColor(detail.vendor == "Flock Safety" ? ALERT_COLOR : ACCENT_COLOR);
+        tft.setCursor(200, DETAIL_NAME_Y);
+        tft.print(detail.vendor.substring(0, 19));
+        tft.setTextColor(TEXT_DIM);
+        tft.setCursor(8, DETAIL_NAME_Y + 11);
+        tft.print(detail.mac);
+        tft.setCursor(200, DETAIL_NAME_Y + 11);
+        tft.print(detail.type.substring(0, 19));
+        tft.setCursor(5, DETAIL_LIVE_Y + 12);
+        tft.print("LIVE");
+        tft.setCursor(5, DETAIL_LIVE_Y + 24);
+        tft.print("32 s");
+        tft.setCursor(5, DETAIL_HIST_Y + 10);
+        tft.print("HIST");
+        tft.setCursor(5, DETAIL_HIST_Y + 22);
+        tft.print("6 min");
+        if (!dev) {
+            tft.setCursor(DETAIL_SPARK_X, DETAIL_LIVE_Y + 18);
+            tft.print("No history: listed before the restart");
+        }
+        detailLaidOut = true;
+        detailHead = 0;
+        detailFold = 0;
+    }
+    if (!dev) return;
+
+    RssiHistory hist;
+    if (!dev->history.copyTo(hist)) return;   // Writer busy: next frame
+    hist.advance(now);
+    if (hist.empty()) return;
+    uint32_t newest = hist.newest();
+    int8_t value = hist.fineBucket(newest);
+    bool newSecond = newest + 1 != detailHead;
+
+    if (newSecond || value != detailNewest) {
+        // The previous newest column (plain now, and it may have changed in
+        // its last moments), the seconds since, and the newest highlighted.
+        // Unsigned wrap is harmless: buckets before the first are empty and
+        // the ring position is the same modulo RSSI_HIST_FINE.
+        uint32_t count = detailHead && newest + 1 - detailHead < RSSI_HIST_FINE ?
+                         newest + 2 - detailHead : RSSI_HIST_FINE;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t n = newest - (count - 1) + i;
+            int8_t v = hist.fineBucket(n);
+            drawSparkColumn(DETAIL_SPARK_X + (n % RSSI_HIST_FINE) * DETAIL_LIVE_COL, DETAIL_LIVE_Y,
+                            DETAIL_LIVE_COL - 2, DETAIL_LIVE_H, v, n == newest ? TEXT_COLOR : signalColor(v));
+        }
+        detailHead = newest + 1;
+        detailNewest = value;
+    }
+
+    uint32_t fold = newest / RSSI_HIST_FOLD + 1;
+    if (fold != detailFold) {
+        int8_t series[RSSI_HIST_SAMPLES];
+        hist.series(series);
+        for (uint8_t i = 0; i < RSSI_HIST_SAMPLES; i++) {
+            drawSparkColumn(DETAIL_SPARK_X + i * DETAIL_HIST_COL, DETAIL_HIST_Y,
+                            DETAIL_HIST_COL - 1, DETAIL_HIST_H, series[i], signalColor(series[i]));
+        }
+        // Resolution changes between the coarse, mid and fine buckets
+        tft.drawFastVLine(DETAIL_SPARK_X + RSSI_HIST_COARSE * DETAIL_HIST_COL - 1, DETAIL_HIST_Y,
+                          DETAIL_HIST_H, TEXT_DIM);
+        tft.drawFastVLine(DETAIL_SPARK_X + (RSSI_HIST_COARSE + RSSI_HIST_MID) * DETAIL_HIST_COL - 1,
+                          DETAIL_HIST_Y, DETAIL_HIST_H, TEXT_DIM);
+        detailFold = fold;
+    }
+
+    if (!newSecond) return;
+    int8_t level = dev->track.levelDbm();
+    int16_t rate = dev->track.rateDeciDbPerS();
+    tft.fillRect(0, DETAIL_STATS_Y - 1, 320, 10, BG_COLOR);
+    tft.setTextSize(1);
+    tft.setCursor(8, DETAIL_STATS_Y);
+    tft.setTextColor(signalColor(level));
+    tft.printf("%ddBm", level);
+    tft.setTextColor(TEXT_COLOR);
+    tft.printf(" %c%d.%ddB/s  peak %d  %u hits  ", rate < 0 ? '-' : '+', abs(rate) / 10, abs(rate) % 10,
+               dev->rssi_max, dev->hit_count);
+    tft.setTextColor(dev->track.phase == RSSI_PHASE_APPROACHING ? ALERT_COLOR : TEXT_DIM);
+    tft.print(rssi_phase_name((RssiPhase)dev->track.phase));
+}
+
+// Bar from the bottom of an x, y, w, h column, scaled between
+// DETAIL_RSSI_FLOOR and DETAIL_RSSI_CEIL; an empty bucket is a baseline
+void DisplayHandler::drawSparkColumn(int16_t x, int16_t y, int16_t w, int16_t h, int8_t rssi, uint16_t color) {
+    if (rssi == RSSI_HIST_NONE) {
+        tft.fillRect(x, y, w, h - 1, BG_COLOR);
+        tft.drawFastHLine(x, y + h - 1, w, color);
+        return;
+    }
+    int16_t bar = map(constrain(rssi, DETAIL_RSSI_FLOOR, DETAIL_RSSI_CEIL), DETAIL_RSSI_FLOOR, DETAIL_RSSI_CEIL, 1, h);
+    if (bar < h) tft.fillRect(x, y, w, h - bar, BG_COLOR);
+    tft.fillRect(x, y + h - bar, w, bar, color);
+}
+
 void DisplayHandler::drawStatsPage() {
     // Fill background for this page area
     uint16_t contentTop = HEADER_HEIGHT + STATUS_BAR_HEIGHT;
@@ -776,7 +979,7 @@ void DisplayHandler::drawStatsPage() {
     }
 
     // Clear button - positioned at bottom with proper spacing
-    uint16_t clrW = 100, clrH = 28;
+    uint16_t clrW = CLEAR_BUTTON_W, clrH = CLEAR_BUTTON_H;
     uint16_t clrX = (320 - clrW) / 2;  // Center horizontally
     uint16_t clrY = contentBottom - clrH - 5;  // 5px above footer
     tft.fillRect(clrX, clrY, clrW, clrH, 0x4000);  // Dark red
@@ -786,7 +989,6 @@ void DisplayHandler::drawStatsPage() {
     // "CLEAR" is 5 chars * 12px = 60px, center in 100px button: (100-60)/2 = 20
     tft.setCursor(clrX + 20, clrY + 6);
     tft.print("CLEAR");
-    addTouchZone(clrX, clrY, clrX + clrW, clrY + clrH, onClearButtonPress, "CLR");
 }
 
 void DisplayHandler::drawSettingsPage() {
@@ -832,7 +1034,10 @@ void DisplayHandler::drawSettingsPage() {
         }
 
         tft.setCursor(120, yPos + 18);
-        if (SD.exists(OUI_FILE)) {
+        if (vendorIndex) {
+            tft.setTextColor(SUCCESS_COLOR);
+            tft.print("oui:FLASH");
+        } else if (SD.exists(OUI_FILE)) {
             tft.setTextColor(SUCCESS_COLOR);
             tft.print("oui: OK");
         } else {
@@ -849,14 +1054,15 @@ void DisplayHandler::drawSettingsPage() {
         tft.print("SD Card not present - Insert for logging");
     }
 
-    yPos += sdPanelH + 8;
+    // Control rows and CALIBRATE sit where the touch zone table expects them
+    yPos = CFG_ROW_Y;
 
     // Control row dimensions
-    uint16_t rowH = 28;
-    uint16_t toggleW = 44;
-    uint16_t btnW = 32;
-    uint16_t btnH = 24;
-    uint16_t maxW = 40;
+    uint16_t rowH = CFG_ROW_H;
+    uint16_t toggleW = CFG_TOGGLE_W;
+    uint16_t btnW = CFG_BUTTON_W;
+    uint16_t btnH = CFG_BUTTON_H;
+    uint16_t maxW = CFG_MAX_W;
 
     // === Row 1: Display Brightness ===
     uint16_t autoColor = autoBrightness ? SUCCESS_COLOR : TEXT_DIM;
@@ -866,7 +1072,6 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextSize(1);
     tft.setCursor(autoBrightness ? 9 : 12, yPos + 8);
     tft.print(autoBrightness ? "AUTO" : "MAN");
-    addTouchZone(5, yPos, 5 + toggleW, yPos + btnH, onAutoBrightnessToggle, "AUTO");
 
     tft.setTextColor(TEXT_COLOR);
     tft.setCursor(55, yPos + 8);
@@ -878,13 +1083,12 @@ void DisplayHandler::drawSettingsPage() {
     tft.setCursor(115, yPos + 4);
     tft.printf("%3d%%", pct);
 
-    uint16_t minusX = 175;
+    uint16_t minusX = CFG_MINUS_X;
     tft.fillRect(minusX, yPos, btnW, btnH, PANEL_COLOR);
     tft.drawRect(minusX, yPos, btnW, btnH, SLIDER_COLOR);
     tft.setTextColor(SLIDER_COLOR);
     tft.setCursor(minusX + 11, yPos + 4);
     tft.print("-");
-    addTouchZone(minusX, yPos, minusX + btnW, yPos + btnH, onBrightnessDown, "BR-");
 
     uint16_t plusX = minusX + btnW + 4;
     tft.fillRect(plusX, yPos, btnW, btnH, PANEL_COLOR);
@@ -892,7 +1096,6 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextColor(SLIDER_COLOR);
     tft.setCursor(plusX + 11, yPos + 4);
     tft.print("+");
-    addTouchZone(plusX, yPos, plusX + btnW, yPos + btnH, onBrightnessUp, "BR+");
 
     uint16_t maxX = plusX + btnW + 4;
     tft.fillRect(maxX, yPos, maxW, btnH, PANEL_COLOR);
@@ -901,7 +1104,6 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextSize(1);
     tft.setCursor(maxX + 8, yPos + 8);
     tft.print("MAX");
-    addTouchZone(maxX, yPos, maxX + maxW, yPos + btnH, onBrightnessMax, "BRMAX");
 
     yPos += rowH;
 
@@ -913,7 +1115,6 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextSize(1);
     tft.setCursor(soundEnabled ? 17 : 14, yPos + 8);
     tft.print(soundEnabled ? "ON" : "OFF");
-    addTouchZone(5, yPos, 5 + toggleW, yPos + btnH, onSoundToggle, "SND");
 
     tft.setTextColor(TEXT_COLOR);
     tft.setCursor(55, yPos + 8);
@@ -930,14 +1131,12 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextColor(ACCENT_COLOR);
     tft.setCursor(minusX + 11, yPos + 4);
     tft.print("-");
-    addTouchZone(minusX, yPos, minusX + btnW, yPos + btnH, onSoundVolumeDown, "SND-");
 
     tft.fillRect(plusX, yPos, btnW, btnH, PANEL_COLOR);
     tft.drawRect(plusX, yPos, btnW, btnH, ACCENT_COLOR);
     tft.setTextColor(ACCENT_COLOR);
     tft.setCursor(plusX + 11, yPos + 4);
     tft.print("+");
-    addTouchZone(plusX, yPos, plusX + btnW, yPos + btnH, onSoundVolumeUp, "SND+");
 
     tft.fillRect(maxX, yPos, maxW, btnH, PANEL_COLOR);
     tft.drawRect(maxX, yPos, maxW, btnH, ACCENT_COLOR);
@@ -945,7 +1144,6 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextSize(1);
     tft.setCursor(maxX + 8, yPos + 8);
     tft.print("MAX");
-    addTouchZone(maxX, yPos, maxX + maxW, yPos + btnH, onSoundVolumeMax, "SNDMAX");
 
     yPos += rowH;
 
@@ -957,7 +1155,6 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextSize(1);
     tft.setCursor(ledAlertsEnabled ? 17 : 14, yPos + 8);
     tft.print(ledAlertsEnabled ? "ON" : "OFF");
-    addTouchZone(5, yPos, 5 + toggleW, yPos + btnH, onLedAlertToggle, "LED");
 
     tft.setTextColor(TEXT_COLOR);
     tft.setCursor(55, yPos + 8);
@@ -974,14 +1171,12 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextColor(ALERT_WARN);
     tft.setCursor(minusX + 11, yPos + 4);
     tft.print("-");
-    addTouchZone(minusX, yPos, minusX + btnW, yPos + btnH, onRgbBrightnessDown, "RGB-");
 
     tft.fillRect(plusX, yPos, btnW, btnH, PANEL_COLOR);
     tft.drawRect(plusX, yPos, btnW, btnH, ALERT_WARN);
     tft.setTextColor(ALERT_WARN);
     tft.setCursor(plusX + 11, yPos + 4);
     tft.print("+");
-    addTouchZone(plusX, yPos, plusX + btnW, yPos + btnH, onRgbBrightnessUp, "RGB+");
 
     tft.fillRect(maxX, yPos, maxW, btnH, PANEL_COLOR);
     tft.drawRect(maxX, yPos, maxW, btnH, ALERT_WARN);
@@ -989,12 +1184,11 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextSize(1);
     tft.setCursor(maxX + 8, yPos + 8);
     tft.print("MAX");
-    addTouchZone(maxX, yPos, maxX + maxW, yPos + btnH, onRgbBrightnessMax, "RGBMAX");
 
-    yPos += rowH + 8;
+    yPos = CFG_CAL_Y;
 
     // === Large CALIBRATE button ===
-    uint16_t calBtnW = 180, calBtnH = 28;
+    uint16_t calBtnW = CFG_CAL_W, calBtnH = CFG_CAL_H;
     uint16_t calBtnX = (320 - calBtnW) / 2;
     tft.fillRect(calBtnX, yPos, calBtnW, calBtnH, 0x0320);
     tft.drawRect(calBtnX, yPos, calBtnW, calBtnH, LOGO_COLOR);
@@ -1002,7 +1196,6 @@ void DisplayHandler::drawSettingsPage() {
     tft.setTextSize(2);
     tft.setCursor(calBtnX + 28, yPos + 6);
     tft.print("CALIBRATE");
-    addTouchZone(calBtnX, yPos, calBtnX + calBtnW, yPos + calBtnH, onCalibratePress, "CAL");
 
     // Draw footer only
     drawFooter();
@@ -1020,6 +1213,7 @@ void DisplayHandler::startCalibration() {
 void DisplayHandler::drawCalibrationPage() {
     // FULL SCREEN calibration - no header/footer, targets at actual corners
     tft.fillScreen(BG_COLOR);
+    overlayDirty = true;
 
     // Target positions at actual screen corners
     uint16_t margin = 20;
@@ -1113,7 +1307,6 @@ void DisplayHandler::drawCalibrationPage() {
     tft.setTextSize(1);
     tft.setCursor(cancelX + 24, btnY + 10);
     tft.print("CANCEL");
-    addTouchZone(cancelX, btnY, cancelX + btnW, btnY + btnH, onSettingsButtonPress, "CANCEL");
 
     // SAVE button (right)
     uint16_t saveX = 175;
@@ -1123,7 +1316,6 @@ void DisplayHandler::drawCalibrationPage() {
         tft.setTextColor(TEXT_COLOR);
         tft.setCursor(saveX + 30, btnY + 10);
         tft.print("SAVE");
-        addTouchZone(saveX, btnY, saveX + btnW, btnY + btnH, onCalibrateSave, "SAVE");
     } else {
         tft.fillRect(saveX, btnY, btnW, btnH, PANEL_COLOR);
         tft.drawRect(saveX, btnY, btnW, btnH, TEXT_DIM);
@@ -1143,16 +1335,8 @@ void DisplayHandler::processCalibrationTouch(uint16_t rawX, uint16_t rawY) {
         if (calStep >= 4) {
             // All corners captured, validate
             if (!validateAndApplyCalibration()) {
-                // Invalid calibration, show error in center panel area
-                uint16_t panelX = 60, panelY = 105;
-                tft.fillRect(panelX, panelY, 200, 50, ALERT_COLOR);
-                tft.setTextColor(TEXT_COLOR);
-                tft.setTextSize(1);
-                tft.setCursor(panelX + 10, panelY + 10);
-                tft.print("Calibration invalid!");
-                tft.setCursor(panelX + 30, panelY + 28);
-                tft.print("Restarting...");
-                delay(2000);
+                // Invalid calibration: say so over the restarted page
+                showAlert("Invalid, restarting", ALERT_COLOR);
                 startCalibration();
                 return;
             }
@@ -1202,10 +1386,7 @@ bool DisplayHandler::validateAndApplyCalibration() {
     return true;
 }
 
-void DisplayHandler::handleCalibrationTouch() {
-    uint16_t rawX, rawY;
-    if (!readTouchRaw(rawX, rawY)) return;
-
+void DisplayHandler::handleCalibrationTouch(uint16_t rawX, uint16_t rawY) {
     // Calculate approximate screen position for button detection
     int16_t screenX = map(rawY, touchRawYMin, touchRawYMax, 0, 319);
     int16_t screenY = map(rawX, touchRawXMin, touchRawXMax, 0, 239);
@@ -1341,38 +1522,161 @@ void DisplayHandler::mapTouchToScreen(uint16_t rawX, uint16_t rawY, int16_t &scr
     screenY = constrain(screenY, 0, 239);
 }
 
-void DisplayHandler::handleTouch() {
-    uint16_t rawX, rawY;
-    if (!readTouchRaw(rawX, rawY)) return;
+void DisplayHandler::touchTaskEntry(void* self) {
+    static_cast<DisplayHandler*>(self)->touchReader();
+}
+
+// Touch task: sleeps until the pen interrupt, then samples every
+// TOUCH_SAMPLE_MS until TOUCH_RELEASE_SAMPLES reads in a row miss, and
+// queues one gesture for update(). A contact gone after TOUCH_DEBOUNCE_MS
+// (bounce, or the GPIO36 glitches the ESP32 is known for) is ignored.
+// PENIRQ also drops during conversions, so edges seen while sampling are
+// discarded once the touch ends.
+void DisplayHandler::touchReader() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(TOUCH_DEBOUNCE_MS));
+
+        TouchEvent ev;
+        if (readTouchRaw(ev.rawX, ev.rawY)) {
+            mapTouchToScreen(ev.rawX, ev.rawY, ev.x, ev.y);
+            uint32_t downAt = millis();
+            int16_t x = ev.x, y = ev.y;
+            bool moved = false, longSent = false;
+            uint8_t misses = 0;
+
+            while (misses < TOUCH_RELEASE_SAMPLES) {
+                vTaskDelay(pdMS_TO_TICKS(TOUCH_SAMPLE_MS));
+                uint16_t rawX, rawY;
+                if (!readTouchRaw(rawX, rawY)) {
+                    misses++;
+                    continue;
+                }
+                misses = 0;
+                mapTouchToScreen(rawX, rawY, x, y);
+                if (abs(x - ev.x) > TOUCH_SLOP_PX || abs(y - ev.y) > TOUCH_SLOP_PX) moved = true;
+                if (!moved && !longSent && millis() - downAt >= TOUCH_LONG_PRESS_MS) {
+                    ev.gesture = TOUCH_LONG_PRESS;
+                    xQueueSend(touchEvents, &ev, 0);
+                    longSent = true;
+                }
+            }
+
+            int16_t dx = x - ev.x, dy = y - ev.y;
+            if (longSent) {
+                // Already reported
+            } else if (!moved) {
+                ev.gesture = TOUCH_TAP;
+                xQueueSend(touchEvents, &ev, 0);
+            } else if (abs(dx) >= TOUCH_SWIPE_PX || abs(dy) >= TOUCH_SWIPE_PX) {
+                if (abs(dx) >= abs(dy)) ev.gesture = dx < 0 ? TOUCH_SWIPE_LEFT : TOUCH_SWIPE_RIGHT;
+                else ev.gesture = dy < 0 ? TOUCH_SWIPE_UP : TOUCH_SWIPE_DOWN;
+                xQueueSend(touchEvents, &ev, 0);
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, 0);
+    }
+}
+
+// One bitmask of touchZones[] indices per grid cell and page, for every zone
+// overlapping the cell. Built once; a tap then checks the one or two zones
+// of its cell instead of the whole table.
+void DisplayHandler::buildTouchGrid() {
+    memset(touchGrid, 0, sizeof(touchGrid));
+    for (uint8_t i = 0; i < TOUCH_ZONE_COUNT; i++) {
+        const TouchZone& z = touchZones[i];
+        uint8_t c1 = min(z.x2 / TOUCH_GRID_CELL, TOUCH_GRID_COLS - 1);
+        uint8_t r1 = min(z.y2 / TOUCH_GRID_CELL, TOUCH_GRID_ROWS - 1);
+        for (uint8_t page = 0; page < PAGE_ROTATION; page++) {
+            if (!(z.pages & (1 << page))) continue;
+            for (uint8_t r = z.y1 / TOUCH_GRID_CELL; r <= r1; r++) {
+                for (uint8_t c = z.x1 / TOUCH_GRID_CELL; c <= c1; c++) {
+                    touchGrid[page][r][c] |= 1UL << i;
+                }
+            }
+        }
+    }
+}
 
-    int16_t screenX, screenY;
-    mapTouchToScreen(rawX, rawY, screenX, screenY);
+const TouchZone* DisplayHandler::hitTest(int16_t x, int16_t y) {
+    uint8_t page = currentPage == PAGE_DETAIL ? (uint8_t)PAGE_LIST : currentPage;
+    if (page >= PAGE_ROTATION || x < 0 || y < 0 || x >= 320 || y >= 240) return nullptr;
+    uint32_t candidates = touchGrid[page][y / TOUCH_GRID_CELL][x / TOUCH_GRID_CELL];
+    while (candidates) {
+        const TouchZone& z = touchZones[__builtin_ctz(candidates)];
+        if (x >= z.x1 && x <= z.x2 && y >= z.y1 && y <= z.y2) return &z;
+        candidates &= candidates - 1;
+    }
+    return nullptr;
+}
+
+// Taps and long presses press the zone under the finger; a tap on a list
+// row opens its detail view and a long press on the list jumps back to the
+// newest entries. Horizontal swipes change page, vertical swipes scroll the
+// list a page at a time.
+void DisplayHandler::handleGesture(const TouchEvent& ev) {
+    if (currentPage == PAGE_CALIBRATE) {
+        if (ev.gesture == TOUCH_TAP || ev.gesture == TOUCH_LONG_PRESS) {
+            handleCalibrationTouch(ev.rawX, ev.rawY);
+        }
+        return;
+    }
 
-    // Check touch zones
-    for (auto& zone : touchZones) {
-        if (screenX >= zone.x1 && screenX <= zone.x2 &&
-            screenY >= zone.y1 && screenY <= zone.y2) {
-            if (zone.callback) {
-                zone.callback();
+    const TouchZone* zone;
+    switch (ev.gesture) {
+        case TOUCH_LONG_PRESS:
+            if (currentPage == PAGE_LIST && !hitTest(ev.x, ev.y)) {
+                scrollList(0);
+                break;
+            }
+            // fall through
+        case TOUCH_TAP:
+            zone = hitTest(ev.x, ev.y);
+            if (zone && zone->callback) {
+                zone->callback();
+            } else if (!zone && currentPage == PAGE_LIST) {
+                int row = listRowAt(ev.y);
+                if (row >= 0) openDetail(detections[row]);
             }
             break;
-        }
+        case TOUCH_SWIPE_LEFT:
+            nextPage();
+            break;
+        case TOUCH_SWIPE_RIGHT:
+            previousPage();
+            break;
+        case TOUCH_SWIPE_DOWN:
+            if (currentPage == PAGE_LIST) scrollList(1);   // Older entries, above
+            break;
+        case TOUCH_SWIPE_UP:
+            if (currentPage == PAGE_LIST) scrollList(-1);
+            break;
     }
+    needsRedraw = true;
+}
+
+// pages > 0 scrolls back towards older entries, < 0 forward, 0 to the newest
+void DisplayHandler::scrollList(int16_t pages) {
+    uint16_t maxItems = LIST_VISIBLE_ROWS;
+    int32_t limit = detections.size() > maxItems ? (int32_t)(detections.size() - maxItems) : 0;
+    int32_t scroll = pages ? (int32_t)listScroll + pages * (maxItems - 1) : 0;
+    listScroll = constrain(scroll, 0, limit);
 }
 
-void DisplayHandler::addTouchZone(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, void (*callback)(), const char* label) {
-    TouchZone zone;
-    zone.x1 = x1;
-    zone.y1 = y1;
-    zone.x2 = x2;
-    zone.y2 = y2;
-    zone.callback = callback;
-    zone.label = label;
-    touchZones.push_back(zone);
+// First entry on the LIST page: newest at the bottom, scrolled back by listScroll
+size_t DisplayHandler::listStart() {
+    size_t maxItems = LIST_VISIBLE_ROWS;
+    if (detections.size() <= maxItems) return 0;
+    size_t start = detections.size() - maxItems;
+    return start - min((size_t)listScroll, start);
 }
 
-void DisplayHandler::clearTouchZones() {
-    touchZones.clear();
+// Index of the LIST entry drawn at screen row y, or -1
+int DisplayHandler::listRowAt(int16_t y) {
+    int16_t top = HEADER_HEIGHT + STATUS_BAR_HEIGHT + 2;
+    if (y < top || (y - top) / LIST_ITEM_HEIGHT >= LIST_VISIBLE_ROWS) return -1;
+    size_t i = listStart() + (y - top) / LIST_ITEM_HEIGHT;
+    return i < detections.size() ? (int)i : -1;
 }
 
 // ============================================================================
@@ -1448,20 +1752,22 @@ String DisplayHandler::lookupOUIFromSD(const String& prefix) {
     while (low < high) {
         size_t mid = (low + high) / 2;
 
-        // Seek to mid and find start of line
-        file.seek(mid);
+        // Find the first line starting at or after mid
         if (mid > 0) {
-            // Skip to next line
+            file.seek(mid - 1);
             while (file.available() && file.read() != '\n');
+        } else {
+            file.seek(0);
         }
 
-        if (!file.available()) {
+        // No line starts in [mid, high): search below mid
+        size_t lineStart = file.position();
+        if (!file.available() || lineStart >= high) {
             high = mid;
             continue;
         }
 
         // Read line
-        size_t lineStart = file.position();
         int len = file.readBytesUntil('\n', lineBuf, sizeof(lineBuf) - 1);
         if (len <= 0) {
             high = mid;
@@ -1488,7 +1794,7 @@ String DisplayHandler::lookupOUIFromSD(const String& prefix) {
             }
             break;
         } else if (cmp < 0) {
-            high = lineStart;
+            high = mid;  // Nothing else starts in [mid, lineStart)
         } else {
             low = file.position();
         }
@@ -1498,7 +1804,7 @@ String DisplayHandler::lookupOUIFromSD(const String& prefix) {
     return result;
 }
 
-// Main OUI lookup: embedded first, then SD card fallback
+// Main OUI lookup: embedded first, then flash index, then SD card fallback
 String DisplayHandler::lookupOUI(const String& mac) {
     // Extract prefix (first 8 chars: "aa:bb:cc")
     if (mac.length() < 8) return "Unknown";
@@ -1508,6 +1814,15 @@ String DisplayHandler::lookupOUI(const String& mac) {
     const char* embedded = lookupEmbeddedOUI(prefix.c_str());
     if (embedded) return String(embedded);
 
+    // Flash-mapped IEEE table (microseconds, no SD access)
+    unsigned int oui[3];
+    if (vendorIndex && sscanf(prefix.c_str(), "%2x:%2x:%2x", &oui[0], &oui[1], &oui[2]) == 3) {
+        uint8_t bytes[3] = { (uint8_t)oui[0], (uint8_t)oui[1], (uint8_t)oui[2] };
+        const char* vendor = vendorIndex->vendor(bytes);
+        if (vendor) return String(vendor);
+        return "Unknown";  // Index is the full table: SD has nothing more
+    }
+
     // Try SD card lookup (slower but comprehensive)
     String sdResult = lookupOUIFromSD(prefix);
     if (sdResult.length() > 0) return sdResult;
@@ -1523,7 +1838,9 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
     det.rssi = rssi;
     det.type = type;
     det.timestamp = millis();
+    det.phase = RSSI_PHASE_IDLE;
     det.isNew = true;
+    det.dev = dev;
 
     detections.push_back(det);
 
@@ -1565,6 +1882,7 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
         log.avg_probe_interval = dev->probe_intervals > 0 ?
             dev->probe_interval_sum / dev->probe_intervals : 0;
         log.channel = dev->last_channel;
+        log.fix = dev->best_fix;
     } else {
         log.rssi_min = rssi;
         log.rssi_max = rssi;
@@ -1572,11 +1890,72 @@ void DisplayHandler::addDetection(String ssid, String mac, int8_t rssi, String t
         log.hit_count = 1;
         log.avg_probe_interval = 0;
         log.channel = 0;
+        log.fix = GpsTag();
     }
 
     queueLog(log);
 
+    // The detail view keeps its own pace (drawDetailPage)
+    if (currentPage != PAGE_DETAIL) needsRedraw = true;
+}
+
+// Proximity event for an already listed device: filtered level and phase
+void DisplayHandler::updateProximity(const String& mac, int8_t rssi, RssiPhase phase) {
+    for (auto it = detections.rbegin(); it != detections.rend(); ++it) {
+        if (it->mac == mac) {
+            it->rssi = rssi;
+            it->phase = phase;
+            if (currentPage != PAGE_DETAIL) needsRedraw = true;
+            return;
+        }
+    }
+}
+
+// Counters, then the list newest first so a full snapshot drops the oldest
+void DisplayHandler::saveSnapshot(SnapshotWriter& w, uint32_t now) {
+    w.beginSection(SNAP_SEC_DISPLAY, DISPLAY_SNAPSHOT_VERSION);
+    w.put32(totalDetections);
+    w.put32(flockDetections);
+    w.put32(bleDetections);
+    w.endRecord();
+    for (auto it = detections.rbegin(); it != detections.rend(); ++it) {
+        w.putStr(it->ssid.c_str());
+        w.putStr(it->mac.c_str());
+        w.putStr(it->vendor.c_str());
+        w.putStr(it->type.c_str());
+        w.put8((uint8_t)it->rssi);
+        w.put8(it->phase);
+        w.put32(now - it->timestamp);
+        w.endRecord();
+    }
+    w.endSection();
+}
+
+uint16_t DisplayHandler::restoreSnapshot(SnapshotReader& r, uint8_t version, uint16_t count, uint32_t base) {
+    if (version != DISPLAY_SNAPSHOT_VERSION || count == 0) return 0;
+    totalDetections = r.get32();
+    flockDetections = r.get32();
+    bleDetections = r.get32();
+
+    std::vector<Detection> restored;
+    char buf[40];
+    for (uint16_t i = 1; i < count; i++) {
+        Detection det;
+        r.getStr(buf, sizeof(buf)); det.ssid = buf;
+        r.getStr(buf, sizeof(buf)); det.mac = buf;
+        r.getStr(buf, sizeof(buf)); det.vendor = buf;
+        r.getStr(buf, sizeof(buf)); det.type = buf;
+        det.rssi = (int8_t)r.get8();
+        det.phase = r.get8();
+        det.timestamp = base - r.get32();
+        det.isNew = false;
+        det.dev = nullptr;   // Tracking records are restored separately, unlinked
+        if (!r.ok()) break;
+        restored.push_back(det);
+    }
+    detections.assign(restored.rbegin(), restored.rend());
     needsRedraw = true;
+    return restored.size();
 }
 
 void DisplayHandler::clearDetections() {
@@ -1584,28 +1963,59 @@ void DisplayHandler::clearDetections() {
     totalDetections = 0;
     flockDetections = 0;
     bleDetections = 0;
+    listScroll = 0;
     clear();
 }
 
-void DisplayHandler::showAlert(String message, uint16_t color) {
-    tft.fillRect(10, tft.height() / 2 - 25, tft.width() - 20, 50, color);
-    tft.drawRect(10, tft.height() / 2 - 25, tft.width() - 20, 50, TEXT_COLOR);
-
-    tft.setTextColor(TEXT_COLOR);
-    tft.setTextSize(2);
-    tft.setCursor(tft.width() / 2 - message.length() * 6, tft.height() / 2 - 8);
-    tft.print(message);
-
-    delay(2000);
-    needsRedraw = true;
+void DisplayHandler::showAlert(String message, uint16_t color, ToastPriority priority, uint32_t durationMs) {
+    toasts.post(message.c_str(), color, priority, durationMs, millis());
 }
 
 void DisplayHandler::showInfo(String message) {
-    showAlert(message, INFO_COLOR);
+    showAlert(message, INFO_COLOR, TOAST_INFO);
+}
+
+// Toast box across the middle of the screen, revealed from the centre out
+// over a few frames. Drawn again only when the toast, its reveal step or the
+// page under it changed; when the last toast goes its box is cleared and the
+// page redrawn.
+void DisplayHandler::drawOverlay(uint32_t now) {
+    const int16_t boxX = 10, boxY = tft.height() / 2 - 25;
+    const int16_t boxW = tft.width() - 20, boxH = 50;
+
+    const Toast* t = toasts.frame(now);
+    if (!t) {
+        if (overlayId) {
+            overlayId = 0;
+            tft.fillRect(boxX, boxY, boxW, boxH, BG_COLOR);
+            if (currentPage == PAGE_CALIBRATE) drawCalibrationPage();
+            else needsRedraw = true;
+        }
+        return;
+    }
+
+    uint8_t step = toasts.revealStep(*t, now);
+    if (t->id == overlayId && step == overlayStep && !overlayDirty) return;
+    overlayId = t->id;
+    overlayStep = step;
+    overlayDirty = false;
+
+    int16_t w = boxW * step / TOAST_ANIM_STEPS;
+    tft.fillRect(boxX + (boxW - w) / 2, boxY, w, boxH, t->color);
+    if (step < TOAST_ANIM_STEPS) return;
+
+    tft.drawRect(boxX, boxY, boxW, boxH, TEXT_COLOR);
+    size_t len = strlen(t->text);
+    uint8_t size = len * 12 <= (size_t)boxW - 12 ? 2 : 1;
+    tft.setTextColor(TEXT_COLOR);
+    tft.setTextSize(size);
+    tft.setCursor(boxX + (boxW - (int16_t)len * 6 * size) / 2, boxY + (boxH - 8 * size) / 2);
+    tft.print(t->text);
 }
 
 void DisplayHandler::setPage(DisplayPage page) {
     currentPage = page;
+    needsRedraw = true;
     clear();
     // Calibration page needs special setup
     if (page == PAGE_CALIBRATE) {
@@ -1613,16 +2023,34 @@ void DisplayHandler::setPage(DisplayPage page) {
     }
 }
 
+// Device detail sits under LIST: next goes on from LIST, previous back to it
 void DisplayHandler::nextPage() {
-    currentPage = (DisplayPage)((currentPage + 1) % 4);  // 4 main pages (0-3)
+    uint8_t from = currentPage == PAGE_DETAIL ? (uint8_t)PAGE_LIST : currentPage;
+    currentPage = (DisplayPage)((from + 1) % PAGE_ROTATION);
     clear();
 }
 
 void DisplayHandler::previousPage() {
-    currentPage = (DisplayPage)((currentPage + 3) % 4);  // 4 main pages (0-3)
+    if (currentPage == PAGE_DETAIL) currentPage = PAGE_LIST;
+    else currentPage = (DisplayPage)((currentPage + PAGE_ROTATION - 1) % PAGE_ROTATION);
     clear();
 }
 
+bool DisplayHandler::showDetail(const String& mac) {
+    for (auto it = detections.rbegin(); it != detections.rend(); ++it) {
+        if (it->mac == mac) {
+            openDetail(*it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DisplayHandler::openDetail(const Detection& det) {
+    detail = det;
+    setPage(PAGE_DETAIL);
+}
+
 void DisplayHandler::setupBacklightPWM() {
     // Use LEDC for backlight PWM
     // Both backlight pins must be driven together
@@ -1636,8 +2064,22 @@ void DisplayHandler::setupBacklightPWM() {
 }
 
 void DisplayHandler::applyBrightness() {
-    ledcWrite(3, brightness);  // Channel 3 = GPIO 27
-    ledcWrite(4, brightness);  // Channel 4 = GPIO 21
+    uint8_t level = awake ? brightness : 0;
+    ledcWrite(3, level);  // Channel 3 = GPIO 27
+    ledcWrite(4, level);  // Channel 4 = GPIO 21
+}
+
+void DisplayHandler::setAwake(bool on) {
+    if (!on && currentPage == PAGE_CALIBRATE) return;
+    if (on == awake) return;
+    awake = on;
+    applyBrightness();
+    if (on) needsRedraw = true;
+}
+
+void DisplayHandler::applyLedSettings() {
+    status_led.setScale(rgbBrightness);
+    status_led.setEnabled(ledAlertsEnabled);
 }
 
 void DisplayHandler::setBrightness(uint8_t level) {
@@ -1708,6 +2150,7 @@ void DisplayHandler::updateAutoBrightness() {
 // === RGB Brightness Control ===
 void DisplayHandler::setRgbBrightness(uint8_t level) {
     rgbBrightness = level;
+    applyLedSettings();
     saveSettings();
     needsRedraw = true;
 }
@@ -1718,6 +2161,7 @@ void DisplayHandler::increaseRgbBrightness() {
     } else {
         rgbBrightness = 255;
     }
+    applyLedSettings();
     saveSettings();
     needsRedraw = true;
 }
@@ -1728,12 +2172,14 @@ void DisplayHandler::decreaseRgbBrightness() {
     } else {
         rgbBrightness = 25;  // Minimum 10%
     }
+    applyLedSettings();
     saveSettings();
     needsRedraw = true;
 }
 
 void DisplayHandler::toggleLedAlerts() {
     ledAlertsEnabled = !ledAlertsEnabled;
+    applyLedSettings();
     saveSettings();
     needsRedraw = true;
 }
@@ -1758,15 +2204,7 @@ bool DisplayHandler::initSDCard() {
     // Create log filename with timestamp placeholder
     logFileName = "/flockyou_detections.csv";
 
-    // Check if file exists, if not create with header
-    if (!SD.exists(logFileName)) {
-        File file = SD.open(logFileName, FILE_WRITE);
-        if (file) {
-            file.println("timestamp,session,ssid,mac,vendor,rssi,type,rssi_min,rssi_max,rssi_avg,hits,probe_interval,channel");
-            file.close();
-            Serial.println("SD Card: Created log file");
-        }
-    }
+    prepareLogFile();
 
     // Write session start marker
     {
@@ -1812,13 +2250,7 @@ void DisplayHandler::checkSDCard() {
                 Serial.println("SD Card: Inserted");
 
                 // Re-setup log file if needed
-                if (!SD.exists(logFileName)) {
-                    File file = SD.open(logFileName, FILE_WRITE);
-                    if (file) {
-                        file.println("timestamp,session,ssid,mac,vendor,rssi,type,rssi_min,rssi_max,rssi_avg,hits,probe_interval,channel");
-                        file.close();
-                    }
-                }
+                prepareLogFile();
             }
         }
     }
@@ -1830,6 +2262,33 @@ void DisplayHandler::checkSDCard() {
     }
 }
 
+// Create the log with LOG_HEADER. A log written with an older column set is
+// renamed aside first so no file mixes two layouts.
+void DisplayHandler::prepareLogFile() {
+    if (SD.exists(logFileName)) {
+        File file = SD.open(logFileName, FILE_READ);
+        String header = file ? file.readStringUntil('\n') : String(LOG_HEADER);
+        if (file) file.close();
+        header.trim();
+        if (header == LOG_HEADER) return;
+
+        char aside[40];
+        for (int i = 1; i < 100; i++) {
+            snprintf(aside, sizeof(aside), "/flockyou_detections_old%d.csv", i);
+            if (!SD.exists(aside)) break;
+        }
+        if (!SD.rename(logFileName, aside)) return;
+        Serial.printf("SD Card: Old log layout, moved to %s\n", aside);
+    }
+
+    File file = SD.open(logFileName, FILE_WRITE);
+    if (file) {
+        file.println(LOG_HEADER);
+        file.close();
+        Serial.println("SD Card: Created log file");
+    }
+}
+
 void DisplayHandler::queueLog(const LogEntry& entry) {
     if (pendingLogCount < MAX_PENDING_LOGS) {
         pendingLogs[pendingLogCount++] = entry;
@@ -1843,21 +2302,31 @@ void DisplayHandler::flushLogs() {
         return;
     }
 
+    uint32_t started = micros();
+    TRACE_BEGIN_ARG(TRACE_SD_FLUSH, pendingLogCount);
     File file = SD.open(logFileName, FILE_APPEND);
     if (file) {
         for (uint8_t i = 0; i < pendingLogCount; i++) {
             LogEntry& e = pendingLogs[i];
-            file.printf("%lu,%u,\"%s\",%s,\"%s\",%d,%s,%d,%d,%d,%u,%u,%u\n",
+            // lat,lon,utc: empty when the sighting had no position / no GPS time
+            char where[40] = ",,";
+            if (e.fix.valid) {
+                int n = snprintf(where, sizeof(where), "%.7f,%.7f,", e.fix.lat_e7 * 1e-7, e.fix.lon_e7 * 1e-7);
+                if (e.fix.utc) snprintf(where + n, sizeof(where) - n, "%u", e.fix.utc);
+            }
+            file.printf("%lu,%u,\"%s\",%s,\"%s\",%d,%s,%d,%d,%d,%u,%u,%u,%s\n",
                 e.timestamp, sessionId,
                 e.ssid, e.mac, e.vendor,
                 e.rssi, e.type,
                 e.rssi_min, e.rssi_max, e.rssi_avg,
-                e.hit_count, e.avg_probe_interval, e.channel);
+                e.hit_count, e.avg_probe_interval, e.channel, where);
         }
         file.close();
         detectionsLogged += pendingLogCount;
         pendingLogCount = 0;
     }
+    TRACE_END(TRACE_SD_FLUSH);
+    if (sdTiming) sdTiming->record(micros() - started);
     lastFlushTime = millis();
 }
 
@@ -3,7 +3,14 @@
  * @brief Touchscreen UI for ESP32-2432S028R (2.8" ILI9341 320x240)
  *
  * Provides 5-page navigation (HOME, LIST, STAT, CONF, CAL), touch calibration
- * with SD card persistence, and brightness controls.
+ * with SD card persistence, and brightness controls. Tapping a LIST row
+ * opens a device detail view with its RSSI history (rssi_history.h).
+ *
+ * Touch is read by a small task woken by the XPT2046 pen interrupt: it
+ * samples the HSPI touch bus (no display mutex needed) until release and
+ * queues one gesture (tap, long press, swipe). update() drains the queue
+ * and hit-tests taps against a per-page zone grid built once in begin(), so
+ * redraws no longer rebuild touch zones.
  *
  * Hardware notes:
  * - Display on VSPI (SCK=14, MOSI=13, MISO=12, CS=15)
@@ -22,6 +29,13 @@
 #include <FS.h>
 #include <vector>
 #include <string>
+#include "flash_index.h"
+#include "nmea_parser.h"
+#include "rssi_track.h"
+#include "tracked_device.h"
+#include "warm_snapshot.h"
+#include "perf_registry.h"
+#include "toast_queue.h"
 
 // SD Card
 #define SD_CS 5
@@ -42,6 +56,7 @@
 #define TOUCH_CAL_FILE "/touch_cal.txt"
 #define SETTINGS_FILE "/settings.txt"
 #define OUI_FILE "/oui.csv"
+#define LOG_HEADER "timestamp,session,ssid,mac,vendor,rssi,type,rssi_min,rssi_max,rssi_avg,hits,probe_interval,channel,lat,lon,utc"
 
 // Modern dark theme color scheme (RGB565)
 #define BG_COLOR       0x0000          // Pure black background
@@ -66,23 +81,6 @@
 #define INFO_COLOR    ACCENT_COLOR
 #define WARNING_COLOR ALERT_WARN
 
-// TrackedDevice struct shared with main.cpp
-struct TrackedDevice {
-    uint32_t mac_hash;           // FNV-1a hash (0 = empty slot)
-    uint8_t  mac[6];             // Full MAC for display/logging
-    int8_t   rssi_min;           // Weakest signal seen
-    int8_t   rssi_max;           // Strongest signal seen
-    int8_t   rssi_last;          // Most recent RSSI
-    int32_t  rssi_sum;           // Running sum for average
-    uint16_t hit_count;          // Total detections
-    uint8_t  last_channel;       // Channel last seen on
-    uint8_t  type;               // Last detection type
-    uint32_t first_seen;         // millis() of first detection
-    uint32_t last_seen;          // millis() of most recent detection
-    uint32_t probe_interval_sum; // Sum of inter-detection intervals (ms)
-    uint16_t probe_intervals;    // Count of intervals measured
-};
-
 // Buffered log entry for async SD writing
 struct LogEntry {
     uint32_t timestamp;
@@ -98,36 +96,117 @@ struct LogEntry {
     uint16_t hit_count;
     uint16_t avg_probe_interval;
     uint8_t channel;
+    GpsTag fix;              // Best-RSSI sighting position, if any
 };
 
+#define DISPLAY_SNAPSHOT_VERSION 1  // SNAP_SEC_DISPLAY layout written by this handler
+
 // Display zones (adjusted for 320x240 with new layout)
 #define HEADER_HEIGHT     55           // Logo header area
 #define STATUS_BAR_HEIGHT 20           // Page status bar
 #define FOOTER_HEIGHT     33           // Nav buttons
 #define LED_STATUS_HEIGHT 22           // LED indicator row
 #define LIST_ITEM_HEIGHT  24
+#define LIST_VISIBLE_ROWS ((240 - FOOTER_HEIGHT - 14 - HEADER_HEIGHT - STATUS_BAR_HEIGHT - 2) / LIST_ITEM_HEIGHT)
+
+// Device detail: text rows, then two sparklines sharing a left edge
+#define DETAIL_NAME_Y     79           // Name/vendor row, MAC/type row 11px below
+#define DETAIL_STATS_Y    101          // Level, trend, peak, hits, phase
+#define DETAIL_SPARK_X    48           // Sparklines start here, labels to the left
+#define DETAIL_LIVE_Y     114          // Last 32 s, one column per fine bucket
+#define DETAIL_LIVE_H     42
+#define DETAIL_LIVE_COL   8            // RSSI_HIST_FINE columns, 2px apart
+#define DETAIL_HIST_Y     163          // Whole history, one column per bucket
+#define DETAIL_HIST_H     40
+#define DETAIL_HIST_COL   4            // RSSI_HIST_SAMPLES columns, 1px apart
+#define DETAIL_RSSI_FLOOR -100         // Bar scale: empty at the floor, full height at the ceiling
+#define DETAIL_RSSI_CEIL  -30
+
+// Touch targets: drawn by the page functions, hit-tested through the zone grid
+#define NAV_BUTTON_W      78           // Footer buttons, 2px apart
+#define NAV_BUTTON_GAP    2
+#define CLEAR_BUTTON_W    100          // STATS page CLEAR, centered above the footer
+#define CLEAR_BUTTON_H    28
+#define CFG_ROW_Y         66           // CONFIG: first control row (below the SD panel)
+#define CFG_ROW_H         28
+#define CFG_TOGGLE_X      5
+#define CFG_TOGGLE_W      44
+#define CFG_MINUS_X       175          // "-", "+" and "MAX", 4px apart
+#define CFG_BUTTON_W      32
+#define CFG_BUTTON_H      24
+#define CFG_MAX_W         40
+#define CFG_CAL_Y         (CFG_ROW_Y + 3 * CFG_ROW_H + 8)
+#define CFG_CAL_W         180
+#define CFG_CAL_H         28
+
+// Touch input
+#define TOUCH_GRID_CELL       40       // Hit-test grid: 8x6 cells of 40px
+#define TOUCH_GRID_COLS       (320 / TOUCH_GRID_CELL)
+#define TOUCH_GRID_ROWS       (240 / TOUCH_GRID_CELL)
+#define TOUCH_DEBOUNCE_MS     15       // Contact must still be there after this
+#define TOUCH_SAMPLE_MS       10       // Sampling period while pressed
+#define TOUCH_RELEASE_SAMPLES 3        // Missed samples that count as release
+#define TOUCH_LONG_PRESS_MS   600
+#define TOUCH_SLOP_PX         12       // Movement still counted as a press
+#define TOUCH_SWIPE_PX        40       // Minimum travel for a swipe
+#define TOUCH_QUEUE_LEN       4
 
-// Touch zones
 struct TouchZone {
     uint16_t x1, y1, x2, y2;
+    uint8_t pages;         // Bit per DisplayPage the zone is on
     void (*callback)();
     const char* label;
 };
 
+enum TouchGesture : uint8_t {
+    TOUCH_TAP = 0,
+    TOUCH_LONG_PRESS,      // Held in place; sent while still pressed, no tap follows
+    TOUCH_SWIPE_LEFT,
+    TOUCH_SWIPE_RIGHT,
+    TOUCH_SWIPE_UP,
+    TOUCH_SWIPE_DOWN,
+};
+
+struct TouchEvent {
+    TouchGesture gesture;
+    uint16_t rawX, rawY;   // At touch-down (calibration uses these)
+    int16_t x, y;          // Screen position at touch-down
+};
+
 class DisplayHandler {
+public:
+    enum DisplayPage {
+        PAGE_MAIN = 0,
+        PAGE_LIST,
+        PAGE_STATS,
+        PAGE_SETTINGS,
+        PAGE_CALIBRATE,
+        PAGE_DETAIL          // Under LIST: not in the swipe rotation, shares LIST's touch zones
+    };
+
+    // Pages in the swipe rotation (MAIN..SETTINGS), each with its own touch
+    // zones; CALIBRATE and DETAIL sit outside it
+    enum { PAGE_ROTATION = PAGE_SETTINGS + 1 };
+
 private:
     TFT_eSPI tft;
     SPIClass touchSPI;  // Separate HSPI for touch
 
-    // Touch reading
+    void showBootSplash();
+
+    // Touch reading (touch task only, after begin())
     bool readTouchRaw(uint16_t &rawX, uint16_t &rawY);
     void mapTouchToScreen(uint16_t rawX, uint16_t rawY, int16_t &screenX, int16_t &screenY);
+    static void touchTaskEntry(void* self);
+    void touchReader();
 
     // Display state
     bool needsRedraw;
     uint32_t lastUpdate;
     uint8_t currentPage;
     uint8_t brightness;
+    bool awake;               // Backlight off and nothing drawn while false (patrol mode)
+    uint32_t lastInput;       // millis() of the last touch gesture
 
     // Detection data
     struct Detection {
@@ -137,10 +216,13 @@ private:
         int8_t rssi;
         String type;
         uint32_t timestamp;
+        uint8_t phase;       // RssiPhase from the proximity filter
         bool isNew;
+        const TrackedDevice* dev;  // Its tracking record (nullptr: restored entry)
     };
 
     // OUI lookup
+    const FlashIndex* vendorIndex;  // Flash-mapped vendor table (nullptr: SD only)
     String lookupOUI(const String& mac);
     String lookupOUIFromSD(const String& prefix);
     static const char* lookupEmbeddedOUI(const char* prefix);
@@ -150,10 +232,25 @@ private:
     uint32_t flockDetections;
     uint32_t bleDetections;
 
-    // Touch handling
-    std::vector<TouchZone> touchZones;
-    uint32_t lastTouchTime;
-    bool touchDebounce;
+    // Touch handling: gestures from the touch task, zone bitmasks per grid cell
+    QueueHandle_t touchEvents;
+    uint32_t touchGrid[PAGE_ROTATION][TOUCH_GRID_ROWS][TOUCH_GRID_COLS];
+    uint16_t listScroll;  // LIST page: entries scrolled back from the newest
+
+    // Device detail (PAGE_DETAIL): laid out on a full redraw, then each frame
+    // appends the fine buckets that closed since the last one
+    Detection detail;        // A copy: the list it came from moves on
+    bool detailLaidOut;
+    uint32_t detailHead;     // Newest fine bucket drawn + 1 (0: none)
+    int8_t detailNewest;     // Its value as drawn
+    uint32_t detailFold;     // Mid bucket the history strip was drawn at + 1 (0: not drawn)
+
+    // Toast overlay, composited over the page by update()
+    ToastQueue toasts;
+    uint32_t overlayId;     // Toast on screen (0: none)
+    uint8_t overlayStep;    // Its reveal step as drawn
+    bool overlayDirty;      // Page drawn over it since
+    void drawOverlay(uint32_t now);
 
     // Scan state
     uint8_t currentChannel;
@@ -165,6 +262,7 @@ private:
     uint32_t lastSdCheck;
     void checkSDCard();
     uint32_t detectionsLogged;
+    PerfHistogram* sdTiming;  // Log flush durations (us), when set
 
     // Buffered logging
     static const int MAX_PENDING_LOGS = 16;
@@ -174,6 +272,7 @@ private:
     uint32_t sessionId;
     void queueLog(const LogEntry& entry);
     void flushLogs();
+    void prepareLogFile();
 
     // Brightness control (PWM)
     bool autoBrightness;
@@ -182,6 +281,7 @@ private:
     bool ledAlertsEnabled;  // LED alert toggle
     void setupBacklightPWM();
     void applyBrightness();
+    void applyLedSettings();  // RGB brightness and alert toggle to the status LED
     void updateAutoBrightness();
 
     // Sound control
@@ -213,26 +313,24 @@ private:
     void drawStatsPage();
     void drawSettingsPage();
     void drawCalibrationPage();
+    void drawDetailPage(uint32_t now);
+    void drawSparkColumn(int16_t x, int16_t y, int16_t w, int16_t h, int8_t rssi, uint16_t color);
 
     // UI widget helpers
-    void handleCalibrationTouch();
+    void handleCalibrationTouch(uint16_t rawX, uint16_t rawY);
     void drawProgressBar(uint16_t x, uint16_t y, uint16_t w, uint16_t h, float progress, uint16_t color);
     void drawSignalStrength(uint16_t x, uint16_t y, int8_t rssi);
-    void handleTouch();
-    void addTouchZone(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, void (*callback)(), const char* label);
-    void clearTouchZones();
+    void buildTouchGrid();
+    const TouchZone* hitTest(int16_t x, int16_t y);
+    void handleGesture(const TouchEvent& ev);
+    void scrollList(int16_t pages);
+    size_t listStart();
+    int listRowAt(int16_t y);
+    void openDetail(const Detection& det);
 
 public:
-    enum DisplayPage {
-        PAGE_MAIN = 0,
-        PAGE_LIST,
-        PAGE_STATS,
-        PAGE_SETTINGS,
-        PAGE_CALIBRATE
-    };
-
     DisplayHandler();
-    bool begin();
+    bool begin(bool fastBoot = false);   // fastBoot: no boot tone or splash
     void update();
     void clear();
     void setBrightness(uint8_t level);
@@ -248,6 +346,13 @@ public:
     void toggleLedAlerts();
     bool isLedAlertsEnabled() { return ledAlertsEnabled; }
 
+    // Patrol mode: asleep, the backlight is off and pages are not drawn. A
+    // touch wakes the display (the gesture itself is dropped); logs keep
+    // flushing. The calibration page never sleeps.
+    void setAwake(bool on);
+    bool isAwake() { return awake; }
+    uint32_t lastInputMs() { return lastInput; }
+
     // Sound control
     void toggleSound();
     bool isSoundEnabled() { return soundEnabled; }
@@ -260,11 +365,19 @@ public:
     bool initSDCard();
     bool isSDCardPresent() { return sdCardPresent; }
     uint32_t getDetectionsLogged() { return detectionsLogged; }
+    void setSdTiming(PerfHistogram* hist) { sdTiming = hist; }
     bool saveCalibration();
+    void setVendorIndex(const FlashIndex* index) { vendorIndex = index; }
 
     // Data management
     void addDetection(String ssid, String mac, int8_t rssi, String type, TrackedDevice* dev = nullptr);
+    void updateProximity(const String& mac, int8_t rssi, RssiPhase phase);
     void clearDetections();
+
+    // Warm restart (warm_snapshot.h): detection list and counters. Restore
+    // returns the entries kept; other boards' sections are ignored.
+    void saveSnapshot(SnapshotWriter& w, uint32_t now);
+    uint16_t restoreSnapshot(SnapshotReader& r, uint8_t version, uint16_t count, uint32_t base);
     uint32_t getDetectionCount() { return totalDetections; }
     uint32_t getFlockCount() { return flockDetections; }
     uint32_t getBLECount() { return bleDetections; }
@@ -273,10 +386,13 @@ public:
     void nextPage();
     void previousPage();
     void setPage(DisplayPage page);
+    bool showDetail(const String& mac);   // Detail view of the newest listed entry for mac
     DisplayPage getCurrentPage() { return (DisplayPage)currentPage; }
 
     // Status displays
-    void showAlert(String message, uint16_t color = TFT_RED);
+    // Toasts: queued and drawn over the page for durationMs, never blocking
+    void showAlert(String message, uint16_t color = TFT_RED, ToastPriority priority = TOAST_ALERT,
+                   uint32_t durationMs = TOAST_DEFAULT_MS);
     void showInfo(String message);
     void updateChannelInfo(uint8_t channel);
     void updateScanMode(bool isBLE);  // true = BLE scanning, false = WiFi
@@ -303,7 +419,6 @@ void onBrightnessMax();
 void onSoundVolumeMax();
 void onRgbBrightnessMax();
 void onCalibratePress();
-void onCalibrateSave();
 void onLedAlertToggle();
 void onSoundToggle();
 void onSoundVolumeUp();
@@ -0,0 +1,171 @@
+/**
+ * @file dwell_policy.cpp
+ * @brief Channel dwell policy implementations
+ *
+ * @see dwell_policy.h for the policy interface
+ */
+
+#include "dwell_policy.h"
+#include <math.h>
+#include <string.h>
+
+// ============================================================================
+// LADDER POLICY
+// ============================================================================
+
+void LadderDwellPolicy::noteDetection(uint8_t channel, uint32_t now) {
+    if (channel < 1 || channel > DWELL_MAX_CHANNEL) return;
+    if (detections[channel] < 255) detections[channel]++;
+    sticky_channel = channel;
+    sticky_until = now + config.sticky_ms;
+}
+
+uint32_t LadderDwellPolicy::dwellTime(uint8_t channel, uint16_t frames, uint32_t now) {
+    if (isSticky(channel, now)) return DWELL_HOLD;
+
+    uint32_t dwell = config.dwell_base;
+    if (frames >= config.high_threshold) {
+        dwell = config.dwell_high;
+    } else if (frames >= config.active_threshold) {
+        dwell = config.dwell_active;
+    }
+
+    // Bonus for channels with past detections
+    if (channel >= 1 && channel <= DWELL_MAX_CHANNEL && detections[channel] > 0) {
+        dwell += config.detection_bonus * detections[channel];
+        if (dwell > config.max_dwell) dwell = config.max_dwell;
+    }
+    return dwell;
+}
+
+uint8_t LadderDwellPolicy::nextChannel(const DwellVisit& visit, uint32_t now) {
+    (void)now;
+    uint8_t next = visit.channel + 1;
+    return next > DWELL_MAX_CHANNEL ? 1 : next;
+}
+
+uint8_t LadderDwellPolicy::saveState(float* out) const {
+    for (uint8_t c = 1; c <= DWELL_MAX_CHANNEL; c++) out[c - 1] = detections[c];
+    return DWELL_MAX_CHANNEL;
+}
+
+bool LadderDwellPolicy::loadState(const float* in, uint8_t count) {
+    if (count != DWELL_MAX_CHANNEL) return false;
+    for (uint8_t c = 1; c <= DWELL_MAX_CHANNEL; c++) {
+        float d = in[c - 1];
+        detections[c] = d >= 255 ? 255 : (d > 0 ? (uint8_t)d : 0);  // NaN fails both
+    }
+    return true;
+}
+
+// ============================================================================
+// BANDIT POLICY (UCB1, decaying statistics)
+// ============================================================================
+
+BanditDwellPolicy::BanditDwellPolicy(const DwellConfig& cfg) : DwellPolicy(cfg) {
+    memset(reward, 0, sizeof(reward));
+    memset(seconds, 0, sizeof(seconds));
+    for (int ch = 0; ch <= DWELL_MAX_CHANNEL; ch++) pending[ch] = 0;
+    total_seconds = 0;
+}
+
+void BanditDwellPolicy::noteDetection(uint8_t channel, uint32_t now) {
+    if (channel < 1 || channel > DWELL_MAX_CHANNEL) return;
+    pending[channel]++;
+    sticky_channel = channel;
+    sticky_until = now + config.sticky_ms;
+}
+
+float BanditDwellPolicy::channelYield(uint8_t channel) const {
+    if (channel < 1 || channel > DWELL_MAX_CHANNEL || seconds[channel] <= 0) return 0;
+    return reward[channel] / seconds[channel];
+}
+
+float BanditDwellPolicy::ucb(uint8_t channel, float log_total) const {
+    if (seconds[channel] < 0.05f) return 1e9f;  // Unvisited (or fully decayed) arm
+    return reward[channel] / seconds[channel] +
+           explore * sqrtf(log_total / seconds[channel]);
+}
+
+uint32_t BanditDwellPolicy::dwellTime(uint8_t channel, uint16_t frames, uint32_t now) {
+    (void)frames;
+    if (isSticky(channel, now)) return DWELL_HOLD;
+
+    // Scale dwell between base and max by this arm's yield relative to the best arm
+    float best = 0;
+    for (uint8_t ch = 1; ch <= DWELL_MAX_CHANNEL; ch++) {
+        float y = channelYield(ch);
+        if (y > best) best = y;
+    }
+    if (best <= 0) return config.dwell_base;
+
+    float rel = channelYield(channel) / best;
+    return config.dwell_base + (uint32_t)((config.dwell_active - config.dwell_base) * rel);
+}
+
+uint8_t BanditDwellPolicy::nextChannel(const DwellVisit& visit, uint32_t now) {
+    (void)now;
+    uint8_t ch = visit.channel;
+
+    // Decay every arm, then fold in the visit we just finished
+    total_seconds = 0;
+    for (uint8_t c = 1; c <= DWELL_MAX_CHANNEL; c++) {
+        reward[c] *= decay;
+        seconds[c] *= decay;
+    }
+    if (ch >= 1 && ch <= DWELL_MAX_CHANNEL) {
+        // A visit that produced any detection scores 1: a camera beaconing
+        // at 10 Hz shouldn't outweigh finding a second camera elsewhere
+        uint16_t det = pending[ch];
+        pending[ch] = 0;
+        reward[ch] += det ? 1.0f : 0.0f;
+        seconds[ch] += visit.dwell_ms / 1000.0f;
+    }
+    for (uint8_t c = 1; c <= DWELL_MAX_CHANNEL; c++) total_seconds += seconds[c];
+
+    // Pick the best upper confidence bound, never the channel we're leaving
+    float log_total = logf(total_seconds + 1.0f);
+    uint8_t best_ch = ch >= DWELL_MAX_CHANNEL ? 1 : ch + 1;
+    float best_score = -1;
+    for (uint8_t c = 1; c <= DWELL_MAX_CHANNEL; c++) {
+        if (c == ch) continue;
+        float score = ucb(c, log_total);
+        if (score > best_score) {
+            best_score = score;
+            best_ch = c;
+        }
+    }
+    return best_ch;
+}
+
+// Reward and seconds per arm; the totals are rebuilt on the next hop
+uint8_t BanditDwellPolicy::saveState(float* out) const {
+    for (uint8_t c = 1; c <= DWELL_MAX_CHANNEL; c++) {
+        out[c - 1] = reward[c];
+        out[DWELL_MAX_CHANNEL + c - 1] = seconds[c];
+    }
+    return 2 * DWELL_MAX_CHANNEL;
+}
+
+bool BanditDwellPolicy::loadState(const float* in, uint8_t count) {
+    if (count != 2 * DWELL_MAX_CHANNEL) return false;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!(in[i] >= 0 && in[i] < 1e6f)) return false;  // Also rejects NaN
+    }
+    total_seconds = 0;
+    for (uint8_t c = 1; c <= DWELL_MAX_CHANNEL; c++) {
+        reward[c] = in[c - 1];
+        seconds[c] = in[DWELL_MAX_CHANNEL + c - 1];
+        total_seconds += seconds[c];
+    }
+    return true;
+}
+
+// ============================================================================
+// FACTORY
+// ============================================================================
+
+DwellPolicy* dwell_policy_create(uint8_t kind, const DwellConfig& cfg) {
+    if (kind == DWELL_POLICY_BANDIT) return new BanditDwellPolicy(cfg);
+    return new LadderDwellPolicy(cfg);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file dwell_policy.h
+ * @brief Pluggable WiFi channel dwell policies
+ *
+ * hop_channel() asks the active policy how long to stay on the current
+ * channel and which channel to visit next. Two policies are provided:
+ *
+ * - LadderDwellPolicy: the original fixed threshold ladder (frame activity
+ *   thresholds, per-detection bonus, sticky window after a detection).
+ * - BanditDwellPolicy: UCB1 over channels, rewarding detection yield per
+ *   second of dwell. Statistics decay on every hop so the policy follows
+ *   the local channel mix instead of remembering a city from an hour ago.
+ *   Background frame counts are deliberately not rewarded: busy channels
+ *   are not where cameras live, and rewarding them starves 1/6/11.
+ *
+ * No Arduino dependencies — the same code runs in tools/dwell_sim.
+ */
+
+#ifndef DWELL_POLICY_H
+#define DWELL_POLICY_H
+
+#include <stdint.h>
+
+#define DWELL_MAX_CHANNEL 13
+
+// Defaults (ms). Previously #defines in main.cpp.
+#define CHANNEL_DWELL_BASE         200   // Fast sweep of quiet channels
+#define CHANNEL_DWELL_ACTIVE       800   // Stay longer on active channels
+#define CHANNEL_DWELL_HIGH        1500   // Stay longest on very active channels
+#define CHANNEL_ACTIVE_THRESHOLD     5   // Frames per dwell to count as active
+#define CHANNEL_HIGH_THRESHOLD      20   // Frames per dwell to count as very active
+#define CHANNEL_STICKY_DURATION   5000   // Stay put after a detection
+#define CHANNEL_DETECTION_BONUS    500   // Ladder: extra dwell per past detection
+#define CHANNEL_MAX_DWELL         3000   // Cap total dwell time
+
+// Bandit tuning
+#define BANDIT_DECAY             0.95f   // Per-hop decay of arm statistics
+#define BANDIT_EXPLORE           0.2f    // UCB exploration weight
+
+#define DWELL_POLICY_LADDER 0
+#define DWELL_POLICY_BANDIT 1
+
+#define DWELL_HOLD 0xFFFFFFFFu  // dwellTime() result: do not hop yet
+#define DWELL_STATE_MAX 32      // Floats of channel memory saveState() may write
+
+struct DwellConfig {
+    uint32_t dwell_base      = CHANNEL_DWELL_BASE;
+    uint32_t dwell_active    = CHANNEL_DWELL_ACTIVE;
+    uint32_t dwell_high      = CHANNEL_DWELL_HIGH;
+    uint16_t active_threshold = CHANNEL_ACTIVE_THRESHOLD;
+    uint16_t high_threshold   = CHANNEL_HIGH_THRESHOLD;
+    uint32_t sticky_ms       = CHANNEL_STICKY_DURATION;
+    uint32_t detection_bonus = CHANNEL_DETECTION_BONUS;
+    uint32_t max_dwell       = CHANNEL_MAX_DWELL;
+};
+
+// One completed stay on a channel, reported when leaving it
+struct DwellVisit {
+    uint8_t  channel;
+    uint32_t dwell_ms;
+    uint16_t frames;
+};
+
+class DwellPolicy {
+public:
+    explicit DwellPolicy(const DwellConfig& cfg) : config(cfg) {}
+    virtual ~DwellPolicy() {}
+
+    virtual const char* name() const = 0;
+
+    // Matched detection on a channel. Called from the processing task (Core 0).
+    virtual void noteDetection(uint8_t channel, uint32_t now) = 0;
+
+    // Total time to stay on `channel`, given frames seen so far in this visit.
+    // Returns DWELL_HOLD to stay regardless of elapsed time.
+    virtual uint32_t dwellTime(uint8_t channel, uint16_t frames, uint32_t now) = 0;
+
+    // Channel being left with its visit stats; returns the channel to tune next.
+    virtual uint8_t nextChannel(const DwellVisit& visit, uint32_t now) = 0;
+
+    // Channel memory for warm restarts (warm_snapshot.h): writes up to
+    // DWELL_STATE_MAX values and returns the count. loadState() ignores a
+    // count this policy did not write.
+    virtual uint8_t saveState(float* out) const = 0;
+    virtual bool loadState(const float* in, uint8_t count) = 0;
+
+    DwellConfig config;
+
+protected:
+    volatile uint32_t sticky_until = 0;
+    volatile uint8_t  sticky_channel = 0;
+    bool isSticky(uint8_t channel, uint32_t now) const {
+        return channel == sticky_channel && (int32_t)(sticky_until - now) > 0;
+    }
+};
+
+// Original behaviour: activity ladder + lifetime detection bonus, round-robin
+class LadderDwellPolicy : public DwellPolicy {
+public:
+    explicit LadderDwellPolicy(const DwellConfig& cfg) : DwellPolicy(cfg) {}
+    const char* name() const override { return "ladder"; }
+    void noteDetection(uint8_t channel, uint32_t now) override;
+    uint32_t dwellTime(uint8_t channel, uint16_t frames, uint32_t now) override;
+    uint8_t nextChannel(const DwellVisit& visit, uint32_t now) override;
+    uint8_t saveState(float* out) const override;
+    bool loadState(const float* in, uint8_t count) override;
+
+private:
+    uint8_t detections[DWELL_MAX_CHANNEL + 1] = {0};  // Lifetime, saturating
+};
+
+// UCB1 over channels with exponentially decaying reward statistics
+class BanditDwellPolicy : public DwellPolicy {
+public:
+    explicit BanditDwellPolicy(const DwellConfig& cfg);
+    const char* name() const override { return "bandit"; }
+    void noteDetection(uint8_t channel, uint32_t now) override;
+    uint32_t dwellTime(uint8_t channel, uint16_t frames, uint32_t now) override;
+    uint8_t nextChannel(const DwellVisit& visit, uint32_t now) override;
+    uint8_t saveState(float* out) const override;
+    bool loadState(const float* in, uint8_t count) override;
+
+    // Decayed mean reward (detections per second) for a channel, for telemetry
+    float channelYield(uint8_t channel) const;
+
+    float decay = BANDIT_DECAY;
+    float explore = BANDIT_EXPLORE;
+
+private:
+    // Per-arm decayed sums: reward mass and observed seconds
+    float reward[DWELL_MAX_CHANNEL + 1];
+    float seconds[DWELL_MAX_CHANNEL + 1];
+    float total_seconds;
+    volatile uint16_t pending[DWELL_MAX_CHANNEL + 1];  // Detections during current visit
+    float ucb(uint8_t channel, float log_total) const;
+};
+
+// Factory used by main.cpp and the simulator
+DwellPolicy* dwell_policy_create(uint8_t kind, const DwellConfig& cfg);
+
+#endif // DWELL_POLICY_H
@@ -0,0 +1,88 @@
+/**
+ * @file flash_index.cpp
+ * @brief Flash-mapped OUI vendor index
+ *
+ * @see flash_index.h for the binary layout
+ */
+
+#include "flash_index.h"
+#include <string.h>
+
+static uint16_t rd16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t rd32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+FlashIndex::FlashIndex() {
+    clear();
+}
+
+void FlashIndex::clear() {
+    image = nullptr;
+    image_len = 0;
+    build_time = 0;
+    keys = nullptr;
+    name_offsets = nullptr;
+    oui_count = 0;
+    names = nullptr;
+    names_len = 0;
+    pack = nullptr;
+    pack_len = 0;
+}
+
+SigPackStatus FlashIndex::attach(const uint8_t* img, size_t len, bool verify_crc) {
+    clear();
+    if (len < FLASH_INDEX_HEADER_SIZE) return SIGPACK_ERR_SIZE;
+    if (memcmp(img, FLASH_INDEX_MAGIC, 4) != 0) return SIGPACK_ERR_MAGIC;
+    if (rd16(img + 4) != FLASH_INDEX_FORMAT) return SIGPACK_ERR_FORMAT;
+
+    uint32_t count = rd32(img + 8);
+    uint32_t blob_len = rd32(img + 12);
+    uint32_t packed_len = rd32(img + 16);
+    uint32_t payload_len = rd32(img + 24);
+    if (payload_len > len - FLASH_INDEX_HEADER_SIZE) return SIGPACK_ERR_SIZE;
+    // Tables are read as native u32: keep them aligned and inside the payload
+    if (((uintptr_t)img & 3) || (blob_len & 3) || count > payload_len / 8 ||
+        (uint64_t)count * 8 + blob_len + packed_len != payload_len) {
+        return SIGPACK_ERR_SIZE;
+    }
+    if (verify_crc &&
+        sigpack_crc32(img + FLASH_INDEX_HEADER_SIZE, payload_len) != rd32(img + 28)) {
+        return SIGPACK_ERR_CRC;
+    }
+
+    const uint8_t* p = img + FLASH_INDEX_HEADER_SIZE;
+    keys = (const uint32_t*)p;
+    name_offsets = keys + count;
+    names = (const char*)(name_offsets + count);
+    // Every lookup returns a C string: the blob must end in NUL
+    if (count && (blob_len == 0 || memchr(names + blob_len - 4, 0, 4) == nullptr)) {
+        clear();
+        return SIGPACK_ERR_SECTION;
+    }
+
+    oui_count = count;
+    names_len = blob_len;
+    pack = (const uint8_t*)names + blob_len;
+    pack_len = packed_len;
+    build_time = rd32(img + 20);
+    image = img;
+    image_len = FLASH_INDEX_HEADER_SIZE + payload_len;
+    return SIGPACK_OK;
+}
+
+const char* FlashIndex::vendor(const uint8_t* mac) const {
+    uint32_t key = ((uint32_t)mac[0] << 16) | (mac[1] << 8) | mac[2];
+    uint32_t lo = 0, hi = oui_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t k = keys[mid];
+        if (k == key) {
+            uint32_t off = name_offsets[mid];
+            return off < names_len ? names + off : nullptr;
+        }
+        if (k < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return nullptr;
+}
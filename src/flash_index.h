@@ -0,0 +1,70 @@
+/**
+ * @file flash_index.h
+ * @brief Read-only OUI vendor + signature index mapped straight from flash
+ *
+ * Built on the host by tools/mkflashindex.py and written to the `fyindex`
+ * data partition (see partitions_cyd.csv). The firmware maps the partition
+ * with esp_partition_mmap and attaches this view to the mapped pointer, so
+ * lookups are binary searches through the flash cache: no filesystem, no
+ * heap copy, and no SD card required.
+ *
+ * Layout (little-endian, every table 4-byte aligned):
+ *
+ *   header   32 B  magic "FYIX", format, reserved, OUI count, names length,
+ *                  signature pack length, build time, payload length,
+ *                  CRC-32 of the payload
+ *   keys     count x u32   OUI as 0x00AABBCC, sorted
+ *   names    count x u32   offset of the vendor name in the name blob
+ *   blob     names_len B   NUL-terminated vendor names, deduplicated
+ *   pack     pack_len B    optional FYSP signature pack (see sigpack.h)
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef FLASH_INDEX_H
+#define FLASH_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sigpack.h"
+
+#define FLASH_INDEX_MAGIC       "FYIX"
+#define FLASH_INDEX_FORMAT      1
+#define FLASH_INDEX_HEADER_SIZE 32
+
+class FlashIndex {
+public:
+    FlashIndex();
+
+    // Validate and index an image. len may be the whole partition; only the
+    // header's payload length is read. verify_crc walks the full payload.
+    SigPackStatus attach(const uint8_t* image, size_t len, bool verify_crc);
+    void clear();
+
+    bool attached() const { return image != nullptr; }
+    uint32_t buildTime() const { return build_time; }
+    uint32_t ouiCount() const { return oui_count; }
+    size_t imageSize() const { return image_len; }
+
+    // Vendor for the first three octets of mac, or nullptr
+    const char* vendor(const uint8_t* mac) const;
+
+    // Embedded signature pack image (nullptr if the index carries none)
+    const uint8_t* packImage() const { return pack_len ? pack : nullptr; }
+    size_t packSize() const { return pack_len; }
+
+private:
+    const uint8_t* image;
+    size_t image_len;
+    uint32_t build_time;
+
+    const uint32_t* keys;
+    const uint32_t* name_offsets;
+    uint32_t oui_count;
+    const char* names;
+    uint32_t names_len;
+    const uint8_t* pack;
+    uint32_t pack_len;
+};
+
+#endif // FLASH_INDEX_H
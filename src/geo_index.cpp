@@ -0,0 +1,202 @@
+/**
+ * @file geo_index.cpp
+ * @brief Camera site grid index: cell hashing, block cache, radius queries
+ *
+ * @see geo_index.h for the binary layout
+ */
+
+#include "geo_index.h"
+#include <math.h>
+#include <string.h>
+
+#define GEO_M_PER_E7   0.0111319f   // Metres per 1e-7 degree of latitude
+#define GEO_READ_SITES 32           // Sites per read when filling the cache
+
+static uint16_t rd16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t rd32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+const char* geo_kind_name(uint8_t kind) {
+    switch (kind) {
+    case GEO_KIND_FLOCK:      return "flock";
+    case GEO_KIND_FS_BATTERY: return "fs_battery";
+    case GEO_KIND_PENGUIN:    return "penguin";
+    case GEO_KIND_PIGVISION:  return "pigvision";
+    case GEO_KIND_CAMERA:     return "camera";
+    }
+    return "unknown";
+}
+
+// Slot for a cell; must match tools/geoindex.py
+static uint32_t cell_hash(int32_t row, int32_t col) {
+    uint32_t h = (uint32_t)row * 0x9E3779B1u ^ (uint32_t)col * 0x85EBCA77u;
+    return h ^ (h >> 15);
+}
+
+static int32_t floor_div(int32_t a, int32_t b) {
+    int32_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+GeoIndex::GeoIndex() {
+    close();
+}
+
+void GeoIndex::close() {
+    read_fn = nullptr;
+    read_ctx = nullptr;
+    site_count = 0;
+    cell_count = 0;
+    slot_count = 0;
+    cell_lat_e7 = 1;
+    cell_lon_e7 = 1;
+    max_radius_m = 0;
+    build_time = 0;
+    cached = 0;
+    cache_valid = false;
+    cache_truncated = false;
+    cache_row = 0;
+    cache_col = 0;
+    block_loads = 0;
+    read_calls = 0;
+}
+
+bool GeoIndex::read(uint32_t offset, void* buf, uint32_t len) {
+    read_calls++;
+    return read_fn(read_ctx, offset, buf, len);
+}
+
+SigPackStatus GeoIndex::open(GeoReadFn fn, void* ctx, uint32_t file_len, bool verify_crc) {
+    close();
+    uint8_t hdr[GEO_INDEX_HEADER_SIZE];
+    if (file_len < GEO_INDEX_HEADER_SIZE || !fn(ctx, 0, hdr, sizeof(hdr))) return SIGPACK_ERR_SIZE;
+    if (memcmp(hdr, GEO_INDEX_MAGIC, 4) != 0) return SIGPACK_ERR_MAGIC;
+    if (rd16(hdr + 4) != GEO_INDEX_FORMAT) return SIGPACK_ERR_FORMAT;
+
+    uint32_t sites = rd32(hdr + 8);
+    uint32_t cells = rd32(hdr + 12);
+    uint32_t slots = rd32(hdr + 16);
+    int32_t cell_lat = (int32_t)rd32(hdr + 20);
+    int32_t cell_lon = (int32_t)rd32(hdr + 24);
+    uint32_t payload_len = rd32(hdr + 36);
+    if (payload_len != file_len - GEO_INDEX_HEADER_SIZE ||
+        (uint64_t)slots * GEO_SLOT_SIZE + (uint64_t)sites * GEO_SITE_SIZE != payload_len) {
+        return SIGPACK_ERR_SIZE;
+    }
+    if (slots == 0 || (slots & (slots - 1)) || cells > slots / 2 || cell_lat <= 0 || cell_lon <= 0) {
+        return SIGPACK_ERR_SECTION;
+    }
+
+    if (verify_crc) {
+        uint8_t chunk[256];
+        uint32_t crc = 0;
+        for (uint32_t off = 0; off < payload_len; off += sizeof(chunk)) {
+            uint32_t n = payload_len - off < sizeof(chunk) ? payload_len - off : sizeof(chunk);
+            if (!fn(ctx, GEO_INDEX_HEADER_SIZE + off, chunk, n)) return SIGPACK_ERR_SIZE;
+            crc = sigpack_crc32(chunk, n, crc);
+        }
+        if (crc != rd32(hdr + 40)) return SIGPACK_ERR_CRC;
+    }
+
+    read_fn = fn;
+    read_ctx = ctx;
+    site_count = sites;
+    cell_count = cells;
+    slot_count = slots;
+    cell_lat_e7 = cell_lat;
+    cell_lon_e7 = cell_lon;
+    max_radius_m = rd32(hdr + 28);
+    build_time = rd32(hdr + 32);
+    return SIGPACK_OK;
+}
+
+bool GeoIndex::findCell(int32_t row, int32_t col, uint32_t& first, uint32_t& count) {
+    uint32_t mask = slot_count - 1;
+    uint32_t slot = cell_hash(row, col) & mask;
+    for (uint32_t probe = 0; probe < GEO_MAX_PROBES; probe++) {
+        uint8_t rec[GEO_SLOT_SIZE];
+        if (!read(GEO_INDEX_HEADER_SIZE + slot * GEO_SLOT_SIZE, rec, sizeof(rec))) return false;
+        count = rd32(rec + 12);
+        if (count == 0) return true;  // Empty slot: cell has no sites
+        if ((int32_t)rd32(rec) == row && (int32_t)rd32(rec + 4) == col) {
+            first = rd32(rec + 8);
+            return first <= site_count && count <= site_count - first;
+        }
+        slot = (slot + 1) & mask;
+    }
+    count = 0;  // Table built at <= 50% load: a run this long means the cell is absent
+    return true;
+}
+
+bool GeoIndex::loadBlock(int32_t row, int32_t col) {
+    cached = 0;
+    cache_valid = false;
+    cache_truncated = false;
+    block_loads++;
+
+    uint32_t sites_base = GEO_INDEX_HEADER_SIZE + slot_count * GEO_SLOT_SIZE;
+    for (int dr = -1; dr <= 1; dr++) {
+        for (int dc = -1; dc <= 1; dc++) {
+            uint32_t first = 0, count = 0;
+            if (!findCell(row + dr, col + dc, first, count)) return false;
+            while (count > 0) {
+                if (cached == GEO_CACHE_SITES) {
+                    cache_truncated = true;
+                    break;
+                }
+                uint8_t buf[GEO_READ_SITES * GEO_SITE_SIZE];
+                uint32_t n = count < GEO_READ_SITES ? count : GEO_READ_SITES;
+                if (n > (uint32_t)(GEO_CACHE_SITES - cached)) n = GEO_CACHE_SITES - cached;
+                if (!read(sites_base + first * GEO_SITE_SIZE, buf, n * GEO_SITE_SIZE)) return false;
+                for (uint32_t i = 0; i < n; i++) {
+                    const uint8_t* rec = buf + i * GEO_SITE_SIZE;
+                    GeoSite& s = cache[cached++];
+                    s.lat_e7 = (int32_t)rd32(rec);
+                    s.lon_e7 = (int32_t)rd32(rec + 4);
+                    s.kind = rec[8];
+                    s.records = rd16(rec + 10);
+                }
+                first += n;
+                count -= n;
+            }
+        }
+    }
+    cache_row = row;
+    cache_col = col;
+    cache_valid = true;
+    return true;
+}
+
+bool GeoIndex::query(int32_t lat_e7, int32_t lon_e7, uint32_t radius_m, GeoResult& out) {
+    memset(&out, 0, sizeof(out));
+    if (!read_fn) return false;
+
+    int32_t row = floor_div(lat_e7, cell_lat_e7);
+    int32_t col = floor_div(lon_e7, cell_lon_e7);
+    if (!cache_valid || row != cache_row || col != cache_col) {
+        if (!loadBlock(row, col)) return false;
+    }
+    out.truncated = cache_truncated;
+
+    if (radius_m > max_radius_m) radius_m = max_radius_m;
+    float lon_scale = GEO_M_PER_E7 * cosf(lat_e7 * 1e-7f * (float)M_PI / 180.0f);
+    float limit_sq = (float)radius_m * radius_m;
+    float best_sq = limit_sq;
+
+    for (uint16_t i = 0; i < cached; i++) {
+        const GeoSite& s = cache[i];
+        float dy = (float)(s.lat_e7 - lat_e7) * GEO_M_PER_E7;
+        float dx = (float)(s.lon_e7 - lon_e7) * lon_scale;
+        float d_sq = dx * dx + dy * dy;
+        if (d_sq > limit_sq) continue;
+        out.count++;
+        if (s.kind < 8) out.kinds |= 1 << s.kind;
+        if (d_sq <= best_sq) {
+            best_sq = d_sq;
+            out.nearest = s;
+        }
+    }
+    if (out.count) out.nearest_m = (uint32_t)sqrtf(best_sq);
+    return true;
+}
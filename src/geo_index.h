@@ -0,0 +1,118 @@
+/**
+ * @file geo_index.h
+ * @brief Grid-bucketed index of known camera sites for GPS proximity queries
+ *
+ * Built offline from datasets/ by tools/geoindex.py and read from SD. The
+ * world is cut into a lat/lon grid whose cells are at least the index's
+ * maximum query radius wide, so every site within that radius of a
+ * position lies in the 3x3 block of cells around it. Occupied cells live in
+ * an open-addressed hash table; a query hashes nine cells instead of
+ * searching, and the block's sites are cached in RAM until the position
+ * moves to another cell. Only the header is resident: the file is read
+ * through a callback (SD on the device, a FILE on the host).
+ *
+ * Layout (little-endian):
+ *
+ *   header  48 B   magic "FYGI", format, reserved, site count, cell count,
+ *                  slot count (power of two), cell height and width in
+ *                  1e-7 degrees, max query radius (m), build time,
+ *                  payload length, CRC-32 of the payload, reserved
+ *   slots   16 B each: cell row (i32), cell column (i32), first site,
+ *                  site count (0 = empty slot)
+ *   sites   12 B each: lat, lon (i32, 1e-7 deg), kind, reserved,
+ *                  merged records (u16); grouped by cell
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef GEO_INDEX_H
+#define GEO_INDEX_H
+
+#include <stdint.h>
+#include "sigpack.h"
+
+#define GEO_INDEX_MAGIC       "FYGI"
+#define GEO_INDEX_FORMAT      1
+#define GEO_INDEX_HEADER_SIZE 48
+#define GEO_SLOT_SIZE         16
+#define GEO_SITE_SIZE         12
+#define GEO_CACHE_SITES       256   // Sites held for the current 3x3 block
+#define GEO_MAX_PROBES        32    // Hash probe limit per cell
+
+// Site kinds (source datasets)
+#define GEO_KIND_FLOCK       0   // Flock-XXXXXX WiFi
+#define GEO_KIND_FS_BATTERY  1   // FS Ext Battery BLE
+#define GEO_KIND_PENGUIN     2   // Penguin BLE
+#define GEO_KIND_PIGVISION   3   // Crowd-mapped Flock cameras
+#define GEO_KIND_CAMERA      4   // Municipal camera inventory (maximum_dots)
+#define GEO_KIND_COUNT       5
+
+const char* geo_kind_name(uint8_t kind);
+
+// Reads len bytes at offset; false on I/O error
+typedef bool (*GeoReadFn)(void* ctx, uint32_t offset, void* buf, uint32_t len);
+
+struct GeoSite {
+    int32_t  lat_e7;
+    int32_t  lon_e7;
+    uint8_t  kind;
+    uint16_t records;    // Dataset rows merged into this site
+};
+
+struct GeoResult {
+    uint16_t count;          // Sites within the radius
+    uint8_t  kinds;          // Bitmask of GEO_KIND_* among them
+    uint32_t nearest_m;      // Valid when count > 0
+    GeoSite  nearest;
+    bool     truncated;      // Block had more than GEO_CACHE_SITES sites
+};
+
+class GeoIndex {
+public:
+    GeoIndex();
+
+    // Read and validate the header; verify_crc streams the whole payload
+    SigPackStatus open(GeoReadFn read, void* ctx, uint32_t file_len, bool verify_crc);
+    void close();
+
+    bool opened() const { return read_fn != nullptr; }
+    uint32_t siteCount() const { return site_count; }
+    uint32_t cellCount() const { return cell_count; }
+    uint32_t maxRadius() const { return max_radius_m; }
+    uint32_t buildTime() const { return build_time; }
+
+    // Sites within radius_m (clamped to maxRadius()) of a position. Reads the
+    // file only when the position enters a new cell. False on I/O error.
+    bool query(int32_t lat_e7, int32_t lon_e7, uint32_t radius_m, GeoResult& out);
+
+    // Cost counters: block loads and read callbacks issued
+    uint32_t blockLoads() const { return block_loads; }
+    uint32_t reads() const { return read_calls; }
+
+private:
+    bool read(uint32_t offset, void* buf, uint32_t len);
+    bool findCell(int32_t row, int32_t col, uint32_t& first, uint32_t& count);
+    bool loadBlock(int32_t row, int32_t col);
+
+    GeoReadFn read_fn;
+    void* read_ctx;
+    uint32_t site_count;
+    uint32_t cell_count;
+    uint32_t slot_count;
+    int32_t cell_lat_e7;
+    int32_t cell_lon_e7;
+    uint32_t max_radius_m;
+    uint32_t build_time;
+
+    GeoSite cache[GEO_CACHE_SITES];
+    uint16_t cached;
+    bool cache_valid;
+    bool cache_truncated;
+    int32_t cache_row;
+    int32_t cache_col;
+
+    uint32_t block_loads;
+    uint32_t read_calls;
+};
+
+#endif // GEO_INDEX_H
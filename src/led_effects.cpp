@@ -0,0 +1,100 @@
+/**
+ * @file led_effects.cpp
+ * @brief Status LED effect table and segment timing
+ *
+ * @see led_effects.h
+ */
+
+#include "led_effects.h"
+
+const LedEffect led_effects_default[LED_FX_COUNT] = {
+    // name     colour          wave              rate            period floor  hold   next
+    { "off",    {0, 0, 0},      LED_WAVE_SOLID,   LED_RATE_FIXED, 0,     0,     0,     LED_FX_OFF },
+    { "scan",   {0, 128, 0},    LED_WAVE_BREATHE, LED_RATE_FIXED, 4000,  25,    0,     LED_FX_SCAN },
+    { "detect", {255, 0, 0},    LED_WAVE_BLINK,   LED_RATE_RSSI,  0,     0,     5000,  LED_FX_ALERT },
+    { "alert",  {255, 100, 0},  LED_WAVE_SOLID,   LED_RATE_FIXED, 0,     0,     10000, LED_FX_SCAN },
+};
+
+uint16_t led_flash_period(int8_t rssi) {
+    uint16_t half;
+    if (rssi >= -40) half = LED_FLASH_MIN_INTERVAL;
+    else if (rssi >= -50) half = 100;
+    else if (rssi >= -60) half = 150;
+    else if (rssi >= -70) half = 200;
+    else if (rssi >= -80) half = 300;
+    else half = LED_FLASH_MAX_INTERVAL;
+    return half * 2;
+}
+
+uint8_t LedSegment::levelAt(uint32_t now_ms) const {
+    uint32_t t = now_ms - start_ms;
+    if (t >= ramp_ms || from == to) return to;
+    return (uint8_t)(from + ((int32_t)to - from) * (int32_t)t / (int32_t)ramp_ms);
+}
+
+LedEffects::LedEffects(const LedEffect* table, uint8_t count)
+    : table(table), count(count), effect(0), period_ms(table[0].period_ms), started_ms(0) {}
+
+void LedEffects::enter(uint8_t next, uint32_t start_ms) {
+    effect = next < count ? next : 0;
+    period_ms = table[effect].rate == LED_RATE_RSSI ? led_flash_period(-70) : table[effect].period_ms;
+    started_ms = start_ms;
+}
+
+void LedEffects::play(uint8_t next, uint32_t now_ms, int8_t rssi) {
+    enter(next, now_ms);
+    if (table[effect].rate == LED_RATE_RSSI) period_ms = led_flash_period(rssi);
+}
+
+bool LedEffects::skip(uint8_t from, uint32_t now_ms) {
+    if (effect != from || !table[effect].hold_ms) return false;
+    enter(table[effect].next, now_ms);
+    return true;
+}
+
+LedSegment LedEffects::segment(uint32_t now_ms) {
+    // Follow the chain; a table with a cycle of holds visits each at most once per call
+    for (uint8_t hops = 0; hops < count; hops++) {
+        const LedEffect& e = table[effect];
+        if (!e.hold_ms || now_ms - started_ms < e.hold_ms) break;
+        enter(e.next, started_ms + e.hold_ms);
+    }
+
+    const LedEffect& e = table[effect];
+    uint32_t t = now_ms - started_ms;
+    if (e.hold_ms && t >= e.hold_ms) {
+        // Chain still expired after a full lap: restart the effect here
+        started_ms = now_ms;
+        t = 0;
+    }
+    uint8_t low = (uint8_t)(LED_LEVEL_MAX * e.floor_pct / 100);
+
+    LedSegment s;
+    s.color = e.color;
+    s.from = s.to = LED_LEVEL_MAX;
+    s.start_ms = started_ms;
+    s.ramp_ms = 0;
+    s.forever = true;
+
+    uint32_t half = period_ms / 2;
+    if (e.wave != LED_WAVE_SOLID && half) {
+        uint32_t k = t / half;
+        bool second = k & 1;
+        s.start_ms = started_ms + k * half;
+        s.end_ms = s.start_ms + half;
+        s.forever = false;
+        if (e.wave == LED_WAVE_BLINK) {
+            s.from = s.to = second ? low : LED_LEVEL_MAX;
+        } else {
+            s.from = second ? low : LED_LEVEL_MAX;
+            s.to = second ? LED_LEVEL_MAX : low;
+            s.ramp_ms = half;
+        }
+    }
+    if (e.hold_ms) {
+        uint32_t hold_end = started_ms + e.hold_ms;
+        if (s.forever || (int32_t)(s.end_ms - hold_end) > 0) s.end_ms = hold_end;
+        s.forever = false;
+    }
+    return s;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file led_effects.h
+ * @brief Declarative status LED effects, resolved into hardware segments
+ *
+ * The status LED used to be a state machine polled from every loop()
+ * iteration that toggled PWM in software. An effect is now a table row:
+ * colour, waveform (solid, blink, breathe), period or RSSI-derived rate,
+ * how long it holds and which effect follows. LedEffects turns the row
+ * playing at a given time into a segment: a level (or a linear ramp
+ * between two levels) that stays valid until a known end time. The LED
+ * driver programs each segment into hardware (an LEDC fade, one WS2812
+ * write) and sleeps until the segment ends or a new effect is played.
+ *
+ * Effect chains follow the hold times exactly, so "red blink for 5 s, then
+ * orange for 10 s, then breathe green" needs nobody to watch the clock.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef LED_EFFECTS_H
+#define LED_EFFECTS_H
+
+#include <stdint.h>
+
+#define LED_LEVEL_MAX       255
+
+// RSSI to blink half-period: stronger signal (less negative) = faster flash
+#define LED_FLASH_MIN_INTERVAL  50   // Very strong, >= -40 dBm
+#define LED_FLASH_MAX_INTERVAL  400  // Weak, < -80 dBm
+
+enum LedWave : uint8_t {
+    LED_WAVE_SOLID = 0,
+    LED_WAVE_BLINK,       // Peak for half the period, floor for the other half
+    LED_WAVE_BREATHE,     // Linear ramps peak -> floor -> peak
+};
+
+enum LedRate : uint8_t {
+    LED_RATE_FIXED = 0,   // period_ms from the table
+    LED_RATE_RSSI,        // Period from the RSSI passed to play()
+};
+
+// Effects of the default table
+enum LedEffectId : uint8_t {
+    LED_FX_OFF = 0,
+    LED_FX_SCAN,          // Breathing green - no detections
+    LED_FX_DETECT,        // Red flashing at a rate set by RSSI - active detection
+    LED_FX_ALERT,         // Orange solid - recent detection, signal lost
+    LED_FX_COUNT,
+};
+
+struct LedColor {
+    uint8_t r, g, b;
+};
+
+struct LedEffect {
+    const char* name;
+    LedColor color;       // At full level
+    LedWave wave;
+    LedRate rate;
+    uint16_t period_ms;   // Blink / breathe cycle
+    uint8_t floor_pct;    // Lowest level of the cycle, % of full
+    uint32_t hold_ms;     // Then `next` plays; 0 holds until replaced
+    uint8_t next;
+};
+
+// Solid levels have ramp_ms 0 and from == to
+struct LedSegment {
+    LedColor color;
+    uint8_t from;         // Level at start_ms, 0..LED_LEVEL_MAX
+    uint8_t to;           // Level from start_ms + ramp_ms on
+    uint32_t start_ms;
+    uint32_t ramp_ms;
+    uint32_t end_ms;      // The next segment starts here
+    bool forever;         // No next segment until play(); end_ms unused
+
+    uint8_t levelAt(uint32_t now_ms) const;
+    bool ramping(uint32_t now_ms) const { return from != to && now_ms - start_ms < ramp_ms; }
+};
+
+extern const LedEffect led_effects_default[LED_FX_COUNT];
+
+// Blink period (both halves) for a detection at `rssi`
+uint16_t led_flash_period(int8_t rssi);
+
+class LedEffects {
+public:
+    LedEffects(const LedEffect* table, uint8_t count);
+
+    // Start an effect now (again from the top if already playing);
+    // `rssi` sets the rate of LED_RATE_RSSI effects
+    void play(uint8_t effect, uint32_t now_ms, int8_t rssi = -70);
+    // If `effect` is playing, end its hold now. False when it was not.
+    bool skip(uint8_t effect, uint32_t now_ms);
+
+    // Segment at now_ms, following expired holds on to their next effects
+    LedSegment segment(uint32_t now_ms);
+
+    uint8_t current() const { return effect; }
+    const LedEffect& info(uint8_t i) const { return table[i]; }
+
+private:
+    void enter(uint8_t next, uint32_t start_ms);
+
+    const LedEffect* table;
+    uint8_t count;
+    uint8_t effect;
+    uint16_t period_ms;
+    uint32_t started_ms;
+};
+
+#endif // LED_EFFECTS_H
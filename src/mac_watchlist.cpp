@@ -0,0 +1,100 @@
+/**
+ * @file mac_watchlist.cpp
+ * @brief Full-MAC watchlist implementation
+ *
+ * @see mac_watchlist.h and tools/watchlist.py (reference builder)
+ */
+
+#include "mac_watchlist.h"
+#include <string.h>
+
+static uint32_t rd32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t splitmix64(uint64_t x) {
+    uint64_t z = x + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+MacWatchlist::MacWatchlist() {
+    clear();
+}
+
+void MacWatchlist::clear() {
+    table = nullptr;
+    buckets = 0;
+    seed = 0;
+    exact = nullptr;
+    exact_count = 0;
+    false_positives = 0;
+}
+
+bool MacWatchlist::attach(const uint8_t* section, uint32_t len) {
+    table = nullptr;
+    if (len < WATCHLIST_HEADER_SIZE) return false;
+    uint32_t n = rd32(section);
+    if (n == 0 || section[8] != WATCHLIST_BUCKET_SIZE || section[9] != WATCHLIST_FP_BITS) return false;
+    // By division: n * bucket bytes wraps in 32 bits for a crafted count
+    uint32_t body = len - WATCHLIST_HEADER_SIZE;
+    if (body % (WATCHLIST_BUCKET_SIZE * 2) != 0 || body / (WATCHLIST_BUCKET_SIZE * 2) != n) return false;
+
+    buckets = n;
+    seed = rd32(section + 4);
+    table = section + WATCHLIST_HEADER_SIZE;
+    return true;
+}
+
+bool MacWatchlist::setExact(const uint8_t* macs, uint32_t len) {
+    exact = nullptr;
+    exact_count = 0;
+    if (len % 6 != 0) return false;
+    exact = macs;
+    exact_count = len / 6;
+    return true;
+}
+
+uint32_t MacWatchlist::filterBytes() const {
+    return table ? WATCHLIST_HEADER_SIZE + buckets * WATCHLIST_BUCKET_SIZE * 2 : 0;
+}
+
+bool MacWatchlist::mayContain(const uint8_t* mac) const {
+    if (!table) return false;
+
+    uint64_t key = 0;
+    for (int i = 0; i < 6; i++) key = (key << 8) | mac[i];
+    uint64_t z = splitmix64(key ^ ((uint64_t)seed * 0x9E3779B97F4A7C15ull));
+
+    uint16_t fp = z & 0xFFFF;
+    if (fp == 0) fp = 1;  // 0 marks an empty slot
+    uint32_t i1 = (uint32_t)(z >> 32) % buckets;
+    uint32_t i2 = ((fp * 0x5BD1E995u) % buckets + buckets - i1) % buckets;
+
+    const uint8_t* b1 = table + i1 * WATCHLIST_BUCKET_SIZE * 2;
+    const uint8_t* b2 = table + i2 * WATCHLIST_BUCKET_SIZE * 2;
+    uint8_t lo = fp & 0xFF, hi = fp >> 8;
+    for (int s = 0; s < WATCHLIST_BUCKET_SIZE; s++) {
+        if ((b1[2 * s] == lo && b1[2 * s + 1] == hi) ||
+            (b2[2 * s] == lo && b2[2 * s + 1] == hi)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MacWatchlist::contains(const uint8_t* mac) const {
+    if (!mayContain(mac)) return false;
+
+    uint32_t lo = 0, hi = exact_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = memcmp(exact + (uint32_t)mid * 6, mac, 6);
+        if (c == 0) return true;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    false_positives++;
+    return false;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file mac_watchlist.h
+ * @brief Full-MAC watchlist: cuckoo filter in front of an exact table
+ *
+ * For device families whose addresses aren't OUI-based (Penguin uses static
+ * random BLE addresses) the only useful match is the whole MAC. The
+ * watchlist answers "is this MAC listed?" from the sniffer/BLE fast path:
+ *
+ * - a cuckoo filter (4 x 16-bit fingerprints per bucket, ~2.1 bytes per
+ *   MAC) rejects almost every miss with two bucket reads, in constant time
+ * - filter positives are confirmed against the exact sorted MAC table,
+ *   so a fingerprint collision (~0.012%) costs one binary search and never
+ *   produces a false detection
+ *
+ * The filter is built on the host (tools/watchlist.py, via sigpack.py) and
+ * read in place from the signature pack image. Hash and alternate-bucket
+ * rules are documented in tools/watchlist.py and must match exactly.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef MAC_WATCHLIST_H
+#define MAC_WATCHLIST_H
+
+#include <stdint.h>
+
+#define WATCHLIST_BUCKET_SIZE    4
+#define WATCHLIST_FP_BITS       16
+#define WATCHLIST_HEADER_SIZE   12
+
+class MacWatchlist {
+public:
+    MacWatchlist();
+
+    // Filter section: header (buckets, seed, bucket size, fp bits) + buckets.
+    // Returns false if the section is malformed.
+    bool attach(const uint8_t* section, uint32_t len);
+    // Sorted 6-byte MACs used to confirm filter positives, len bytes of them.
+    // Returns false (and keeps no table) unless len is a whole number of MACs.
+    bool setExact(const uint8_t* macs, uint32_t len);
+    void clear();
+
+    bool attached() const { return table != nullptr; }
+    // Filter only: false = definitely not listed
+    bool mayContain(const uint8_t* mac) const;
+    // Filter, then exact confirmation
+    bool contains(const uint8_t* mac) const;
+
+    uint32_t bucketCount() const { return buckets; }
+    uint32_t filterBytes() const;
+    // Filter positives that the exact table rejected (fingerprint collisions)
+    uint32_t falsePositives() const { return false_positives; }
+
+private:
+    const uint8_t* table;
+    uint32_t buckets;
+    uint32_t seed;
+    const uint8_t* exact;
+    uint32_t exact_count;
+    mutable volatile uint32_t false_positives;
+};
+
+#endif // MAC_WATCHLIST_H
@@ -24,6 +24,36 @@
 #include "esp_wifi.h"
 #include "esp_wifi_types.h"
 #include "esp_task_wdt.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_idf_version.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include <sys/time.h>
+#include <Preferences.h>
+#include "dwell_policy.h"
+#include "airtime.h"
+#include "radio_scheduler.h"
+#include "ble_seen_cache.h"
+#include "ble_matcher.h"
+#include "sigpack.h"
+#include "flash_index.h"
+#include "geo_index.h"
+#include "nmea_parser.h"
+#include "rssi_track.h"
+#include "site_cluster.h"
+#include "tracked_device.h"
+#include "rule_vm.h"
+#include "rules_default.h"
+#include "warm_snapshot.h"
+#include "perf_registry.h"
+#include "trace_ring.h"
+#include "param_registry.h"
+#include "led_effects.h"
+#include "status_led.h"
+#include "patrol_policy.h"
 
 #ifdef CYD_DISPLAY
 #include "display_handler_28.h"
@@ -38,10 +68,67 @@
 #define HAS_DISPLAY 1
 #endif
 
+// Signature pack lives on the display board's SD card (headless: built-in tables only)
+#if defined(CYD_DISPLAY)
+#define SIGPACK_FS SD
+#elif defined(WAVESHARE_147)
+#define SIGPACK_FS SD_MMC
+#endif
+#define SIGPACK_FILE      "/signatures.fysp"
+#define SIGPACK_MAX_SIZE  (256 * 1024)
+#define SIGPACK_CHECK_MS  10000   // Poll the file for changes (also the minimum swap interval)
+
+// OUI vendor + signature index in its own flash partition (partitions_cyd.csv),
+// written by tools/mkflashindex.py and read in place through the flash cache
+#define FLASH_INDEX_LABEL    "fyindex"
+#define FLASH_INDEX_SUBTYPE  0x40
+
+// Known camera sites (tools/geoindex.py) on the same SD card, queried on
+// every position fix (UART GPS, or "POS <lat> <lon>" lines on the serial port)
+#define GEO_FILE          "/cameras.fygi"
+#define GEO_ALERT_M       300     // Pre-alert when a known site is this close
+#define GEO_BOOST_MS      30000   // Lengthened dwell after a pre-alert
+#define GEO_DWELL_SCALE   2       // Dwell multiplier while boosted
+
+// Optional NMEA GPS on a UART, RX only. CYD boards: GPIO 35 on the P3
+// connector. Other boards: build with -DGPS_RX_PIN=<gpio>. Its fixes feed the
+// camera site queries and geotag sightings, so no laptop is needed for either.
+#if !defined(GPS_RX_PIN) && defined(CONFIG_IDF_TARGET_ESP32)
+#define GPS_RX_PIN 35
+#endif
+#define GPS_BAUD            9600
+#define GPS_UART_NUM        1
+#define GPS_RX_BUFFER       2048   // ~2 s of NMEA at 9600 baud (legacy BLE scan blocks loop() 1 s)
+#define GPS_FIX_MAX_AGE_MS  3000   // Older positions are not attached to sightings
+
+// Warm-restart snapshot of the tracking state (warm_snapshot.h): on SD next to
+// the signature pack when a card is present, else in NVS. Written only after
+// something was sighted; NVS intervals are stretched for flash wear.
+#define SNAPSHOT_FILE        "/snapshot.fyws"
+#define SNAPSHOT_TMP_FILE    "/snapshot.tmp"   // Written first, then renamed over SNAPSHOT_FILE
+#define SNAPSHOT_NVS_NS      "flockyou"
+#define SNAPSHOT_NVS_KEY     "snapshot"
+#define SNAPSHOT_MAX_SIZE    8192
+#define SNAPSHOT_NVS_MAX     3968      // NVS blob limit on the 20 KB partition is 4000 B
+#define SNAPSHOT_NEW_MS      10000     // New device since the last snapshot: write this soon
+#define SNAPSHOT_REFRESH_MS  60000     // Re-sightings only
+#define SNAPSHOT_NVS_SCALE   5         // NVS: both intervals this many times longer
+#define SNAPSHOT_MAX_AGE_MS  3600000   // Older snapshots are ignored entirely
+
 // ============================================================================
 // CONFIGURATION
 // ============================================================================
 
+// Boot: 1 brings the WiFi capture up first and mounts SD / loads settings,
+// calibration and the snapshot on Core 0 in parallel, skipping the LED test,
+// console delay and splash animation; 0 is the original sequential boot
+#define FAST_BOOT 1
+
+// Patrol mode for battery units: short scan bursts between light sleeps,
+// display dark until a detection or touch (patrol_policy.h). Switchable at
+// runtime with "@set patrol.on=1".
+#define PATROL_MODE 0
+
 // Hardware Configuration
 #define BUZZER_ENABLED 0  // Set to 1 to enable buzzer, 0 to disable
 
@@ -51,8 +138,8 @@
 #define BUZZER_PIN 3   // GPIO3 (D2) - PWM capable pin on Xiao ESP32 S3
 #endif
 
-// RGB LED — active LOW on ESP32-2432S028R (PWM for brightness)
-// Waveshare 1.47" uses WS2812 addressable LED instead (handled by display handler)
+// RGB LED — active LOW on ESP32-2432S028R (LEDC hardware fades)
+// Waveshare 1.47" uses a WS2812 addressable LED instead (RMT)
 #ifndef WAVESHARE_147
 #define RGB_R  4
 #define RGB_G  16
@@ -61,22 +148,7 @@
 #define LED_CH_G  1  // LEDC channel for green
 #define LED_CH_B  2  // LEDC channel for blue
 #endif
-
-// LED States
-enum LedState {
-    LED_SCANNING,    // Green at 50% - no detections
-    LED_DETECTED,    // Red flashing - active detection
-    LED_ALERT        // Orange solid - recent detection, signal lost
-};
-
-static LedState led_state = LED_SCANNING;
-static bool     led_flash_on = false;
-static uint32_t led_last_toggle = 0;
-static uint32_t led_detection_time = 0;
-static int8_t   led_detection_rssi = -100;  // Signal strength for flash rate
-#define LED_ALERT_TIMEOUT  15000  // 15s after detection before returning to scanning
-#define LED_FLASH_MIN_INTERVAL  50   // Fastest flash (strong signal)
-#define LED_FLASH_MAX_INTERVAL  400  // Slowest flash (weak signal)
+// LED effects (scan breathing, RSSI flash rate, alert hold) are the table in led_effects.cpp
 
 // Audio Configuration
 #define LOW_FREQ 200      // Boot sequence - low pitch
@@ -89,10 +161,26 @@ static int8_t   led_detection_rssi = -100;  // Signal strength for flash rate
 
 // WiFi Promiscuous Mode Configuration
 #define MAX_CHANNEL 13
+#define CHANNEL_DWELL_POLICY DWELL_POLICY_BANDIT  // DWELL_POLICY_LADDER for the fixed threshold ladder
 // BLE SCANNING CONFIGURATION
 #define BLE_SCAN_DURATION 1    // Seconds
 #define BLE_SCAN_INTERVAL 2000 // Milliseconds between scans (was 5000)
+// Coexistence between the WiFi sniffer and the BLE scanner:
+//   BLE_MODE_LEGACY     - blocking 1 s scan every BLE_SCAN_INTERVAL
+//   BLE_MODE_SLOTTED    - WiFi/BLE time slots (see radio_scheduler.h)
+//   BLE_MODE_CONTINUOUS - scan never stops; duty cycle via scan window/interval,
+//                         controller duplicate filter reset every BLE_DUP_RESET_MS
+#define BLE_MODE_LEGACY     0
+#define BLE_MODE_SLOTTED    1
+#define BLE_MODE_CONTINUOUS 2
+#define BLE_SCAN_MODE BLE_MODE_SLOTTED
+#define BLE_SCAN_ITVL_MS   100   // Continuous: scan interval
+#define BLE_DUP_RESET_MS  3000   // Continuous: controller duplicate filter reset period
 static unsigned long last_ble_scan = 0;
+#if BLE_SCAN_MODE == BLE_MODE_LEGACY
+static uint32_t ble_scan_interval_ms = BLE_SCAN_INTERVAL;
+static uint32_t ble_scan_duration_s = BLE_SCAN_DURATION;
+#endif
 
 // Detection Pattern Limits
 #define MAX_SSID_PATTERNS 10
@@ -137,6 +225,16 @@ static const char* device_name_patterns[] = {
     "pigvision"        // Pigvision surveillance systems
 };
 
+// The tables above are the built-in fallback; a signature pack on SD
+// (tools/sigpack.py, sources in signatures/) replaces all of them.
+
+// BLE payload signatures (see ble_matcher.h). Match on what the device
+// advertises, independent of address or name.
+static const BleRule ble_payload_rules[] = {
+    // Penguin: random non-OUI addresses, but wigle reports mfgrId 2504 for every unit
+    { "penguin_mfg_id", BLE_RULE_MFG_ID, 0x09C8 },
+};
+
 // ============================================================================
 // GLOBAL VARIABLES
 // ============================================================================
@@ -148,6 +246,21 @@ static bool device_in_range = false;
 static unsigned long last_detection_time = 0;
 static uint32_t total_frames_seen = 0;
 static uint32_t total_ssids_seen = 0;
+
+// Boot timeline: milestones from setup() and the boot I/O task (esp_timer us)
+#define BOOT_MARKS_MAX 20
+struct BootMark {
+    const char* what;
+    uint32_t us;
+    uint8_t core;
+};
+static BootMark boot_marks[BOOT_MARKS_MAX];
+static uint8_t boot_mark_count = 0;
+static portMUX_TYPE boot_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t boot_capture_us = 0;                // Promiscuous mode on
+static volatile uint32_t boot_first_frame_us = 0;   // First frame in the sniffer
+static volatile bool boot_io_done = false;
+static bool boot_reported = false;
 static unsigned long last_heartbeat = 0;
 static NimBLEScan* pBLEScan;
 
@@ -155,37 +268,42 @@ static NimBLEScan* pBLEScan;
 #define MAX_TRACKED 64
 #define MAX_TRACKED_MASK (MAX_TRACKED - 1)
 #define HASH_MAX_PROBE 8
-#define DETECTION_TTL 300000  // 5 minutes — re-detect after this
-
-// TrackedDevice struct defined in display_handler_28.h when CYD_DISPLAY is set
-#ifndef CYD_DISPLAY
-struct TrackedDevice {
-    uint32_t mac_hash;           // FNV-1a hash (0 = empty slot)
-    uint8_t  mac[6];             // Full MAC for display/logging
-    int8_t   rssi_min;           // Weakest signal seen
-    int8_t   rssi_max;           // Strongest signal seen
-    int8_t   rssi_last;          // Most recent RSSI
-    int32_t  rssi_sum;           // Running sum for average
-    uint16_t hit_count;          // Total detections
-    uint8_t  last_channel;       // Channel last seen on
-    uint8_t  type;               // Last detection type
-    uint32_t first_seen;         // millis() of first detection
-    uint32_t last_seen;          // millis() of most recent detection
-    uint32_t probe_interval_sum; // Sum of inter-detection intervals (ms)
-    uint16_t probe_intervals;    // Count of intervals measured
-};
-#endif
+#define DETECTION_TTL 300000  // 5 minutes — re-detect after this (default of "detect.ttl_ms")
+static volatile uint32_t detection_ttl_ms = DETECTION_TTL;
 
 static TrackedDevice tracked_devices[MAX_TRACKED] = {};
 static uint32_t hash_entries = 0;
 static uint32_t hash_collisions = 0;
 
-// Channel memory: detection-aware channel biasing
-static uint8_t  channel_detections[14] = {0};   // Matched detections per channel (lifetime)
-static volatile uint32_t channel_sticky_until = 0;  // millis() — stay on current channel
-#define CHANNEL_STICKY_DURATION 5000             // 5s sticky after detection
-#define CHANNEL_DETECTION_BONUS 500              // Extra ms dwell per past detection
-#define CHANNEL_MAX_DWELL 3000                   // Cap total dwell time
+// Site correlation: one site per slot of tracked_devices
+static_assert(MAX_TRACKED <= SITE_SLOTS, "site cluster must cover every tracked slot");
+#define SITE_HELD_MAX 8  // New-device alerts held while a nearby site may absorb them
+static SiteCluster sites;
+static uint32_t site_held = 0;
+static uint32_t site_folded = 0;
+
+// Channel memory: detection-aware dwell policy (see dwell_policy.h)
+static DwellPolicy* dwell_policy = nullptr;
+
+// Warm-restart snapshot (WARM RESTART SNAPSHOT below): encoded on Core 0 by
+// the processing task, stored by loop() on Core 1
+static uint8_t snapshot_image[SNAPSHOT_MAX_SIZE];
+static size_t snapshot_len = 0;
+static volatile bool snapshot_pending = false;
+static uint32_t snapshot_seq = 0;
+static uint32_t snapshot_last_ms = 0;
+static uint32_t snapshot_last_entries = 0;  // hash_entries at the last snapshot
+static const char* snapshot_from = nullptr;  // Store the restored snapshot came from
+
+// Write and restore costs, for [SNAP] logs and stats
+static uint32_t snapshot_writes = 0;
+static uint32_t snapshot_failures = 0;
+static uint32_t snapshot_dropped = 0;       // Records that did not fit the last snapshot
+static uint32_t snapshot_encode_us = 0;
+static uint32_t snapshot_store_ms = 0;
+static uint32_t snapshot_store_max_ms = 0;
+static uint32_t snapshot_restore_us = 0;
+static uint16_t snapshot_restored = 0;      // Devices restored at boot
 
 // FNV-1a hash of 6-byte MAC address
 static uint32_t fnv1a_mac(const uint8_t* mac) {
@@ -204,9 +322,15 @@ struct DetectionEvent {
     char ssid[33];        // WiFi SSID or BLE name
     int8_t rssi;
     uint8_t channel;
-    uint8_t type;         // 0=probe, 1=beacon, 2=ble_mac, 3=ble_name
+    uint8_t type;         // 0=probe, 1=beacon, 2=ble_mac, 3=ble_name, 4=probe_resp, 5=ble_payload, 6=wifi_watchlist
+    const BleRule* rule;  // Matched BLE payload rule (type 5), else nullptr
+    uint32_t ie_fp;       // WiFi IE fingerprint (probe/beacon), else 0
+    int32_t mfg_id;       // BLE manufacturer data company ID, else -1
+    uint32_t queued_us;   // now_us() when enqueued (queue residency)
 };
 
+#define DETECTION_QUEUE_LEN 16   // Default of "queue.len" (read at boot)
+static uint32_t detection_queue_len = DETECTION_QUEUE_LEN;
 static QueueHandle_t detectionQueue = NULL;
 static TaskHandle_t processingTaskHandle = NULL;
 static SemaphoreHandle_t displayMutex = NULL;
@@ -216,11 +340,196 @@ static volatile bool pending_beep = false;  // Signal Core 1 to play detection b
 
 // Adaptive channel dwell
 static volatile uint16_t channel_activity[14] = {0};  // frames per channel in current dwell
-#define CHANNEL_DWELL_BASE    200   // ms - fast sweep of quiet channels
-#define CHANNEL_DWELL_ACTIVE  800   // ms - stay longer on active channels
-#define CHANNEL_DWELL_HIGH   1500   // ms - stay longest on very active channels
-#define CHANNEL_ACTIVE_THRESHOLD  5
-#define CHANNEL_HIGH_THRESHOLD   20
+
+// Radio airtime accounting (see airtime.h) — emitted with [STATS] every window
+static AirtimeLedger airtime;
+
+static inline uint32_t now_us() { return (uint32_t)esp_timer_get_time(); }
+
+// Performance registry (see perf_registry.h), dumped by the serial "PERF"
+// command. Every metric has one writer: the task in its comment, or
+// whoever holds displayMutex.
+static PerfRegistry perf;
+static PerfHistogram perf_sniffer_ns;        // WiFi task: promiscuous callback
+static PerfHistogram perf_ble_cb_ns;         // BLE host task: onResult
+static PerfHistogram perf_queue_us;          // detect: enqueue to dequeue
+static PerfHistogram perf_process_us;        // detect: handling one event
+static PerfHistogram perf_display_us;        // loop: display.update() (CYD: includes log flushes)
+static PerfHistogram perf_sd_write_us;       // displayMutex: detection log and snapshot file writes
+static PerfHistogram perf_mutex_wait_us[2];  // displayMutex acquisition, per core (detect / loop)
+static PerfHistogram perf_loop_us;           // loop: one pass, excluding its yield
+static PerfGauge perf_queue_depth;           // detect: events still waiting after a dequeue
+static PerfGauge perf_tracked;               // detect: hash_entries after each event
+static uint32_t perf_window_us = 0;          // Start of the histogram window (PERF RESET)
+static uint32_t perf_cpu_mhz = 240;
+
+// Callback durations come from the CPU cycle counter (one register read)
+static inline uint32_t cycles_to_ns(uint32_t cycles)
+{
+    return cycles < 4000000 ? cycles * 1000 / perf_cpu_mhz : cycles / perf_cpu_mhz * 1000;
+}
+
+// Event trace (see trace_ring.h), dumped by the serial "TRACE" command.
+// Tasks get small ids on their first event; names are copied then, since
+// short-lived tasks may be gone by the time of the dump.
+#define TRACE_MAX_TASKS     32
+#define TRACE_MUTEX_MIN_US  50    // Shorter displayMutex waits are not traced
+#define TRACE_DUMP_CHUNK    32    // Events per "trace_events" line
+#if TRACE_ENABLED
+TraceRing trace_ring;
+static char trace_task_names[TRACE_MAX_TASKS + 1][16];
+static TaskHandle_t trace_tasks[TRACE_MAX_TASKS];
+static volatile uint8_t trace_task_count = 0;
+static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t trace_span_ns = 0;  // Cost of a begin/end pair, measured at boot
+
+// Track byte for an event: calling core and the task's id (TRACE_MAX_TASKS
+// when the table is full)
+static uint8_t trace_track()
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint8_t id = 0;
+    for (uint8_t n = trace_task_count; id < n; id++) {
+        if (trace_tasks[id] == self) return (uint8_t)(xPortGetCoreID() << 7 | id);
+    }
+    portENTER_CRITICAL(&trace_mux);
+    for (id = 0; id < trace_task_count && trace_tasks[id] != self; id++) {}
+    if (id == trace_task_count && id < TRACE_MAX_TASKS) {
+        trace_tasks[id] = self;
+        strncpy(trace_task_names[id], pcTaskGetName(NULL), sizeof(trace_task_names[id]) - 1);
+        trace_task_count = id + 1;
+    }
+    portEXIT_CRITICAL(&trace_mux);
+    return (uint8_t)(xPortGetCoreID() << 7 | id);
+}
+#endif
+
+// Take displayMutex, recording how long it took (including timeouts)
+static bool display_lock(uint32_t timeout_ms)
+{
+    uint32_t t0 = now_us();
+    bool ok = xSemaphoreTake(displayMutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+    uint32_t t1 = now_us();
+    perf_mutex_wait_us[xPortGetCoreID()].record(t1 - t0);
+    if (t1 - t0 >= TRACE_MUTEX_MIN_US) TRACE_SPAN(TRACE_MUTEX_WAIT, t0, t1, ok);
+    return ok;
+}
+
+// WiFi/BLE time-slot plan; hopping and promiscuous RX pause during BLE slots
+static RadioScheduler radio_scheduler;
+static unsigned long ble_slot_started = 0;
+static volatile bool wifi_rx_paused = false;  // BLE slot: frames still in flight are dropped
+
+// Patrol mode: duty cycle, energy meter and its current model
+static PatrolPolicy patrol;
+static PatrolMeter patrol_meter;
+static PatrolPowerModel patrol_power = {
+    { PATROL_SCAN_MA_X10, PATROL_IDLE_MA_X10, PATROL_SLEEP_MA_X10 }, PATROL_DISPLAY_MA_X10
+};
+static bool patrol_on = PATROL_MODE;
+static uint32_t patrol_display_ms = PATROL_DISPLAY_MS;
+static uint32_t patrol_metered_ms = 0;    // Energy metered up to here
+static uint32_t patrol_wake_ms = 0;       // Boot, or a sleep ended by touch / button
+static bool patrol_display_on = true;     // What patrol mode last asked of the display
+
+// BLE advert funnel: received (airtime.advertCount) -> filtered by seen-cache / forwarded to matching
+static BleSeenCache ble_seen;
+static BleMatcher ble_matcher;
+
+// Signature pack double buffer. Readers load active_sigpack once per event;
+// a reload fills the idle slot and swaps the pointer, so matching never
+// waits. A slot is only rewritten a full SIGPACK_CHECK_MS after it was
+// retired, long after any reader that picked it up has finished. Nothing
+// may keep pointers into a pack longer than that: detection events carry
+// a BleRule* through the queue (milliseconds), and held alerts, which wait
+// up to SITE_HOLD_MS, copy their rule (see HeldAlert).
+static SignaturePack sigpacks[2];
+static uint8_t* sigpack_images[2] = { nullptr, nullptr };
+static SignaturePack* volatile active_sigpack = nullptr;
+static size_t sigpack_file_size = 0;
+static time_t sigpack_file_time = 0;
+static unsigned long last_sigpack_check = 0;
+
+// Flash-mapped index; flash_sigpack views the pack embedded in it and is the
+// active pack until one is loaded from SD
+static FlashIndex flash_index;
+static SignaturePack flash_sigpack;
+
+// Camera site proximity: latest fix from the position feed, nearest site of
+// the last pre-alert (one alert per site), dwell boost deadline
+static volatile int32_t geo_lat_e7 = 0, geo_lon_e7 = 0;
+static volatile bool geo_fix_pending = false;
+static unsigned long geo_boost_until = 0;
+static uint32_t geo_alerts = 0;
+#ifdef SIGPACK_FS
+static uint32_t geo_alert_m = GEO_ALERT_M;
+static uint32_t geo_boost_ms = GEO_BOOST_MS;
+#endif
+#define SERIAL_POLL_MAX   256        // Serial bytes parsed per loop() pass
+#define PARAMS_NVS_KEY    "params"   // Saved runtime parameters (namespace SNAPSHOT_NVS_NS)
+static char serial_line[PARAM_REPLY_MAX];
+static uint8_t serial_line_len = 0;
+static bool serial_line_overflow = false;
+
+// Position attached to sightings: the latest fix from the UART GPS or the
+// serial feed and when it arrived. Written on Core 1, read on Core 0.
+static GpsTag gps_tag = {};
+static unsigned long gps_tag_ms = 0;
+static portMUX_TYPE gps_mux = portMUX_INITIALIZER_UNLOCKED;
+#ifdef GPS_RX_PIN
+static HardwareSerial gps_uart(GPS_UART_NUM);
+static NmeaParser gps_parser;
+#endif
+#ifdef SIGPACK_FS
+static GeoIndex geo_index;
+static File geo_file;
+static GeoSite geo_alerted;
+static bool geo_in_range = false;
+#endif
+static volatile uint32_t ble_adverts_filtered = 0;
+static volatile uint32_t ble_adverts_forwarded = 0;
+static unsigned long last_dup_reset = 0;
+
+// Lossy single-slot mailbox: onResult drops a non-matching advert here only
+// when the slot is free; loop() hands it to the display under the mutex
+struct BleDebugSample {
+    uint8_t mac[6];
+    char name[21];
+    int8_t rssi;
+};
+static BleDebugSample ble_debug_sample;
+static volatile bool ble_debug_ready = false;
+
+#ifdef BLE_ALLOC_PROBE
+// Heap allocations made inside onResult past the seen-cache (forwarded
+// adverts). IDF's calloc and realloc don't go through malloc, and Arduino
+// String grows with realloc, so all three are wrapped.
+// Build with: -DBLE_ALLOC_PROBE -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+static volatile uint32_t ble_cb_allocs = 0;
+static volatile TaskHandle_t ble_cb_task = NULL;
+
+static inline void ble_probe_count() {
+    if (ble_cb_task && xTaskGetCurrentTaskHandle() == ble_cb_task) ble_cb_allocs++;
+}
+
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t n, size_t size);
+extern "C" void* __real_realloc(void* p, size_t size);
+extern "C" void* __wrap_malloc(size_t size) {
+    ble_probe_count();
+    return __real_malloc(size);
+}
+extern "C" void* __wrap_calloc(size_t n, size_t size) {
+    ble_probe_count();
+    return __real_calloc(n, size);
+}
+extern "C" void* __wrap_realloc(void* p, size_t size) {
+    ble_probe_count();
+    return __real_realloc(p, size);
+}
+#endif
+// Per-second rates over the last stats window
+static uint32_t ble_rx_per_s = 0, ble_filtered_per_s = 0, ble_forwarded_per_s = 0;
 
 
 
@@ -252,62 +561,20 @@ void beep(int frequency, int duration_ms)
 // RGB LED ALERT
 // ============================================================================
 
-// Set RGB LED using PWM (active LOW, so invert values)
-// Applies rgbBrightness scaling when display handler is available
-// Note: Waveshare 1.47" uses WS2812 LED handled by display handler
-#ifndef WAVESHARE_147
-static inline void rgb_pwm(uint8_t r, uint8_t g, uint8_t b) {
-#ifdef CYD_DISPLAY
-    // Scale by RGB brightness setting (0-255)
-    uint8_t scale = display.getRgbBrightness();
-    r = (r * scale) / 255;
-    g = (g * scale) / 255;
-    b = (b * scale) / 255;
-#endif
-    // Active LOW: 255 = off, 0 = full brightness
-    ledcWrite(LED_CH_R, 255 - r);
-    ledcWrite(LED_CH_G, 255 - g);
-    ledcWrite(LED_CH_B, 255 - b);
-}
-
-// Simple on/off for backward compatibility
-static inline void rgb_set(bool r, bool g, bool b) {
-    rgb_pwm(r ? 255 : 0, g ? 255 : 0, b ? 255 : 0);
-}
-
-// Initialize RGB LED PWM
+// Effects run in the "led" task (status_led.h); nothing here is polled from loop()
 void led_init(void) {
-    ledcSetup(LED_CH_R, 5000, 8);  // 5kHz, 8-bit
-    ledcSetup(LED_CH_G, 5000, 8);
-    ledcSetup(LED_CH_B, 5000, 8);
-    ledcAttachPin(RGB_R, LED_CH_R);
-    ledcAttachPin(RGB_G, LED_CH_G);
-    ledcAttachPin(RGB_B, LED_CH_B);
-    rgb_pwm(0, 0, 0);  // Start off
-}
+#ifdef WAVESHARE_147
+    bool ok = status_led.beginWs2812(RGB_LED_PIN);
 #else
-// Waveshare stub functions - LED handled by display handler
-static inline void rgb_pwm(uint8_t r, uint8_t g, uint8_t b) { (void)r; (void)g; (void)b; }
-static inline void rgb_set(bool r, bool g, bool b) { (void)r; (void)g; (void)b; }
-void led_init(void) { }
+    bool ok = status_led.beginLedc(RGB_R, RGB_G, RGB_B, LED_CH_R, LED_CH_G, LED_CH_B);
 #endif
+    if (!ok) printf("[LED] Status LED init failed\n");
+}
 
-// Call on detection — triggers red flash state
+// Call on detection — red flash at a rate set by signal strength, then the
+// alert colour, then back to scanning
 void led_flash_trigger(int8_t rssi) {
-    led_state = LED_DETECTED;
-    led_detection_time = millis();
-    led_detection_rssi = rssi;
-    led_flash_on = true;
-    led_last_toggle = millis();
-#ifdef WAVESHARE_147
-    // Mutex already held by caller (processingTask) or acquired here
-    if (displayMutex && xSemaphoreTake(displayMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        display.setLEDDetection(rssi);
-        xSemaphoreGive(displayMutex);
-    }
-#else
-    rgb_pwm(255, 0, 0);  // Immediate red flash
-#endif
+    status_led.play(LED_FX_DETECT, rssi);
 }
 
 // Overload for backward compatibility
@@ -315,85 +582,6 @@ void led_flash_trigger(void) {
     led_flash_trigger(-70);  // Default RSSI
 }
 
-// Calculate flash interval based on signal strength
-uint32_t get_flash_interval(int8_t rssi) {
-    // Stronger signal (less negative) = faster flash
-    // RSSI typically -30 (very strong) to -90 (very weak)
-    if (rssi >= -40) return LED_FLASH_MIN_INTERVAL;      // Very strong: 50ms
-    if (rssi >= -50) return 100;
-    if (rssi >= -60) return 150;
-    if (rssi >= -70) return 200;
-    if (rssi >= -80) return 300;
-    return LED_FLASH_MAX_INTERVAL;  // Weak: 400ms
-}
-
-// Call every loop iteration — handles LED state machine
-void led_flash_update(void) {
-    uint32_t now = millis();
-
-#ifdef WAVESHARE_147
-    // Waveshare LED is handled by display handler's update() method
-    // Just track state transitions here (called from loop on Core 1)
-    if (led_state == LED_DETECTED && now - led_detection_time >= 5000) {
-        led_state = LED_ALERT;
-        if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-            display.setLEDAlert();
-            xSemaphoreGive(displayMutex);
-        }
-    }
-    if (led_state == LED_ALERT && now - led_detection_time >= LED_ALERT_TIMEOUT) {
-        led_state = LED_SCANNING;
-        if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-            display.setLEDScanning();
-            xSemaphoreGive(displayMutex);
-        }
-    }
-    return;
-#endif
-
-#ifdef CYD_DISPLAY
-    // Check if LED alerts are disabled
-    if (!display.isLedAlertsEnabled()) {
-        rgb_pwm(0, 0, 0);  // LED off when disabled
-        return;
-    }
-#endif
-
-    switch (led_state) {
-        case LED_SCANNING:
-            // Green at 50% brightness
-            rgb_pwm(0, 128, 0);
-            break;
-
-        case LED_DETECTED: {
-            // Red flashing, speed based on signal strength
-            uint32_t interval = get_flash_interval(led_detection_rssi);
-
-            if (now - led_last_toggle >= interval) {
-                led_flash_on = !led_flash_on;
-                rgb_pwm(led_flash_on ? 255 : 0, 0, 0);
-                led_last_toggle = now;
-            }
-
-            // After 5 seconds of no new detection, transition to alert
-            if (now - led_detection_time >= 5000) {
-                led_state = LED_ALERT;
-            }
-            break;
-        }
-
-        case LED_ALERT:
-            // Orange solid (red + green)
-            rgb_pwm(255, 100, 0);
-
-            // After timeout, return to scanning
-            if (now - led_detection_time >= LED_ALERT_TIMEOUT) {
-                led_state = LED_SCANNING;
-            }
-            break;
-    }
-}
-
 void boot_beep_sequence()
 {
     printf("Initializing audio system...\n");
@@ -405,6 +593,7 @@ void boot_beep_sequence()
 
 void flock_detected_beep_sequence()
 {
+    TRACE_BEGIN(TRACE_DETECT_BEEP);
     printf("FLOCK SAFETY DEVICE DETECTED!\n");
     printf("Playing alert sequence: 3 fast high-pitch beeps\n");
     for (int i = 0; i < 3; i++) {
@@ -412,6 +601,7 @@ void flock_detected_beep_sequence()
         if (i < 2) delay(50); // Short gap between beeps
     }
     printf("Detection complete - device identified!\n\n");
+    TRACE_END(TRACE_DETECT_BEEP);
     
     // Mark device as in range and start heartbeat tracking
     device_in_range = true;
@@ -421,17 +611,58 @@ void flock_detected_beep_sequence()
 
 void heartbeat_pulse()
 {
+    TRACE_BEGIN(TRACE_HEARTBEAT);
     printf("Heartbeat: Device still in range\n");
     beep(HEARTBEAT_FREQ, HEARTBEAT_DURATION);
     delay(100);
     beep(HEARTBEAT_FREQ, HEARTBEAT_DURATION);
+    TRACE_END(TRACE_HEARTBEAT);
 }
 
 // ============================================================================
 // JSON OUTPUT FUNCTIONS
 // ============================================================================
 
-void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi, const char* detection_type, TrackedDevice* dev = nullptr)
+// Forward declarations (pattern matching, defined with the detection helpers)
+bool check_mac_prefix(const uint8_t* mac);
+bool check_mac_watchlist(const uint8_t* mac);
+const char* match_ssid_pattern(const char* ssid);
+const char* match_device_name_pattern(const char* name);
+
+// Vendor name for a "aa:bb:cc..." MAC from the flash index, or nullptr
+static const char* flash_vendor(const char* mac_text)
+{
+    unsigned int oui[3];
+    if (!flash_index.attached() || sscanf(mac_text, "%2x:%2x:%2x", &oui[0], &oui[1], &oui[2]) != 3) {
+        return nullptr;
+    }
+    uint8_t bytes[3] = { (uint8_t)oui[0], (uint8_t)oui[1], (uint8_t)oui[2] };
+    return flash_index.vendor(bytes);
+}
+
+// "key": {lat, lon, utc} for a sighting with a position
+static void add_geotag_json(JsonDocument& doc, const char* key, const GpsTag& tag)
+{
+    if (!tag.valid) return;
+    JsonObject o = doc.createNestedObject(key);
+    o["lat"] = tag.lat_e7 * 1e-7;
+    o["lon"] = tag.lon_e7 * 1e-7;
+    if (tag.utc) o["utc"] = tag.utc;
+}
+
+// Sighting positions; the best-RSSI one only once it differs from the first
+static void add_geotags_json(JsonDocument& doc, const TrackedDevice* dev)
+{
+    add_geotag_json(doc, "geotag", dev->first_fix);
+    const GpsTag& a = dev->first_fix;
+    const GpsTag& b = dev->best_fix;
+    if (a.lat_e7 != b.lat_e7 || a.lon_e7 != b.lon_e7 || a.utc != b.utc) {
+        add_geotag_json(doc, "geotag_best", b);
+    }
+}
+
+void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi, const char* detection_type,
+                                const RuleResult& score, TrackedDevice* dev = nullptr)
 {
     DynamicJsonDocument doc(2048);
 
@@ -458,7 +689,7 @@ void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi,
 
 #ifdef HAS_DISPLAY
     // Add detection to display (mutex for thread safety with Core 1 display.update())
-    if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+    if (display_lock(10)) {
 #ifdef CYD_DISPLAY
         display.addDetection(String(ssid), String(mac_str), rssi, String(detection_type), dev);
 #else
@@ -472,32 +703,27 @@ void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi,
     snprintf(mac_prefix, sizeof(mac_prefix), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
     doc["mac_prefix"] = mac_prefix;
     doc["vendor_oui"] = mac_prefix;
+    const char* vendor = flash_vendor(mac_prefix);
+    if (vendor) doc["vendor"] = vendor;
 
     // Detection pattern matching
-    bool ssid_match = false;
-    bool mac_match = false;
-
-    for (size_t i = 0; i < sizeof(wifi_ssid_patterns)/sizeof(wifi_ssid_patterns[0]); i++) {
-        if (strcasestr(ssid, wifi_ssid_patterns[i])) {
-            doc["matched_ssid_pattern"] = wifi_ssid_patterns[i];
-            doc["ssid_match_confidence"] = "HIGH";
-            ssid_match = true;
-            break;
-        }
+    const char* ssid_pattern = match_ssid_pattern(ssid);
+    if (ssid_pattern) {
+        doc["matched_ssid_pattern"] = ssid_pattern;
+        doc["ssid_match_confidence"] = "HIGH";
     }
 
-    for (size_t i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
-        if (strncasecmp(mac_prefix, mac_prefixes[i], 8) == 0) {
-            doc["matched_mac_pattern"] = mac_prefixes[i];
-            doc["mac_match_confidence"] = "HIGH";
-            mac_match = true;
-            break;
-        }
+    if (check_mac_prefix(mac)) {
+        doc["matched_mac_pattern"] = mac_prefix;
+        doc["mac_match_confidence"] = "HIGH";
+    } else if (check_mac_watchlist(mac)) {
+        doc["matched_mac_pattern"] = mac_str;
+        doc["mac_match_confidence"] = "HIGH";
     }
 
-    // Detection summary
-    doc["detection_criteria"] = ssid_match && mac_match ? "SSID_AND_MAC" : (ssid_match ? "SSID_ONLY" : "MAC_ONLY");
-    doc["threat_score"] = ssid_match && mac_match ? 100 : (ssid_match || mac_match ? 85 : 70);
+    // Detection summary (confidence rules)
+    doc["detection_criteria"] = score.criteria;
+    doc["threat_score"] = score.score;
 
     // Frame type details
     if (strcmp(detection_type, "probe_request") == 0 || strcmp(detection_type, "probe_request_mac") == 0) {
@@ -506,6 +732,9 @@ void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi,
     } else if (strcmp(detection_type, "probe_response") == 0 || strcmp(detection_type, "probe_response_mac") == 0) {
         doc["frame_type"] = "PROBE_RESPONSE";
         doc["frame_description"] = "Device responding to network scan";
+    } else if (strcmp(detection_type, "frame_watchlist") == 0) {
+        doc["frame_type"] = "OTHER";
+        doc["frame_description"] = "Frame from a watchlisted transmitter";
     } else {
         doc["frame_type"] = "BEACON";
         doc["frame_description"] = "Device advertising its network";
@@ -520,8 +749,12 @@ void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi,
         if (dev->probe_intervals > 0) {
             doc["avg_probe_interval_ms"] = dev->probe_interval_sum / dev->probe_intervals;
         }
-        int8_t range = dev->rssi_max - dev->rssi_min;
-        doc["signal_trend"] = range < 10 ? "stable" : (range < 20 ? "moderate" : "moving");
+        doc["rssi_filtered"] = dev->track.levelDbm();
+        doc["rssi_rate"] = dev->track.rateDeciDbPerS() / 10.0;
+        doc["signal_trend"] = rssi_phase_name((RssiPhase)dev->track.phase);
+        uint8_t slot = dev - tracked_devices;
+        if (sites.active(slot) && sites.siteId(slot)) doc["site_id"] = sites.siteId(slot);
+        add_geotags_json(doc, dev);
     }
 
     String json_output;
@@ -529,11 +762,24 @@ void output_wifi_detection_json(const char* ssid, const uint8_t* mac, int rssi,
     Serial.println(json_output);
 }
 
-void output_ble_detection_json(const char* mac, const char* name, int rssi, const char* detection_method, TrackedDevice* dev = nullptr)
+// detection_method string for a payload rule kind
+static const char* ble_rule_method(const BleRule* rule)
+{
+    if (!rule) return "payload";
+    switch (rule->kind) {
+    case BLE_RULE_MFG_ID:       return "manufacturer_id";
+    case BLE_RULE_MFG_DATA:     return "manufacturer_data";
+    case BLE_RULE_SERVICE_UUID: return "service_uuid";
+    default:                    return "service_data";
+    }
+}
+
+void output_ble_detection_json(const char* mac, const char* name, int rssi, const char* detection_method,
+                               const RuleResult& score, TrackedDevice* dev = nullptr, const BleRule* rule = nullptr)
 {
 #ifdef HAS_DISPLAY
     // Add BLE detection to display (mutex for thread safety with Core 1 display.update())
-    if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+    if (display_lock(10)) {
 #ifdef CYD_DISPLAY
         display.addDetection(name ? String(name) : "Unknown", String(mac), rssi, "BLE", dev);
 #else
@@ -575,38 +821,40 @@ void output_ble_detection_json(const char* mac, const char* name, int rssi, cons
     mac_prefix[8] = '\0';
     doc["mac_prefix"] = mac_prefix;
     doc["vendor_oui"] = mac_prefix;
+    const char* vendor = flash_vendor(mac_prefix);
+    if (vendor) doc["vendor"] = vendor;
 
     // Detection pattern matching
-    bool name_match = false;
-    bool mac_match = false;
-
     // Check MAC prefix patterns
-    for (size_t i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
-        if (strncasecmp(mac, mac_prefixes[i], strlen(mac_prefixes[i])) == 0) {
-            doc["matched_mac_pattern"] = mac_prefixes[i];
-            doc["mac_match_confidence"] = "HIGH";
-            mac_match = true;
-            break;
-        }
+    uint8_t mac_bytes[6] = {0};
+    sscanf(mac, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &mac_bytes[0], &mac_bytes[1], &mac_bytes[2],
+           &mac_bytes[3], &mac_bytes[4], &mac_bytes[5]);
+    if (check_mac_prefix(mac_bytes)) {
+        doc["matched_mac_pattern"] = mac_prefix;
+        doc["mac_match_confidence"] = "HIGH";
+    } else if (check_mac_watchlist(mac_bytes)) {
+        doc["matched_mac_pattern"] = mac;
+        doc["mac_match_confidence"] = "HIGH";
     }
 
     // Check device name patterns
-    if (name && strlen(name) > 0) {
-        for (size_t i = 0; i < sizeof(device_name_patterns)/sizeof(device_name_patterns[0]); i++) {
-            if (strcasestr(name, device_name_patterns[i])) {
-                doc["matched_name_pattern"] = device_name_patterns[i];
-                doc["name_match_confidence"] = "HIGH";
-                name_match = true;
-                break;
-            }
-        }
+    const char* name_pattern = (name && name[0]) ? match_device_name_pattern(name) : nullptr;
+    if (name_pattern) {
+        doc["matched_name_pattern"] = name_pattern;
+        doc["name_match_confidence"] = "HIGH";
+    }
+
+    // Payload signature (manufacturer ID / service data)
+    if (rule) {
+        doc["matched_payload_rule"] = rule->name;
+        char id_str[7];
+        snprintf(id_str, sizeof(id_str), "0x%04X", rule->id);
+        doc[rule->kind <= BLE_RULE_MFG_DATA ? "company_id" : "service_uuid"] = id_str;
     }
 
-    // Detection summary
-    doc["detection_criteria"] = name_match && mac_match ? "NAME_AND_MAC" :
-                               (name_match ? "NAME_ONLY" : "MAC_ONLY");
-    doc["threat_score"] = name_match && mac_match ? 100 :
-                         (name_match || mac_match ? 85 : 70);
+    // Detection summary (confidence rules)
+    doc["detection_criteria"] = score.criteria;
+    doc["threat_score"] = score.score;
 
     // BLE advertisement type analysis
     doc["advertisement_type"] = "BLE_ADVERTISEMENT";
@@ -619,6 +867,9 @@ void output_ble_detection_json(const char* mac, const char* name, int rssi, cons
     } else if (strcmp(detection_method, "device_name") == 0) {
         doc["primary_indicator"] = "DEVICE_NAME";
         doc["detection_reason"] = "Device name matches Flock Safety pattern";
+    } else if (rule) {
+        doc["primary_indicator"] = "ADVERTISEMENT_PAYLOAD";
+        doc["detection_reason"] = "Advertisement payload matches a known signature";
     }
 
     // Enriched tracking data
@@ -630,21 +881,420 @@ void output_ble_detection_json(const char* mac, const char* name, int rssi, cons
         if (dev->probe_intervals > 0) {
             doc["avg_probe_interval_ms"] = dev->probe_interval_sum / dev->probe_intervals;
         }
-        int8_t range = dev->rssi_max - dev->rssi_min;
-        doc["signal_trend"] = range < 10 ? "stable" : (range < 20 ? "moderate" : "moving");
+        doc["rssi_filtered"] = dev->track.levelDbm();
+        doc["rssi_rate"] = dev->track.rateDeciDbPerS() / 10.0;
+        doc["signal_trend"] = rssi_phase_name((RssiPhase)dev->track.phase);
+        uint8_t slot = dev - tracked_devices;
+        if (sites.active(slot) && sites.siteId(slot)) doc["site_id"] = sites.siteId(slot);
+        add_geotags_json(doc, dev);
+    }
+
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+}
+
+// Convert BLE funnel counters into per-second rates for the window just closed
+static void update_ble_rates(uint32_t window_adverts, uint32_t span_us)
+{
+    static uint32_t prev_filtered = 0, prev_forwarded = 0;
+    uint32_t filtered = ble_adverts_filtered;
+    uint32_t forwarded = ble_adverts_forwarded;
+
+    ble_rx_per_s = (uint32_t)((uint64_t)window_adverts * 1000000 / span_us);
+    ble_filtered_per_s = (uint32_t)((uint64_t)(filtered - prev_filtered) * 1000000 / span_us);
+    ble_forwarded_per_s = (uint32_t)((uint64_t)(forwarded - prev_forwarded) * 1000000 / span_us);
+    prev_filtered = filtered;
+    prev_forwarded = forwarded;
+}
+
+// Capacity of the fullest stats record: GPS, geo index and alloc probe
+// compiled in, slotted scheduler, every channel visited. Keys and string
+// values are literals, so only slots count: 149 of them, 2384 bytes on ESP32.
+#define STATS_JSON_SIZE (JSON_OBJECT_SIZE(21) +                        /* top level */          \
+                         JSON_OBJECT_SIZE(6) + JSON_OBJECT_SIZE(10) +  /* sites, snapshot */    \
+                         JSON_OBJECT_SIZE(6) + JSON_OBJECT_SIZE(13) +  /* gps, airtime */       \
+                         JSON_ARRAY_SIZE(AIRTIME_CHANNELS) +           /* channels */           \
+                         AIRTIME_CHANNELS * JSON_ARRAY_SIZE(3) +       /* channel rows */       \
+                         JSON_OBJECT_SIZE(7) +                         /* rolling */            \
+                         3 * JSON_OBJECT_SIZE(5) +                     /* scheduler */          \
+                         JSON_OBJECT_SIZE(10) + JSON_OBJECT_SIZE(9))   /* patrol, ble */
+
+// Structured stats record: pipeline counters + airtime ledger (last window and rolling minute)
+void output_stats_json(unsigned queue_depth)
+{
+    DynamicJsonDocument doc(STATS_JSON_SIZE);
+    const AirtimeWindow& w = airtime.last();
+
+    doc["type"] = "stats";
+    doc["timestamp"] = millis();
+    doc["frames"] = total_frames_seen;
+    doc["ssids"] = total_ssids_seen;
+    doc["channel"] = current_channel;
+    doc["queue_depth"] = queue_depth;
+    doc["processed"] = events_processed;
+    doc["dropped"] = events_dropped;
+    doc["tracked"] = hash_entries;
+    const SignaturePack* pack = active_sigpack;
+    doc["sigpack"] = pack ? pack->version() : 0;
+    doc["watchlist_fp"] = pack ? pack->watchlist().falsePositives() : 0;
+    doc["flash_ouis"] = flash_index.ouiCount();
+#ifdef SIGPACK_FS
+    doc["geo_sites"] = geo_index.siteCount();
+#endif
+    doc["geo_alerts"] = geo_alerts;
+    JsonObject site = doc.createNestedObject("sites");
+    site["active"] = sites.sites();
+    site["mac_joins"] = sites.joins[SITE_JOIN_MAC_ADJACENT];
+    site["co_joins"] = sites.joins[SITE_JOIN_CO_OCCURRENCE];
+    site["held"] = site_held;
+    site["folded"] = site_folded;
+    site["pair_evictions"] = sites.pair_evictions;
+    JsonObject snap = doc.createNestedObject("snapshot");
+    snap["seq"] = snapshot_seq;
+    snap["writes"] = snapshot_writes;
+    snap["failures"] = snapshot_failures;
+    snap["bytes"] = snapshot_len;
+    snap["dropped"] = snapshot_dropped;
+    snap["encode_us"] = snapshot_encode_us;
+    snap["store_ms"] = snapshot_store_ms;
+    snap["store_max_ms"] = snapshot_store_max_ms;
+    snap["restored"] = snapshot_restored;
+    snap["restore_us"] = snapshot_restore_us;
+#ifdef GPS_RX_PIN
+    JsonObject gps = doc.createNestedObject("gps");
+    const GpsFix& fix = gps_parser.fix();
+    gps["fix"] = fix.valid;
+    gps["sats"] = fix.sats;
+    gps["hdop"] = fix.hdop_x10 / 10.0f;
+    gps["sentences"] = gps_parser.sentences();
+    gps["checksum_errors"] = gps_parser.checksumErrors();
+    gps["malformed"] = gps_parser.malformed();
+#endif
+
+    JsonObject air = doc.createNestedObject("airtime");
+    air["window_ms"] = w.span_us / 1000;
+    air["listen_ms"] = w.totalListenUs() / 1000;
+    air["switch_us"] = w.switch_us;
+    air["switches"] = w.switches;
+    air["ble_ms"] = w.ble_us / 1000;
+    air["ble_windows"] = w.ble_windows;
+    air["overlap_ms"] = w.overlap_us / 1000;
+    air["frames_per_ms"] = w.totalListenUs() ? w.totalFrames() * 1000.0f / w.totalListenUs() : 0.0f;
+    air["adverts"] = w.adverts;
+    air["adverts_per_ms"] = w.advertsPerMs();
+    air["sleep_ms"] = w.sleep_us / 1000;
+
+    // Per-channel [channel, listen_ms, frames] for channels visited this window
+    JsonArray chans = air.createNestedArray("channels");
+    for (uint8_t ch = 1; ch <= AIRTIME_CHANNELS; ch++) {
+        if (w.listen_us[ch] == 0) continue;
+        JsonArray row = chans.createNestedArray();
+        row.add(ch);
+        row.add(w.listen_us[ch] / 1000);
+        row.add(w.frames[ch]);
+    }
+
+    AirtimeWindow minute;
+    airtime.sum(AIRTIME_HISTORY, minute);
+    JsonObject roll = air.createNestedObject("rolling");
+    roll["window_ms"] = minute.span_us / 1000;
+    roll["listen_ms"] = minute.totalListenUs() / 1000;
+    roll["switch_ms"] = minute.switch_us / 1000;
+    roll["ble_ms"] = minute.ble_us / 1000;
+    roll["overlap_ms"] = minute.overlap_us / 1000;
+    roll["frames_per_ms"] = minute.totalListenUs() ? minute.totalFrames() * 1000.0f / minute.totalListenUs() : 0.0f;
+    roll["adverts_per_ms"] = minute.advertsPerMs();
+
+    // Slot plan totals (lifetime) so slotted vs legacy yield can be compared
+    JsonObject sched = doc.createNestedObject("scheduler");
+    sched["mode"] = BLE_SCAN_MODE == BLE_MODE_SLOTTED ? "slotted" :
+                    BLE_SCAN_MODE == BLE_MODE_CONTINUOUS ? "continuous" : "legacy";
+    if (BLE_SCAN_MODE == BLE_MODE_SLOTTED) {
+        sched["frame_ms"] = radio_scheduler.frame_ms;
+        sched["wifi_share"] = radio_scheduler.activeWifiSharePct();
+        const char* names[2] = { "wifi", "ble" };
+        for (uint8_t i = 0; i < 2; i++) {
+            const RadioSlotStats& st = radio_scheduler.stats((RadioSlot)i);
+            JsonObject o = sched.createNestedObject(names[i]);
+            o["slots"] = st.slots;
+            o["ms"] = st.ms;
+            o["units"] = st.units;
+            o["per_ms"] = st.yield();
+            o["detections"] = st.detections;
+        }
+    }
+
+    // Patrol duty cycle and metered energy (lifetime, whether or not patrol is on)
+    JsonObject pat = doc.createNestedObject("patrol");
+    pat["on"] = patrol_on;
+    pat["duty_pct"] = patrol.dutyPct();
+    pat["density"] = patrol.density();
+    pat["sleeps"] = patrol.sleeps();
+    pat["sleep_ms"] = patrol_meter.ms(PATROL_POWER_SLEEP);
+    pat["display_ms"] = patrol_meter.displayMs();
+    pat["mah"] = patrol_meter.mAh(patrol_power);
+    pat["avg_ma"] = patrol_meter.averageMa(patrol_power);
+    pat["detections"] = patrol.detections();
+    pat["per_mah"] = patrol_meter.perMah(patrol.detections(), patrol_power);
+
+    JsonObject ble = doc.createNestedObject("ble");
+    ble["received"] = airtime.advertCount();
+    ble["filtered"] = ble_adverts_filtered;
+    ble["forwarded"] = ble_adverts_forwarded;
+    ble["received_per_s"] = ble_rx_per_s;
+    ble["filtered_per_s"] = ble_filtered_per_s;
+    ble["forwarded_per_s"] = ble_forwarded_per_s;
+    ble["seen_cache"] = ble_seen.occupancy();
+#ifdef BLE_ALLOC_PROBE
+    ble["cb_allocs"] = ble_cb_allocs;
+    ble["allocs_per_forwarded"] = ble_adverts_forwarded ? (float)ble_cb_allocs / ble_adverts_forwarded : 0.0f;
+#endif
+
+    if (doc.overflowed()) printf("[STATS] Record truncated, raise STATS_JSON_SIZE\n");
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+}
+
+// ============================================================================
+// PERFORMANCE REGISTRY DUMP (serial "PERF" command)
+// ============================================================================
+
+#define PERF_MAX_TASKS 24
+
+static void init_perf()
+{
+    perf_cpu_mhz = getCpuFrequencyMhz();
+    perf.addCounter("frames", &total_frames_seen);
+    perf.addCounter("processed", &events_processed);
+    perf.addCounter("dropped", &events_dropped);
+    perf.addCounter("ble_filtered", &ble_adverts_filtered);
+    perf.addCounter("ble_forwarded", &ble_adverts_forwarded);
+    perf.addGauge("queue_depth", "events", &perf_queue_depth);
+    perf.addGauge("tracked", "devices", &perf_tracked);
+    perf.addHistogram("sniffer_cb", "ns", &perf_sniffer_ns);
+    perf.addHistogram("ble_cb", "ns", &perf_ble_cb_ns);
+    perf.addHistogram("queue_residency", "us", &perf_queue_us);
+    perf.addHistogram("process_event", "us", &perf_process_us);
+    perf.addHistogram("display_frame", "us", &perf_display_us);
+    perf.addHistogram("sd_write", "us", &perf_sd_write_us);
+    perf.addHistogram("mutex_wait_core0", "us", &perf_mutex_wait_us[0]);
+    perf.addHistogram("mutex_wait_core1", "us", &perf_mutex_wait_us[1]);
+    perf.addHistogram("loop", "us", &perf_loop_us);
+#ifdef HAS_DISPLAY
+    display.setSdTiming(&perf_sd_write_us);
+#endif
+    perf_window_us = now_us();
+}
+
+#if configUSE_TRACE_FACILITY
+// Task table, and each task's run time at the previous dump for CPU shares
+static TaskStatus_t perf_tasks[PERF_MAX_TASKS];
+#if configGENERATE_RUN_TIME_STATS
+static struct { UBaseType_t number; uint32_t runtime; } perf_task_prev[PERF_MAX_TASKS];
+static uint8_t perf_task_prev_count = 0;
+static uint32_t perf_total_prev = 0;
+#endif
+
+// One row per FreeRTOS task: stack headroom, and with run-time stats
+// compiled in, the share of one core it used since the previous dump
+static void add_task_stats(JsonArray tasks)
+{
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(perf_tasks, PERF_MAX_TASKS, &total);
+#if configGENERATE_RUN_TIME_STATS
+    uint32_t elapsed = total - perf_total_prev;
+#endif
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t& t = perf_tasks[i];
+        JsonObject o = tasks.createNestedObject();
+        o["name"] = t.pcTaskName;
+        o["prio"] = t.uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID
+        o["core"] = t.xCoreID > 1 ? -1 : (int)t.xCoreID;  // -1: not pinned
+#endif
+        o["stack_free"] = t.usStackHighWaterMark;
+#if configGENERATE_RUN_TIME_STATS
+        for (uint8_t j = 0; j < perf_task_prev_count; j++) {
+            if (perf_task_prev[j].number != t.xTaskNumber) continue;
+            if (elapsed) o["cpu_pct"] = (uint32_t)((uint64_t)(t.ulRunTimeCounter - perf_task_prev[j].runtime) * 1000 / elapsed) / 10.0f;
+            break;
+        }
+#endif
+    }
+#if configGENERATE_RUN_TIME_STATS
+    for (UBaseType_t i = 0; i < n; i++) {
+        perf_task_prev[i].number = perf_tasks[i].xTaskNumber;
+        perf_task_prev[i].runtime = perf_tasks[i].ulRunTimeCounter;
+    }
+    perf_task_prev_count = n;
+    perf_total_prev = total;
+#endif
+}
+#else
+// Without the trace facility only our own tasks' stack headroom is known
+static void add_task_stats(JsonArray tasks)
+{
+    JsonObject detect = tasks.createNestedObject();
+    detect["name"] = "detect";
+    detect["stack_free"] = uxTaskGetStackHighWaterMark(processingTaskHandle);
+    JsonObject main_loop = tasks.createNestedObject();
+    main_loop["name"] = pcTaskGetName(NULL);
+    main_loop["stack_free"] = uxTaskGetStackHighWaterMark(NULL);
+}
+#endif
+
+// Everything in the registry as one "perf" record. Histograms cover the
+// window since boot or the last PERF RESET; buckets[i] counts values below
+// 2^i (and at least 2^(i-1)), trimmed after the last non-empty one.
+static void output_perf_json()
+{
+    DynamicJsonDocument doc(12288);
+    uint32_t window_us = now_us() - perf_window_us;
+
+    doc["type"] = "perf";
+    doc["timestamp"] = millis();
+    doc["window_ms"] = window_us / 1000;
+    doc["cpu_mhz"] = perf_cpu_mhz;
+
+    JsonObject counters = doc.createNestedObject("counters");
+    JsonObject gauges = doc.createNestedObject("gauges");
+    JsonObject hists = doc.createNestedObject("histograms");
+    for (uint8_t i = 0; i < perf.size(); i++) {
+        const PerfMetric& m = perf.metric(i);
+        if (m.kind == PERF_COUNTER) {
+            counters[m.name] = (uint32_t)*m.counter;
+        } else if (m.kind == PERF_GAUGE) {
+            JsonObject g = gauges.createNestedObject(m.name);
+            g["unit"] = m.unit;
+            g["value"] = m.gauge->value;
+            g["max"] = m.gauge->max;
+        } else {
+            const PerfHistogram& h = *m.histogram;
+            JsonObject o = hists.createNestedObject(m.name);
+            o["unit"] = m.unit;
+            o["count"] = h.count;
+            o["mean"] = h.mean();
+            o["p50"] = h.percentile(50);
+            o["p90"] = h.percentile(90);
+            o["p99"] = h.percentile(99);
+            o["max"] = h.max;
+            JsonArray buckets = o.createNestedArray("buckets");
+            for (uint8_t b = 0; b < h.usedBuckets(); b++) buckets.add(h.buckets[b]);
+        }
+    }
+
+    // Busy share of the two loops we own, from their own timings
+    JsonObject busy = doc.createNestedObject("busy_pct");
+    if (window_us) {
+        busy["detect"] = (uint32_t)(perf_process_us.sum * 1000 / window_us) / 10.0f;
+        busy["loop"] = (uint32_t)(perf_loop_us.sum * 1000 / window_us) / 10.0f;
+    }
+
+    add_task_stats(doc.createNestedArray("tasks"));
+
+    JsonObject heap = doc.createNestedObject("heap");
+    heap["free"] = ESP.getFreeHeap();
+    heap["min_free"] = ESP.getMinFreeHeap();
+    heap["largest"] = ESP.getMaxAllocHeap();
+
+    if (doc.overflowed()) printf("[PERF] Record truncated, raise the document size\n");
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+}
+
+// "PERF RESET": start a new histogram window
+static void perf_reset()
+{
+    perf.reset();
+    perf_window_us = now_us();
+    printf("[PERF] Histograms and gauge maxima cleared\n");
+}
+
+// ============================================================================
+// EVENT TRACE DUMP (serial "TRACE" command, tools/trace2chrome.py)
+// ============================================================================
+
+#if TRACE_ENABLED
+// Start recording and measure what a span costs on this chip
+static void init_trace()
+{
+    strcpy(trace_task_names[TRACE_MAX_TASKS], "other");
+    trace_ring.setSource(now_us, trace_track);
+
+    const int spans = 256;
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < spans; i++) {
+        TRACE_BEGIN(TRACE_PROCESS_EVENT);
+        TRACE_END(TRACE_PROCESS_EVENT);
     }
+    trace_span_ns = cycles_to_ns(ESP.getCycleCount() - start) / spans;
+    trace_ring.clear();
+    printf("[TRACE] %u-event ring (%u bytes), a span costs %u ns\n",
+           TRACE_RING_EVENTS, (unsigned)sizeof(TraceEvent) * TRACE_RING_EVENTS, trace_span_ns);
+}
+
+// Header record, the events oldest first in "trace_events" chunks of
+// [ts_us, point, phase, core, task, arg], then "trace_end". The ring is
+// frozen for the dump and cleared after it, so successive dumps do not
+// overlap; the gap while the dump is printed shows up in the next one.
+static void output_trace_json()
+{
+    trace_ring.freeze();
+    delay(2);  // Let writers that already reserved a slot fill it
+    uint32_t n = trace_ring.count();
 
+    DynamicJsonDocument doc(2048);
+    doc["type"] = "trace";
+    doc["now_us"] = now_us();
+    doc["events"] = n;
+    doc["lost"] = trace_ring.lost();
+    doc["span_ns"] = trace_span_ns;
+    JsonArray points = doc.createNestedArray("points");
+    for (uint8_t i = 0; i < TRACE_POINT_COUNT; i++) points.add(trace_point_names[i]);
+    JsonArray tasks = doc.createNestedArray("tasks");
+    for (uint8_t i = 0; i < trace_task_count; i++) tasks.add(trace_task_names[i]);
     String json_output;
     serializeJson(doc, json_output);
     Serial.println(json_output);
+
+    static char line[64 + TRACE_DUMP_CHUNK * 40];
+    for (uint32_t i = 0; i < n; ) {
+        int len = snprintf(line, sizeof(line), "{\"type\":\"trace_events\",\"e\":[");
+        for (uint32_t k = 0; k < TRACE_DUMP_CHUNK && i < n; k++, i++) {
+            const TraceEvent& e = trace_ring.at(i);
+            len += snprintf(line + len, sizeof(line) - len, "%s[%u,%u,%u,%u,%u,%u]", k ? "," : "",
+                            e.ts_us, e.tracePoint(), e.phase(), e.core(), e.task(), e.arg);
+        }
+        snprintf(line + len, sizeof(line) - len, "]}");
+        Serial.println(line);
+    }
+    Serial.printf("{\"type\":\"trace_end\",\"events\":%u}\n", n);
+
+    trace_ring.clear();
+    trace_ring.thaw();
 }
+#endif
 
 // ============================================================================
 // DETECTION HELPER FUNCTIONS
 // ============================================================================
 
 // Forward declaration
-static void update_tracked_device(TrackedDevice* dev, int8_t rssi, uint8_t channel, uint8_t type);
+static RssiEvent update_tracked_device(TrackedDevice* dev, int8_t rssi, uint8_t channel, uint8_t type);
+
+// Latest position if it is fresh enough to tag a sighting with
+static GpsTag current_geotag()
+{
+    portENTER_CRITICAL(&gps_mux);
+    GpsTag tag = gps_tag;
+    bool fresh = millis() - gps_tag_ms <= GPS_FIX_MAX_AGE_MS;
+    portEXIT_CRITICAL(&gps_mux);
+    if (!fresh) tag.valid = false;
+    return tag;
+}
 
 // Find tracked device by MAC hash, returns pointer or nullptr
 static TrackedDevice* find_tracked(const uint8_t* mac) {
@@ -665,8 +1315,8 @@ bool is_already_detected(const uint8_t* mac)
     TrackedDevice* dev = find_tracked(mac);
     if (!dev) return false;
 
-    // TTL check: if last seen > DETECTION_TTL ago, treat as expired
-    if (millis() - dev->last_seen > DETECTION_TTL) return false;
+    // TTL check: if last seen > detection_ttl_ms ago, treat as expired
+    if (millis() - dev->last_seen > detection_ttl_ms) return false;
 
     return true;
 }
@@ -696,6 +1346,11 @@ void add_detected_device(const uint8_t* mac, int8_t rssi, uint8_t channel, uint8
             dev.last_seen = now;
             dev.probe_interval_sum = 0;
             dev.probe_intervals = 0;
+            dev.first_fix = current_geotag();
+            dev.best_fix = dev.first_fix;
+            dev.track.reset(rssi, now);
+            dev.history.record(rssi, now);
+            dev.threat_score = 0;
             hash_entries++;
             if (probe > 0) hash_collisions++;
             return;
@@ -709,13 +1364,19 @@ void add_detected_device(const uint8_t* mac, int8_t rssi, uint8_t channel, uint8
     printf("[WARN] Tracked device table probe limit reached (%u entries)\n", hash_entries);
 }
 
-// Update existing tracked device with new detection data
-static void update_tracked_device(TrackedDevice* dev, int8_t rssi, uint8_t channel, uint8_t type) {
+// Update existing tracked device with new detection data; returns the
+// proximity event the sighting caused, if any
+static RssiEvent update_tracked_device(TrackedDevice* dev, int8_t rssi, uint8_t channel, uint8_t type) {
     uint32_t now = millis();
 
-    // RSSI trending
+    // RSSI trending; the strongest sighting with a position is the best
+    // estimate of where the device is
     dev->rssi_last = rssi;
     if (rssi < dev->rssi_min) dev->rssi_min = rssi;
+    if (rssi > dev->rssi_max || !dev->best_fix.valid) {
+        GpsTag tag = current_geotag();
+        if (tag.valid) dev->best_fix = tag;
+    }
     if (rssi > dev->rssi_max) dev->rssi_max = rssi;
     dev->rssi_sum += rssi;
 
@@ -730,43 +1391,86 @@ static void update_tracked_device(TrackedDevice* dev, int8_t rssi, uint8_t chann
     dev->last_seen = now;
     dev->last_channel = channel;
     dev->type = type;
+    dev->history.record(rssi, now);
+    return dev->track.update(rssi, now);
+}
+
+// mac_prefixes[] parsed once into bytes so the hot paths compare 3 bytes
+// instead of formatting the MAC and doing string compares per prefix
+#define MAC_PREFIX_COUNT (sizeof(mac_prefixes)/sizeof(mac_prefixes[0]))
+static uint8_t mac_prefix_bytes[MAC_PREFIX_COUNT][3];
+
+void init_mac_prefixes()
+{
+    for (size_t i = 0; i < MAC_PREFIX_COUNT; i++) {
+        unsigned a = 0, b = 0, c = 0;
+        sscanf(mac_prefixes[i], "%x:%x:%x", &a, &b, &c);
+        mac_prefix_bytes[i][0] = a;
+        mac_prefix_bytes[i][1] = b;
+        mac_prefix_bytes[i][2] = c;
+    }
 }
 
 bool check_mac_prefix(const uint8_t* mac)
 {
-    char mac_str[9];  // Only need first 3 octets for prefix check
-    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
-    
-    for (int i = 0; i < sizeof(mac_prefixes)/sizeof(mac_prefixes[0]); i++) {
-        if (strncasecmp(mac_str, mac_prefixes[i], 8) == 0) {
+    const SignaturePack* pack = active_sigpack;
+    if (pack) return pack->matchOui(mac);
+
+    for (size_t i = 0; i < MAC_PREFIX_COUNT; i++) {
+        if (mac[0] == mac_prefix_bytes[i][0] &&
+            mac[1] == mac_prefix_bytes[i][1] &&
+            mac[2] == mac_prefix_bytes[i][2]) {
             return true;
         }
     }
     return false;
 }
 
-bool check_ssid_pattern(const char* ssid)
+// Full-MAC watchlist (signature pack only)
+bool check_mac_watchlist(const uint8_t* mac)
 {
-    if (!ssid) return false;
-    
-    for (int i = 0; i < sizeof(wifi_ssid_patterns)/sizeof(wifi_ssid_patterns[0]); i++) {
+    const SignaturePack* pack = active_sigpack;
+    return pack && pack->matchMac(mac);
+}
+
+// Matched SSID pattern or nullptr
+const char* match_ssid_pattern(const char* ssid)
+{
+    if (!ssid) return nullptr;
+    const SignaturePack* pack = active_sigpack;
+    if (pack) return pack->matchSsid(ssid);
+
+    for (size_t i = 0; i < sizeof(wifi_ssid_patterns)/sizeof(wifi_ssid_patterns[0]); i++) {
         if (strcasestr(ssid, wifi_ssid_patterns[i])) {
-            return true;
+            return wifi_ssid_patterns[i];
         }
     }
-    return false;
+    return nullptr;
 }
 
-bool check_device_name_pattern(const char* name)
+// Matched device name pattern or nullptr
+const char* match_device_name_pattern(const char* name)
 {
-    if (!name) return false;
-    
-    for (int i = 0; i < sizeof(device_name_patterns)/sizeof(device_name_patterns[0]); i++) {
+    if (!name) return nullptr;
+    const SignaturePack* pack = active_sigpack;
+    if (pack) return pack->matchName(name);
+
+    for (size_t i = 0; i < sizeof(device_name_patterns)/sizeof(device_name_patterns[0]); i++) {
         if (strcasestr(name, device_name_patterns[i])) {
-            return true;
+            return device_name_patterns[i];
         }
     }
-    return false;
+    return nullptr;
+}
+
+bool check_ssid_pattern(const char* ssid)
+{
+    return match_ssid_pattern(ssid) != nullptr;
+}
+
+bool check_device_name_pattern(const char* name)
+{
+    return match_device_name_pattern(name) != nullptr;
 }
 
 // ============================================================================
@@ -783,14 +1487,19 @@ typedef struct {
     uint8_t addr4[6]; /* optional */
 } wifi_ieee80211_mac_hdr_t;
 
+#define MGMT_HDR_LEN 24  // Management frames carry no addr4: the body starts here
+#define ADDR2_END    16  // Frame control, duration, addr1, addr2
+#define WIFI_FCS_LEN 4
+
 typedef struct {
     wifi_ieee80211_mac_hdr_t hdr;
     uint8_t payload[0]; /* network data ended with 4 bytes csum (CRC32) */
 } wifi_ieee80211_packet_t;
 
-void wifi_sniffer_packet_handler(void* buff, wifi_promiscuous_pkt_type_t type)
+static void sniff_frame(void* buff, wifi_promiscuous_pkt_type_t type)
 {
-    total_frames_seen++;
+    if (wifi_rx_paused) return;
+    if (++total_frames_seen == 1) boot_first_frame_us = (uint32_t)esp_timer_get_time();
 
     const wifi_promiscuous_pkt_t *ppkt = (wifi_promiscuous_pkt_t *)buff;
     const wifi_ieee80211_packet_t *ipkt = (wifi_ieee80211_packet_t *)ppkt->payload;
@@ -799,25 +1508,48 @@ void wifi_sniffer_packet_handler(void* buff, wifi_promiscuous_pkt_type_t type)
     // Track channel activity for adaptive dwell
     uint8_t ch = ppkt->rx_ctrl.channel;
     if (ch >= 1 && ch <= 13) channel_activity[ch]++;
+    airtime.addFrame(ch);
 
     // Check for probe requests (0x04), probe responses (0x05), and beacons (0x08)
     uint8_t frame_type = (hdr->frame_ctrl & 0xFF) >> 2;
 
     if (frame_type != 0x10 && frame_type != 0x14 && frame_type != 0x20) {
+        // Any other frame only matters if its transmitter is on the full-MAC
+        // watchlist (cuckoo filter: two bucket reads, exact table on a hit).
+        // Control frames are skipped: ACK and CTS carry no transmitter address.
+        if (type == WIFI_PKT_CTRL || ppkt->rx_ctrl.sig_len < ADDR2_END + WIFI_FCS_LEN) return;
+        if (detectionQueue && check_mac_watchlist(hdr->addr2)) {
+            DetectionEvent evt;
+            memcpy(evt.mac, hdr->addr2, 6);
+            evt.ssid[0] = '\0';
+            evt.rssi = ppkt->rx_ctrl.rssi;
+            evt.channel = ch;
+            evt.type = 6;  // 6=wifi_watchlist (non-beacon/probe frame)
+            evt.rule = nullptr;
+            evt.ie_fp = 0;
+            evt.mfg_id = -1;
+            evt.queued_us = now_us();
+            if (xQueueSend(detectionQueue, &evt, 0) != pdTRUE) {
+                events_dropped++;
+                TRACE_INSTANT(TRACE_QUEUE_DROP, evt.type);
+            }
+        }
         return;  // Not probe req (0x10), probe resp (0x14), or beacon (0x20)
     }
 
     // Extract SSID from management frame
     char ssid[33] = {0};
-    uint8_t *payload = (uint8_t *)ipkt->payload;
+    const uint8_t *payload = ppkt->payload + MGMT_HDR_LEN;
+    int ie_len = (int)ppkt->rx_ctrl.sig_len - MGMT_HDR_LEN - WIFI_FCS_LEN;
 
     if (frame_type == 0x14 || frame_type == 0x20) {
         // Probe response & beacon: skip timestamp(8) + beacon_interval(2) + capability(2) = 12 bytes
         payload += 12;
+        ie_len -= 12;
     }
 
     // Parse SSID element (tag 0, length, data)
-    if (payload[0] == 0 && payload[1] > 0 && payload[1] <= 32) {
+    if (ie_len >= 2 && payload[0] == 0 && payload[1] > 0 && payload[1] <= 32 && payload[1] + 2 <= ie_len) {
         memcpy(ssid, &payload[2], payload[1]);
         ssid[payload[1]] = '\0';
         total_ssids_seen++;
@@ -832,59 +1564,109 @@ void wifi_sniffer_packet_handler(void* buff, wifi_promiscuous_pkt_type_t type)
         evt.rssi = ppkt->rx_ctrl.rssi;
         evt.channel = ch;
         evt.type = (frame_type == 0x10) ? 0 : ((frame_type == 0x14) ? 4 : 1);  // 0=probe_req, 1=beacon, 4=probe_resp
+        evt.rule = nullptr;
+        evt.ie_fp = ie_len > 0 ? ie_fingerprint(payload, ie_len) : 0;
+        evt.mfg_id = -1;
+        evt.queued_us = now_us();
 
         if (xQueueSend(detectionQueue, &evt, 0) != pdTRUE) {
             events_dropped++;
+            TRACE_INSTANT(TRACE_QUEUE_DROP, evt.type);
         }
     }
 }
 
+void wifi_sniffer_packet_handler(void* buff, wifi_promiscuous_pkt_type_t type)
+{
+    uint32_t start = ESP.getCycleCount();
+    sniff_frame(buff, type);
+    perf_sniffer_ns.record(cycles_to_ns(ESP.getCycleCount() - start));
+}
+
 // ============================================================================
 // BLE SCANNING
 // ============================================================================
 
 class AdvertisedDeviceCallbacks: public NimBLEAdvertisedDeviceCallbacks {
     void onResult(NimBLEAdvertisedDevice* advertisedDevice) {
+        uint32_t start = ESP.getCycleCount();
+        handleAdvert(advertisedDevice);
+        perf_ble_cb_ns.record(cycles_to_ns(ESP.getCycleCount() - start));
+    }
+
+    void handleAdvert(NimBLEAdvertisedDevice* advertisedDevice) {
+        airtime.addAdvert();
 
+        // Seen-cache: drop unchanged repeats before any parsing
         NimBLEAddress addr = advertisedDevice->getAddress();
-        std::string addrStr = addr.toString();
-        uint8_t mac[6];
-        sscanf(addrStr.c_str(), "%02x:%02x:%02x:%02x:%02x:%02x",
-               &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
+        if (!ble_seen.check(addr.getNative(), advertisedDevice->getPayload(),
+                            (uint8_t)advertisedDevice->getPayloadLength(), millis())) {
+            ble_adverts_filtered++;
+            return;
+        }
+        ble_adverts_forwarded++;
+#ifdef BLE_ALLOC_PROBE
+        ble_cb_task = xTaskGetCurrentTaskHandle();
+#endif
 
+        // NimBLE stores the address little-endian; flip to display order
+        const uint8_t* native = addr.getNative();
+        uint8_t mac[6];
+        for (int i = 0; i < 6; i++) mac[i] = native[5 - i];
+
+        // One pass over the raw AD structures: payload signatures + local name
+        char name[33];
+        int32_t company = -1;
+        const SignaturePack* pack = active_sigpack;
+        const BleMatcher& matcher = pack ? pack->bleMatcher() : ble_matcher;
+        const BleRule* rule = matcher.match(advertisedDevice->getPayload(),
+                                                advertisedDevice->getPayloadLength(),
+                                                name, sizeof(name), &company);
         int rssi = advertisedDevice->getRSSI();
-        std::string name = "";
-        if (advertisedDevice->haveName()) {
-            name = advertisedDevice->getName();
-        }
 
         // Quick check: does this device match any pattern?
-        bool mac_match = check_mac_prefix(mac);
-        bool name_match = !name.empty() && check_device_name_pattern(name.c_str());
+        bool mac_match = check_mac_prefix(mac) || check_mac_watchlist(mac);
+        bool name_match = name[0] && check_device_name_pattern(name);
 
-        if (!mac_match && !name_match) {
+        if (!mac_match && !name_match && !rule) {
 #ifdef HAS_DISPLAY
-            // Still show non-matching BLE devices on display for debug
-            if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-                display.showDebugBLE(String(name.c_str()), String(addrStr.c_str()), rssi);
-                xSemaphoreGive(displayMutex);
+            // Still show non-matching BLE devices on display for debug (lossy)
+            if (!ble_debug_ready) {
+                memcpy(ble_debug_sample.mac, mac, 6);
+                strncpy(ble_debug_sample.name, name, sizeof(ble_debug_sample.name) - 1);
+                ble_debug_sample.name[sizeof(ble_debug_sample.name) - 1] = '\0';
+                ble_debug_sample.rssi = rssi;
+                ble_debug_ready = true;
             }
+#endif
+#ifdef BLE_ALLOC_PROBE
+            ble_cb_task = NULL;
 #endif
             return;
         }
 
-        // Enqueue matching BLE detection for processing
+        // Enqueue matching BLE detection for processing (never block the host task)
         if (detectionQueue) {
             DetectionEvent evt;
             memcpy(evt.mac, mac, 6);
-            strncpy(evt.ssid, name.c_str(), 32);
-            evt.ssid[32] = '\0';
+            memcpy(evt.ssid, name, sizeof(evt.ssid));
             evt.rssi = rssi;
             evt.channel = 0;  // No channel for BLE
-            evt.type = mac_match ? 2 : 3;  // 2=ble_mac, 3=ble_name
-
-            xQueueSend(detectionQueue, &evt, pdMS_TO_TICKS(10));
+            evt.type = mac_match ? 2 : (name_match ? 3 : 5);  // 2=ble_mac, 3=ble_name, 5=ble_payload
+            evt.rule = rule;
+            evt.ie_fp = 0;
+            evt.mfg_id = company;
+            evt.queued_us = now_us();
+            TRACE_INSTANT(TRACE_BLE_MATCH, evt.type);
+
+            if (xQueueSend(detectionQueue, &evt, 0) != pdTRUE) {
+                events_dropped++;
+                TRACE_INSTANT(TRACE_QUEUE_DROP, evt.type);
+            }
         }
+#ifdef BLE_ALLOC_PROBE
+        ble_cb_task = NULL;
+#endif
     }
 };
 
@@ -896,37 +1678,38 @@ void hop_channel()
 {
     unsigned long now = millis();
 
-    // Sticky channel: don't hop if we recently detected on this channel
-    if (now < channel_sticky_until) return;
+#if BLE_SCAN_MODE == BLE_MODE_SLOTTED
+    // Hold the channel while the BLE slot owns the radio
+    if (radio_scheduler.slot() == RADIO_SLOT_BLE) return;
+#endif
 
-    // Adaptive dwell: check activity on current channel
+    // Dwell policy decides how long to stay (DWELL_HOLD = sticky after detection)
     uint16_t activity = channel_activity[current_channel];
-    uint32_t dwell_time = CHANNEL_DWELL_BASE;
-    if (activity >= CHANNEL_HIGH_THRESHOLD) {
-        dwell_time = CHANNEL_DWELL_HIGH;
-    } else if (activity >= CHANNEL_ACTIVE_THRESHOLD) {
-        dwell_time = CHANNEL_DWELL_ACTIVE;
-    }
-
-    // Add detection bonus for channels with past detections
-    uint8_t ch = current_channel;
-    if (ch >= 1 && ch <= 13 && channel_detections[ch] > 0) {
-        dwell_time += CHANNEL_DETECTION_BONUS * channel_detections[ch];
-        if (dwell_time > CHANNEL_MAX_DWELL) dwell_time = CHANNEL_MAX_DWELL;
+    uint32_t dwell_time = dwell_policy->dwellTime(current_channel, activity, now);
+    if (dwell_time == DWELL_HOLD) return;
+    // Known camera site ahead: linger so its beacons/probes are not missed
+    if ((long)(geo_boost_until - now) > 0) {
+        uint32_t boosted = dwell_time * GEO_DWELL_SCALE;
+        dwell_time = boosted < dwell_policy->config.max_dwell ? boosted : dwell_policy->config.max_dwell;
     }
 
     if (now - last_channel_hop > dwell_time) {
-        // Reset activity counter for channel we're leaving
+        // Report the finished visit and reset the activity counter for it
+        DwellVisit visit = { current_channel, (uint32_t)(now - last_channel_hop), activity };
         channel_activity[current_channel] = 0;
 
-        current_channel++;
-        if (current_channel > MAX_CHANNEL) {
+        current_channel = dwell_policy->nextChannel(visit, now);
+        if (current_channel < 1 || current_channel > MAX_CHANNEL) {
             current_channel = 1;
         }
+        airtime.switchStart(now_us());
+        TRACE_BEGIN_ARG(TRACE_CHANNEL_HOP, current_channel);
         esp_wifi_set_channel(current_channel, WIFI_SECOND_CHAN_NONE);
+        TRACE_END(TRACE_CHANNEL_HOP);
+        airtime.switchEnd(current_channel, now_us());
         last_channel_hop = now;
 #ifdef HAS_DISPLAY
-        if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+        if (display_lock(5)) {
             display.updateChannelInfo(current_channel);
             xSemaphoreGive(displayMutex);
         }
@@ -934,33 +1717,782 @@ void hop_channel()
     }
 }
 
+// ============================================================================
+// PATROL MODE (duty-cycled scanning for battery units, patrol_policy.h)
+// ============================================================================
+
+#if defined(CYD_DISPLAY)
+#define PATROL_WAKE_PIN TOUCH_IRQ          // XPT2046 pen IRQ, LOW while touched
+#elif defined(WAVESHARE_147)
+#define PATROL_WAKE_PIN BOOT_BUTTON_PIN    // LOW while pressed
+#endif
+
+static void init_patrol()
+{
+    uint32_t now = millis();
+    patrol.begin(now);
+    patrol_metered_ms = now;
+    patrol_wake_ms = now;
+    printf("[PATROL] %s: %ums bursts, %u-%ums light sleep, on for %ums after a detection (\"@set patrol.on=1\")\n",
+           patrol_on ? "On" : "Off", (unsigned)patrol.config.burst_ms, (unsigned)patrol.config.sleep_min_ms,
+           (unsigned)patrol.config.sleep_max_ms, (unsigned)patrol.config.hold_ms);
+}
+
+// Charge the time since the last call to radios-on, plus the backlight
+static void patrol_account(uint32_t now)
+{
+    uint32_t ms = now - patrol_metered_ms;
+    patrol_metered_ms = now;
+    patrol_meter.add(PATROL_POWER_SCAN, ms);
+#ifdef HAS_DISPLAY
+    if (display.isAwake()) patrol_meter.addDisplay(ms, display.getBrightness());
+#endif
+}
+
+#ifdef HAS_DISPLAY
+// Dark until a detection or touch, then lit for patrol.display_ms. A touch
+// on a dark display wakes it by itself; this only puts it back to sleep.
+static void patrol_display(uint32_t now)
+{
+    uint32_t input = display.lastInputMs();
+    if ((int32_t)(patrol_wake_ms - input) > 0) input = patrol_wake_ms;
+    bool on = !patrol_on || now - patrol.lastDetectionMs() < patrol_display_ms || now - input < patrol_display_ms;
+    if (on == patrol_display_on) return;
+    if (!display_lock(5)) return;
+    display.setAwake(on);
+    xSemaphoreGive(displayMutex);
+    patrol_display_on = on;
+}
+#endif
+
+// Radios off, light sleep for up to `ms` (touch or button ends it early),
+// radios back on. Everything else, including the other core, sleeps too.
+static void patrol_sleep(uint32_t ms)
+{
+    uint32_t started = millis();
+    patrol_account(started);
+
+    if (pBLEScan->isScanning()) pBLEScan->stop();
+    airtime.bleStop(now_us());
+    esp_wifi_set_promiscuous(false);
+    esp_wifi_stop();
+    airtime.radiosOff(now_us());
+
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+#ifdef PATROL_WAKE_PIN
+#ifdef CYD_DISPLAY
+    // The wake source turns the pin level-triggered: keep the touch ISR off
+    gpio_intr_disable((gpio_num_t)PATROL_WAKE_PIN);
+#endif
+    gpio_wakeup_enable((gpio_num_t)PATROL_WAKE_PIN, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+#endif
+    Serial.flush();  // The UART stops while asleep
+    PatrolPower state = PATROL_POWER_SLEEP;
+    if (esp_light_sleep_start() != ESP_OK) {
+        // Refused: radios stay off for the interval anyway
+        state = PATROL_POWER_IDLE;
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+    bool by_input = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO;
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+#ifdef PATROL_WAKE_PIN
+    gpio_wakeup_disable((gpio_num_t)PATROL_WAKE_PIN);
+#ifdef CYD_DISPLAY
+    // Back to the touch task's falling-edge interrupt
+    gpio_set_intr_type((gpio_num_t)PATROL_WAKE_PIN, GPIO_INTR_NEGEDGE);
+    gpio_intr_enable((gpio_num_t)PATROL_WAKE_PIN);
+#endif
+#endif
+
+    uint32_t now = millis();
+    uint32_t slept = now - started;
+    patrol_meter.add(state, slept);
+    patrol_metered_ms = now;
+    if (by_input) patrol_wake_ms = now;
+
+    esp_wifi_start();
+    esp_wifi_set_promiscuous(true);
+    wifi_rx_paused = false;  // A sleep in a BLE slot resumes in a WiFi slot
+    esp_wifi_set_channel(current_channel, WIFI_SECOND_CHAN_NONE);
+    airtime.radiosOn(current_channel, now_us());
+    last_channel_hop = now;
+#if BLE_SCAN_MODE == BLE_MODE_CONTINUOUS
+    pBLEScan->start(0, nullptr, false);
+    airtime.bleStart(now_us());
+#elif BLE_SCAN_MODE == BLE_MODE_SLOTTED
+    radio_scheduler.resume(now, total_frames_seen);
+#ifdef HAS_DISPLAY
+    if (display_lock(5)) {
+        display.updateScanMode(false);
+        xSemaphoreGive(displayMutex);
+    }
+#endif
+#endif
+    patrol.woke(now, slept);
+}
+
+// loop(): meter energy, drive the display, and sleep when a burst is over
+static void patrol_update()
+{
+    uint32_t now = millis();
+    patrol_account(now);
+#ifdef HAS_DISPLAY
+    patrol_display(now);
+#endif
+    if (!patrol_on) return;
+    uint32_t sleep_ms = patrol.sleepDue(now);
+    if (sleep_ms) patrol_sleep(sleep_ms);
+}
+
 // ============================================================================
 // PROCESSING TASK (Core 0) — dequeues detection events, does pattern matching
 // ============================================================================
 
+#define PROXIMITY_EXPIRE_MS 1000  // How often quiet tracks are checked for DEPART
+
+static void output_proximity_json(const TrackedDevice* dev, RssiEvent event)
+{
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+             dev->mac[0], dev->mac[1], dev->mac[2], dev->mac[3], dev->mac[4], dev->mac[5]);
+    StaticJsonDocument<384> doc;
+    doc["type"] = "proximity";
+    doc["timestamp"] = millis();
+    doc["event"] = rssi_event_name(event);
+    doc["mac_address"] = mac_str;
+    doc["protocol"] = dev->type == 2 || dev->type == 3 || dev->type == 5 ? "bluetooth_le" : "wifi";
+    doc["rssi"] = dev->track.levelDbm();
+    doc["rate"] = dev->track.rateDeciDbPerS() / 10.0;
+    doc["peak_rssi"] = dev->track.peakDbm();
+    doc["peak_ms_ago"] = millis() - dev->track.peak_ms;
+    doc["threat_score"] = dev->threat_score;
+    add_geotags_json(doc, dev);
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+// One line, LED and display update per drive-by phase instead of per frame
+static void report_proximity(TrackedDevice* dev, RssiEvent event)
+{
+    if (event == RSSI_EVENT_NONE) return;
+    // A site reports through the radio that alerted for it
+    uint8_t slot = dev - tracked_devices;
+    if (sites.active(slot) && sites.lead(slot) != slot) return;
+    output_proximity_json(dev, event);
+
+    if (event == RSSI_EVENT_DEPART) {
+        // Let the LED fall back to the alert colour and time out from there
+        status_led.skip(LED_FX_DETECT);
+    } else {
+        led_flash_trigger(dev->track.levelDbm());
+    }
+
+#ifdef HAS_DISPLAY
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+             dev->mac[0], dev->mac[1], dev->mac[2], dev->mac[3], dev->mac[4], dev->mac[5]);
+    if (display_lock(10)) {
+        display.updateProximity(String(mac_str), dev->track.levelDbm(), (RssiPhase)dev->track.phase);
+        xSemaphoreGive(displayMutex);
+    }
+#endif
+}
+
+// Close out passes whose device went quiet before it dropped off in level
+static void expire_proximity_tracks()
+{
+    uint32_t now = millis();
+    for (int i = 0; i < MAX_TRACKED; i++) {
+        TrackedDevice& dev = tracked_devices[i];
+        if (dev.mac_hash == 0) continue;
+        report_proximity(&dev, dev.track.expire(now));
+    }
+}
+
+// ============================================================================
+// CONFIDENCE RULES — threat_score / detection_criteria (rule_vm.h)
+// ============================================================================
+
+static inline bool is_wifi_event(uint8_t type) { return type <= 1 || type == 4 || type == 6; }
+
+// Confidence rules from the signature pack, else the built-in set
+static RuleProgram default_rules;
+
+static const RuleProgram& active_rules()
+{
+    const SignaturePack* pack = active_sigpack;
+    return pack && pack->rules().loaded() ? pack->rules() : default_rules;
+}
+
+// Run the confidence rules over one sighting
+static RuleResult score_sighting(const DetectionEvent& evt, const TrackedDevice* dev)
+{
+    bool wifi = is_wifi_event(evt.type);
+    RuleFacts facts = {};
+    facts.flags = 1 << (wifi ? RULE_FACT_WIFI : RULE_FACT_BLE);
+    if (wifi && evt.ssid[0] && check_ssid_pattern(evt.ssid)) facts.flags |= 1 << RULE_FACT_SSID_MATCH;
+    if (!wifi && evt.ssid[0] && check_device_name_pattern(evt.ssid)) facts.flags |= 1 << RULE_FACT_NAME_MATCH;
+    if (check_mac_prefix(evt.mac)) facts.flags |= 1 << RULE_FACT_OUI;
+    if (check_mac_watchlist(evt.mac)) facts.flags |= 1 << RULE_FACT_WATCHLIST;
+    if (evt.rule) facts.flags |= 1 << RULE_FACT_PAYLOAD;
+    facts.rssi = evt.rssi;
+    facts.channel = wifi ? evt.channel : 0;
+    facts.hits = dev ? dev->hit_count : 1;
+    facts.probe_ms = dev && dev->probe_intervals ? dev->probe_interval_sum / dev->probe_intervals : 0;
+    facts.mfg = evt.mfg_id;
+    facts.ie_fp = evt.ie_fp;
+    facts.mac = evt.mac;
+    facts.ssid = wifi ? evt.ssid : nullptr;
+    facts.name = wifi ? nullptr : evt.ssid;
+    return active_rules().eval(facts);
+}
+
+// ============================================================================
+// SITE CORRELATION — one alert per installation, not per radio
+// ============================================================================
+
+// A held alert outlives the signature pack it matched against (a hold runs
+// up to SITE_HOLD_MS, several pack swaps), so it keeps its own copy of the
+// BLE rule and evt.rule points at that
+struct HeldAlert {
+    DetectionEvent evt;
+    BleRule rule;
+    char rule_name[16];   // Pack rule names are at most 15 characters
+    uint32_t since;
+    bool used;
+};
+static HeldAlert held_alerts[SITE_HELD_MAX];
+
+// Alert for a newly detected device: detection JSON (which also feeds the
+// display), then beep and LED on the first one
+static void alert_detection(const DetectionEvent& evt, TrackedDevice* dev)
+{
+    TRACE_INSTANT(TRACE_DETECTION, evt.type);
+    RuleResult score = score_sighting(evt, dev);
+    if (dev) dev->threat_score = score.score;
+
+    if (is_wifi_event(evt.type)) {
+        const char* detection_type;
+        const char* ssid_out = strlen(evt.ssid) > 0 ? evt.ssid : "hidden";
+
+        if (strlen(evt.ssid) > 0 && check_ssid_pattern(evt.ssid)) {
+            detection_type = (evt.type == 0) ? "probe_request" :
+                             (evt.type == 4) ? "probe_response" : "beacon";
+        } else if (evt.type == 6) {
+            detection_type = "frame_watchlist";
+        } else {
+            detection_type = (evt.type == 0) ? "probe_request_mac" :
+                             (evt.type == 4) ? "probe_response_mac" : "beacon_mac";
+        }
+        output_wifi_detection_json(ssid_out, evt.mac, evt.rssi, detection_type, score, dev);
+
+        if (!triggered) {
+            triggered = true;
+            flock_detected_beep_sequence();
+            led_flash_trigger(evt.rssi);
+        }
+    } else {
+        char mac_str[18];
+        snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 evt.mac[0], evt.mac[1], evt.mac[2], evt.mac[3], evt.mac[4], evt.mac[5]);
+        const char* method = (evt.type == 2) ? (check_mac_prefix(evt.mac) ? "mac_prefix" : "mac_watchlist") :
+                             (evt.type == 3) ? "device_name" : ble_rule_method(evt.rule);
+        output_ble_detection_json(mac_str, evt.ssid, evt.rssi, method, score, dev, evt.rule);
+
+        if (!triggered) {
+            triggered = true;
+            pending_beep = true;
+            led_flash_trigger(evt.rssi);
+        }
+    }
+}
+
+// Compact record of a radio joining an alerted site, or two alerted sites merging
+static void output_site_json(uint8_t slot, const SiteJoin& join)
+{
+    StaticJsonDocument<512> doc;
+    doc["type"] = "site";
+    doc["timestamp"] = millis();
+    doc["event"] = join.absorbed_id ? "merge" : "join";
+    doc["site_id"] = join.site_id;
+    if (join.absorbed_id) doc["merged_site_id"] = join.absorbed_id;
+    doc["reason"] = site_reason_name(join.reason);
+    doc["size"] = sites.siteSize(slot);
+    doc["mixed"] = sites.mixed(slot);
+
+    uint8_t members[8];
+    uint8_t n = sites.members(slot, members, 8);
+    JsonArray macs = doc.createNestedArray("members");  // Lead (the radio that alerted) first
+    for (uint8_t i = 0; i < n; i++) {
+        const uint8_t* m = tracked_devices[members[i]].mac;
+        char mac_str[18];
+        snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 m[0], m[1], m[2], m[3], m[4], m[5]);
+        macs.add(mac_str);
+    }
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+static bool hold_alert(const DetectionEvent& evt, uint32_t now)
+{
+    for (int i = 0; i < SITE_HELD_MAX; i++) {
+        HeldAlert& held = held_alerts[i];
+        if (held.used) continue;
+        held.evt = evt;
+        if (evt.rule) {
+            held.rule = *evt.rule;
+            strncpy(held.rule_name, evt.rule->name, sizeof(held.rule_name) - 1);
+            held.rule_name[sizeof(held.rule_name) - 1] = '\0';
+            held.rule.name = held.rule_name;
+            held.evt.rule = &held.rule;
+        }
+        held.since = now;
+        held.used = true;
+        site_held++;
+        return true;
+    }
+    return false;
+}
+
+// First sighting of a device (or the first after its TTL): folded into a
+// site that already alerted, held while an alerted site nearby may still
+// absorb it, or alerted as a new site
+static void site_first_sighting(const DetectionEvent& evt)
+{
+    TrackedDevice* dev = find_tracked(evt.mac);
+    if (!dev) {
+        alert_detection(evt, nullptr);
+        return;
+    }
+    uint8_t slot = dev - tracked_devices;
+    uint32_t now = millis();
+    SiteJoin join = sites.add(slot, evt.mac, !is_wifi_event(evt.type), now);
+    if (join.site_id) {
+        site_folded++;
+        if (join.reason != SITE_JOIN_NONE) output_site_json(slot, join);
+        return;
+    }
+    if (sites.alertedNearby(slot, now) && hold_alert(evt, now)) return;
+    sites.assign(slot);
+    alert_detection(evt, dev);
+}
+
+// Re-detection, after the proximity track has taken the sighting
+static void site_sighting(TrackedDevice* dev)
+{
+    uint8_t slot = dev - tracked_devices;
+    SiteJoin join = sites.sight(slot, dev->track, millis());
+    if (join.reason != SITE_JOIN_NONE && join.site_id) output_site_json(slot, join);
+}
+
+// Held alerts are dropped once their device has joined an alerted site, and
+// raised once the hold runs out or no alerted site is nearby any more
+static void release_held_alerts()
+{
+    uint32_t now = millis();
+    for (int i = 0; i < SITE_HELD_MAX; i++) {
+        HeldAlert& held = held_alerts[i];
+        if (!held.used) continue;
+        TrackedDevice* dev = find_tracked(held.evt.mac);
+        uint8_t slot = dev ? (uint8_t)(dev - tracked_devices) : SITE_NONE;
+        bool tracked = sites.active(slot);
+
+        if (tracked && sites.siteId(slot)) {
+            held.used = false;
+            site_folded++;
+        } else if (!tracked || now - held.since >= SITE_HOLD_MS || !sites.alertedNearby(slot, now)) {
+            held.used = false;
+            if (tracked) sites.assign(slot);
+            alert_detection(held.evt, dev);
+        }
+    }
+}
+
+// ============================================================================
+// WARM RESTART SNAPSHOT (warm_snapshot.h)
+// ============================================================================
+
+// The RTC clock (gettimeofday, never set by this firmware) and RTC memory
+// survive software, watchdog, panic and brown-out resets, but not a power
+// cycle. A random id kept in RTC memory tells the two apart: a snapshot's
+// age is only known when it was taken on the current clock.
+#define SNAPSHOT_CLOCK_MAGIC 0x46594353u
+static RTC_NOINIT_ATTR uint32_t rtc_clock_magic;
+static RTC_NOINIT_ATTR uint32_t rtc_clock_id;
+
+static uint32_t snapshot_clock_ms()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (uint32_t)((uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000);
+}
+
+static bool snapshot_use_sd()
+{
+#ifdef SIGPACK_FS
+    return display.isSDCardPresent();
+#else
+    return false;
+#endif
+}
+
+// Live devices go most recently seen first, so a full buffer drops the
+// stalest; the display list goes last. Returns 0 if the display is busy.
+static size_t encode_snapshot(uint32_t now)
+{
+#ifdef HAS_DISPLAY
+    if (!display_lock(10)) return 0;
+#endif
+    SnapshotWriter w(snapshot_image, snapshot_use_sd() ? SNAPSHOT_MAX_SIZE : SNAPSHOT_NVS_MAX);
+
+    w.beginSection(SNAP_SEC_COUNTERS, 1);
+    w.put32(hash_collisions);
+    w.put32(site_held);
+    w.put32(site_folded);
+    w.put32(geo_alerts);
+    w.endRecord();
+    w.endSection();
+
+    float memory[DWELL_STATE_MAX];
+    uint8_t n = dwell_policy->saveState(memory);
+    w.beginSection(SNAP_SEC_DWELL, 1);
+    w.putStr(dwell_policy->name());
+    w.put8(n);
+    for (uint8_t i = 0; i < n; i++) w.putFloat(memory[i]);
+    w.endRecord();
+    w.endSection();
+
+    uint8_t order[MAX_TRACKED];
+    uint8_t live = 0;
+    for (uint8_t i = 0; i < MAX_TRACKED; i++) {
+        const TrackedDevice& dev = tracked_devices[i];
+        uint32_t age = now - dev.last_seen;
+        if (dev.mac_hash == 0 || age > detection_ttl_ms) continue;
+        uint8_t j = live++;
+        for (; j > 0 && now - tracked_devices[order[j - 1]].last_seen > age; j--) order[j] = order[j - 1];
+        order[j] = i;
+    }
+    w.beginSection(SNAP_SEC_DEVICES, 1);
+    for (uint8_t i = 0; i < live; i++) {
+        SiteSlotState state;
+        bool in_site = sites.saveSlot(order[i], state);
+        w.putDevice(order[i], tracked_devices[order[i]], now);
+        w.put8(in_site);
+        if (in_site) w.putSiteSlot(state, now);
+        w.endRecord();
+    }
+    w.endSection();
+
+#ifdef HAS_DISPLAY
+    display.saveSnapshot(w, now);
+    xSemaphoreGive(displayMutex);
+#endif
+
+    SnapHeader hdr = { snapshot_seq + 1, rtc_clock_id, snapshot_clock_ms(), now };
+    snapshot_seq = hdr.seq;
+    snapshot_dropped = w.dropped();
+    return w.finish(hdr);
+}
+
+// Called every second by the processing task: snapshot soon after a new
+// device, less often while known ones are still being sighted, never when idle
+static void snapshot_tick()
+{
+    if (snapshot_pending) return;
+    uint32_t now = millis();
+    uint32_t scale = snapshot_use_sd() ? 1 : SNAPSHOT_NVS_SCALE;
+    uint32_t since = now - snapshot_last_ms;
+    bool added = hash_entries != snapshot_last_entries;
+    bool sighted = (int32_t)(last_detection_time - snapshot_last_ms) > 0;
+    if (!(added && since >= SNAPSHOT_NEW_MS * scale) && !(sighted && since >= SNAPSHOT_REFRESH_MS * scale)) return;
+
+    int64_t t0 = esp_timer_get_time();
+    TRACE_BEGIN(TRACE_SNAPSHOT_ENCODE);
+    size_t len = encode_snapshot(now);
+    TRACE_END_ARG(TRACE_SNAPSHOT_ENCODE, len);
+    if (!len) return;
+    snapshot_encode_us = (uint32_t)(esp_timer_get_time() - t0);
+    snapshot_last_ms = now;
+    snapshot_last_entries = hash_entries;
+    snapshot_len = len;
+    snapshot_pending = true;
+}
+
+#ifdef SIGPACK_FS
+// Caller holds displayMutex. A reset between remove and rename leaves the
+// temporary file, which restore_snapshot() also reads.
+static bool write_snapshot_file()
+{
+    File file = SIGPACK_FS.open(SNAPSHOT_TMP_FILE, FILE_WRITE);
+    if (!file) return false;
+    size_t wrote = file.write(snapshot_image, snapshot_len);
+    file.close();
+    if (wrote != snapshot_len) return false;
+    SIGPACK_FS.remove(SNAPSHOT_FILE);
+    return SIGPACK_FS.rename(SNAPSHOT_TMP_FILE, SNAPSHOT_FILE);
+}
+#endif
+
+static bool write_snapshot_nvs()
+{
+    if (snapshot_len > SNAPSHOT_NVS_MAX) return false;  // Encoded for SD, card since removed
+    Preferences prefs;
+    if (!prefs.begin(SNAPSHOT_NVS_NS, false)) return false;
+    bool ok = prefs.putBytes(SNAPSHOT_NVS_KEY, snapshot_image, snapshot_len) == snapshot_len;
+    prefs.end();
+    return ok;
+}
+
+// loop(): write the snapshot the processing task encoded
+static void store_snapshot()
+{
+    if (!snapshot_pending) return;
+    bool sd = snapshot_use_sd();
+    int64_t t0 = esp_timer_get_time();
+    bool ok;
+    TRACE_BEGIN(TRACE_SNAPSHOT_WRITE);
+#ifdef SIGPACK_FS
+    if (sd) {
+        if (!display_lock(5)) return;  // Retry next loop
+        uint32_t started = now_us();
+        ok = write_snapshot_file();
+        perf_sd_write_us.record(now_us() - started);
+        xSemaphoreGive(displayMutex);
+    } else
+#endif
+    {
+        ok = write_snapshot_nvs();
+    }
+    TRACE_END_ARG(TRACE_SNAPSHOT_WRITE, snapshot_len);
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+
+    if (ok) {
+        snapshot_writes++;
+        snapshot_store_ms = ms;
+        if (ms > snapshot_store_max_ms) snapshot_store_max_ms = ms;
+        if (snapshot_dropped) {
+            printf("[SNAP] Snapshot %u: %u records did not fit in %u bytes\n",
+                   snapshot_seq, snapshot_dropped, (unsigned)snapshot_len);
+        }
+    } else {
+        snapshot_failures++;
+        printf("[SNAP] Writing snapshot %u (%u bytes) to %s failed\n",
+               snapshot_seq, (unsigned)snapshot_len, sd ? "SD" : "NVS");
+    }
+    snapshot_pending = false;
+}
+
+// Keep the image if it is valid and newer than the one in snapshot_image
+static void snapshot_candidate(const uint8_t* image, size_t len, const char* from)
+{
+    SnapshotReader reader;
+    SnapStatus status = reader.open(image, len);
+    if (status != SNAP_OK) {
+        printf("[SNAP] %s: %s\n", from, snap_status_str(status));
+        return;
+    }
+    if (snapshot_len && (int32_t)(reader.header().seq - snapshot_seq) <= 0) return;
+    memcpy(snapshot_image, image, len);
+    snapshot_len = len;
+    snapshot_seq = reader.header().seq;
+    snapshot_from = from;
+}
+
+#ifdef SIGPACK_FS
+static void read_snapshot_file(const char* path, uint8_t* scratch)
+{
+    File file = SIGPACK_FS.open(path, FILE_READ);
+    if (!file) return;
+    size_t size = file.size();
+    size_t got = size <= SNAPSHOT_MAX_SIZE ? file.read(scratch, size) : 0;
+    file.close();
+    if (got == size && size) snapshot_candidate(scratch, size, path);
+}
+#endif
+
+static void read_snapshot_nvs(uint8_t* scratch)
+{
+    Preferences prefs;
+    if (!prefs.begin(SNAPSHOT_NVS_NS, true)) return;
+    size_t size = prefs.getBytesLength(SNAPSHOT_NVS_KEY);
+    if (size && size <= SNAPSHOT_MAX_SIZE && prefs.getBytes(SNAPSHOT_NVS_KEY, scratch, size) == size) {
+        snapshot_candidate(scratch, size, "NVS");
+    }
+    prefs.end();
+}
+
+// Place a restored device in the first free slot of its probe sequence; its
+// old slot may sit behind one that was not restored. Returns the new slot.
+static int restore_tracked_device(TrackedDevice& dev)
+{
+    uint32_t hash = fnv1a_mac(dev.mac);
+    for (int probe = 0; probe < HASH_MAX_PROBE; probe++) {
+        uint32_t slot = (hash + probe) & MAX_TRACKED_MASK;
+        if (tracked_devices[slot].mac_hash == hash) return -1;  // Duplicate record
+        if (tracked_devices[slot].mac_hash != 0) continue;
+        dev.mac_hash = hash;
+        tracked_devices[slot] = dev;
+        hash_entries++;
+        return slot;
+    }
+    return -1;
+}
+
+// setup(), before the processing task starts: newest valid snapshot from SD
+// or NVS. With the clock restarted (power cycle) its age is unknown and only
+// the channel memory is kept.
+static void restore_snapshot()
+{
+    if (rtc_clock_magic != SNAPSHOT_CLOCK_MAGIC || esp_reset_reason() == ESP_RST_POWERON) {
+        rtc_clock_id = esp_random() | 1;
+        rtc_clock_magic = SNAPSHOT_CLOCK_MAGIC;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    uint8_t* scratch = (uint8_t*)malloc(SNAPSHOT_MAX_SIZE);
+    if (!scratch) return;
+#ifdef SIGPACK_FS
+    if (display.isSDCardPresent()) {
+        read_snapshot_file(SNAPSHOT_FILE, scratch);
+        read_snapshot_file(SNAPSHOT_TMP_FILE, scratch);
+    }
+#endif
+    read_snapshot_nvs(scratch);
+    free(scratch);
+    int64_t t_read = esp_timer_get_time();
+    if (!snapshot_len) {
+        printf("[SNAP] No snapshot to restore\n");
+        return;
+    }
+
+    SnapshotReader reader;
+    reader.open(snapshot_image, snapshot_len);
+    const SnapHeader& hdr = reader.header();
+    uint32_t now = millis();
+    bool same_clock = hdr.clock_id == rtc_clock_id;
+    uint32_t age = snapshot_clock_ms() - hdr.clock_ms;
+    if (same_clock && age > SNAPSHOT_MAX_AGE_MS) {
+        printf("[SNAP] Snapshot %u from %s is %u s old, ignored\n", hdr.seq, snapshot_from, age / 1000);
+        snapshot_len = 0;
+        return;
+    }
+    uint32_t base = now - age;
+
+    // Devices may move slot (see restore_tracked_device); site roots and
+    // leads are remapped once the whole section has been read
+    uint8_t slot_map[MAX_TRACKED];
+    memset(slot_map, SITE_NONE, sizeof(slot_map));
+    static SiteSlotState site_state[MAX_TRACKED];
+    uint8_t site_slot[MAX_TRACKED];
+    uint8_t site_slots = 0;
+    bool dwell = false;
+    uint16_t shown = 0;
+    uint8_t type, version;
+    uint16_t count;
+    while (reader.nextSection(type, version, count)) {
+        if (type == SNAP_SEC_DWELL && version == 1) {
+            char name[16];
+            reader.getStr(name, sizeof(name));
+            uint8_t n = reader.get8();
+            float memory[DWELL_STATE_MAX];
+            for (uint8_t i = 0; i < n && i < DWELL_STATE_MAX; i++) memory[i] = reader.getFloat();
+            dwell = reader.ok() && n <= DWELL_STATE_MAX && strcmp(name, dwell_policy->name()) == 0 &&
+                    dwell_policy->loadState(memory, n);
+        }
+        if (!same_clock) continue;
+
+        if (type == SNAP_SEC_COUNTERS && version == 1) {
+            hash_collisions = reader.get32();
+            site_held = reader.get32();
+            site_folded = reader.get32();
+            geo_alerts = reader.get32();
+        } else if (type == SNAP_SEC_DEVICES && version == 1) {
+            for (uint16_t i = 0; i < count; i++) {
+                TrackedDevice dev;
+                uint8_t old_slot = reader.getDevice(dev, base);
+                bool in_site = reader.get8();
+                SiteSlotState state;
+                if (in_site) reader.getSiteSlot(state, base);
+                if (!reader.ok()) break;
+                if (old_slot >= MAX_TRACKED || now - dev.last_seen > detection_ttl_ms) continue;
+                int slot = restore_tracked_device(dev);
+                if (slot < 0) continue;
+                slot_map[old_slot] = slot;
+                snapshot_restored++;
+                if (in_site) {
+                    memcpy(state.mac, dev.mac, 6);
+                    site_state[site_slots] = state;
+                    site_slot[site_slots++] = slot;
+                }
+            }
+            for (uint8_t i = 0; i < site_slots; i++) {
+                SiteSlotState& state = site_state[i];
+                state.root = state.root < MAX_TRACKED ? slot_map[state.root] : SITE_NONE;
+                state.lead = state.lead < MAX_TRACKED ? slot_map[state.lead] : SITE_NONE;
+                sites.restoreSlot(site_slot[i], state);
+            }
+            sites.restoreDone();
+        }
+#ifdef HAS_DISPLAY
+        else if (type == SNAP_SEC_DISPLAY) {
+            shown = display.restoreSnapshot(reader, version, count, base);
+        }
+#endif
+    }
+    snapshot_last_ms = now;
+    snapshot_last_entries = hash_entries;
+    snapshot_restore_us = (uint32_t)(esp_timer_get_time() - t0);
+
+    if (same_clock) {
+        printf("[SNAP] Restored snapshot %u from %s (%u s old): %u devices, %u site slots, %u display entries, channel memory %s"
+               " in %u us (read %u us)\n",
+               hdr.seq, snapshot_from, age / 1000, snapshot_restored, site_slots, shown, dwell ? "yes" : "no",
+               snapshot_restore_us, (unsigned)(t_read - t0));
+    } else {
+        printf("[SNAP] Snapshot %u from %s predates a power cycle: channel memory %s, tracking state dropped (%u us)\n",
+               hdr.seq, snapshot_from, dwell ? "restored" : "not restored", snapshot_restore_us);
+    }
+}
+
 void processingTask(void* parameter) {
     (void)parameter;
     DetectionEvent evt;
+    uint32_t last_expire = 0;
+    UBaseType_t last_depth = 0;
 
     while (true) {
         // Yield to IDLE0 to feed watchdog — critical when queue stays full
         vTaskDelay(1);
 
+        if (millis() - last_expire >= PROXIMITY_EXPIRE_MS) {
+            last_expire = millis();
+            expire_proximity_tracks();
+            sites.expire(last_expire, detection_ttl_ms);
+            release_held_alerts();
+            snapshot_tick();
+        }
+
         if (xQueueReceive(detectionQueue, &evt, pdMS_TO_TICKS(100)) == pdTRUE) {
+            uint32_t started = now_us();
+            UBaseType_t waiting = uxQueueMessagesWaiting(detectionQueue);
+            TRACE_BEGIN_ARG(TRACE_PROCESS_EVENT, evt.type);
+            if (waiting != last_depth) {
+                TRACE_COUNTER(TRACE_QUEUE_DEPTH, waiting);
+                last_depth = waiting;
+            }
+            perf_queue_us.record(started - evt.queued_us);
+            perf_queue_depth.set(waiting);
             events_processed++;
 
-            char mac_str[18];
-            snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
-                     evt.mac[0], evt.mac[1], evt.mac[2],
-                     evt.mac[3], evt.mac[4], evt.mac[5]);
-
-            if (evt.type <= 1 || evt.type == 4) {
-                // WiFi event (0=probe_req, 1=beacon, 4=probe_resp)
+            if (is_wifi_event(evt.type)) {
+                // WiFi event (0=probe_req, 1=beacon, 4=probe_resp, 6=watchlisted transmitter)
 
 #ifdef HAS_DISPLAY
                 // Show debug SSID on display
                 if (strlen(evt.ssid) > 0) {
-                    if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+                    if (display_lock(10)) {
                         display.showDebugSSID(String(evt.ssid), evt.rssi, evt.channel);
                         xSemaphoreGive(displayMutex);
                     }
@@ -968,124 +2500,567 @@ void processingTask(void* parameter) {
 #endif
 
                 bool ssid_match = strlen(evt.ssid) > 0 && check_ssid_pattern(evt.ssid);
-                bool mac_match = check_mac_prefix(evt.mac);
+                bool mac_match = check_mac_prefix(evt.mac) || check_mac_watchlist(evt.mac);
 
                 if (ssid_match || mac_match) {
-                    // Track channel detections for channel memory
-                    if (evt.channel >= 1 && evt.channel <= 13) {
-                        channel_detections[evt.channel]++;
-                        channel_sticky_until = millis() + CHANNEL_STICKY_DURATION;
-                    }
-
-                    if (!is_already_detected(evt.mac)) {
-                        const char* detection_type;
-                        const char* ssid_out = strlen(evt.ssid) > 0 ? evt.ssid : "hidden";
-
-                        if (ssid_match) {
-                            detection_type = (evt.type == 0) ? "probe_request" :
-                                             (evt.type == 4) ? "probe_response" : "beacon";
-                        } else {
-                            detection_type = (evt.type == 0) ? "probe_request_mac" :
-                                             (evt.type == 4) ? "probe_response_mac" : "beacon_mac";
-                        }
-
+                    // Feed channel memory (sticky window + dwell statistics)
+                    dwell_policy->noteDetection(evt.channel, millis());
+                    bool new_device = !is_already_detected(evt.mac);
+                    patrol.noteDetection(millis(), new_device);
+
+                    if (new_device) {
+                        // Only new devices steer the share; a beaconing camera
+                        // would otherwise pin it at wifi_share_max
+                        radio_scheduler.noteDetection(RADIO_SLOT_WIFI);
                         add_detected_device(evt.mac, evt.rssi, evt.channel, evt.type);
-                        TrackedDevice* dev = find_tracked(evt.mac);
-                        output_wifi_detection_json(ssid_out, evt.mac, evt.rssi, detection_type, dev);
-
-                        if (!triggered) {
-                            triggered = true;
-                            flock_detected_beep_sequence();
-                            led_flash_trigger(evt.rssi);
-                        }
+                        site_first_sighting(evt);
                     } else {
                         // Re-detection: update tracking data
                         TrackedDevice* dev = find_tracked(evt.mac);
-                        if (dev) update_tracked_device(dev, evt.rssi, evt.channel, evt.type);
+                        if (dev) {
+                            RssiEvent event = update_tracked_device(dev, evt.rssi, evt.channel, evt.type);
+                            dev->threat_score = score_sighting(evt, dev).score;
+                            report_proximity(dev, event);
+                            site_sighting(dev);
+                        }
                     }
                     last_detection_time = millis();
                 }
             } else {
-                // BLE event (mac_prefix or device_name)
-                const char* method = (evt.type == 2) ? "mac_prefix" : "device_name";
+                // BLE event (mac_prefix, device_name or payload signature)
+                bool new_device = !is_already_detected(evt.mac);
+                patrol.noteDetection(millis(), new_device);
 
-                if (!is_already_detected(evt.mac)) {
+                if (new_device) {
+                    radio_scheduler.noteDetection(RADIO_SLOT_BLE);
                     add_detected_device(evt.mac, evt.rssi, 0, evt.type);
-                    TrackedDevice* dev = find_tracked(evt.mac);
-                    output_ble_detection_json(mac_str, evt.ssid, evt.rssi, method, dev);
-
-                    if (!triggered) {
-                        triggered = true;
-                        pending_beep = true;
-                        led_flash_trigger(evt.rssi);
-                    }
+                    site_first_sighting(evt);
                 } else {
                     // Re-detection: update tracking data
                     TrackedDevice* dev = find_tracked(evt.mac);
-                    if (dev) update_tracked_device(dev, evt.rssi, 0, evt.type);
+                    if (dev) {
+                        RssiEvent event = update_tracked_device(dev, evt.rssi, 0, evt.type);
+                        dev->threat_score = score_sighting(evt, dev).score;
+                        report_proximity(dev, event);
+                        site_sighting(dev);
+                    }
                 }
                 last_detection_time = millis();
             }
+            perf_tracked.set(hash_entries);
+            perf_process_us.record(now_us() - started);
+            TRACE_END(TRACE_PROCESS_EVENT);
         }
     }
 }
 
 // ============================================================================
-// MAIN FUNCTIONS
+// FLASH INDEX (memory-mapped partition)
 // ============================================================================
 
-void setup()
+// Map the fyindex partition and attach the vendor table and embedded pack.
+// The mapping is never released: lookups read flash through the cache.
+static void init_flash_index()
 {
-    Serial.begin(115200);
-    delay(1000);
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)FLASH_INDEX_SUBTYPE, FLASH_INDEX_LABEL);
+    if (!part) {
+        printf("[FLASHIDX] No %s partition (flash with partitions_cyd.csv)\n", FLASH_INDEX_LABEL);
+        return;
+    }
 
-#ifdef HAS_DISPLAY
-    // Initialize display first for visual feedback
-    if (!display.begin()) {
-        Serial.println("Failed to initialize display!");
+    const void* mapped = nullptr;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &mapped, &handle);
+#else
+    spi_flash_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &mapped, &handle);
+#endif
+    if (err != ESP_OK) {
+        printf("[FLASHIDX] mmap of %u bytes failed: %s\n", (unsigned)part->size, esp_err_to_name(err));
+        return;
     }
-    // Note: Don't show info here - display.begin() may have started calibration mode (CYD only)
+
+    int64_t t0 = esp_timer_get_time();
+    SigPackStatus status = flash_index.attach((const uint8_t*)mapped, part->size, true);
+    if (status != SIGPACK_OK) {
+        // Erased partition reads as 0xFF: bad magic just means nothing flashed yet
+        printf("[FLASHIDX] %s: %s\n", FLASH_INDEX_LABEL, sigpack_status_str(status));
+        return;
+    }
+    printf("[FLASHIDX] %u OUIs, %u byte image at 0x%x (verified in %lld ms)\n",
+           flash_index.ouiCount(), (unsigned)flash_index.imageSize(), (unsigned)part->address,
+           (esp_timer_get_time() - t0) / 1000);
+
+    if (flash_index.packImage()) {
+        status = flash_sigpack.load(flash_index.packImage(), flash_index.packSize());
+        if (status == SIGPACK_OK) {
+            active_sigpack = &flash_sigpack;
+            printf("[FLASHIDX] Signature pack v%u: %u OUIs, %u MACs, %u BLE rules\n",
+                   flash_sigpack.version(), flash_sigpack.ouiCount(),
+                   flash_sigpack.macCount(), flash_sigpack.bleRuleCount());
+        } else {
+            printf("[FLASHIDX] Embedded signature pack rejected: %s\n", sigpack_status_str(status));
+        }
+    }
+#ifdef CYD_DISPLAY
+    display.setVendorIndex(&flash_index);
 #endif
+}
 
-    // Initialize buzzer
-#if BUZZER_ENABLED
-    pinMode(BUZZER_PIN, OUTPUT);
-    digitalWrite(BUZZER_PIN, LOW);
+// ============================================================================
+// POSITION (UART GPS, serial feed)
+// ============================================================================
+
+// New position from either source: tag sightings with it and queue a
+// camera site query
+static void set_position(int32_t lat_e7, int32_t lon_e7, uint32_t utc)
+{
+    portENTER_CRITICAL(&gps_mux);
+    gps_tag.lat_e7 = lat_e7;
+    gps_tag.lon_e7 = lon_e7;
+    gps_tag.utc = utc;
+    gps_tag.valid = true;
+    gps_tag_ms = millis();
+    portEXIT_CRITICAL(&gps_mux);
+    geo_lat_e7 = lat_e7;
+    geo_lon_e7 = lon_e7;
+    geo_fix_pending = true;
+}
+
+#ifdef GPS_RX_PIN
+static void init_gps()
+{
+    gps_uart.setRxBufferSize(GPS_RX_BUFFER);
+    gps_uart.begin(GPS_BAUD, SERIAL_8N1, GPS_RX_PIN, -1);
+    printf("[GPS] NMEA input on GPIO %d at %d baud\n", GPS_RX_PIN, GPS_BAUD);
+}
+
+// Drain whatever the UART holds into the parser; never waits for a line
+static void poll_gps()
+{
+    int n = gps_uart.available();
+    bool had_fix = gps_parser.fix().valid;
+    while (n-- > 0) {
+        if (!gps_parser.feed((char)gps_uart.read())) continue;
+        const GpsFix& fix = gps_parser.fix();
+        if (fix.valid) set_position(fix.lat_e7, fix.lon_e7, fix.utc);
+    }
+    if (gps_parser.fix().valid != had_fix) {
+        printf("[GPS] %s\n", had_fix ? "Fix lost" : "Fix acquired");
+    }
+}
 #endif
 
-#ifndef WAVESHARE_147
-    // Initialize RGB LED with PWM (Waveshare uses WS2812 via display handler)
-    led_init();
+// ============================================================================
+// BOOT TIMELINE (serial "BOOT" command)
+// ============================================================================
 
-    // LED boot test - cycle R, G, B to verify hardware
-    printf("LED boot test: RED...\n");
-    rgb_pwm(255, 0, 0);   // Red
-    delay(400);
-    printf("LED boot test: GREEN...\n");
-    rgb_pwm(0, 255, 0);   // Green
-    delay(400);
-    printf("LED boot test: BLUE...\n");
-    rgb_pwm(0, 0, 255);   // Blue
-    delay(400);
-    printf("LED boot test: ORANGE...\n");
-    rgb_pwm(255, 100, 0);  // Orange
-    delay(400);
-    printf("LED boot test: Scanning mode (green 50%%)\n");
-    rgb_pwm(0, 128, 0);   // Green 50%
-    delay(400);
+static void boot_mark(const char* what)
+{
+    uint32_t us = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&boot_mux);
+    if (boot_mark_count < BOOT_MARKS_MAX) boot_marks[boot_mark_count++] = { what, us, (uint8_t)xPortGetCoreID() };
+    portEXIT_CRITICAL(&boot_mux);
+}
+
+// Printed from loop() once both boot tasks are done, and on request: with
+// FAST_BOOT nothing waits for the USB serial host, so the first copy is
+// often gone before a monitor attaches. Times start when the app starts
+// (after the ROM and second-stage bootloader).
+static void output_boot_timeline()
+{
+    printf("[BOOT] %s boot: capture on at %.1f ms, first frame at %.1f ms\n", FAST_BOOT ? "Fast" : "Full",
+           boot_capture_us / 1000.0f, boot_first_frame_us / 1000.0f);
+    DynamicJsonDocument doc(2048);
+    doc["type"] = "boot";
+    doc["timestamp"] = millis();
+    doc["fast"] = (bool)FAST_BOOT;
+    doc["capture_ms"] = boot_capture_us / 1000.0f;
+    doc["first_frame_ms"] = boot_first_frame_us / 1000.0f;
+    doc["reset_reason"] = (int)esp_reset_reason();
+    JsonArray marks = doc.createNestedArray("marks");
+    for (uint8_t i = 0; i < boot_mark_count; i++) {
+        const BootMark& m = boot_marks[i];
+        printf("[BOOT] %8.1f ms  core %u  %s\n", m.us / 1000.0f, m.core, m.what);
+        JsonObject o = marks.createNestedObject();
+        o["ms"] = m.us / 1000.0f;
+        o["core"] = m.core;
+        o["what"] = m.what;
+    }
+    String json_output;
+    serializeJson(doc, json_output);
+    Serial.println(json_output);
+}
+
+// ============================================================================
+// RUNTIME PARAMETERS (serial '@' console, see param_registry.h)
+// ============================================================================
+
+// The registry points at the variables the firmware already reads. Dwell,
+// radio and BLE parameters are read by loop(), which also runs the console,
+// so a set lands between two hops or slots, never inside one; the processing
+// task only reads single words (detect.ttl_ms).
+static ParamRegistry params;
+static portMUX_TYPE param_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool check_params(const ParamRegistry&, const char** why)
+{
+    const DwellConfig& d = dwell_policy->config;
+#if CHANNEL_DWELL_POLICY == DWELL_POLICY_LADDER
+    if (d.dwell_base > d.dwell_active || d.dwell_active > d.dwell_high || d.dwell_high > d.max_dwell) {
+        *why = "need dwell.base_ms<=dwell.active_ms<=dwell.high_ms<=dwell.max_ms";
+        return false;
+    }
+    if (d.active_threshold >= d.high_threshold) {
+        *why = "need dwell.active_frames<dwell.high_frames";
+        return false;
+    }
+#else
+    if (d.dwell_base > d.dwell_active || d.dwell_active > d.max_dwell) {
+        *why = "need dwell.base_ms<=dwell.active_ms<=dwell.max_ms";
+        return false;
+    }
 #endif
+#if BLE_SCAN_MODE == BLE_MODE_SLOTTED
+    if (radio_scheduler.wifi_share_min > radio_scheduler.wifi_share_pct ||
+        radio_scheduler.wifi_share_pct > radio_scheduler.wifi_share_max) {
+        *why = "need radio.share_min<=radio.wifi_share<=radio.share_max";
+        return false;
+    }
+#elif BLE_SCAN_MODE == BLE_MODE_LEGACY
+    if (ble_scan_duration_s * 1000 >= ble_scan_interval_ms) {
+        *why = "need ble.scan_s shorter than ble.interval_ms";
+        return false;
+    }
+#endif
+    if (patrol.config.sleep_min_ms > patrol.config.sleep_max_ms) {
+        *why = "need patrol.sleep_min_ms<=patrol.sleep_max_ms";
+        return false;
+    }
+    return true;
+}
 
-    boot_beep_sequence();
+static void lock_params(bool lock)
+{
+    if (lock) portENTER_CRITICAL(&param_mux);
+    else portEXIT_CRITICAL(&param_mux);
+}
 
-    printf("Starting Flock Squawk Enhanced Detection System...\n\n");
+static bool store_params(const uint8_t* blob, size_t len)
+{
+    Preferences prefs;
+    if (!prefs.begin(SNAPSHOT_NVS_NS, false)) return false;
+    bool ok = prefs.putBytes(PARAMS_NVS_KEY, blob, len) == len;
+    prefs.end();
+    return ok;
+}
+
+// One write per reply line, so JSON records from other tasks cannot split it
+static void param_reply(const char* line, size_t len, void*)
+{
+    Serial.write((const uint8_t*)line, len);
+}
+
+// Register every parameter and apply the saved set. setup(): after the dwell
+// policy exists, before the queue is created and the tasks start.
+static void init_params()
+{
+    DwellConfig& d = dwell_policy->config;
+    params.add("dwell.base_ms", PARAM_U32, &d.dwell_base, 50, 10000, "ms");
+    params.add("dwell.active_ms", PARAM_U32, &d.dwell_active, 50, 10000, "ms");
+    params.add("dwell.max_ms", PARAM_U32, &d.max_dwell, 50, 30000, "ms");
+    params.add("dwell.sticky_ms", PARAM_U32, &d.sticky_ms, 0, 60000, "ms");
+#if CHANNEL_DWELL_POLICY == DWELL_POLICY_LADDER
+    // Only the ladder reads the activity thresholds and detection bonus
+    params.add("dwell.high_ms", PARAM_U32, &d.dwell_high, 50, 10000, "ms");
+    params.add("dwell.active_frames", PARAM_U16, &d.active_threshold, 1, 1000);
+    params.add("dwell.high_frames", PARAM_U16, &d.high_threshold, 1, 1000);
+    params.add("dwell.bonus_ms", PARAM_U32, &d.detection_bonus, 0, 5000, "ms");
+#endif
+#if BLE_SCAN_MODE == BLE_MODE_SLOTTED
+    params.add("radio.frame_ms", PARAM_U32, &radio_scheduler.frame_ms, 200, 10000, "ms");
+    params.add("radio.wifi_share", PARAM_U8, &radio_scheduler.wifi_share_pct, 5, 95, "%");
+    params.add("radio.share_min", PARAM_U8, &radio_scheduler.wifi_share_min, 5, 95, "%");
+    params.add("radio.share_max", PARAM_U8, &radio_scheduler.wifi_share_max, 5, 95, "%");
+    params.add("radio.adaptive", PARAM_BOOL, &radio_scheduler.adaptive, 0, 1);
+#elif BLE_SCAN_MODE == BLE_MODE_LEGACY
+    params.add("ble.interval_ms", PARAM_U32, &ble_scan_interval_ms, 500, 60000, "ms");
+    params.add("ble.scan_s", PARAM_U32, &ble_scan_duration_s, 1, 10, "s");
+#endif
+    params.add("detect.ttl_ms", PARAM_U32, (void*)&detection_ttl_ms, 10000, 3600000, "ms");
+    params.add("queue.len", PARAM_U32, &detection_queue_len, 4, 64, nullptr, PARAM_PERSIST | PARAM_REBOOT);
+#ifdef SIGPACK_FS
+    params.add("geo.alert_m", PARAM_U32, &geo_alert_m, 50, 2000, "m");
+    params.add("geo.boost_ms", PARAM_U32, &geo_boost_ms, 0, 300000, "ms");
+#endif
+    PatrolConfig& p = patrol.config;
+    params.add("patrol.on", PARAM_BOOL, &patrol_on, 0, 1);
+    params.add("patrol.burst_ms", PARAM_U32, &p.burst_ms, 1000, 60000, "ms");
+    params.add("patrol.sleep_min_ms", PARAM_U32, &p.sleep_min_ms, 500, 300000, "ms");
+    params.add("patrol.sleep_max_ms", PARAM_U32, &p.sleep_max_ms, 500, 300000, "ms");
+    params.add("patrol.hold_ms", PARAM_U32, &p.hold_ms, 0, 600000, "ms");
+    params.add("patrol.near_m", PARAM_U32, &p.near_m, 0, 5000, "m");
+    params.add("patrol.display_ms", PARAM_U32, &patrol_display_ms, 0, 600000, "ms");
+    params.add("power.scan_ma10", PARAM_U16, &patrol_power.ma_x10[PATROL_POWER_SCAN], 0, 20000, "0.1mA");
+    params.add("power.sleep_ma10", PARAM_U16, &patrol_power.ma_x10[PATROL_POWER_SLEEP], 0, 20000, "0.1mA");
+    params.add("power.display_ma10", PARAM_U16, &patrol_power.display_ma_x10, 0, 20000, "0.1mA");
+    params.setHooks(check_params, lock_params, store_params);
+
+    uint8_t blob[PARAM_BLOB_MAX];
+    size_t len = 0;
+    Preferences prefs;
+    if (prefs.begin(SNAPSHOT_NVS_NS, true)) {
+        len = prefs.getBytesLength(PARAMS_NVS_KEY);
+        if (len > sizeof(blob) || prefs.getBytes(PARAMS_NVS_KEY, blob, len) != len) len = 0;
+        prefs.end();
+    }
+    uint8_t restored = len ? params.load(blob, len) : 0;
+    printf("[PARAM] %u runtime parameters, %u saved values applied (serial \"@list\")\n",
+           params.size(), restored);
+}
+
+// ============================================================================
+// GEO PROXIMITY (known camera sites)
+// ============================================================================
+
+// Serial commands, one per line:
+//   POS <lat> <lon>  position feed (decimal degrees), e.g. from api/flockyou.py
+//                    relaying its GPS dongle
+//   PERF             dump the performance registry (api/perf_chart.py)
+//   PERF RESET       start a new histogram window
+//   TRACE            dump and clear the event trace (tools/trace2chrome.py)
+//   BOOT             repeat the boot timeline
+//   @...             parameter console (get/set/list/defaults/save); replies
+//                    start with '@' too, see param_registry.h
+// At most SERIAL_POLL_MAX bytes are taken per loop() pass; the rest waits
+// in the UART buffer for the next one.
+static void poll_serial_input()
+{
+    for (int budget = SERIAL_POLL_MAX; budget > 0 && Serial.available(); budget--) {
+        char c = Serial.read();
+        if (c != '\n' && c != '\r') {
+            if (serial_line_len < sizeof(serial_line) - 1) serial_line[serial_line_len++] = c;
+            else serial_line_overflow = true;
+            continue;
+        }
+        serial_line[serial_line_len] = '\0';
+        serial_line_len = 0;
+        if (serial_line_overflow) {
+            serial_line_overflow = false;
+            if (serial_line[0] == '@') param_reply("@err syntax line too long\n", 26, nullptr);
+            continue;
+        }
+
+        double lat, lon;
+        if (serial_line[0] == '@') {
+            params.command(serial_line, param_reply, nullptr);
+        } else if (sscanf(serial_line, "POS %lf %lf", &lat, &lon) == 2 &&
+            lat >= -90 && lat <= 90 && lon >= -180 && lon <= 180) {
+            set_position((int32_t)lround(lat * 1e7), (int32_t)lround(lon * 1e7), 0);
+        } else if (strcmp(serial_line, "PERF") == 0) {
+            output_perf_json();
+        } else if (strcmp(serial_line, "PERF RESET") == 0) {
+            perf_reset();
+#if TRACE_ENABLED
+        } else if (strcmp(serial_line, "TRACE") == 0) {
+            output_trace_json();
+#endif
+        } else if (strcmp(serial_line, "BOOT") == 0) {
+            output_boot_timeline();
+        }
+    }
+}
+
+#ifdef SIGPACK_FS
+static bool geo_read(void* ctx, uint32_t offset, void* buf, uint32_t len)
+{
+    File* file = (File*)ctx;
+    return file->seek(offset) && file->read((uint8_t*)buf, len) == len;
+}
+
+// Open GEO_FILE and keep it open for block loads. Caller holds displayMutex.
+static void init_geo_index()
+{
+    geo_file = SIGPACK_FS.open(GEO_FILE, FILE_READ);
+    if (!geo_file) {
+        printf("[GEO] No %s on SD, proximity alerts off\n", GEO_FILE);
+        return;
+    }
+    SigPackStatus status = geo_index.open(geo_read, &geo_file, geo_file.size(), true);
+    if (status != SIGPACK_OK) {
+        printf("[GEO] Rejected %s: %s\n", GEO_FILE, sigpack_status_str(status));
+        geo_file.close();
+        return;
+    }
+    printf("[GEO] %u known sites in %u cells, queries up to %u m\n",
+           geo_index.siteCount(), geo_index.cellCount(), geo_index.maxRadius());
+}
+
+static void output_geo_alert_json(const GeoResult& r, int32_t lat_e7, int32_t lon_e7)
+{
+    StaticJsonDocument<384> doc;
+    doc["type"] = "geo_alert";
+    doc["timestamp"] = millis();
+    doc["kind"] = geo_kind_name(r.nearest.kind);
+    doc["distance_m"] = r.nearest_m;
+    doc["sites_in_range"] = r.count;
+    doc["site_lat"] = r.nearest.lat_e7 * 1e-7;
+    doc["site_lon"] = r.nearest.lon_e7 * 1e-7;
+    doc["site_records"] = r.nearest.records;
+    doc["lat"] = lat_e7 * 1e-7;
+    doc["lon"] = lon_e7 * 1e-7;
+    serializeJson(doc, Serial);
+    Serial.println();
+}
+
+// Query the latest fix: one pre-alert per newly nearest site, and a dwell
+// boost so the radios are already listening when it comes into RF range
+static void geo_update()
+{
+    if (!geo_fix_pending || !geo_index.opened()) return;
+    // A block load reads SD: share the bus with the display's log flush
+    if (!display_lock(5)) return;
+    int32_t lat_e7 = geo_lat_e7, lon_e7 = geo_lon_e7;
+    geo_fix_pending = false;
+    GeoResult r;
+    TRACE_BEGIN(TRACE_GEO_UPDATE);
+    bool ok = geo_index.query(lat_e7, lon_e7, geo_alert_m, r);
+    TRACE_END_ARG(TRACE_GEO_UPDATE, ok ? r.count : 0);
+    xSemaphoreGive(displayMutex);
+    if (!ok) return;
+
+    patrol.setSiteDistance(r.count ? r.nearest_m : PATROL_DISTANCE_UNKNOWN);
+    if (r.count == 0) {
+        geo_in_range = false;
+        return;
+    }
+    if (!geo_in_range || r.nearest.lat_e7 != geo_alerted.lat_e7 || r.nearest.lon_e7 != geo_alerted.lon_e7) {
+        geo_alerted = r.nearest;
+        geo_in_range = true;
+        geo_alerts++;
+        printf("[GEO] Known %s site %u m away (%u in range)\n",
+               geo_kind_name(r.nearest.kind), r.nearest_m, r.count);
+        output_geo_alert_json(r, lat_e7, lon_e7);
+    }
+    geo_boost_until = millis() + geo_boost_ms;
+}
+#endif
+
+// ============================================================================
+// SIGNATURE PACK (SD, hot reload)
+// ============================================================================
+
+#ifdef SIGPACK_FS
+// Load SIGPACK_FILE into the idle slot and make it active. Caller holds
+// displayMutex (serialises SD access with the display's log flush).
+static bool load_signature_pack()
+{
+    File file = SIGPACK_FS.open(SIGPACK_FILE, FILE_READ);
+    if (!file) return false;
+
+    size_t size = file.size();
+    sigpack_file_size = size;
+    sigpack_file_time = file.getLastWrite();
+    if (size == 0 || size > SIGPACK_MAX_SIZE) {
+        printf("[SIGPACK] %s: bad size %u\n", SIGPACK_FILE, (unsigned)size);
+        file.close();
+        return false;
+    }
+
+    uint8_t* image = (uint8_t*)malloc(size);
+    if (!image) {
+        printf("[SIGPACK] Out of memory for %u byte pack\n", (unsigned)size);
+        file.close();
+        return false;
+    }
+    size_t got = file.read(image, size);
+    file.close();
+
+    int slot = (active_sigpack == &sigpacks[0]) ? 1 : 0;
+    SignaturePack staged;
+    SigPackStatus status = got == size ? staged.load(image, size) : SIGPACK_ERR_SIZE;
+    if (status != SIGPACK_OK) {
+        printf("[SIGPACK] Rejected %s: %s\n", SIGPACK_FILE, sigpack_status_str(status));
+        free(image);
+        return false;
+    }
+    if (active_sigpack && staged.version() == active_sigpack->version()) {
+        free(image);  // Same content (file touched), keep the active pack
+        return false;
+    }
+
+    // Idle slot was retired at least one check interval ago, and held alerts
+    // keep copies of their rules: safe to reuse
+    free(sigpack_images[slot]);
+    sigpack_images[slot] = image;
+    sigpacks[slot].load(image, size);
+    active_sigpack = &sigpacks[slot];
+
+    const SignaturePack* pack = active_sigpack;
+    printf("[SIGPACK] Active v%u: %u OUIs, %u MACs, %u SSID / %u name patterns, %u BLE rules, %u confidence rules\n",
+           pack->version(), pack->ouiCount(), pack->macCount(),
+           pack->ssidCount(), pack->nameCount(), pack->bleRuleCount(), pack->rules().ruleCount());
+    return true;
+}
+
+// Poll for a changed pack file (size or mtime) and hot-swap it
+static void check_signature_pack()
+{
+    if (millis() - last_sigpack_check < SIGPACK_CHECK_MS) return;
+    last_sigpack_check = millis();
+    if (!display.isSDCardPresent()) return;
+    if (!display_lock(5)) return;
+
+    TRACE_BEGIN(TRACE_SIGPACK_CHECK);
+    bool changed = false;
+    File file = SIGPACK_FS.open(SIGPACK_FILE, FILE_READ);
+    if (file) {
+        changed = file.size() != sigpack_file_size || file.getLastWrite() != sigpack_file_time;
+        file.close();
+        if (changed) load_signature_pack();
+    }
+    TRACE_END_ARG(TRACE_SIGPACK_CHECK, changed);
+    xSemaphoreGive(displayMutex);
+}
+#endif
+
+// ============================================================================
+// BOOT SEQUENCE (FAST_BOOT: radios on Core 1, storage on Core 0)
+// ============================================================================
+
+// Channel dwell policy, runtime parameters, then the queue and mutex sized
+// by them: everything the tasks and callbacks below rely on
+static void init_pipeline()
+{
+    // Channel dwell policy must exist before the processing task reports to it
+    DwellConfig dwell_config;
+    dwell_policy = dwell_policy_create(CHANNEL_DWELL_POLICY, dwell_config);
+    printf("[INIT] Channel dwell policy: %s\n", dwell_policy->name());
+
+    // Saved runtime parameters, including the queue length
+    init_params();
 
     // Create FreeRTOS queue and mutex before starting WiFi/BLE
-    detectionQueue = xQueueCreate(16, sizeof(DetectionEvent));
+    detectionQueue = xQueueCreate(detection_queue_len, sizeof(DetectionEvent));
     displayMutex = xSemaphoreCreateMutex();
     if (!detectionQueue || !displayMutex) {
         printf("[FATAL] Failed to create queue or mutex!\n");
     }
+}
 
+// Matchers and the flash index; CPU and flash only
+static void init_matching()
+{
+    init_mac_prefixes();
+    ble_matcher.compile(ble_payload_rules, sizeof(ble_payload_rules) / sizeof(ble_payload_rules[0]));
+    RuleStatus rules = default_rules.load(rules_default_image, sizeof(rules_default_image));
+    printf("[RULES] Built-in confidence rules: %u (%s)\n", default_rules.ruleCount(), rule_status_str(rules));
+}
+
+static void start_processing_task()
+{
     // Start processing task on Core 0
     xTaskCreatePinnedToCore(
         processingTask,        // Task function
@@ -1101,32 +3076,84 @@ void setup()
     // Remove IDLE0 from task watchdog — Core 0 is dedicated to detection processing
     esp_task_wdt_delete(xTaskGetIdleTaskHandleForCPU(0));
     printf("[INIT] IDLE0 removed from task watchdog\n");
+}
 
+static void start_wifi_capture()
+{
     // Initialize WiFi in promiscuous mode
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
+#if !FAST_BOOT
     delay(100);
+#endif
 
     esp_wifi_set_promiscuous(true);
     esp_wifi_set_promiscuous_rx_cb(&wifi_sniffer_packet_handler);
     esp_wifi_set_channel(current_channel, WIFI_SECOND_CHAN_NONE);
+    airtime.begin(current_channel, now_us());
+    boot_capture_us = (uint32_t)esp_timer_get_time();
 
     printf("WiFi promiscuous mode enabled on channel %d\n", current_channel);
     printf("Monitoring probe requests and beacons...\n");
+}
 
-    // Initialize BLE
+static void init_ble_scanner()
+{
     printf("Initializing BLE scanner...\n");
     NimBLEDevice::init("");
     pBLEScan = NimBLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new AdvertisedDeviceCallbacks());
+    // Every advert reaches onResult; repeats are dropped by the controller
+    // duplicate filter and then by the host seen-cache. No result storage.
+    pBLEScan->setAdvertisedDeviceCallbacks(new AdvertisedDeviceCallbacks(), true);
     pBLEScan->setActiveScan(false);  // Passive scan — lower power, still gets ads
+    pBLEScan->setDuplicateFilter(true);
+    pBLEScan->setMaxResults(0);
+#if BLE_SCAN_MODE == BLE_MODE_CONTINUOUS
+    // Duty cycle the scan window to the configured BLE share of the radio
+    pBLEScan->setInterval(BLE_SCAN_ITVL_MS);
+    pBLEScan->setWindow(BLE_SCAN_ITVL_MS * (100 - RADIO_WIFI_SHARE_PCT) / 100);
+#else
     pBLEScan->setInterval(100);
     pBLEScan->setWindow(99);
+#endif
 
     printf("BLE scanner initialized (passive mode)\n");
-    printf("System ready - hunting for Flock Safety devices...\n\n");
+#if BLE_SCAN_MODE == BLE_MODE_CONTINUOUS
+    pBLEScan->start(0, nullptr, false);
+    airtime.bleStart(now_us());
+    last_dup_reset = millis();
+    printf("[INIT] BLE continuous scan: window %u/%ums, duplicate filter reset every %ums\n",
+           BLE_SCAN_ITVL_MS * (100 - RADIO_WIFI_SHARE_PCT) / 100, BLE_SCAN_ITVL_MS, BLE_DUP_RESET_MS);
+#elif BLE_SCAN_MODE == BLE_MODE_SLOTTED
+    radio_scheduler.begin(millis(), total_frames_seen, airtime.advertCount());
+    printf("[INIT] Radio slots: %ums frame, WiFi %u%% (adaptive %u-%u%%)\n",
+           (unsigned)radio_scheduler.frame_ms, radio_scheduler.wifi_share_pct,
+           radio_scheduler.wifi_share_min, radio_scheduler.wifi_share_max);
+#endif
+}
+
+// Signature pack and known-site index from SD. The display shares the SD
+// bus, so this waits for the mutex however long loop() holds it.
+static void load_sd_indexes()
+{
+#ifdef SIGPACK_FS
+    if (display.isSDCardPresent()) {
+        if (!display_lock(100)) {
+            printf("[SIGPACK] Display busy, waiting to load the SD indexes\n");
+            while (!display_lock(100)) {}
+        }
+        if (!load_signature_pack()) printf("[SIGPACK] No pack on SD, using built-in signatures\n");
+        init_geo_index();
+        xSemaphoreGive(displayMutex);
+    }
+    last_sigpack_check = millis();
+#endif
+}
 
+static void show_scan_ready()
+{
 #ifdef HAS_DISPLAY
+    if (!display_lock(100)) return;
     // Only show system ready if not in calibration mode (CYD has touch calibration)
 #ifdef CYD_DISPLAY
     if (display.getCurrentPage() != DisplayHandler::PAGE_CALIBRATE) {
@@ -1135,15 +3162,177 @@ void setup()
 #ifdef CYD_DISPLAY
     }
 #endif
+    xSemaphoreGive(displayMutex);
+#endif
+}
+
+#if FAST_BOOT
+static SemaphoreHandle_t boot_storage_ready = NULL;
+
+// Storage side of a fast boot, on Core 0 while setup() brings up the radios
+// on Core 1: display and SD mount (settings, touch calibration), the warm
+// snapshot, then the SD indexes and the cosmetic boot beep. setup() waits
+// for boot_storage_ready before starting the processing task, which must
+// not run while the snapshot is restored. Nothing else touches SD until
+// then, so the restore reads it without the display mutex.
+static void boot_io_task(void*)
+{
+#ifdef HAS_DISPLAY
+    xSemaphoreTake(displayMutex, portMAX_DELAY);
+    if (!display.begin(true)) {
+        Serial.println("Failed to initialize display!");
+    }
+    xSemaphoreGive(displayMutex);
+    boot_mark("display, SD, settings, calibration");
+#endif
+    restore_snapshot();
+    boot_mark("snapshot restored");
+    // The index CRC walks the whole partition: here, not ahead of capture.
+    // Until it is attached, matching uses the built-in tables.
+    init_flash_index();
+    boot_mark("flash index");
+    xSemaphoreGive(boot_storage_ready);
+
+    load_sd_indexes();
+    boot_mark("signature pack, geo index");
+    show_scan_ready();
+    boot_beep_sequence();
+    boot_io_done = true;
+    vTaskDelete(NULL);
+}
 #endif
 
+// ============================================================================
+// MAIN FUNCTIONS
+// ============================================================================
+
+#if FAST_BOOT
+void setup()
+{
+    Serial.begin(115200);
+    boot_mark("serial");
+    init_pipeline();
+    boot_storage_ready = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(boot_io_task, "boot_io", 8192, NULL, 1, NULL, 0);
+    boot_mark("pipeline, boot I/O task started");
+
+    // Buzzer and status LED straight to their idle state (no LED test)
+#if BUZZER_ENABLED
+    pinMode(BUZZER_PIN, OUTPUT);
+    digitalWrite(BUZZER_PIN, LOW);
+#endif
+    led_init();
+    status_led.play(LED_FX_SCAN);
+    init_matching();
+#ifdef GPS_RX_PIN
+    init_gps();
+#endif
+    boot_mark("matchers");
+
+    start_wifi_capture();
+    boot_mark("WiFi capture on");
+    init_ble_scanner();
+    boot_mark("BLE scanner");
+
+    // Frames queue up (and overflow) until the processing task runs
+    // The restore writes the tracking tables and the dwell policy, so there
+    // is no timeout: it is bounded by one SD mount and two snapshot reads
+    if (xSemaphoreTake(boot_storage_ready, pdMS_TO_TICKS(5000)) != pdTRUE) {
+        printf("[BOOT] Storage still initializing after 5 s, waiting for the snapshot restore\n");
+        xSemaphoreTake(boot_storage_ready, portMAX_DELAY);
+    }
+    init_perf();
+#if TRACE_ENABLED
+    init_trace();
+#endif
+    start_processing_task();
+    boot_mark("processing task");
+    printf("System ready - hunting for Flock Safety devices...\n\n");
+    init_patrol();
     last_channel_hop = millis();
 }
+#else
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+    boot_mark("serial");
+    init_flash_index();
+    init_matching();
+#ifdef GPS_RX_PIN
+    init_gps();
+#endif
+    boot_mark("matchers");
+
+#ifdef HAS_DISPLAY
+    // Initialize display first for visual feedback
+    if (!display.begin()) {
+        Serial.println("Failed to initialize display!");
+    }
+    // Note: Don't show info here - display.begin() may have started calibration mode (CYD only)
+    boot_mark("display, SD, settings, calibration");
+#endif
+
+    // Initialize buzzer
+#if BUZZER_ENABLED
+    pinMode(BUZZER_PIN, OUTPUT);
+    digitalWrite(BUZZER_PIN, LOW);
+#endif
+
+    // Initialize status LED (LEDC on the CYD, WS2812 over RMT on the Waveshare)
+    led_init();
+
+    // LED boot test - cycle R, G, B to verify hardware
+    printf("LED boot test: RED...\n");
+    status_led.show(255, 0, 0);   // Red
+    delay(400);
+    printf("LED boot test: GREEN...\n");
+    status_led.show(0, 255, 0);   // Green
+    delay(400);
+    printf("LED boot test: BLUE...\n");
+    status_led.show(0, 0, 255);   // Blue
+    delay(400);
+    printf("LED boot test: ORANGE...\n");
+    status_led.show(255, 100, 0);  // Orange
+    delay(400);
+    printf("LED boot test: Scanning mode (breathing green)\n");
+    status_led.play(LED_FX_SCAN);
+
+    boot_beep_sequence();
+    boot_mark("LED test, boot beep");
+
+    printf("Starting Flock Squawk Enhanced Detection System...\n\n");
+
+    init_pipeline();
+
+    // Tracking state from before the last reset, while nothing else touches it
+    restore_snapshot();
+    boot_mark("snapshot restored");
+    init_perf();
+#if TRACE_ENABLED
+    init_trace();
+#endif
+    start_processing_task();
+    boot_mark("processing task");
+
+    start_wifi_capture();
+    boot_mark("WiFi capture on");
+    init_ble_scanner();
+    boot_mark("BLE scanner");
+    load_sd_indexes();
+    boot_mark("signature pack, geo index");
+    printf("System ready - hunting for Flock Safety devices...\n\n");
+    show_scan_ready();
+
+    boot_io_done = true;
+    init_patrol();
+    last_channel_hop = millis();
+}
+#endif
 
 void loop()
 {
-    // Service the RGB LED strobe (non-blocking)
-    led_flash_update();
+    uint32_t loop_started = now_us();
 
     // Play detection beep on Core 1 (deferred from processingTask on Core 0)
     if (pending_beep) {
@@ -1151,21 +3340,47 @@ void loop()
         flock_detected_beep_sequence();
     }
 
-    // Print stats every 5 seconds (includes queue diagnostics)
-    static unsigned long last_stats = 0;
-    if (millis() - last_stats > 5000) {
+    // Print stats every airtime window (5s, includes queue diagnostics)
+    if (airtime.roll(now_us())) {
+        TRACE_BEGIN(TRACE_STATS_OUTPUT);
+        const AirtimeWindow& w = airtime.last();
+        uint32_t span = w.span_us ? w.span_us : 1;
+        update_ble_rates(w.adverts, span);
         UBaseType_t queueDepth = detectionQueue ? uxQueueMessagesWaiting(detectionQueue) : 0;
-        printf("[STATS] Frames: %u, SSIDs: %u, Ch: %d | Queue: %u/16, Processed: %u, Dropped: %u | Tracked: %u/%d, Collisions: %u\n",
+        printf("[STATS] Frames: %u, SSIDs: %u, Ch: %d | Queue: %u/%u, Processed: %u, Dropped: %u | Tracked: %u/%d, Collisions: %u"
+               " | Air: WiFi %u%%, Switch %u.%u%% (%u), BLE %u%%, Overlap %u%%, %.3f f/ms"
+               " | BLE/s: rx %u, filtered %u, fwd %u\n",
                total_frames_seen, total_ssids_seen, current_channel,
-               (unsigned)queueDepth, events_processed, events_dropped,
-               hash_entries, MAX_TRACKED, hash_collisions);
-        last_stats = millis();
+               (unsigned)queueDepth, (unsigned)detection_queue_len, events_processed, events_dropped,
+               hash_entries, MAX_TRACKED, hash_collisions,
+               (unsigned)((uint64_t)w.totalListenUs() * 100 / span),
+               (unsigned)((uint64_t)w.switch_us * 100 / span),
+               (unsigned)((uint64_t)w.switch_us * 1000 / span % 10), w.switches,
+               (unsigned)((uint64_t)w.ble_us * 100 / span),
+               (unsigned)((uint64_t)w.overlap_us * 100 / span),
+               w.totalListenUs() ? w.totalFrames() * 1000.0f / w.totalListenUs() : 0.0f,
+               ble_rx_per_s, ble_filtered_per_s, ble_forwarded_per_s);
+        output_stats_json((unsigned)queueDepth);
+        TRACE_END(TRACE_STATS_OUTPUT);
     }
 
 #ifdef HAS_DISPLAY
     // Update display (mutex protects against concurrent addDetection from processing task)
-    if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+    if (display_lock(10)) {
+        // Latest non-matching BLE advert sampled by onResult (Strings built here, not on the BLE host)
+        if (ble_debug_ready) {
+            char mac_str[18];
+            snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
+                     ble_debug_sample.mac[0], ble_debug_sample.mac[1], ble_debug_sample.mac[2],
+                     ble_debug_sample.mac[3], ble_debug_sample.mac[4], ble_debug_sample.mac[5]);
+            display.showDebugBLE(String(ble_debug_sample.name), String(mac_str), ble_debug_sample.rssi);
+            ble_debug_ready = false;
+        }
+        uint32_t frame_started = now_us();
+        TRACE_BEGIN(TRACE_DISPLAY_UPDATE);
         display.update();
+        TRACE_END(TRACE_DISPLAY_UPDATE);
+        perf_display_us.record(now_us() - frame_started);
         xSemaphoreGive(displayMutex);
     }
 #endif
@@ -1173,6 +3388,20 @@ void loop()
     // Handle channel hopping for WiFi promiscuous mode
     hop_channel();
 
+    if (boot_io_done && !boot_reported) {
+        boot_reported = true;
+        output_boot_timeline();
+    }
+    poll_serial_input();
+#ifdef GPS_RX_PIN
+    poll_gps();
+#endif
+#ifdef SIGPACK_FS
+    check_signature_pack();
+    geo_update();
+#endif
+    store_snapshot();
+
     // Handle heartbeat pulse if device is in range
     if (device_in_range) {
         unsigned long now = millis();
@@ -1191,26 +3420,75 @@ void loop()
         }
     }
 
-    if (millis() - last_ble_scan >= BLE_SCAN_INTERVAL && !pBLEScan->isScanning()) {
-        pBLEScan->start(BLE_SCAN_DURATION, false);
+#if BLE_SCAN_MODE == BLE_MODE_CONTINUOUS
+    // Scan stays up; periodically forget the controller's duplicate list so
+    // known advertisers are heard again (the seen-cache bounds the burst)
+    if (millis() - last_dup_reset >= BLE_DUP_RESET_MS) {
+        pBLEScan->clearDuplicateCache();
+        last_dup_reset = millis();
+    }
+#elif BLE_SCAN_MODE == BLE_MODE_SLOTTED
+    // Slot boundary: hand the radio to BLE (non-blocking scan) or back to WiFi
+    if (radio_scheduler.tick(millis(), total_frames_seen, airtime.advertCount())) {
+        if (radio_scheduler.slot() == RADIO_SLOT_BLE) {
+            ble_slot_started = millis();
+            // BLE gets the front end: no frames counted against the held channel
+            wifi_rx_paused = true;
+            esp_wifi_set_promiscuous(false);
+            airtime.wifiPause(now_us());
+            airtime.bleStart(now_us());
+            TRACE_BEGIN(TRACE_BLE_SCAN_START);
+            pBLEScan->start(0, nullptr, false);  // Runs until the WiFi slot stops it
+            TRACE_END(TRACE_BLE_SCAN_START);
+        } else {
+            TRACE_BEGIN(TRACE_BLE_SCAN_STOP);
+            pBLEScan->stop();
+            TRACE_END(TRACE_BLE_SCAN_STOP);
+            airtime.bleStop(now_us());
+            esp_wifi_set_promiscuous(true);
+            wifi_rx_paused = false;
+            airtime.wifiResume(current_channel, now_us());
+            last_ble_scan = millis();
+            // Don't charge the BLE slot against the current channel's dwell
+            last_channel_hop += last_ble_scan - ble_slot_started;
+        }
+#ifdef HAS_DISPLAY
+        if (display_lock(5)) {
+            display.updateScanMode(radio_scheduler.slot() == RADIO_SLOT_BLE);
+            xSemaphoreGive(displayMutex);
+        }
+#endif
+    }
+#else
+    if (millis() - last_ble_scan >= ble_scan_interval_ms && !pBLEScan->isScanning()) {
+        // Blocking overload: returns when the scan window ends
+        airtime.bleStart(now_us());
+        TRACE_BEGIN(TRACE_BLE_SCAN_BLOCKING);
+        pBLEScan->start(ble_scan_duration_s, false);
+        TRACE_END(TRACE_BLE_SCAN_BLOCKING);
+        airtime.bleStop(now_us());
         last_ble_scan = millis();
 #ifdef HAS_DISPLAY
-        if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+        if (display_lock(5)) {
             display.updateScanMode(true);
             xSemaphoreGive(displayMutex);
         }
 #endif
     }
 
-    if (pBLEScan->isScanning() == false && millis() - last_ble_scan > BLE_SCAN_DURATION * 1000) {
+    if (pBLEScan->isScanning() == false && millis() - last_ble_scan > ble_scan_duration_s * 1000) {
         pBLEScan->clearResults();
 #ifdef HAS_DISPLAY
-        if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+        if (display_lock(5)) {
             display.updateScanMode(false);
             xSemaphoreGive(displayMutex);
         }
 #endif
     }
 
+#endif
+
+    patrol_update();
+    perf_loop_us.record(now_us() - loop_started);
     vTaskDelay(pdMS_TO_TICKS(10));  // 10ms yield instead of 100ms delay
 }
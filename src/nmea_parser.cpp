@@ -0,0 +1,260 @@
+/**
+ * @file nmea_parser.cpp
+ * @brief Byte-at-a-time NMEA framing, checksum and RMC/GGA field decoding
+ *
+ * @see nmea_parser.h
+ */
+
+#include "nmea_parser.h"
+#include <string.h>
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Decimal text to an integer scaled by 10^decimals, extra digits truncated
+static bool parse_fixed(const char* s, int decimals, int32_t& out) {
+    bool neg = *s == '-';
+    if (neg || *s == '+') s++;
+    int64_t v = 0;
+    int digits = 0, frac = -1;
+    for (; *s; s++) {
+        if (*s == '.' && frac < 0) {
+            frac = 0;
+        } else if (*s >= '0' && *s <= '9') {
+            if (frac >= decimals) continue;
+            if (v > 100000000000LL) return false;
+            v = v * 10 + (*s - '0');
+            digits++;
+            if (frac >= 0) frac++;
+        } else {
+            return false;
+        }
+    }
+    if (digits == 0) return false;
+    for (int i = frac < 0 ? 0 : frac; i < decimals; i++) v *= 10;
+    if (v > INT32_MAX) return false;
+    out = neg ? -(int32_t)v : (int32_t)v;
+    return true;
+}
+
+static bool parse_digits(const char* s, int count, int& out) {
+    out = 0;
+    for (int i = 0; i < count; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        out = out * 10 + (s[i] - '0');
+    }
+    return true;
+}
+
+// "ddmm.mmmm" / "dddmm.mmmm" plus hemisphere to 1e-7 degrees
+static bool parse_coord(const char* s, const char* hemi, int32_t max_e7, int32_t& out) {
+    const char* dot = strchr(s, '.');
+    int int_len = dot ? (int)(dot - s) : (int)strlen(s);
+    if (int_len < 3 || int_len > 5) return false;
+    int deg;
+    int32_t min_e7;
+    if (!parse_digits(s, int_len - 2, deg) || !parse_fixed(s + int_len - 2, 7, min_e7)) return false;
+    if (min_e7 < 0 || min_e7 >= 600000000) return false;
+    int64_t v = (int64_t)deg * 10000000 + (min_e7 + 30) / 60;
+    if (v > max_e7) return false;
+    switch (hemi[0]) {
+    case 'N': case 'E': out = (int32_t)v; return true;
+    case 'S': case 'W': out = -(int32_t)v; return true;
+    }
+    return false;
+}
+
+// "hhmmss[.sss]" to second of day (fraction dropped)
+static bool parse_time(const char* s, int32_t& tod) {
+    int h, m, sec;
+    if (strlen(s) < 6 || !parse_digits(s, 2, h) || !parse_digits(s + 2, 2, m) || !parse_digits(s + 4, 2, sec)) {
+        return false;
+    }
+    if (h > 23 || m > 59 || sec > 60) return false;
+    tod = h * 3600 + m * 60 + sec;
+    return true;
+}
+
+// "ddmmyy" to days since 1970-01-01 (civil-from-days inverse, H. Hinnant)
+static bool parse_date(const char* s, int32_t& days) {
+    int d, m, y;
+    if (strlen(s) != 6 || !parse_digits(s, 2, d) || !parse_digits(s + 2, 2, m) || !parse_digits(s + 4, 2, y)) {
+        return false;
+    }
+    if (d < 1 || d > 31 || m < 1 || m > 12) return false;
+    y += y < 80 ? 2000 : 1900;
+    y -= m <= 2;
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = era * 146097 + doe - 719468;
+    return true;
+}
+
+NmeaParser::NmeaParser() {
+    reset();
+}
+
+void NmeaParser::reset() {
+    memset(&gps, 0, sizeof(gps));
+    len = 0;
+    sum = 0;
+    check = 0;
+    state = IDLE;
+    day = -1;
+    rmc_tod = 0;
+    accepted = 0;
+    bad_checksum = 0;
+    bad_framing = 0;
+    other = 0;
+}
+
+GpsTag NmeaParser::tag() const {
+    GpsTag t;
+    t.lat_e7 = gps.lat_e7;
+    t.lon_e7 = gps.lon_e7;
+    t.utc = gps.utc;
+    t.valid = gps.valid;
+    return t;
+}
+
+bool NmeaParser::feed(char c) {
+    if (c == '$') {
+        if (state != IDLE) bad_framing++;  // Previous sentence cut short
+        state = BODY;
+        len = 0;
+        sum = 0;
+        return false;
+    }
+
+    switch (state) {
+    case IDLE:
+        return false;
+
+    case BODY:
+        if (c == '*') {
+            state = CHECK_HI;
+        } else if (c < 0x20 || c > 0x7E || len >= NMEA_MAX_SENTENCE) {
+            bad_framing++;  // Line ended without a checksum, noise, or overlong
+            state = IDLE;
+        } else {
+            buf[len++] = c;
+            sum ^= (uint8_t)c;
+        }
+        return false;
+
+    case CHECK_HI:
+    case CHECK_LO: {
+        int v = hex_value(c);
+        if (v < 0) {
+            bad_framing++;
+            state = IDLE;
+            return false;
+        }
+        if (state == CHECK_HI) {
+            check = v << 4;
+            state = CHECK_LO;
+            return false;
+        }
+        state = IDLE;
+        if ((check | v) != sum) {
+            bad_checksum++;
+            return false;
+        }
+        buf[len] = '\0';
+        return apply();
+    }
+    }
+    return false;
+}
+
+bool NmeaParser::apply() {
+    char* f[NMEA_MAX_FIELDS];
+    int n = 0;
+    char* p = buf;
+    f[n++] = p;
+    while ((p = strchr(p, ',')) != nullptr && n < NMEA_MAX_FIELDS) {
+        *p++ = '\0';
+        f[n++] = p;
+    }
+
+    bool ok;
+    if (strlen(f[0]) == 5 && strcmp(f[0] + 2, "RMC") == 0) {
+        ok = applyRmc(f, n);
+    } else if (strlen(f[0]) == 5 && strcmp(f[0] + 2, "GGA") == 0) {
+        ok = applyGga(f, n);
+    } else {
+        other++;
+        return false;
+    }
+    if (!ok) {
+        bad_framing++;
+        return false;
+    }
+    accepted++;
+    return true;
+}
+
+bool NmeaParser::applyRmc(char** f, int n) {
+    if (n < 10) return false;
+    int32_t tod, days;
+    if (parse_time(f[1], tod) && parse_date(f[9], days)) {
+        day = days;
+        rmc_tod = tod;
+        gps.utc = (uint32_t)days * 86400u + tod;
+    }
+    if (f[2][0] != 'A') {
+        gps.valid = false;  // 'V': receiver has no fix yet
+        return true;
+    }
+
+    int32_t lat, lon;
+    if (!parse_coord(f[3], f[4], 900000000, lat) || !parse_coord(f[5], f[6], 1800000000, lon)) return false;
+    gps.lat_e7 = lat;
+    gps.lon_e7 = lon;
+    gps.valid = true;
+
+    int32_t knots_x100;
+    if (parse_fixed(f[7], 2, knots_x100) && knots_x100 >= 0) {
+        int64_t cms = ((int64_t)knots_x100 * 514444 + 500000) / 1000000;
+        gps.speed_cms = cms > 0xFFFF ? 0xFFFF : (uint16_t)cms;
+    }
+    return true;
+}
+
+bool NmeaParser::applyGga(char** f, int n) {
+    if (n < 10) return false;
+    int32_t tod;
+    if (day >= 0 && parse_time(f[1], tod)) {
+        // GGA has no date: borrow the last RMC's, across midnight if needed
+        int32_t d = day;
+        if (tod + 43200 < rmc_tod) d++;
+        else if (tod > rmc_tod + 43200) d--;
+        gps.utc = (uint32_t)d * 86400u + tod;
+    }
+
+    int32_t quality = 0;
+    if (f[6][0] && !parse_fixed(f[6], 0, quality)) return false;
+    gps.quality = (uint8_t)quality;
+    if (quality <= 0) {
+        gps.valid = false;
+        return true;
+    }
+
+    int32_t lat, lon;
+    if (!parse_coord(f[2], f[3], 900000000, lat) || !parse_coord(f[4], f[5], 1800000000, lon)) return false;
+    gps.lat_e7 = lat;
+    gps.lon_e7 = lon;
+    gps.valid = true;
+
+    int32_t sats, hdop, alt;
+    if (parse_fixed(f[7], 0, sats)) gps.sats = sats > 255 ? 255 : (uint8_t)sats;
+    if (parse_fixed(f[8], 1, hdop)) gps.hdop_x10 = hdop > 0xFFFF ? 0xFFFF : (uint16_t)hdop;
+    if (parse_fixed(f[9], 1, alt)) gps.alt_dm = alt;
+    return true;
+}
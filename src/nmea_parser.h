@@ -0,0 +1,90 @@
+/**
+ * @file nmea_parser.h
+ * @brief Incremental NMEA 0183 parser for a UART GPS (RMC and GGA)
+ *
+ * Bytes are fed one at a time as they come off the UART, so the caller never
+ * waits for a full line and never needs a line buffer of its own. A sentence
+ * is only applied once its checksum has been verified; anything else (other
+ * sentence types, noise on a floating RX pin, truncated lines) is counted and
+ * dropped.
+ *
+ * All arithmetic is integer: positions come out in 1e-7 degrees like the geo
+ * index, time as Unix seconds.
+ *
+ *   $GPRMC,hhmmss.ss,A,ddmm.mmmm,N,dddmm.mmmm,W,knots,course,ddmmyy,,,A*hh
+ *   $GPGGA,hhmmss.ss,ddmm.mmmm,N,dddmm.mmmm,W,quality,sats,hdop,alt,M,...*hh
+ *
+ * Any talker ID is accepted (GP, GN, GL, GA, BD).
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef NMEA_PARSER_H
+#define NMEA_PARSER_H
+
+#include <stdint.h>
+
+#define NMEA_MAX_SENTENCE  82   // Standard limit, '$' to checksum inclusive
+#define NMEA_MAX_FIELDS    24
+
+// Position and time attached to a sighting
+struct GpsTag {
+    int32_t  lat_e7;
+    int32_t  lon_e7;
+    uint32_t utc;        // Unix seconds, 0 = time unknown
+    bool     valid;      // lat/lon hold a fix
+};
+
+struct GpsFix {
+    bool     valid;      // RMC status A / GGA quality > 0 on the last sentence
+    int32_t  lat_e7;
+    int32_t  lon_e7;
+    uint32_t utc;        // Unix seconds of the last sentence, 0 until RMC gives a date
+    uint8_t  quality;    // GGA fix quality (1 = GPS, 2 = DGPS, ...)
+    uint8_t  sats;       // Satellites used (GGA)
+    uint16_t hdop_x10;   // Horizontal dilution of precision x10 (GGA)
+    int32_t  alt_dm;     // Altitude above mean sea level, decimetres (GGA)
+    uint16_t speed_cms;  // Speed over ground, cm/s (RMC)
+};
+
+class NmeaParser {
+public:
+    NmeaParser();
+    void reset();
+
+    // Consume one byte. True when it completed an RMC or GGA sentence that
+    // passed its checksum and updated fix(); check fix().valid for a position.
+    bool feed(char c);
+
+    const GpsFix& fix() const { return gps; }
+    GpsTag tag() const;
+
+    uint32_t sentences() const { return accepted; }        // RMC/GGA applied
+    uint32_t checksumErrors() const { return bad_checksum; }
+    uint32_t malformed() const { return bad_framing; }     // Overlong, bad hex, bad fields
+    uint32_t ignored() const { return other; }              // Valid, but not RMC/GGA
+
+private:
+    bool apply();
+    bool applyRmc(char** f, int n);
+    bool applyGga(char** f, int n);
+
+    enum State : uint8_t { IDLE, BODY, CHECK_HI, CHECK_LO };
+
+    GpsFix gps;
+    char buf[NMEA_MAX_SENTENCE + 1];
+    uint8_t len;
+    uint8_t sum;
+    uint8_t check;
+    State state;
+
+    int32_t day;           // Days since 1970-01-01 from the last RMC, -1 unknown
+    int32_t rmc_tod;       // Second of day of that RMC
+
+    uint32_t accepted;
+    uint32_t bad_checksum;
+    uint32_t bad_framing;
+    uint32_t other;
+};
+
+#endif // NMEA_PARSER_H
@@ -0,0 +1,411 @@
+/**
+ * @file param_registry.cpp
+ * @brief Runtime parameter registry, '@' console commands and persistence
+ *
+ * @see param_registry.h
+ */
+
+#include "param_registry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARAM_BLOB_MAGIC   0x52505946u   // "FYPR"
+#define PARAM_BLOB_VERSION 1
+
+const char* param_status_str(ParamStatus status) {
+    switch (status) {
+    case PARAM_OK:           return "ok";
+    case PARAM_ERR_UNKNOWN:  return "unknown";
+    case PARAM_ERR_VALUE:    return "bad value";
+    case PARAM_ERR_RANGE:    return "out of range";
+    case PARAM_ERR_READONLY: return "read-only";
+    case PARAM_ERR_CONFLICT: return "conflict";
+    case PARAM_ERR_SYNTAX:   return "syntax";
+    case PARAM_ERR_STORE:    return "store failed";
+    default:                 return "unknown";
+    }
+}
+
+static const char* const type_names[] = {"bool", "u8", "u16", "u32"};
+
+static uint32_t name_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+ParamRegistry::ParamRegistry()
+    : params(), count(0), check_fn(nullptr), lock_fn(nullptr), store_fn(nullptr) {}
+
+void ParamRegistry::setHooks(CheckFn check, LockFn lock, StoreFn store) {
+    check_fn = check;
+    lock_fn = lock;
+    store_fn = store;
+}
+
+bool ParamRegistry::add(const char* name, ParamType type, void* value, uint32_t min, uint32_t max,
+                        const char* unit, uint8_t flags) {
+    if (count >= PARAM_MAX || find(name) >= 0) return false;
+    Param& p = params[count];
+    p.name = name;
+    p.unit = unit;
+    p.value = value;
+    p.type = type;
+    p.flags = flags;
+    p.min = type == PARAM_BOOL ? 0 : min;
+    p.max = type == PARAM_BOOL ? 1 : max;
+    uint32_t v = get(count);
+    if (v < p.min || v > p.max) return false;
+    p.def = v;
+    count++;
+    return true;
+}
+
+int ParamRegistry::find(const char* name) const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (strcmp(params[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+uint32_t ParamRegistry::get(uint8_t i) const {
+    const Param& p = params[i];
+    switch (p.type) {
+    case PARAM_BOOL: return *(volatile bool*)p.value ? 1 : 0;
+    case PARAM_U8:   return *(volatile uint8_t*)p.value;
+    case PARAM_U16:  return *(volatile uint16_t*)p.value;
+    default:         return *(volatile uint32_t*)p.value;
+    }
+}
+
+uint32_t ParamRegistry::get(const char* name) const {
+    int i = find(name);
+    return i < 0 ? 0 : get((uint8_t)i);
+}
+
+void ParamRegistry::put(uint8_t i, uint32_t v) {
+    const Param& p = params[i];
+    switch (p.type) {
+    case PARAM_BOOL: *(volatile bool*)p.value = v != 0; break;
+    case PARAM_U8:   *(volatile uint8_t*)p.value = (uint8_t)v; break;
+    case PARAM_U16:  *(volatile uint16_t*)p.value = (uint16_t)v; break;
+    default:         *(volatile uint32_t*)p.value = v; break;
+    }
+}
+
+ParamStatus ParamRegistry::parse(uint8_t i, const char* text, uint32_t& out) const {
+    const Param& p = params[i];
+    if (p.type == PARAM_BOOL) {
+        if (!strcmp(text, "on") || !strcmp(text, "true") || !strcmp(text, "1")) out = 1;
+        else if (!strcmp(text, "off") || !strcmp(text, "false") || !strcmp(text, "0")) out = 0;
+        else return PARAM_ERR_VALUE;
+        return PARAM_OK;
+    }
+    // strtoull alone would accept a sign or blanks and read a leading 0 as octal
+    bool hex = text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+    const char* digits = hex ? text + 2 : text;
+    const char* d = digits;
+    while (*d && (hex ? strchr("0123456789abcdefABCDEF", *d) : strchr("0123456789", *d))) d++;
+    if (d == digits || *d || d - digits > (hex ? 8 : 10)) return PARAM_ERR_VALUE;
+    unsigned long long v = strtoull(digits, nullptr, hex ? 16 : 10);
+    if (v < p.min || v > p.max) return PARAM_ERR_RANGE;
+    out = (uint32_t)v;
+    return PARAM_OK;
+}
+
+bool ParamRegistry::apply(const ParamAssign* assigns, uint8_t n, const char** why) {
+    uint32_t old[PARAM_MAX];
+    const char* reason = "rejected";
+    if (lock_fn) lock_fn(true);
+    for (uint8_t k = 0; k < n; k++) {
+        old[k] = get(assigns[k].index);
+        put(assigns[k].index, assigns[k].value);
+    }
+    bool ok = !check_fn || check_fn(*this, &reason);
+    if (!ok) {
+        // Reverse order, so a parameter named twice gets its original back
+        for (uint8_t k = n; k > 0; k--) put(assigns[k - 1].index, old[k - 1]);
+    }
+    if (lock_fn) lock_fn(false);
+    if (why) *why = ok ? nullptr : reason;
+    return ok;
+}
+
+ParamStatus ParamRegistry::set(const ParamAssign* assigns, uint8_t n, int* bad, const char** why) {
+    if (bad) *bad = -1;
+    if (why) *why = nullptr;
+    if (n > PARAM_MAX) return PARAM_ERR_SYNTAX;
+    for (uint8_t k = 0; k < n; k++) {
+        const Param& p = params[assigns[k].index];
+        ParamStatus st = PARAM_OK;
+        if (p.flags & PARAM_READONLY) st = PARAM_ERR_READONLY;
+        else if (assigns[k].value < p.min || assigns[k].value > p.max) st = PARAM_ERR_RANGE;
+        if (st != PARAM_OK) {
+            if (bad) *bad = k;
+            return st;
+        }
+    }
+    return apply(assigns, n, why) ? PARAM_OK : PARAM_ERR_CONFLICT;
+}
+
+void ParamRegistry::defaults() {
+    if (lock_fn) lock_fn(true);
+    for (uint8_t i = 0; i < count; i++) put(i, params[i].def);
+    if (lock_fn) lock_fn(false);
+}
+
+uint8_t ParamRegistry::changed() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (get(i) != params[i].def) n++;
+    }
+    return n;
+}
+
+int ParamRegistry::format(uint8_t i, char* buf, size_t cap) const {
+    const Param& p = params[i];
+    uint32_t v = get(i);
+    int len = p.type == PARAM_BOOL ? snprintf(buf, cap, "%s=%s", p.name, v ? "on" : "off")
+                                   : snprintf(buf, cap, "%s=%u", p.name, (unsigned)v);
+    if (len < 0) return 0;
+    return (size_t)len < cap ? len : (int)cap - 1;
+}
+
+// ============================================================================
+// CONSOLE
+// ============================================================================
+
+namespace {
+
+// Collects "key=value" items and sends them as "@[id] <tag> items\n"
+struct Reply {
+    ParamRegistry::ReplyFn fn;
+    void* ctx;
+    long id;
+    char items[PARAM_REPLY_MAX - 24];   // Room for "@<id> <tag> " and '\n'
+    size_t len;
+
+    bool fits(const char* text) const { return len + 1 + strlen(text) < sizeof(items); }
+    void add(const char* text) {
+        if (!fits(text)) return;
+        len += snprintf(items + len, sizeof(items) - len, len ? " %s" : "%s", text);
+    }
+    void send(const char* tag) {
+        char line[PARAM_REPLY_MAX];
+        int n = id >= 0 ? snprintf(line, sizeof(line), "@%ld %s%s%s\n", id, tag, len ? " " : "", items)
+                        : snprintf(line, sizeof(line), "@%s%s%s\n", tag, len ? " " : "", items);
+        fn(line, (size_t)n < sizeof(line) ? n : sizeof(line) - 1, ctx);
+        len = 0;
+        items[0] = '\0';
+    }
+    void error(ParamStatus st, const char* detail) {
+        len = 0;
+        add(param_status_str(st));
+        if (detail) add(detail);
+        send("err");
+    }
+};
+
+// Next blank-separated token, NUL-terminated in place
+char* next_token(char*& s) {
+    while (*s == ' ' || *s == '\t') s++;
+    if (!*s) return nullptr;
+    char* tok = s;
+    while (*s && *s != ' ' && *s != '\t') s++;
+    if (*s) *s++ = '\0';
+    return tok;
+}
+
+}  // namespace
+
+void ParamRegistry::command(const char* text, ReplyFn reply_fn, void* ctx) {
+    char buf[PARAM_REPLY_MAX];
+    char item[PARAM_REPLY_MAX];
+    Reply r;
+    r.fn = reply_fn;
+    r.ctx = ctx;
+    r.id = -1;
+    r.len = 0;
+    r.items[0] = '\0';
+
+    if (text[0] != '@') return;
+    strncpy(buf, text + 1, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    char* s = buf;
+    if (*s >= '0' && *s <= '9') {
+        r.id = strtol(s, &s, 10);
+        if (r.id > 999999999 || r.id < 0) {
+            r.id = -1;
+            return r.error(PARAM_ERR_SYNTAX, "id over 999999999");
+        }
+    }
+    char* cmd = next_token(s);
+
+    if (cmd && !strcmp(cmd, "get")) {
+        bool hit[PARAM_MAX] = {false};
+        bool any = false;
+        for (char* name; (name = next_token(s)); any = true) {
+            size_t len = strlen(name);
+            bool prefix = name[len - 1] == '*';
+            bool found = false;
+            for (uint8_t i = 0; i < count; i++) {
+                if (prefix ? !strncmp(params[i].name, name, len - 1) : !strcmp(params[i].name, name)) {
+                    hit[i] = found = true;
+                }
+            }
+            if (!found) return r.error(PARAM_ERR_UNKNOWN, name);
+        }
+        // Long answers span several "more" lines; the last one is "ok"
+        for (uint8_t i = 0; i < count; i++) {
+            if (any && !hit[i]) continue;
+            format(i, item, sizeof(item));
+            if (!r.fits(item)) r.send("more");
+            r.add(item);
+        }
+        return r.send("ok");
+    }
+
+    if (cmd && !strcmp(cmd, "set")) {
+        ParamAssign assigns[PARAM_SET_MAX];
+        char* names[PARAM_SET_MAX];
+        uint8_t n = 0;
+        for (char* tok; (tok = next_token(s));) {
+            char* eq = strchr(tok, '=');
+            if (n >= PARAM_SET_MAX || !eq || eq == tok) return r.error(PARAM_ERR_SYNTAX, tok);
+            *eq = '\0';
+            int i = find(tok);
+            if (i < 0) return r.error(PARAM_ERR_UNKNOWN, tok);
+            ParamStatus st = parse((uint8_t)i, eq + 1, assigns[n].value);
+            if (st == PARAM_ERR_RANGE) {
+                snprintf(item, sizeof(item), "%s=%s (%u..%u)", tok, eq + 1, (unsigned)params[i].min,
+                         (unsigned)params[i].max);
+                return r.error(st, item);
+            }
+            if (st != PARAM_OK) {
+                snprintf(item, sizeof(item), "%s=%s", tok, eq + 1);
+                return r.error(st, item);
+            }
+            assigns[n].index = (uint8_t)i;
+            names[n++] = tok;
+        }
+        if (n == 0) return r.error(PARAM_ERR_SYNTAX, "set name=value ...");
+
+        int bad;
+        const char* why;
+        ParamStatus st = set(assigns, n, &bad, &why);
+        if (st != PARAM_OK) return r.error(st, bad >= 0 ? names[bad] : why);
+        bool restart = false;
+        for (uint8_t k = 0; k < n; k++) {
+            format(assigns[k].index, item, sizeof(item));
+            r.add(item);
+            if (params[assigns[k].index].flags & PARAM_REBOOT) restart = true;
+        }
+        if (restart) r.add("restart=needed");
+        return r.send("ok");
+    }
+
+    if (cmd && !strcmp(cmd, "list")) {
+        for (uint8_t i = 0; i < count; i++) {
+            const Param& p = params[i];
+            snprintf(item, sizeof(item), "name=%s value=%u default=%u min=%u max=%u type=%s", p.name,
+                     (unsigned)get(i), (unsigned)p.def, (unsigned)p.min, (unsigned)p.max, type_names[p.type]);
+            r.add(item);
+            if (p.unit) {
+                snprintf(item, sizeof(item), "unit=%s", p.unit);
+                r.add(item);
+            }
+            if (p.flags) {
+                snprintf(item, sizeof(item), "flags=%s%s%s", p.flags & PARAM_PERSIST ? "persist," : "",
+                         p.flags & PARAM_REBOOT ? "reboot," : "", p.flags & PARAM_READONLY ? "readonly," : "");
+                item[strlen(item) - 1] = '\0';
+                r.add(item);
+            }
+            r.send("param");
+        }
+        snprintf(item, sizeof(item), "params=%u changed=%u", count, changed());
+        r.add(item);
+        return r.send("ok");
+    }
+
+    if (cmd && !strcmp(cmd, "defaults")) {
+        defaults();
+        snprintf(item, sizeof(item), "params=%u", count);
+        r.add(item);
+        return r.send("ok");
+    }
+
+    if (cmd && !strcmp(cmd, "save")) {
+        uint8_t blob[PARAM_BLOB_MAX];
+        size_t len = save(blob, sizeof(blob));
+        if (!store_fn || !len || !store_fn(blob, len)) return r.error(PARAM_ERR_STORE, nullptr);
+        snprintf(item, sizeof(item), "saved=%u bytes=%u", blob[5], (unsigned)len);
+        r.add(item);
+        return r.send("ok");
+    }
+
+    r.error(cmd ? PARAM_ERR_UNKNOWN : PARAM_ERR_SYNTAX, cmd ? cmd : "get|set|list|defaults|save");
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+
+// Blob: magic u32, version u8, count u8, 2 reserved, then count x (name hash
+// u32, value u32), little-endian
+size_t ParamRegistry::save(uint8_t* out, size_t cap) const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if ((params[i].flags & PARAM_PERSIST) && get(i) != params[i].def) n++;
+    }
+    if (8 + (size_t)n * 8 > cap) return 0;
+    put_u32(out, PARAM_BLOB_MAGIC);
+    out[4] = PARAM_BLOB_VERSION;
+    out[5] = n;
+    out[6] = out[7] = 0;
+    uint8_t k = 0;
+    for (uint8_t i = 0; i < count && k < n; i++) {
+        uint32_t v = get(i);
+        if (!(params[i].flags & PARAM_PERSIST) || v == params[i].def) continue;
+        put_u32(out + 8 + k * 8, name_hash(params[i].name));
+        put_u32(out + 12 + k * 8, v);
+        k++;
+    }
+    out[5] = k;
+    return 8 + (size_t)k * 8;
+}
+
+uint8_t ParamRegistry::load(const uint8_t* in, size_t len) {
+    if (len < 8 || get_u32(in) != PARAM_BLOB_MAGIC || in[4] != PARAM_BLOB_VERSION) return 0;
+    uint8_t n = in[5];
+    if (len < 8 + (size_t)n * 8) return 0;
+
+    ParamAssign assigns[PARAM_MAX];
+    uint8_t found = 0;
+    for (uint8_t k = 0; k < n && found < PARAM_MAX; k++) {
+        uint32_t hash = get_u32(in + 8 + k * 8);
+        uint32_t v = get_u32(in + 12 + k * 8);
+        for (uint8_t i = 0; i < count; i++) {
+            const Param& p = params[i];
+            if (name_hash(p.name) != hash) continue;
+            if ((p.flags & PARAM_PERSIST) && !(p.flags & PARAM_READONLY) && v >= p.min && v <= p.max) {
+                assigns[found].index = i;
+                assigns[found++].value = v;
+            }
+            break;
+        }
+    }
+    // The whole blob is checked together, as one set
+    return found && apply(assigns, found, nullptr) ? found : 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file param_registry.h
+ * @brief Typed runtime parameters and the '@' serial console that edits them
+ *
+ * Dwell times, scan intervals and the detection TTL used to be #defines, so
+ * tuning for a new city meant a rebuild. A ParamRegistry maps names onto the
+ * variables the firmware already reads (the dwell policy's DwellConfig, the
+ * radio scheduler's public fields, a few globals in main.cpp) with a type,
+ * range and unit, and a registry-wide consistency check (e.g. base dwell
+ * <= active dwell <= high dwell).
+ *
+ * set() takes several assignments at once and applies them all or none:
+ * every value is parsed and range-checked first, then the new values are
+ * written and the consistency check run inside the caller's lock, and the
+ * old values put back if it fails. Each parameter is one aligned word, so a
+ * reader on another task sees its old or new value, never a torn one.
+ *
+ * Parameters flagged PARAM_REBOOT (e.g. the queue length) are only read at
+ * boot; a new value takes effect once saved and restarted. PARAM_PERSIST
+ * parameters that differ from their defaults are saved with save() as
+ * (name hash, value) pairs, so firmware updates that add, drop or reorder
+ * parameters still load an old blob, and untouched parameters follow new
+ * firmware defaults.
+ *
+ * Console lines start with '@' so they cannot be mistaken for the JSON
+ * records and log lines sharing the UART; replies start with '@' too and
+ * echo an optional request id of up to 9 digits ("@7 set x=1" gets
+ * "@7 ok x=1"):
+ *
+ *   @[id] get <name>|<prefix>*     @[id] ok name=value ...
+ *   @[id] set name=value ...       @[id] ok name=value ... | @[id] err ...
+ *   @[id] list                     @[id] param name=... value=... ... (one
+ *                                  per parameter), then @[id] ok params=N
+ *   @[id] defaults                 all parameters back to their defaults
+ *   @[id] save                     persist through the caller's StoreFn
+ *
+ * Unknown commands and bad input are answered with "@[id] err <reason>".
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef PARAM_REGISTRY_H
+#define PARAM_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PARAM_MAX          32
+#define PARAM_SET_MAX       8     // Assignments in one "set"
+#define PARAM_REPLY_MAX   192     // One reply line, including the id and newline
+#define PARAM_BLOB_MAX    (8 + PARAM_MAX * 8)
+
+enum ParamType : uint8_t {
+    PARAM_BOOL = 0,
+    PARAM_U8,
+    PARAM_U16,
+    PARAM_U32,
+};
+
+enum ParamFlags : uint8_t {
+    PARAM_PERSIST  = 1 << 0,   // Saved by save()
+    PARAM_REBOOT   = 1 << 1,   // Read at boot only; a set takes effect after a restart
+    PARAM_READONLY = 1 << 2,
+};
+
+enum ParamStatus : uint8_t {
+    PARAM_OK = 0,
+    PARAM_ERR_UNKNOWN,     // No such parameter or command
+    PARAM_ERR_VALUE,       // Not a number / on|off
+    PARAM_ERR_RANGE,
+    PARAM_ERR_READONLY,
+    PARAM_ERR_CONFLICT,    // Rejected by the consistency check
+    PARAM_ERR_SYNTAX,
+    PARAM_ERR_STORE,       // No StoreFn, or it failed
+};
+
+const char* param_status_str(ParamStatus status);
+
+struct Param {
+    const char* name;
+    const char* unit;      // nullptr for plain numbers
+    void* value;
+    uint32_t min;
+    uint32_t max;
+    uint32_t def;          // Value at registration
+    ParamType type;
+    uint8_t flags;
+};
+
+struct ParamAssign {
+    uint8_t index;
+    uint32_t value;
+};
+
+class ParamRegistry {
+public:
+    // Whole-set consistency check, run with the new values in place. Sets
+    // *why to a short reason when it fails.
+    typedef bool (*CheckFn)(const ParamRegistry& reg, const char** why);
+    // Brackets the write-check-restore step of set() (e.g. a spinlock)
+    typedef void (*LockFn)(bool lock);
+    // Writes a save() blob to flash; false on failure
+    typedef bool (*StoreFn)(const uint8_t* blob, size_t len);
+    // One reply line, '\n' included, to be written in one go
+    typedef void (*ReplyFn)(const char* line, size_t len, void* ctx);
+
+    ParamRegistry();
+
+    void setHooks(CheckFn check, LockFn lock, StoreFn store);
+
+    // Register a parameter; its current value becomes the default. False
+    // when full or when the current value is out of range. Names and units
+    // must outlive the registry (string literals).
+    bool add(const char* name, ParamType type, void* value, uint32_t min, uint32_t max,
+             const char* unit = nullptr, uint8_t flags = PARAM_PERSIST);
+
+    uint8_t size() const { return count; }
+    const Param& param(uint8_t i) const { return params[i]; }
+    int find(const char* name) const;     // Index or -1
+    uint32_t get(uint8_t i) const;
+    uint32_t get(const char* name) const; // 0 when unknown
+
+    // "on"/"off"/"true"/"false" for bools, decimal or 0x hex for numbers
+    ParamStatus parse(uint8_t i, const char* text, uint32_t& out) const;
+    // Apply assignments all-or-nothing; on failure *bad is the index into
+    // `assigns` at fault (-1 for the consistency check) and *why the reason
+    ParamStatus set(const ParamAssign* assigns, uint8_t n, int* bad = nullptr, const char** why = nullptr);
+    void defaults();
+
+    // Console: one '@' line (without the newline), answered through `reply`
+    void command(const char* line, ReplyFn reply, void* ctx);
+
+    // Persistence: bytes written (0 if it does not fit), and parameters
+    // restored from a blob (corrupt or unknown entries are skipped; if the
+    // loaded set fails the consistency check nothing is applied)
+    size_t save(uint8_t* out, size_t cap) const;
+    uint8_t load(const uint8_t* in, size_t len);
+    // Parameters differing from their defaults
+    uint8_t changed() const;
+
+    // "name=value" into buf (bools as on/off); returns the length
+    int format(uint8_t i, char* buf, size_t cap) const;
+
+private:
+    void put(uint8_t i, uint32_t v);
+    // Write, check, and restore on failure, inside the lock
+    bool apply(const ParamAssign* assigns, uint8_t n, const char** why);
+
+    Param params[PARAM_MAX];
+    uint8_t count;
+    CheckFn check_fn;
+    LockFn lock_fn;
+    StoreFn store_fn;
+};
+
+#endif // PARAM_REGISTRY_H
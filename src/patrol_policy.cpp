@@ -0,0 +1,96 @@
+/**
+ * @file patrol_policy.cpp
+ * @brief Patrol duty cycle and energy accounting
+ *
+ * @see patrol_policy.h
+ */
+
+#include "patrol_policy.h"
+#include <math.h>
+
+PatrolPolicy::PatrolPolicy()
+    : config{PATROL_BURST_MS, PATROL_SLEEP_MIN_MS, PATROL_SLEEP_MAX_MS, PATROL_HOLD_MS,
+             PATROL_NEAR_M, PATROL_DENSITY_TAU_MS},
+      burst_start_ms(0), density_ms(0), dens(0.0f), site_m(PATROL_DISTANCE_UNKNOWN),
+      last_detection_ms(0), new_devices(0), absorbed(0), detected(false),
+      last_burst_ms(0), last_sleep_ms(0), sleep_count(0) {}
+
+void PatrolPolicy::begin(uint32_t now_ms) {
+    burst_start_ms = now_ms;
+    density_ms = now_ms;
+}
+
+void PatrolPolicy::noteDetection(uint32_t now_ms, bool new_device) {
+    last_detection_ms = now_ms;
+    detected = true;
+    if (new_device) new_devices = new_devices + 1;
+}
+
+void PatrolPolicy::absorb(uint32_t now_ms) {
+    uint32_t dt = now_ms - density_ms;
+    density_ms = now_ms;
+    if (config.density_tau_ms) dens *= expf(-(float)dt / config.density_tau_ms);
+    uint32_t n = new_devices;
+    dens += (float)(n - absorbed);
+    absorbed = n;
+}
+
+uint32_t PatrolPolicy::sleepDue(uint32_t now_ms) {
+    if (now_ms - burst_start_ms < config.burst_ms) return 0;
+    absorb(now_ms);
+    if (detected && now_ms - last_detection_ms < config.hold_ms) return 0;
+    if (site_m <= config.near_m) return 0;
+
+    uint32_t lo = config.sleep_min_ms;
+    uint32_t hi = config.sleep_max_ms > lo ? config.sleep_max_ms : lo;
+    uint32_t sleep_ms = site_m != PATROL_DISTANCE_UNKNOWN ? lo : lo + (uint32_t)((hi - lo) / (1.0f + dens));
+    last_burst_ms = now_ms - burst_start_ms;
+    return sleep_ms;
+}
+
+void PatrolPolicy::woke(uint32_t now_ms, uint32_t slept_ms) {
+    burst_start_ms = now_ms;
+    last_sleep_ms = slept_ms;
+    sleep_count++;
+}
+
+uint8_t PatrolPolicy::dutyPct() const {
+    if (!sleep_count) return 100;
+    uint32_t cycle = last_burst_ms + last_sleep_ms;
+    return cycle ? (uint8_t)((uint64_t)last_burst_ms * 100 / cycle) : 100;
+}
+
+PatrolMeter::PatrolMeter() : state_ms{}, display_ms(0), display_level_ms(0) {}
+
+void PatrolMeter::add(PatrolPower state, uint32_t ms) {
+    if (state < PATROL_POWER_STATES) state_ms[state] += ms;
+}
+
+void PatrolMeter::addDisplay(uint32_t ms, uint8_t level) {
+    if (!level) return;
+    display_ms += ms;
+    display_level_ms += (uint64_t)ms * level / 255;
+}
+
+uint64_t PatrolMeter::totalMs() const {
+    uint64_t total = 0;
+    for (int i = 0; i < PATROL_POWER_STATES; i++) total += state_ms[i];
+    return total;
+}
+
+float PatrolMeter::mAh(const PatrolPowerModel& model) const {
+    // ms x 0.1 mA -> mAh
+    double sum = (double)display_level_ms * model.display_ma_x10;
+    for (int i = 0; i < PATROL_POWER_STATES; i++) sum += (double)state_ms[i] * model.ma_x10[i];
+    return (float)(sum / 10.0 / 3600000.0);
+}
+
+float PatrolMeter::perMah(uint32_t detections, const PatrolPowerModel& model) const {
+    float used = mAh(model);
+    return used > 0.0f ? detections / used : 0.0f;
+}
+
+float PatrolMeter::averageMa(const PatrolPowerModel& model) const {
+    uint64_t total = totalMs();
+    return total ? mAh(model) * 3600000.0f / total : 0.0f;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file patrol_policy.h
+ * @brief Duty-cycled patrol mode for battery deployments, and its energy meter
+ *
+ * Always-on scanning keeps WiFi promiscuous RX and the BLE scanner running
+ * at full power, the backlight lit and loop() awake. In patrol mode the
+ * firmware alternates short scan bursts with light-sleep intervals, radios
+ * off. PatrolPolicy decides when a burst ends and how long to sleep:
+ *
+ * - A burst lasts burst_ms. Any detection keeps the radios on for hold_ms,
+ *   so a camera in range is tracked as if patrol mode were off.
+ * - Sleep length falls from sleep_max_ms toward sleep_min_ms as detection
+ *   density rises (new devices, decayed with density_tau_ms):
+ *   sleep = min + (max - min) / (1 + density).
+ * - With a known camera site nearby (setSiteDistance(), from the geo index
+ *   query around the latest fix) sleeps are the shortest, and within
+ *   near_m the radios stay on.
+ *
+ * PatrolMeter charges measured time in each power state (radios on, radios
+ * off but awake, light sleep, backlight at its level) against a per-state
+ * current model, giving mAh used and detections per mAh. The boards have no
+ * current sensing; calibrate the model against a USB power meter.
+ *
+ * noteDetection() may be called from the processing task; everything else
+ * runs on loop()'s core. tools/patrol_sim replays recorded detections
+ * through the same policy and meter.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef PATROL_POLICY_H
+#define PATROL_POLICY_H
+
+#include <stdint.h>
+
+#define PATROL_BURST_MS          6000
+#define PATROL_SLEEP_MIN_MS      3000
+#define PATROL_SLEEP_MAX_MS      24000
+#define PATROL_HOLD_MS           30000
+#define PATROL_NEAR_M            300
+#define PATROL_DENSITY_TAU_MS    300000   // 5 min
+#define PATROL_DISPLAY_MS        20000    // Display on after a detection or touch
+#define PATROL_DISTANCE_UNKNOWN  0xFFFFFFFFu
+
+// Supply current estimates, 0.1 mA units (5 V input, whole board)
+#define PATROL_SCAN_MA_X10       1150     // WiFi promiscuous + BLE scan, CPU at 240 MHz
+#define PATROL_IDLE_MA_X10       450      // Radios off, CPU awake (light sleep refused)
+#define PATROL_SLEEP_MA_X10      100      // Light sleep: regulator, USB-UART, touch controller
+#define PATROL_DISPLAY_MA_X10    600      // Backlight at full brightness
+
+struct PatrolConfig {
+    uint32_t burst_ms;
+    uint32_t sleep_min_ms;
+    uint32_t sleep_max_ms;
+    uint32_t hold_ms;
+    uint32_t near_m;
+    uint32_t density_tau_ms;
+};
+
+class PatrolPolicy {
+public:
+    PatrolPolicy();
+
+    PatrolConfig config;
+
+    void begin(uint32_t now_ms);
+
+    // Matched detection (any task); `new_device` for a first sighting
+    void noteDetection(uint32_t now_ms, bool new_device);
+    // Nearest known camera site, PATROL_DISTANCE_UNKNOWN when none is in range
+    void setSiteDistance(uint32_t meters) { site_m = meters; }
+
+    // Light sleep to take now, in ms; 0 keeps the radios on
+    uint32_t sleepDue(uint32_t now_ms);
+    // Back from a sleep of slept_ms: a new burst starts
+    void woke(uint32_t now_ms, uint32_t slept_ms);
+
+    float density() const { return dens; }
+    uint32_t lastDetectionMs() const { return last_detection_ms; }
+    uint32_t detections() const { return new_devices; }
+    uint32_t sleeps() const { return sleep_count; }
+    // Radios-on share of the last burst + sleep
+    uint8_t dutyPct() const;
+
+private:
+    void absorb(uint32_t now_ms);
+
+    uint32_t burst_start_ms;
+    uint32_t density_ms;         // When dens was last decayed
+    float dens;
+    uint32_t site_m;
+
+    volatile uint32_t last_detection_ms;
+    volatile uint32_t new_devices;   // Written by the processing task only
+    uint32_t absorbed;               // new_devices already in dens
+    volatile bool detected;          // Any detection yet (last_detection_ms valid)
+
+    uint32_t last_burst_ms;
+    uint32_t last_sleep_ms;
+    uint32_t sleep_count;
+};
+
+enum PatrolPower : uint8_t {
+    PATROL_POWER_SCAN = 0,   // Radios on
+    PATROL_POWER_IDLE,       // Radios off, CPU awake
+    PATROL_POWER_SLEEP,      // Light sleep
+    PATROL_POWER_STATES,
+};
+
+struct PatrolPowerModel {
+    uint16_t ma_x10[PATROL_POWER_STATES];
+    uint16_t display_ma_x10;   // At brightness 255
+};
+
+class PatrolMeter {
+public:
+    PatrolMeter();
+
+    void add(PatrolPower state, uint32_t ms);
+    // Backlight on for ms at brightness level 0-255
+    void addDisplay(uint32_t ms, uint8_t level);
+
+    float mAh(const PatrolPowerModel& model) const;
+    float perMah(uint32_t detections, const PatrolPowerModel& model) const;
+    // Average current over the metered time
+    float averageMa(const PatrolPowerModel& model) const;
+
+    uint64_t ms(PatrolPower state) const { return state_ms[state]; }
+    uint64_t totalMs() const;
+    uint64_t displayMs() const { return display_ms; }
+
+private:
+    uint64_t state_ms[PATROL_POWER_STATES];
+    uint64_t display_ms;
+    uint64_t display_level_ms;   // ms x level / 255, summed
+};
+
+#endif // PATROL_POLICY_H
@@ -0,0 +1,98 @@
+/**
+ * @file perf_registry.cpp
+ * @brief Performance metric registry and histogram percentiles
+ *
+ * @see perf_registry.h
+ */
+
+#include "perf_registry.h"
+#include <string.h>
+
+uint32_t perf_bucket_limit(uint8_t bucket) {
+    if (bucket == 0) return 1;
+    if (bucket >= PERF_BUCKETS - 1) return UINT32_MAX;
+    return (uint32_t)1 << bucket;
+}
+
+uint32_t PerfHistogram::percentile(uint8_t pct) const {
+    if (count == 0) return 0;
+    // Rank of the sample we want, 1-based, rounded up
+    uint64_t rank = ((uint64_t)count * pct + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (uint8_t b = 0; b < PERF_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            uint32_t edge = b == 0 ? 0 : perf_bucket_limit(b) - 1;
+            return edge < max ? edge : max;
+        }
+    }
+    return max;  // count changed under us; good enough
+}
+
+uint8_t PerfHistogram::usedBuckets() const {
+    for (uint8_t b = PERF_BUCKETS; b > 0; b--) {
+        if (buckets[b - 1]) return b;
+    }
+    return 0;
+}
+
+void PerfHistogram::clear() {
+    memset(buckets, 0, sizeof(buckets));
+    count = 0;
+    max = 0;
+    sum = 0;
+}
+
+// ============================================================================
+// REGISTRY
+// ============================================================================
+
+PerfRegistry::PerfRegistry() : metrics(), count(0) {}
+
+bool PerfRegistry::add(const PerfMetric& m) {
+    if (count >= PERF_MAX_METRICS) return false;
+    metrics[count++] = m;
+    return true;
+}
+
+bool PerfRegistry::addCounter(const char* name, const volatile uint32_t* value) {
+    PerfMetric m;
+    m.name = name;
+    m.unit = nullptr;
+    m.kind = PERF_COUNTER;
+    m.counter = value;
+    return add(m);
+}
+
+bool PerfRegistry::addGauge(const char* name, const char* unit, PerfGauge* gauge) {
+    PerfMetric m;
+    m.name = name;
+    m.unit = unit;
+    m.kind = PERF_GAUGE;
+    m.gauge = gauge;
+    return add(m);
+}
+
+bool PerfRegistry::addHistogram(const char* name, const char* unit, PerfHistogram* hist) {
+    PerfMetric m;
+    m.name = name;
+    m.unit = unit;
+    m.kind = PERF_HISTOGRAM;
+    m.histogram = hist;
+    return add(m);
+}
+
+const PerfMetric* PerfRegistry::find(const char* name) const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (strcmp(metrics[i].name, name) == 0) return &metrics[i];
+    }
+    return nullptr;
+}
+
+void PerfRegistry::reset() {
+    for (uint8_t i = 0; i < count; i++) {
+        if (metrics[i].kind == PERF_HISTOGRAM) metrics[i].histogram->clear();
+        else if (metrics[i].kind == PERF_GAUGE) metrics[i].gauge->max = metrics[i].gauge->value;
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file perf_registry.h
+ * @brief Named counters, gauges and log-bucketed latency histograms
+ *
+ * The [STATS] line says how many frames and events went through, not how
+ * long anything took or where the time went. Hot paths record into
+ * statically allocated metrics; a PerfRegistry maps names and units onto
+ * them so main.cpp can dump everything as one JSON record on request
+ * (serial "PERF") without knowing each metric.
+ *
+ * Histograms have one bucket per power of two: bucket 0 holds 0, bucket i
+ * holds [2^(i-1), 2^i). Recording is a count-leading-zeros and three
+ * increments, cheap enough for the sniffer callback, and percentiles are
+ * reported as the upper edge of the bucket they fall in (within 2x, capped
+ * at the largest value seen).
+ *
+ * Metrics are not locked. Each one must have a single writer (one task, or
+ * callers serialised by a mutex); the dump may read a histogram mid-record
+ * and be off by one sample, which is fine for telemetry. Counters that
+ * already exist as globals are registered by pointer rather than copied.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef PERF_REGISTRY_H
+#define PERF_REGISTRY_H
+
+#include <stdint.h>
+
+#define PERF_BUCKETS      32    // Bucket 31 also takes everything >= 2^31
+#define PERF_MAX_METRICS  24
+
+enum PerfKind : uint8_t {
+    PERF_COUNTER = 0,    // Monotonic; readers diff successive dumps
+    PERF_GAUGE,          // Last value and the largest since reset()
+    PERF_HISTOGRAM,
+};
+
+struct PerfGauge {
+    int32_t value;
+    int32_t max;
+
+    inline void set(int32_t v) {
+        value = v;
+        if (v > max) max = v;
+    }
+};
+
+struct PerfHistogram {
+    uint32_t buckets[PERF_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+
+    inline void record(uint32_t v) {
+        uint8_t b = v ? 32 - __builtin_clz(v) : 0;
+        buckets[b < PERF_BUCKETS ? b : PERF_BUCKETS - 1]++;
+        count++;
+        sum += v;
+        if (v > max) max = v;
+    }
+
+    // Upper edge of the bucket holding the pct-th percentile, at most max
+    uint32_t percentile(uint8_t pct) const;
+    uint32_t mean() const { return count ? (uint32_t)(sum / count) : 0; }
+    // Highest non-empty bucket + 1 (0 when empty), to trim dumps
+    uint8_t usedBuckets() const;
+    void clear();
+};
+
+// Upper edge of bucket i (values in it are < this, bucket 0 holds only 0)
+uint32_t perf_bucket_limit(uint8_t bucket);
+
+struct PerfMetric {
+    const char* name;
+    const char* unit;    // "us", "ns", "bytes", ... (nullptr for plain counts)
+    PerfKind kind;
+    union {
+        const volatile uint32_t* counter;
+        PerfGauge* gauge;
+        PerfHistogram* histogram;
+    };
+};
+
+class PerfRegistry {
+public:
+    PerfRegistry();
+
+    // Register a metric; false when the registry is full. Names and units
+    // must outlive the registry (string literals).
+    bool addCounter(const char* name, const volatile uint32_t* value);
+    bool addGauge(const char* name, const char* unit, PerfGauge* gauge);
+    bool addHistogram(const char* name, const char* unit, PerfHistogram* hist);
+
+    uint8_t size() const { return count; }
+    const PerfMetric& metric(uint8_t i) const { return metrics[i]; }
+    const PerfMetric* find(const char* name) const;
+
+    // Start a new measurement window: clear histograms and gauge maxima.
+    // Counters are left alone (they are often shared with [STATS]).
+    void reset();
+
+private:
+    bool add(const PerfMetric& m);
+
+    PerfMetric metrics[PERF_MAX_METRICS];
+    uint8_t count;
+};
+
+#endif // PERF_REGISTRY_H
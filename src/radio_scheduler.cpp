@@ -0,0 +1,101 @@
+/**
+ * @file radio_scheduler.cpp
+ * @brief WiFi/BLE coexistence time-slot planner implementation
+ *
+ * @see radio_scheduler.h for the slot layout and adaptation rule
+ */
+
+#include "radio_scheduler.h"
+#include <string.h>
+
+RadioScheduler::RadioScheduler() {
+    current = RADIO_SLOT_WIFI;
+    slot_start = 0;
+    units_at_start = 0;
+    active_share_pct = RADIO_WIFI_SHARE_PCT;
+    wifi_score = 0;
+    ble_score = 0;
+    pending_wifi = 0;
+    pending_ble = 0;
+    memset(slot_stats, 0, sizeof(slot_stats));
+}
+
+void RadioScheduler::begin(uint32_t now, uint32_t frames_total, uint32_t adverts_total) {
+    (void)adverts_total;
+    active_share_pct = wifi_share_pct;
+    current = RADIO_SLOT_WIFI;
+    slot_start = now;
+    units_at_start = frames_total;
+}
+
+void RadioScheduler::resume(uint32_t now, uint32_t frames_total) {
+    current = RADIO_SLOT_WIFI;
+    slot_start = now;
+    units_at_start = frames_total;
+}
+
+uint32_t RadioScheduler::slotLength() const {
+    uint32_t wifi_ms = frame_ms * active_share_pct / 100;
+    return current == RADIO_SLOT_WIFI ? wifi_ms : frame_ms - wifi_ms;
+}
+
+void RadioScheduler::noteDetection(RadioSlot source) {
+    if (source == RADIO_SLOT_WIFI) pending_wifi++;
+    else pending_ble++;
+}
+
+void RadioScheduler::closeSlot(uint32_t now, uint32_t frames_total, uint32_t adverts_total) {
+    RadioSlotStats& st = slot_stats[current];
+    uint32_t elapsed = now - slot_start;
+    uint32_t total = current == RADIO_SLOT_WIFI ? frames_total : adverts_total;
+    uint32_t units = total - units_at_start;
+
+    st.slots++;
+    st.ms += elapsed;
+    st.units += units;
+    st.last_yield = elapsed ? (float)units / elapsed : 0.0f;
+}
+
+// Re-plan the WiFi share at each frame boundary from where detections came from
+void RadioScheduler::planFrame() {
+    uint16_t wifi_hits = pending_wifi;
+    uint16_t ble_hits = pending_ble;
+    pending_wifi = 0;
+    pending_ble = 0;
+    slot_stats[RADIO_SLOT_WIFI].detections += wifi_hits;
+    slot_stats[RADIO_SLOT_BLE].detections += ble_hits;
+
+    wifi_score = wifi_score * RADIO_ADAPT_DECAY + wifi_hits;
+    ble_score = ble_score * RADIO_ADAPT_DECAY + ble_hits;
+
+    if (!adaptive) {
+        active_share_pct = wifi_share_pct;
+        return;
+    }
+
+    // Prior mass splits per the configured budget; detections pull away from it
+    float base = wifi_share_pct / 100.0f;
+    float share = (wifi_score + RADIO_ADAPT_PRIOR * base) /
+                  (wifi_score + ble_score + RADIO_ADAPT_PRIOR);
+    int pct = (int)(share * 100.0f + 0.5f);
+    if (pct < wifi_share_min) pct = wifi_share_min;
+    if (pct > wifi_share_max) pct = wifi_share_max;
+    active_share_pct = (uint8_t)pct;
+}
+
+bool RadioScheduler::tick(uint32_t now, uint32_t frames_total, uint32_t adverts_total) {
+    if (now - slot_start < slotLength()) return false;
+
+    closeSlot(now, frames_total, adverts_total);
+
+    if (current == RADIO_SLOT_WIFI) {
+        current = RADIO_SLOT_BLE;
+        units_at_start = adverts_total;
+    } else {
+        planFrame();
+        current = RADIO_SLOT_WIFI;
+        units_at_start = frames_total;
+    }
+    slot_start = now;
+    return true;
+}
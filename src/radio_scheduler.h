@@ -0,0 +1,104 @@
+/**
+ * @file radio_scheduler.h
+ * @brief WiFi/BLE coexistence time-slot planner
+ *
+ * The ESP32 has one RF front end shared by WiFi promiscuous capture and the
+ * BLE scanner. Instead of letting loop() start BLE scans on a timer while
+ * hop_channel() keeps hopping, the scheduler divides time into frames of
+ * RADIO_FRAME_MS, each split into a WiFi slot followed by a BLE slot:
+ *
+ *   |<------------- frame ------------->|
+ *   |   WiFi (hopping, share %)   | BLE |
+ *
+ * During the BLE slot main.cpp turns promiscuous RX off as well as holding
+ * the channel, so the scanner has the front end to itself and no frames are
+ * charged to the held channel's dwell statistics.
+ *
+ * The WiFi share starts at the configured budget (e.g. 70/30) and, when
+ * adaptive, drifts toward whichever radio has been finding new devices,
+ * using decayed per-source detection counts anchored by a prior so a single
+ * hit can't swing the budget. The share is clamped to [min, max] so neither
+ * radio is ever starved.
+ *
+ * Per-slot yield (WiFi frames or BLE adverts per ms of slot) is recorded so
+ * the slotted plan can be compared with the legacy interleave from data.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef RADIO_SCHEDULER_H
+#define RADIO_SCHEDULER_H
+
+#include <stdint.h>
+
+#define RADIO_FRAME_MS          2000   // One WiFi slot + one BLE slot
+#define RADIO_WIFI_SHARE_PCT      70   // Configured WiFi budget
+#define RADIO_WIFI_SHARE_MIN      40   // Adaptive floor
+#define RADIO_WIFI_SHARE_MAX      90   // Adaptive ceiling
+#define RADIO_ADAPT_DECAY       0.9f   // Per-frame decay of detection source counts
+#define RADIO_ADAPT_PRIOR       4.0f   // Pseudo-detections anchoring the configured budget
+
+enum RadioSlot : uint8_t {
+    RADIO_SLOT_WIFI = 0,
+    RADIO_SLOT_BLE  = 1
+};
+
+struct RadioSlotStats {
+    uint32_t slots;        // Completed slots
+    uint32_t ms;           // Total slot time
+    uint32_t units;        // WiFi frames or BLE adverts received in slots
+    uint32_t detections;   // New devices attributed to this radio
+    float    last_yield;   // Units per ms in the most recent slot
+
+    float yield() const { return ms ? (float)units / ms : 0.0f; }
+};
+
+class RadioScheduler {
+public:
+    RadioScheduler();
+
+    uint32_t frame_ms = RADIO_FRAME_MS;
+    uint8_t  wifi_share_pct = RADIO_WIFI_SHARE_PCT;
+    uint8_t  wifi_share_min = RADIO_WIFI_SHARE_MIN;
+    uint8_t  wifi_share_max = RADIO_WIFI_SHARE_MAX;
+    bool     adaptive = true;
+
+    // Start with a WiFi slot. Counters are the monotonic totals passed to tick().
+    void begin(uint32_t now, uint32_t frames_total, uint32_t adverts_total);
+
+    // After the radios were off (patrol sleep): a fresh WiFi slot from now,
+    // keeping the adapted share. The interrupted slot is not recorded.
+    void resume(uint32_t now, uint32_t frames_total);
+
+    // Advance the plan. Returns true when the active slot changed.
+    bool tick(uint32_t now, uint32_t frames_total, uint32_t adverts_total);
+
+    RadioSlot slot() const { return current; }
+    uint32_t slotStart() const { return slot_start; }
+    uint32_t slotLength() const;
+    uint8_t  activeWifiSharePct() const { return active_share_pct; }
+
+    // First sighting of a matched device from either radio; re-sightings are
+    // not counted. Safe to call from the processing task.
+    void noteDetection(RadioSlot source);
+
+    const RadioSlotStats& stats(RadioSlot which) const { return slot_stats[which]; }
+
+private:
+    void closeSlot(uint32_t now, uint32_t frames_total, uint32_t adverts_total);
+    void planFrame();
+
+    RadioSlot current;
+    uint32_t  slot_start;
+    uint32_t  units_at_start;
+    uint8_t   active_share_pct;
+
+    float wifi_score;
+    float ble_score;
+    volatile uint16_t pending_wifi;
+    volatile uint16_t pending_ble;
+
+    RadioSlotStats slot_stats[2];
+};
+
+#endif // RADIO_SCHEDULER_H
@@ -0,0 +1,106 @@
+/**
+ * @file rssi_history.cpp
+ * @brief Multi-resolution RSSI rings and their sequence-counted reads
+ *
+ * @see rssi_history.h
+ */
+
+#include "rssi_history.h"
+#include <string.h>
+
+// Strongest of two buckets, either of which may be empty
+static inline void merge(int8_t& into, int8_t v) {
+    if (v != RSSI_HIST_NONE && (into == RSSI_HIST_NONE || v > into)) into = v;
+}
+
+void RssiHistory::record(int8_t rssi, uint32_t now) {
+    if (rssi >= 0) rssi = -1;   // 0 marks an empty bucket
+
+    uint32_t s = __atomic_load_n(&seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (!head) {
+        start_ms = now;
+        head = 1;
+    } else {
+        advance(now);
+    }
+    merge(fine[newest() % RSSI_HIST_FINE], rssi);
+
+    __atomic_store_n(&seq, s + 2, __ATOMIC_RELEASE);
+}
+
+void RssiHistory::advance(uint32_t now) {
+    if (!head) return;
+    uint32_t target = (now - start_ms) / RSSI_HIST_TICK_MS;
+    if (target <= newest()) return;   // Same second, or the clock went backwards
+
+    if (target - newest() >= RSSI_HIST_SPAN) {
+        memset(fine, 0, sizeof(fine));
+        memset(mid, 0, sizeof(mid));
+        memset(coarse, 0, sizeof(coarse));
+        head = target + 1;
+        return;
+    }
+    while (newest() < target) step();
+}
+
+// One new fine bucket. The one it displaces goes into the newest mid
+// bucket, which starts afresh (displacing a mid bucket into the coarse
+// ring) every RSSI_HIST_FOLD fine buckets.
+void RssiHistory::step() {
+    uint32_t n = head;   // New fine bucket number
+    if (n >= RSSI_HIST_FINE) {
+        uint32_t out = n - RSSI_HIST_FINE;
+        uint32_t m = out / RSSI_HIST_FOLD;
+        if (out % RSSI_HIST_FOLD == 0) {
+            if (m >= RSSI_HIST_MID) {
+                uint32_t mout = m - RSSI_HIST_MID;
+                uint32_t c = mout / RSSI_HIST_FOLD;
+                if (mout % RSSI_HIST_FOLD == 0) coarse[c % RSSI_HIST_COARSE] = RSSI_HIST_NONE;
+                merge(coarse[c % RSSI_HIST_COARSE], mid[mout % RSSI_HIST_MID]);
+            }
+            mid[m % RSSI_HIST_MID] = RSSI_HIST_NONE;
+        }
+        merge(mid[m % RSSI_HIST_MID], fine[out % RSSI_HIST_FINE]);
+    }
+    fine[n % RSSI_HIST_FINE] = RSSI_HIST_NONE;
+    head = n + 1;
+}
+
+bool RssiHistory::copyTo(RssiHistory& out) const {
+    for (int i = 0; i < RSSI_HIST_COPY_TRIES; i++) {
+        uint32_t s = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+        if (s & 1) continue;
+        RssiHistory copy;
+        memcpy(&copy, this, sizeof(copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&seq, __ATOMIC_RELAXED) != s) continue;
+        copy.seq = 0;
+        out = copy;
+        return true;
+    }
+    return false;
+}
+
+// Ring of size buckets whose newest bucket number is newest (< 0: none yet)
+static void unroll(int8_t* out, const int8_t* ring, int32_t size, int32_t newest) {
+    for (int32_t i = 0; i < size; i++) {
+        int32_t n = newest - size + 1 + i;
+        out[i] = n >= 0 ? ring[n % size] : RSSI_HIST_NONE;
+    }
+}
+
+void RssiHistory::series(int8_t out[RSSI_HIST_SAMPLES]) const {
+    if (!head) {
+        memset(out, RSSI_HIST_NONE, RSSI_HIST_SAMPLES);
+        return;
+    }
+    int32_t fn = (int32_t)newest();
+    int32_t mn = fn >= RSSI_HIST_FINE ? (fn - RSSI_HIST_FINE) / RSSI_HIST_FOLD : -1;
+    int32_t cn = mn >= RSSI_HIST_MID ? (mn - RSSI_HIST_MID) / RSSI_HIST_FOLD : -1;
+    unroll(out, coarse, RSSI_HIST_COARSE, cn);
+    unroll(out + RSSI_HIST_COARSE, mid, RSSI_HIST_MID, mn);
+    unroll(out + RSSI_HIST_COARSE + RSSI_HIST_MID, fine, RSSI_HIST_FINE, fn);
+}
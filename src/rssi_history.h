@@ -0,0 +1,80 @@
+/**
+ * @file rssi_history.h
+ * @brief Fixed-size, multi-resolution RSSI history per tracked device
+ *
+ * 64 one-byte buckets in three rings, each bucket holding the strongest
+ * sighting of its interval (fades only ever pull RSSI down):
+ *
+ *   fine    32 x 1 s    the last 32 s
+ *   mid     16 x 4 s    the 64 s before that
+ *   coarse  16 x 16 s   the 256 s before that
+ *
+ * A bucket leaving the fine ring is merged into the newest mid bucket, and
+ * a mid bucket leaving its ring into the newest coarse one, so the buckets
+ * never overlap and together cover 5 min 52 s, the last half minute at full
+ * resolution. Recording a sighting is a compare and a store. Each new second
+ * moves the rings on by one slot. After a longer silence than the whole
+ * span the rings are simply cleared, so no sighting costs more than
+ * RSSI_HIST_SPAN slot moves.
+ *
+ * The processing task is the only writer. The display reads with copyTo(),
+ * which retries while a write is in progress (sequence counter), and then
+ * brings its copy up to the current time with advance().
+ *
+ * 76 bytes; zero-initialised is a valid empty history. It lives in
+ * TrackedDevice and is not kept in the warm-restart snapshot.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef RSSI_HISTORY_H
+#define RSSI_HISTORY_H
+
+#include <stdint.h>
+
+#define RSSI_HIST_FINE       32     // 1 s buckets
+#define RSSI_HIST_MID        16     // 4 s buckets
+#define RSSI_HIST_COARSE     16     // 16 s buckets
+#define RSSI_HIST_FOLD        4     // Buckets of one ring per bucket of the next
+#define RSSI_HIST_TICK_MS  1000     // Fine bucket width
+#define RSSI_HIST_SAMPLES  (RSSI_HIST_COARSE + RSSI_HIST_MID + RSSI_HIST_FINE)
+#define RSSI_HIST_SPAN     (RSSI_HIST_FINE + RSSI_HIST_MID * RSSI_HIST_FOLD + \
+                            RSSI_HIST_COARSE * RSSI_HIST_FOLD * RSSI_HIST_FOLD)   // In fine buckets
+#define RSSI_HIST_NONE        0     // Bucket without a sighting
+#define RSSI_HIST_COPY_TRIES  4     // copyTo() attempts before giving up on a busy writer
+
+struct RssiHistory {
+    int8_t   fine[RSSI_HIST_FINE];       // Rings, indexed by bucket number modulo size
+    int8_t   mid[RSSI_HIST_MID];
+    int8_t   coarse[RSSI_HIST_COARSE];
+    uint32_t start_ms;                   // First sighting: start of fine bucket 0
+    uint32_t head;                       // Newest fine bucket number + 1 (0: empty)
+    uint32_t seq;                        // Odd while the writer is inside record()
+
+    // Feed one sighting (writer only)
+    void record(int8_t rssi, uint32_t now);
+
+    // Move the rings on to now without a sighting. Only on a private copy:
+    // the shared history only moves in record().
+    void advance(uint32_t now);
+
+    // Consistent copy of a history another task is writing; false (out
+    // unchanged) if the writer stayed busy for RSSI_HIST_COPY_TRIES reads
+    bool copyTo(RssiHistory& out) const;
+
+    // All buckets oldest to newest: coarse, then mid, then fine; buckets
+    // before the first sighting are RSSI_HIST_NONE
+    void series(int8_t out[RSSI_HIST_SAMPLES]) const;
+
+    bool empty() const { return head == 0; }
+    uint32_t newest() const { return head - 1; }   // Bucket number of the newest fine bucket
+    // Fine bucket n while it is still in the ring, else RSSI_HIST_NONE
+    int8_t fineBucket(uint32_t n) const {
+        return head && n < head && head - n <= RSSI_HIST_FINE ? fine[n % RSSI_HIST_FINE] : RSSI_HIST_NONE;
+    }
+
+private:
+    void step();
+};
+
+#endif // RSSI_HISTORY_H
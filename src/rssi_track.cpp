@@ -0,0 +1,117 @@
+/**
+ * @file rssi_track.cpp
+ * @brief Fixed-point alpha-beta RSSI filter and pass state machine
+ *
+ * @see rssi_track.h
+ */
+
+#include "rssi_track.h"
+
+const char* rssi_event_name(RssiEvent event) {
+    switch (event) {
+    case RSSI_EVENT_APPROACH: return "approach";
+    case RSSI_EVENT_CLOSEST:  return "closest";
+    case RSSI_EVENT_DEPART:   return "depart";
+    default:                  return "none";
+    }
+}
+
+const char* rssi_phase_name(RssiPhase phase) {
+    switch (phase) {
+    case RSSI_PHASE_APPROACHING: return "approaching";
+    case RSSI_PHASE_PASSED:      return "passed";
+    case RSSI_PHASE_DEPARTED:    return "departing";
+    default:                     return "steady";
+    }
+}
+
+static int16_t clamp16(int32_t v) {
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+void RssiTrack::reset(int8_t rssi, uint32_t now) {
+    level_q8 = rssi * 256;
+    rate_q8 = 0;
+    peak_q8 = level_q8;
+    trough_q8 = level_q8;
+    hits = 1;
+    phase = RSSI_PHASE_IDLE;
+    last_ms = now;
+    peak_ms = now;
+}
+
+RssiEvent RssiTrack::update(int8_t rssi, uint32_t now) {
+    uint32_t dt = now - last_ms;
+    if (hits == 0 || dt > RSSI_RESET_MS) {
+        reset(rssi, now);
+        return RSSI_EVENT_NONE;
+    }
+    last_ms = now;
+    if (hits < 255) hits++;
+
+    // Predict (a trend is not extrapolated across a long silence), then
+    // correct with time-scaled gains. The rate gain product needs 64 bits:
+    // after a gap the residual alone can be tens of dB.
+    uint32_t horizon = dt < RSSI_PREDICT_MAX_MS ? dt : RSSI_PREDICT_MAX_MS;
+    int32_t level = level_q8 + (int32_t)rate_q8 * (int32_t)horizon / 1000;
+    int32_t r = rssi * 256 - level;
+    int32_t alpha = (int32_t)(dt * 256 / (dt + RSSI_TAU_LEVEL_MS));
+    if (alpha < RSSI_MIN_ALPHA_Q8) alpha = RSSI_MIN_ALPHA_Q8;
+    level += r * alpha / 256;
+    int64_t rate = rate_q8 + (int64_t)r * RSSI_BETA_Q8 * 1000 / 256 / (int64_t)(dt + RSSI_TAU_RATE_MS);
+    level_q8 = clamp16(level);
+    rate_q8 = clamp16(rate > INT32_MAX ? INT32_MAX : (rate < INT32_MIN ? INT32_MIN : (int32_t)rate));
+
+    if (phase != RSSI_PHASE_PASSED && level_q8 > peak_q8) {
+        peak_q8 = level_q8;
+        peak_ms = now;
+    }
+    if ((phase == RSSI_PHASE_IDLE || phase == RSSI_PHASE_DEPARTED) && level_q8 < trough_q8) {
+        trough_q8 = level_q8;
+    }
+    if (hits < RSSI_MIN_HITS) return RSSI_EVENT_NONE;
+
+    bool rising = rate_q8 >= RSSI_APPROACH_Q8;
+    bool falling = rate_q8 <= -RSSI_APPROACH_Q8;
+    switch (phase) {
+    case RSSI_PHASE_IDLE:
+    case RSSI_PHASE_DEPARTED:
+        if (rising && level_q8 >= trough_q8 + RSSI_RISE_Q8) {
+            phase = RSSI_PHASE_APPROACHING;
+            peak_q8 = level_q8;
+            peak_ms = now;
+            return RSSI_EVENT_APPROACH;
+        }
+        // First heard already close, at the peak
+        if (phase == RSSI_PHASE_IDLE && falling && level_q8 <= peak_q8 - RSSI_FIRST_DROP_Q8) {
+            phase = RSSI_PHASE_PASSED;
+            return RSSI_EVENT_CLOSEST;
+        }
+        break;
+
+    case RSSI_PHASE_APPROACHING:
+        if (level_q8 <= peak_q8 - RSSI_PEAK_DROP_Q8) {
+            phase = RSSI_PHASE_PASSED;
+            return RSSI_EVENT_CLOSEST;
+        }
+        break;
+
+    case RSSI_PHASE_PASSED:
+        if (level_q8 <= peak_q8 - RSSI_DEPART_DROP_Q8) {
+            phase = RSSI_PHASE_DEPARTED;
+            trough_q8 = level_q8;
+            return RSSI_EVENT_DEPART;
+        }
+        break;
+    }
+    return RSSI_EVENT_NONE;
+}
+
+RssiEvent RssiTrack::expire(uint32_t now) {
+    if ((phase != RSSI_PHASE_APPROACHING && phase != RSSI_PHASE_PASSED) || now - last_ms < RSSI_LOST_MS) {
+        return RSSI_EVENT_NONE;
+    }
+    phase = RSSI_PHASE_DEPARTED;
+    trough_q8 = level_q8;
+    return RSSI_EVENT_DEPART;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file rssi_track.h
+ * @brief Per-device RSSI level/trend filter with approach, closest-point and depart events
+ *
+ * A constant-velocity alpha-beta filter (the steady-state form of a 1-D
+ * Kalman filter) over the sightings of one device, in fixed point:
+ *
+ *   predict   level += rate * min(dt, RSSI_PREDICT_MAX_MS)
+ *   correct   r = rssi - level
+ *             level += a * r,   a = dt / (dt + RSSI_TAU_LEVEL_MS)
+ *             rate  += b * r / (dt + RSSI_TAU_RATE_MS)
+ *
+ * Sightings arrive in bursts (beacons while the hopper sits on the right
+ * channel, then nothing for a second or two), so the gains are scaled by
+ * the time since the previous sighting instead of being fixed per sample:
+ * a burst of ten frames moves the estimate about as much as one frame after
+ * a gap of the same length.
+ *
+ * The level and its rate drive a small per-pass state machine:
+ *
+ *   IDLE, DEPARTED --(rising, RISE over trough)--> APPROACHING
+ *   APPROACHING --(PEAK_DROP under peak)--> PASSED
+ *   IDLE --(falling, FIRST_DROP under peak)--> PASSED
+ *   PASSED --(DEPART_DROP under peak)--> DEPARTED
+ *   APPROACHING, PASSED --(silent LOST_MS)--> DEPARTED
+ *
+ * The thresholds are in dB of filtered level rather than rate alone: a
+ * parked device's level wanders by a couple of dB and its rate estimate by
+ * about 1 dB/s, while a drive-by swings 20-30 dB. Tuned with
+ * tools/bench/rssi_track_bench.cpp.
+ *
+ * Each transition is reported once, so the caller emits three events per
+ * drive-by instead of a line per frame. Level Q8 dBm, rate Q8 dB/s; the
+ * whole state is 20 bytes and lives in TrackedDevice.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef RSSI_TRACK_H
+#define RSSI_TRACK_H
+
+#include <stdint.h>
+
+#define RSSI_TAU_LEVEL_MS     3000   // Level smoothing time constant
+#define RSSI_TAU_RATE_MS      6000   // Rate smoothing time constant
+#define RSSI_BETA_Q8            96   // Rate gain (0.375)
+#define RSSI_MIN_ALPHA_Q8       16   // Floor on the level gain (1/16) for tight bursts
+#define RSSI_PREDICT_MAX_MS   3000   // Extrapolate the trend at most this far over a gap
+#define RSSI_RESET_MS        20000   // Silent this long: start a new track
+#define RSSI_MIN_HITS            4   // Sightings before any event
+#define RSSI_APPROACH_Q8       256   // Rising at 1.0 dB/s: approaching
+#define RSSI_RISE_Q8         (10 * 256)   // ...and this far above the trough
+#define RSSI_PEAK_DROP_Q8     (4 * 256)   // This far under the peak: closest point passed
+#define RSSI_FIRST_DROP_Q8    (8 * 256)   // Same, for a device first heard near its peak
+#define RSSI_DEPART_DROP_Q8  (10 * 256)   // This far under the peak: departed
+#define RSSI_LOST_MS         15000   // Silent this long mid-pass: departed
+
+enum RssiEvent : uint8_t {
+    RSSI_EVENT_NONE = 0,
+    RSSI_EVENT_APPROACH,     // Signal rising steadily
+    RSSI_EVENT_CLOSEST,      // Peak passed; peakDbm()/peak_ms mark the closest point
+    RSSI_EVENT_DEPART,       // Well past the peak, or gone quiet after it
+};
+
+enum RssiPhase : uint8_t {
+    RSSI_PHASE_IDLE = 0,
+    RSSI_PHASE_APPROACHING,
+    RSSI_PHASE_PASSED,
+    RSSI_PHASE_DEPARTED,
+};
+
+const char* rssi_event_name(RssiEvent event);
+const char* rssi_phase_name(RssiPhase phase);
+
+// Zero-initialised is a valid empty track
+struct RssiTrack {
+    int16_t  level_q8;   // Filtered RSSI, 1/256 dBm
+    int16_t  rate_q8;    // Trend, 1/256 dB per second
+    int16_t  peak_q8;    // Highest level this pass
+    int16_t  trough_q8;  // Lowest level before the approach / since departing
+    uint8_t  hits;       // Sightings in this track, saturating
+    uint8_t  phase;      // RssiPhase
+    uint32_t last_ms;    // Time of the last sighting
+    uint32_t peak_ms;    // Time the peak was reached
+
+    void reset(int8_t rssi, uint32_t now);
+
+    // Feed one sighting; returns the transition it caused, if any
+    RssiEvent update(int8_t rssi, uint32_t now);
+
+    // Call periodically: DEPART once an approaching or passed device goes quiet
+    RssiEvent expire(uint32_t now);
+
+    int8_t levelDbm() const { return (int8_t)((level_q8 + (level_q8 < 0 ? -128 : 128)) / 256); }
+    int8_t peakDbm() const { return (int8_t)((peak_q8 + (peak_q8 < 0 ? -128 : 128)) / 256); }
+    int16_t rateDeciDbPerS() const { return (int16_t)(rate_q8 * 10 / 256); }
+};
+
+#endif // RSSI_TRACK_H
@@ -0,0 +1,275 @@
+/**
+ * @file rule_vm.cpp
+ * @brief Verifier and evaluator for compiled confidence rules
+ *
+ * @see rule_vm.h
+ */
+
+#include "rule_vm.h"
+#include <string.h>
+#include <strings.h>
+
+static inline uint16_t rd16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static inline uint32_t rd32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+const char* rule_status_str(RuleStatus status) {
+    switch (status) {
+    case RULE_OK:          return "ok";
+    case RULE_ERR_SIZE:    return "bad size";
+    case RULE_ERR_FORMAT:  return "unsupported format";
+    case RULE_ERR_OPCODE:  return "bad instruction";
+    case RULE_ERR_OPERAND: return "bad operand";
+    case RULE_ERR_STACK:   return "bad stack use";
+    default:               return "unknown";
+    }
+}
+
+// Instruction length including the opcode, 0 if unknown
+static uint8_t op_size(uint8_t op) {
+    switch (op) {
+    case RULE_OP_END:
+    case RULE_OP_AND:
+    case RULE_OP_OR:
+    case RULE_OP_NOT:      return 1;
+    case RULE_OP_FACT:     return 2;
+    case RULE_OP_SSID_HAS:
+    case RULE_OP_NAME_HAS: return 3;
+    case RULE_OP_OUI:
+    case RULE_OP_SCORE:
+    case RULE_OP_BONUS:    return 4;
+    case RULE_OP_CMP:      return 7;
+    default:               return 0;
+    }
+}
+
+RuleProgram::RuleProgram() {
+    clear();
+}
+
+void RuleProgram::clear() {
+    strings = nullptr;
+    string_len = 0;
+    code = nullptr;
+    code_len = 0;
+    rule_count = 0;
+}
+
+RuleStatus RuleProgram::load(const uint8_t* image, size_t len) {
+    clear();
+    if (len < RULE_HEADER_SIZE) return RULE_ERR_SIZE;
+    if (image[0] != RULE_FORMAT) return RULE_ERR_FORMAT;
+    uint16_t slen = rd16(image + 2);
+    uint16_t clen = rd16(image + 4);
+    if (slen > RULE_MAX_STRINGS || clen > RULE_MAX_CODE || image[1] > RULE_MAX_RULES ||
+        len != (size_t)RULE_HEADER_SIZE + slen + clen) {
+        return RULE_ERR_SIZE;
+    }
+
+    strings = (const char*)image + RULE_HEADER_SIZE;
+    string_len = slen;
+    code = image + RULE_HEADER_SIZE + slen;
+    code_len = clen;
+    rule_count = image[1];
+
+    RuleStatus status = verify();
+    if (status != RULE_OK) clear();
+    return status;
+}
+
+// Walk the code once as eval() would, tracking only the stack depth
+RuleStatus RuleProgram::verify() const {
+    if (string_len && strings[string_len - 1] != '\0') return RULE_ERR_OPERAND;
+    uint8_t depth = 0;
+    uint8_t rules = 0;
+    uint16_t pc = 0;
+    while (pc < code_len) {
+        uint8_t op = code[pc];
+        uint8_t size = op_size(op);
+        if (!size) return RULE_ERR_OPCODE;
+        if (pc + size > code_len) return RULE_ERR_SIZE;
+        const uint8_t* arg = code + pc + 1;
+
+        switch (op) {
+        case RULE_OP_END:
+            if (pc + 1 != code_len) return RULE_ERR_OPCODE;
+            if (depth) return RULE_ERR_STACK;
+            return rules == rule_count ? RULE_OK : RULE_ERR_OPERAND;
+
+        case RULE_OP_FACT:
+            if (arg[0] >= RULE_FACT_COUNT) return RULE_ERR_OPERAND;
+            depth++;
+            break;
+        case RULE_OP_CMP:
+            if (arg[0] >= RULE_FIELD_COUNT || arg[1] >= RULE_CMP_COUNT) return RULE_ERR_OPERAND;
+            depth++;
+            break;
+        case RULE_OP_SSID_HAS:
+        case RULE_OP_NAME_HAS:
+            if (rd16(arg) >= string_len) return RULE_ERR_OPERAND;
+            depth++;
+            break;
+        case RULE_OP_OUI:
+            depth++;
+            break;
+
+        case RULE_OP_AND:
+        case RULE_OP_OR:
+            if (depth < 2) return RULE_ERR_STACK;
+            depth--;
+            break;
+        case RULE_OP_NOT:
+            if (depth < 1) return RULE_ERR_STACK;
+            break;
+
+        case RULE_OP_SCORE:
+        case RULE_OP_BONUS:
+            // Each rule consumes exactly its own expression
+            if (depth != 1) return RULE_ERR_STACK;
+            if (op == RULE_OP_SCORE && arg[0] > 100) return RULE_ERR_OPERAND;
+            if (rd16(arg + 1) >= string_len) return RULE_ERR_OPERAND;
+            depth = 0;
+            rules++;
+            break;
+        }
+        if (depth > RULE_MAX_DEPTH) return RULE_ERR_STACK;
+        pc += size;
+    }
+    return RULE_ERR_OPCODE;  // No END
+}
+
+static int32_t field_value(const RuleFacts& f, uint8_t field) {
+    switch (field) {
+    case RULE_FIELD_RSSI:     return f.rssi;
+    case RULE_FIELD_HITS:     return f.hits;
+    case RULE_FIELD_PROBE_MS: return (int32_t)f.probe_ms;
+    case RULE_FIELD_CHANNEL:  return f.channel;
+    case RULE_FIELD_MFG:      return f.mfg;
+    default:                  return (int32_t)f.ie_fp;
+    }
+}
+
+static bool compare(int32_t v, uint8_t cmp, int32_t imm) {
+    switch (cmp) {
+    case RULE_CMP_LT: return v < imm;
+    case RULE_CMP_LE: return v <= imm;
+    case RULE_CMP_GT: return v > imm;
+    case RULE_CMP_GE: return v >= imm;
+    case RULE_CMP_EQ: return v == imm;
+    default:          return v != imm;
+    }
+}
+
+RuleResult RuleProgram::eval(const RuleFacts& f) const {
+    RuleResult result = { 0, RULE_NONE, 0, "NONE" };
+    if (!code) return result;
+
+    int16_t bonus = 0;
+    uint8_t rule = 0;
+    uint32_t stack = 0;     // Top of stack in bit 0
+    const uint8_t* pc = code;
+    for (;;) {
+        const uint8_t* arg = pc + 1;
+        bool top;
+        switch (*pc) {
+        case RULE_OP_FACT:
+            stack = (stack << 1) | ((f.flags >> arg[0]) & 1);
+            pc += 2;
+            break;
+        case RULE_OP_CMP:
+            top = compare(field_value(f, arg[0]), arg[1], (int32_t)rd32(arg + 2));
+            stack = (stack << 1) | top;
+            pc += 7;
+            break;
+        case RULE_OP_SSID_HAS:
+            top = f.ssid && strcasestr(f.ssid, strings + rd16(arg));
+            stack = (stack << 1) | top;
+            pc += 3;
+            break;
+        case RULE_OP_NAME_HAS:
+            top = f.name && strcasestr(f.name, strings + rd16(arg));
+            stack = (stack << 1) | top;
+            pc += 3;
+            break;
+        case RULE_OP_OUI:
+            top = f.mac && f.mac[0] == arg[0] && f.mac[1] == arg[1] && f.mac[2] == arg[2];
+            stack = (stack << 1) | top;
+            pc += 4;
+            break;
+
+        case RULE_OP_AND:
+            stack = (stack >> 1) & (stack | ~1u);
+            pc += 1;
+            break;
+        case RULE_OP_OR:
+            stack = (stack >> 1) | (stack & 1);
+            pc += 1;
+            break;
+        case RULE_OP_NOT:
+            stack ^= 1;
+            pc += 1;
+            break;
+
+        case RULE_OP_SCORE:
+            if ((stack & 1) && result.rule == RULE_NONE) {
+                result.rule = rule;
+                result.score = arg[0];
+                result.criteria = strings + rd16(arg + 1);
+            }
+            stack >>= 1;
+            rule++;
+            pc += 4;
+            break;
+        case RULE_OP_BONUS:
+            if (stack & 1) {
+                bonus += (int8_t)arg[0];
+                result.bonuses++;
+            }
+            stack >>= 1;
+            rule++;
+            pc += 4;
+            break;
+
+        default:  // RULE_OP_END (verified)
+            bonus += result.score;
+            result.score = bonus < 0 ? 0 : (bonus > 100 ? 100 : (uint8_t)bonus);
+            return result;
+        }
+    }
+}
+
+uint32_t ie_fingerprint(const uint8_t* ies, size_t len) {
+    uint32_t h = 0x811c9dc5;
+    size_t pos = 0;
+    for (uint8_t n = 0; n < 64 && pos + 2 <= len; n++) {
+        uint8_t id = ies[pos];
+        uint8_t ie_len = ies[pos + 1];
+        if (pos + 2 + ie_len > len) break;  // Truncated (or the FCS)
+        const uint8_t* body = ies + pos + 2;
+
+        // Capabilities and vendor OUI/type describe the firmware; SSID,
+        // channel, TIM and HT/VHT operation describe the network or moment
+        uint8_t take;
+        switch (id) {
+        case 1:    // Supported rates
+        case 45:   // HT capabilities
+        case 48:   // RSN
+        case 50:   // Extended rates
+        case 127:  // Extended capabilities
+        case 191:  // VHT capabilities
+            take = ie_len;
+            break;
+        case 221:  // Vendor specific: OUI + type
+            take = ie_len < 4 ? ie_len : 4;
+            break;
+        default:
+            take = 0;
+            break;
+        }
+        h = (h ^ id) * 0x01000193;
+        for (uint8_t i = 0; i < take; i++) h = (h ^ body[i]) * 0x01000193;
+        pos += 2 + ie_len;
+    }
+    return h ? h : 1;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file rule_vm.h
+ * @brief Bytecode evaluator for detection confidence rules
+ *
+ * threat_score and detection_criteria come from a rule set instead of
+ * being hardcoded in the JSON emitters. Rules are written in a small
+ * language (signatures/rules.txt), compiled on the host by tools/rulec.py
+ * and shipped as a section of the signature pack; a built-in copy of the
+ * default set (rules_default.h) covers boards without a pack.
+ *
+ *   score 100 SSID_AND_MAC: wifi and ssid_match and (oui or watchlist)
+ *   bonus  10 STEADY:       hits >= 5 and probe_ms <= 3000
+ *
+ * The first matching score rule sets the score and names the criteria;
+ * every matching bonus rule adds its (signed) delta; the total is clamped
+ * to 0-100.
+ *
+ * Each rule is a postfix expression over the facts of one sighting
+ * (RuleFacts) followed by its SCORE/BONUS instruction. Booleans live in a
+ * 32-bit stack, one bit per entry. There are no jumps, so a program runs
+ * straight through once: evaluation time is bounded by its length
+ * (RULE_MAX_CODE). load() verifies opcodes, operands, string references
+ * and stack depth up front, so eval() does no checking at all.
+ *
+ * Image layout (little-endian):
+ *
+ *   header   8 B  format, rule count, string table length, code length, reserved
+ *   strings       NUL-terminated rule names and string literals, referenced
+ *                 by offset
+ *   code          instructions, ending with RULE_OP_END
+ *
+ * Instructions (operands follow the opcode byte):
+ *
+ *   FACT      fact                push a RuleFacts flag
+ *   CMP       field cmp imm32     push field <cmp> imm
+ *   SSID_HAS  str16               push ssid contains the string (case-insensitive)
+ *   NAME_HAS  str16               push name contains the string (case-insensitive)
+ *   OUI       b0 b1 b2            push MAC starts with the OUI
+ *   AND, OR, NOT
+ *   SCORE     score name16        pop; the first true one sets score and criteria
+ *   BONUS     delta name16        pop; adds the signed delta when true
+ *   END
+ *
+ * The image is not copied and must outlive the program. Also home to the
+ * WiFi IE fingerprint the sniffer computes for the ie_fp field.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef RULE_VM_H
+#define RULE_VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RULE_FORMAT         1
+#define RULE_HEADER_SIZE    8
+#define RULE_MAX_CODE    2048    // Bytes of code: bounds eval() time
+#define RULE_MAX_STRINGS 1024    // Bytes of string table
+#define RULE_MAX_RULES     64
+#define RULE_MAX_DEPTH     32    // Bits in the evaluation stack
+#define RULE_NONE        0xFF    // RuleResult::rule when no score rule matched
+
+enum RuleOp : uint8_t {
+    RULE_OP_END = 0,
+    RULE_OP_FACT,
+    RULE_OP_CMP,
+    RULE_OP_SSID_HAS,
+    RULE_OP_NAME_HAS,
+    RULE_OP_OUI,
+    RULE_OP_AND,
+    RULE_OP_OR,
+    RULE_OP_NOT,
+    RULE_OP_SCORE,
+    RULE_OP_BONUS,
+};
+
+// Bits of RuleFacts::flags
+enum RuleFact : uint8_t {
+    RULE_FACT_WIFI = 0,
+    RULE_FACT_BLE,
+    RULE_FACT_SSID_MATCH,    // SSID matches a signature pattern
+    RULE_FACT_NAME_MATCH,    // BLE name matches a signature pattern
+    RULE_FACT_OUI,           // MAC prefix is a known OUI
+    RULE_FACT_WATCHLIST,     // Full MAC is on the watchlist
+    RULE_FACT_PAYLOAD,       // BLE payload matched a signature rule
+    RULE_FACT_COUNT
+};
+
+enum RuleField : uint8_t {
+    RULE_FIELD_RSSI = 0,
+    RULE_FIELD_HITS,
+    RULE_FIELD_PROBE_MS,
+    RULE_FIELD_CHANNEL,
+    RULE_FIELD_MFG,
+    RULE_FIELD_IE_FP,
+    RULE_FIELD_COUNT
+};
+
+enum RuleCmp : uint8_t {
+    RULE_CMP_LT = 0,
+    RULE_CMP_LE,
+    RULE_CMP_GT,
+    RULE_CMP_GE,
+    RULE_CMP_EQ,
+    RULE_CMP_NE,
+    RULE_CMP_COUNT
+};
+
+enum RuleStatus : uint8_t {
+    RULE_OK = 0,
+    RULE_ERR_SIZE,          // Truncated, or over the RULE_MAX_* limits
+    RULE_ERR_FORMAT,        // Unsupported format version
+    RULE_ERR_OPCODE,        // Unknown instruction or missing END
+    RULE_ERR_OPERAND,       // Fact/field/comparison/string out of range
+    RULE_ERR_STACK,         // Stack underflow/overflow, or a rule not on one value
+};
+
+const char* rule_status_str(RuleStatus status);
+
+// What is known about one sighting
+struct RuleFacts {
+    uint16_t flags;          // 1 << RuleFact
+    int8_t   rssi;
+    uint8_t  channel;        // 0 for BLE
+    uint16_t hits;           // Sightings of this device so far
+    uint32_t probe_ms;       // Mean interval between sightings, 0 = not measured
+    int32_t  mfg;            // BLE company ID, -1 = none
+    uint32_t ie_fp;          // WiFi IE fingerprint, 0 = none
+    const uint8_t* mac;
+    const char* ssid;        // WiFi SSID, or nullptr
+    const char* name;        // BLE local name, or nullptr
+};
+
+struct RuleResult {
+    uint8_t score;           // 0-100
+    uint8_t rule;            // Index of the matching score rule, RULE_NONE if none
+    uint8_t bonuses;         // Bonus rules that matched
+    const char* criteria;    // Name of the score rule, "NONE" if none
+};
+
+class RuleProgram {
+public:
+    RuleProgram();
+
+    // Verify and attach a compiled rule image. On failure the program is left empty.
+    RuleStatus load(const uint8_t* image, size_t len);
+    void clear();
+
+    bool loaded() const { return code != nullptr; }
+    uint8_t ruleCount() const { return rule_count; }
+    uint16_t codeSize() const { return code_len; }
+
+    RuleResult eval(const RuleFacts& facts) const;
+
+private:
+    RuleStatus verify() const;
+
+    const char* strings;
+    uint16_t string_len;
+    const uint8_t* code;
+    uint16_t code_len;
+    uint8_t rule_count;
+};
+
+// FNV-1a over the order and shape of a management frame's information
+// elements (`ies`: the tagged parameters after the fixed fields). SSID,
+// channel and TIM contents are left out, so units running the same firmware
+// share a fingerprint whatever their name or channel. Never returns 0.
+uint32_t ie_fingerprint(const uint8_t* ies, size_t len);
+
+#endif // RULE_VM_H
@@ -0,0 +1,31 @@
+/**
+ * @file rules_default.h
+ * @brief Built-in confidence rules (signatures/rules.txt, 9 rules)
+ *
+ * Generated by tools/rulec.py; do not edit. Used until a signature pack
+ * with a rules section is loaded. Regenerate with:
+ *   python3 tools/rulec.py signatures/rules.txt --header src/rules_default.h
+ */
+
+#ifndef RULES_DEFAULT_H
+#define RULES_DEFAULT_H
+
+#include <stdint.h>
+
+static const uint8_t rules_default_image[195] = {
+    0x01, 0x09, 0x4b, 0x00, 0x70, 0x00, 0x00, 0x00, 0x53, 0x53, 0x49, 0x44, 0x5f, 0x41, 0x4e, 0x44,
+    0x5f, 0x4d, 0x41, 0x43, 0x00, 0x53, 0x53, 0x49, 0x44, 0x5f, 0x4f, 0x4e, 0x4c, 0x59, 0x00, 0x4d,
+    0x41, 0x43, 0x5f, 0x4f, 0x4e, 0x4c, 0x59, 0x00, 0x4e, 0x41, 0x4d, 0x45, 0x5f, 0x41, 0x4e, 0x44,
+    0x5f, 0x4d, 0x41, 0x43, 0x00, 0x4e, 0x41, 0x4d, 0x45, 0x5f, 0x4f, 0x4e, 0x4c, 0x59, 0x00, 0x50,
+    0x41, 0x59, 0x4c, 0x4f, 0x41, 0x44, 0x5f, 0x4f, 0x4e, 0x4c, 0x59, 0x00, 0x53, 0x54, 0x45, 0x41,
+    0x44, 0x59, 0x00, 0x01, 0x00, 0x01, 0x02, 0x06, 0x01, 0x04, 0x01, 0x05, 0x07, 0x06, 0x09, 0x64,
+    0x00, 0x00, 0x01, 0x00, 0x01, 0x02, 0x06, 0x09, 0x55, 0x0d, 0x00, 0x01, 0x00, 0x01, 0x04, 0x01,
+    0x05, 0x07, 0x06, 0x09, 0x55, 0x17, 0x00, 0x01, 0x00, 0x09, 0x46, 0x17, 0x00, 0x01, 0x01, 0x01,
+    0x03, 0x06, 0x01, 0x04, 0x01, 0x05, 0x07, 0x06, 0x09, 0x64, 0x20, 0x00, 0x01, 0x01, 0x01, 0x03,
+    0x06, 0x09, 0x55, 0x2d, 0x00, 0x01, 0x01, 0x01, 0x04, 0x01, 0x05, 0x07, 0x06, 0x09, 0x55, 0x17,
+    0x00, 0x01, 0x01, 0x09, 0x46, 0x37, 0x00, 0x02, 0x01, 0x03, 0x05, 0x00, 0x00, 0x00, 0x02, 0x02,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x06, 0x02, 0x02, 0x01, 0xb8, 0x0b, 0x00, 0x00, 0x06, 0x0a, 0x0a,
+    0x44, 0x00, 0x00,
+};
+
+#endif // RULES_DEFAULT_H
@@ -0,0 +1,215 @@
+/**
+ * @file sigpack.cpp
+ * @brief Signature pack parser and lookups
+ *
+ * @see sigpack.h for the binary layout
+ */
+
+#include "sigpack.h"
+#include <string.h>
+#include <strings.h>
+#ifdef ESP_PLATFORM
+#include "esp_rom_crc.h"
+#endif
+
+static uint16_t rd16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t rd32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+const char* sigpack_status_str(SigPackStatus status) {
+    switch (status) {
+    case SIGPACK_OK:          return "ok";
+    case SIGPACK_ERR_SIZE:    return "bad size";
+    case SIGPACK_ERR_MAGIC:   return "bad magic";
+    case SIGPACK_ERR_FORMAT:  return "unsupported format";
+    case SIGPACK_ERR_CRC:     return "CRC mismatch";
+    case SIGPACK_ERR_SECTION: return "malformed section";
+    case SIGPACK_ERR_LIMIT:   return "too many entries";
+    }
+    return "unknown";
+}
+
+// CRC-32 (IEEE 802.3, reflected), matches zlib.crc32. On the ESP32 the
+// table-driven ROM routine (same convention) checks the ~670 KB flash
+// index several times faster than the bitwise loop.
+uint32_t sigpack_crc32(const uint8_t* data, size_t len, uint32_t crc) {
+#ifdef ESP_PLATFORM
+    return esp_rom_crc32_le(crc, data, (uint32_t)len);
+#else
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+#endif
+}
+
+// Binary search a sorted array of fixed-width keys
+static bool sorted_contains(const uint8_t* set, uint32_t count, const uint8_t* key, size_t width) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = memcmp(set + (size_t)mid * width, key, width);
+        if (c == 0) return true;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+SignaturePack::SignaturePack() {
+    clear();
+}
+
+void SignaturePack::clear() {
+    is_loaded = false;
+    pack_version = 0;
+    build_time = 0;
+    ouis = nullptr;
+    oui_count = 0;
+    macs = nullptr;
+    mac_count = 0;
+    ssid_count = 0;
+    name_count = 0;
+    ble_count = 0;
+    matcher.compile(ble_rules, 0);
+    mac_filter.clear();
+    rule_program.clear();
+}
+
+SigPackStatus SignaturePack::loadPatterns(const uint8_t* body, uint32_t len, uint32_t count,
+                                          const char** out, uint16_t& out_count) {
+    if (count > SIGPACK_MAX_PATTERNS) return SIGPACK_ERR_LIMIT;
+    if (count > len) return SIGPACK_ERR_SECTION;  // Each pattern takes at least its NUL
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* end = (const uint8_t*)memchr(body + pos, 0, len - pos);
+        if (!end) return SIGPACK_ERR_SECTION;
+        out[i] = (const char*)body + pos;
+        pos = (end - body) + 1;
+    }
+    out_count = count;
+    return SIGPACK_OK;
+}
+
+SigPackStatus SignaturePack::loadBleRules(const uint8_t* body, uint32_t len, uint32_t count) {
+    if (count > BLE_MATCHER_MAX_RULES) return SIGPACK_ERR_LIMIT;
+    if (len % SIGPACK_BLE_RULE_SIZE != 0 || count != len / SIGPACK_BLE_RULE_SIZE) return SIGPACK_ERR_SECTION;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* rec = body + i * SIGPACK_BLE_RULE_SIZE;
+        BleRule& r = ble_rules[i];
+        r.kind = rec[0];
+        r.offset = rec[1];
+        r.len = rec[2];
+        r.id = rd16(rec + 4);
+        memcpy(r.value, rec + 8, BLE_RULE_MAX_BYTES);
+        memcpy(r.mask, rec + 16, BLE_RULE_MAX_BYTES);
+        // Name: 16 B NUL-padded, last byte must be NUL
+        if (rec[39] != 0 || r.kind > BLE_RULE_SERVICE_DATA || r.len > BLE_RULE_MAX_BYTES) {
+            return SIGPACK_ERR_SECTION;
+        }
+        r.name = (const char*)rec + 24;
+    }
+    ble_count = count;
+    return matcher.compile(ble_rules, ble_count) ? SIGPACK_OK : SIGPACK_ERR_LIMIT;
+}
+
+SigPackStatus SignaturePack::load(const uint8_t* image, size_t len) {
+    clear();
+    if (len < SIGPACK_HEADER_SIZE) return SIGPACK_ERR_SIZE;
+    if (memcmp(image, SIGPACK_MAGIC, 4) != 0) return SIGPACK_ERR_MAGIC;
+    if (rd16(image + 4) != SIGPACK_FORMAT) return SIGPACK_ERR_FORMAT;
+
+    uint16_t sections = rd16(image + 6);
+    uint32_t payload_len = rd32(image + 16);
+    if (sections > SIGPACK_MAX_SECTIONS || payload_len != len - SIGPACK_HEADER_SIZE ||
+        payload_len < (uint32_t)sections * SIGPACK_SECTION_SIZE) {
+        return SIGPACK_ERR_SIZE;
+    }
+    if (sigpack_crc32(image + SIGPACK_HEADER_SIZE, payload_len) != rd32(image + 20)) {
+        return SIGPACK_ERR_CRC;
+    }
+
+    SigPackStatus status = SIGPACK_OK;
+    uint32_t mac_len = 0;
+    for (uint16_t s = 0; s < sections && status == SIGPACK_OK; s++) {
+        const uint8_t* sec = image + SIGPACK_HEADER_SIZE + s * SIGPACK_SECTION_SIZE;
+        uint16_t type = rd16(sec);
+        uint32_t count = rd32(sec + 4);
+        uint32_t offset = rd32(sec + 8);
+        uint32_t length = rd32(sec + 12);
+        if (offset > len || length > len - offset) {
+            status = SIGPACK_ERR_SIZE;
+            break;
+        }
+        const uint8_t* body = image + offset;
+
+        switch (type) {
+        case SIGPACK_SEC_OUI:
+            // Lengths are checked by division: count * 3 can wrap in 32 bits
+            if (length % 3 != 0 || count != length / 3) status = SIGPACK_ERR_SECTION;
+            ouis = body;
+            oui_count = count;
+            break;
+        case SIGPACK_SEC_MAC:
+            if (length % 6 != 0 || count != length / 6) status = SIGPACK_ERR_SECTION;
+            macs = body;
+            mac_count = count;
+            mac_len = length;
+            break;
+        case SIGPACK_SEC_SSID:
+            status = loadPatterns(body, length, count, ssid_patterns, ssid_count);
+            break;
+        case SIGPACK_SEC_NAME:
+            status = loadPatterns(body, length, count, name_patterns, name_count);
+            break;
+        case SIGPACK_SEC_BLE:
+            status = loadBleRules(body, length, count);
+            break;
+        case SIGPACK_SEC_CUCKOO:
+            if (!mac_filter.attach(body, length)) status = SIGPACK_ERR_SECTION;
+            break;
+        case SIGPACK_SEC_RULES:
+            if (rule_program.load(body, length) != RULE_OK) status = SIGPACK_ERR_SECTION;
+            break;
+        default:
+            break;  // Unknown sections are skipped (newer compiler, same format)
+        }
+    }
+
+    if (status == SIGPACK_OK && !mac_filter.setExact(macs, mac_len)) status = SIGPACK_ERR_SECTION;
+    if (status != SIGPACK_OK) {
+        clear();
+        return status;
+    }
+    pack_version = rd32(image + 8);
+    build_time = rd32(image + 12);
+    is_loaded = true;
+    return SIGPACK_OK;
+}
+
+bool SignaturePack::matchOui(const uint8_t* mac) const {
+    return oui_count && sorted_contains(ouis, oui_count, mac, 3);
+}
+
+bool SignaturePack::matchMac(const uint8_t* mac) const {
+    if (mac_filter.attached()) return mac_filter.contains(mac);
+    return mac_count && sorted_contains(macs, mac_count, mac, 6);
+}
+
+const char* SignaturePack::matchSsid(const char* ssid) const {
+    for (uint16_t i = 0; i < ssid_count; i++) {
+        if (strcasestr(ssid, ssid_patterns[i])) return ssid_patterns[i];
+    }
+    return nullptr;
+}
+
+const char* SignaturePack::matchName(const char* name) const {
+    for (uint16_t i = 0; i < name_count; i++) {
+        if (strcasestr(name, name_patterns[i])) return name_patterns[i];
+    }
+    return nullptr;
+}
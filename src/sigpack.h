@@ -0,0 +1,124 @@
+/**
+ * @file sigpack.h
+ * @brief Versioned binary signature pack (OUIs, MACs, SSID/name patterns, BLE rules)
+ *
+ * Lets the detection signatures ship as data instead of firmware. Packs are
+ * compiled on the host from CSV sources (tools/sigpack.py) and loaded from
+ * SD at boot; see main.cpp for the hot-reload double buffer.
+ *
+ * Layout (little-endian):
+ *
+ *   header   24 B  magic "FYSP", format, section count, pack version,
+ *                  build time, payload length, CRC-32 of the payload
+ *   sections 16 B each: type, count, offset (from file start), length
+ *   data           section bodies
+ *
+ * Section bodies:
+ *   OUI      count x 3 B, sorted           -> binary search
+ *   MAC      count x 6 B, sorted           -> binary search
+ *   SSID     count NUL-terminated patterns -> case-insensitive substring
+ *   NAME     count NUL-terminated patterns -> case-insensitive substring
+ *   BLE      count x 40 B rule records     -> compiled into a BleMatcher
+ *   CUCKOO   cuckoo filter over the MAC set -> MacWatchlist fast path
+ *   RULES    compiled confidence rules      -> RuleProgram (rule_vm.h)
+ *
+ * A SignaturePack never copies the image: sorted sets and patterns are
+ * views into the caller's buffer, which must outlive it.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef SIGPACK_H
+#define SIGPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ble_matcher.h"
+#include "mac_watchlist.h"
+#include "rule_vm.h"
+
+#define SIGPACK_MAGIC         "FYSP"
+#define SIGPACK_FORMAT        1
+#define SIGPACK_HEADER_SIZE   24
+#define SIGPACK_SECTION_SIZE  16
+#define SIGPACK_BLE_RULE_SIZE 40
+#define SIGPACK_MAX_SECTIONS  8
+#define SIGPACK_MAX_PATTERNS  64     // Per SSID / name section
+
+// Section types
+#define SIGPACK_SEC_OUI     1
+#define SIGPACK_SEC_MAC     2
+#define SIGPACK_SEC_SSID    3
+#define SIGPACK_SEC_NAME    4
+#define SIGPACK_SEC_BLE     5
+#define SIGPACK_SEC_CUCKOO  6
+#define SIGPACK_SEC_RULES   7
+
+enum SigPackStatus : uint8_t {
+    SIGPACK_OK = 0,
+    SIGPACK_ERR_SIZE,       // Truncated or inconsistent lengths
+    SIGPACK_ERR_MAGIC,
+    SIGPACK_ERR_FORMAT,     // Unsupported format version
+    SIGPACK_ERR_CRC,
+    SIGPACK_ERR_SECTION,    // Malformed section body
+    SIGPACK_ERR_LIMIT       // More patterns/rules than this firmware holds
+};
+
+const char* sigpack_status_str(SigPackStatus status);
+// Pass the previous result as crc to checksum data in chunks (zlib.crc32 style)
+uint32_t sigpack_crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+class SignaturePack {
+public:
+    SignaturePack();
+
+    // Validate and index a pack image. On failure the pack is left empty.
+    SigPackStatus load(const uint8_t* image, size_t len);
+    void clear();
+
+    bool loaded() const { return is_loaded; }
+    uint32_t version() const { return pack_version; }
+    uint32_t buildTime() const { return build_time; }
+
+    bool matchOui(const uint8_t* mac) const;
+    bool matchMac(const uint8_t* mac) const;
+    // Matched pattern or nullptr
+    const char* matchSsid(const char* ssid) const;
+    const char* matchName(const char* name) const;
+    const BleMatcher& bleMatcher() const { return matcher; }
+    const MacWatchlist& watchlist() const { return mac_filter; }
+    const RuleProgram& rules() const { return rule_program; }  // Empty if the pack has none
+
+    uint32_t ouiCount() const { return oui_count; }
+    uint32_t macCount() const { return mac_count; }
+    uint16_t ssidCount() const { return ssid_count; }
+    uint16_t nameCount() const { return name_count; }
+    uint16_t bleRuleCount() const { return ble_count; }
+
+private:
+    SigPackStatus loadPatterns(const uint8_t* body, uint32_t len, uint32_t count,
+                               const char** out, uint16_t& out_count);
+    SigPackStatus loadBleRules(const uint8_t* body, uint32_t len, uint32_t count);
+
+    bool is_loaded;
+    uint32_t pack_version;
+    uint32_t build_time;
+
+    const uint8_t* ouis;
+    uint32_t oui_count;
+    const uint8_t* macs;
+    uint32_t mac_count;
+
+    const char* ssid_patterns[SIGPACK_MAX_PATTERNS];
+    uint16_t ssid_count;
+    const char* name_patterns[SIGPACK_MAX_PATTERNS];
+    uint16_t name_count;
+
+    BleRule ble_rules[BLE_MATCHER_MAX_RULES];
+    uint16_t ble_count;
+    BleMatcher matcher;
+    MacWatchlist mac_filter;    // Optional; matchMac() falls back to binary search
+    RuleProgram rule_program;   // Optional; main.cpp falls back to rules_default.h
+};
+
+#endif // SIGPACK_H
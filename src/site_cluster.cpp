@@ -0,0 +1,298 @@
+/**
+ * @file site_cluster.cpp
+ * @brief Union-find site grouping over tracked devices
+ *
+ * @see site_cluster.h
+ */
+
+#include "site_cluster.h"
+#include <string.h>
+
+const char* site_reason_name(SiteReason reason) {
+    switch (reason) {
+    case SITE_JOIN_MAC_ADJACENT:  return "mac_adjacent";
+    case SITE_JOIN_CO_OCCURRENCE: return "co_occurrence";
+    default:                      return "none";
+    }
+}
+
+SiteCluster::SiteCluster() {
+    clear();
+}
+
+void SiteCluster::clear() {
+    memset(slots, 0, sizeof(slots));
+    memset(pairs, 0, sizeof(pairs));
+    next_id = 1;
+}
+
+uint8_t SiteCluster::find(uint8_t slot) {
+    while (slots[slot].parent != slot) {
+        slots[slot].parent = slots[slots[slot].parent].parent;  // Path halving
+        slot = slots[slot].parent;
+    }
+    return slot;
+}
+
+SiteJoin SiteCluster::join(uint8_t a, uint8_t b, SiteReason reason) {
+    SiteJoin j = { SITE_JOIN_NONE, 0, 0 };
+    uint8_t ra = find(a), rb = find(b);
+    if (ra == rb) return j;
+
+    // The site that alerted first keeps its id and lead
+    Slot& sa = slots[ra];
+    Slot& sb = slots[rb];
+    bool keep_a = sa.site_id && (!sb.site_id || sa.site_id < sb.site_id);
+    uint16_t id = keep_a ? sa.site_id : sb.site_id;
+    uint8_t lead = keep_a ? sa.lead : sb.lead;
+    j.absorbed_id = keep_a ? sb.site_id : (sb.site_id ? sa.site_id : 0);
+
+    // Union by size
+    uint8_t big = sa.size >= sb.size ? ra : rb;
+    uint8_t small = big == ra ? rb : ra;
+    slots[small].parent = big;
+    slots[big].size += slots[small].size;
+    slots[big].site_id = id;
+    slots[big].lead = lead;
+
+    joins[reason]++;
+    j.reason = reason;
+    j.site_id = id;
+    return j;
+}
+
+SiteJoin SiteCluster::add(uint8_t slot, const uint8_t* mac, bool ble, uint32_t now) {
+    SiteJoin j = { SITE_JOIN_NONE, 0, 0 };
+    if (slot >= SITE_SLOTS) return j;
+    Slot& s = slots[slot];
+    if (s.flags & FLAG_ACTIVE) {
+        s.last_ms = now;
+        j.site_id = siteId(slot);
+        return j;
+    }
+
+    memcpy(s.mac, mac, 6);
+    s.flags = FLAG_ACTIVE | (ble ? FLAG_BLE : 0);
+    s.parent = slot;
+    s.size = 1;
+    s.lead = SITE_NONE;
+    s.site_id = 0;
+    s.tick = (uint16_t)(now / 1000);
+    s.last_ms = now;
+    s.peak_ms = now;
+    dropPairs(slot);
+
+    uint32_t low = ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        const Slot& o = slots[i];
+        if (i == slot || !(o.flags & FLAG_ACTIVE) || now - o.last_ms > SITE_ADJ_MS) continue;
+        if (memcmp(o.mac, mac, 3) != 0) continue;
+        uint32_t other = ((uint32_t)o.mac[3] << 16) | ((uint32_t)o.mac[4] << 8) | o.mac[5];
+        uint32_t diff = low > other ? low - other : other - low;
+        if (diff <= SITE_MAC_ADJ) return join(slot, i, SITE_JOIN_MAC_ADJACENT);
+    }
+    return j;
+}
+
+// A track's peak only moves later until it has passed, so an unpassed
+// peak_ms is a lower bound on where its closest point will be
+bool SiteCluster::peaksMayMatch(const Slot& a, const Slot& b) {
+    if ((a.flags & FLAG_PASSED) && (int32_t)(b.peak_ms - a.peak_ms) > SITE_PEAK_MS) return false;
+    if ((b.flags & FLAG_PASSED) && (int32_t)(a.peak_ms - b.peak_ms) > SITE_PEAK_MS) return false;
+    return true;
+}
+
+SiteCluster::Pair* SiteCluster::pair(uint8_t a, uint8_t b) {
+    if (a > b) { uint8_t t = a; a = b; b = t; }
+    Pair* free_entry = nullptr;
+    for (uint8_t i = 0; i < SITE_PAIRS; i++) {
+        Pair& p = pairs[i];
+        if (p.co == 0) {
+            if (!free_entry) free_entry = &p;
+        } else if (p.a == a && p.b == b) {
+            return &p;
+        }
+    }
+    if (!free_entry) {
+        // Replace the entry updated longest ago (ticks wrap; compare ages)
+        uint16_t newest = pairs[0].tick;
+        for (uint8_t i = 1; i < SITE_PAIRS; i++) {
+            if ((int16_t)(pairs[i].tick - newest) > 0) newest = pairs[i].tick;
+        }
+        free_entry = &pairs[0];
+        for (uint8_t i = 1; i < SITE_PAIRS; i++) {
+            if ((uint16_t)(newest - pairs[i].tick) > (uint16_t)(newest - free_entry->tick)) free_entry = &pairs[i];
+        }
+        pair_evictions++;
+    }
+    free_entry->a = a;
+    free_entry->b = b;
+    free_entry->co = 0;
+    return free_entry;
+}
+
+void SiteCluster::dropPairs(uint8_t slot) {
+    for (uint8_t i = 0; i < SITE_PAIRS; i++) {
+        if (pairs[i].a == slot || pairs[i].b == slot) pairs[i].co = 0;
+    }
+}
+
+SiteJoin SiteCluster::sight(uint8_t slot, const RssiTrack& track, uint32_t now) {
+    SiteJoin j = { SITE_JOIN_NONE, 0, 0 };
+    if (!active(slot)) return j;
+    Slot& s = slots[slot];
+    s.last_ms = now;
+    s.peak_ms = track.peak_ms;
+    if (track.phase == RSSI_PHASE_PASSED || track.phase == RSSI_PHASE_DEPARTED) {
+        s.flags |= FLAG_PASSED;
+    } else {
+        s.flags &= ~FLAG_PASSED;
+    }
+
+    // One round of evidence per second: WiFi bursts would otherwise vote many times
+    uint16_t tick = (uint16_t)(now / 1000);
+    uint8_t root = find(slot);
+    j.site_id = slots[root].site_id;
+    if (s.tick == tick) return j;
+    s.tick = tick;
+
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        const Slot& o = slots[i];
+        if (i == slot || !(o.flags & FLAG_ACTIVE) || now - o.last_ms > SITE_CO_MS) continue;
+        if (find(i) == root) continue;
+
+        Pair* p = pair(slot, i);
+        if (p->co && p->tick == tick) continue;  // The other slot already voted this second
+        p->tick = tick;
+        if (p->co < 255) p->co++;
+        if (p->co >= SITE_CO_MIN && (s.flags & o.flags & FLAG_PASSED) && peaksMayMatch(s, o)) {
+            p->co = 0;
+            return join(slot, i, SITE_JOIN_CO_OCCURRENCE);
+        }
+    }
+    return j;
+}
+
+uint8_t SiteCluster::expire(uint32_t now, uint32_t ttl_ms) {
+    // Roots first: dissolving rewrites parents
+    uint8_t root_of[SITE_SLOTS];
+    uint64_t fresh = 0;
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        if (!(slots[i].flags & FLAG_ACTIVE)) continue;
+        root_of[i] = find(i);
+        if (now - slots[i].last_ms <= ttl_ms) fresh |= 1ull << root_of[i];
+    }
+    uint8_t dissolved = 0;
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        if (!(slots[i].flags & FLAG_ACTIVE) || (fresh & (1ull << root_of[i]))) continue;
+        if (root_of[i] == i) dissolved++;
+        slots[i].flags = 0;
+        dropPairs(i);
+    }
+    return dissolved;
+}
+
+bool SiteCluster::alertedNearby(uint8_t slot, uint32_t now) {
+    uint8_t root = find(slot);
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        const Slot& o = slots[i];
+        if (!(o.flags & FLAG_ACTIVE) || now - o.last_ms > SITE_NEAR_MS) continue;
+        uint8_t r = find(i);
+        if (r != root && slots[r].site_id && peaksMayMatch(slots[slot], o)) return true;
+    }
+    return false;
+}
+
+uint16_t SiteCluster::assign(uint8_t slot) {
+    Slot& r = slots[find(slot)];
+    if (!r.site_id) {
+        r.site_id = next_id++;
+        if (!next_id) next_id = 1;
+        r.lead = slot;
+    }
+    return r.site_id;
+}
+
+uint8_t SiteCluster::members(uint8_t slot, uint8_t* out, uint8_t max) {
+    uint8_t root = find(slot);
+    uint8_t lead_slot = slots[root].lead;
+    uint8_t n = 0;
+    if (lead_slot != SITE_NONE && n < max) out[n++] = lead_slot;
+    for (uint8_t i = 0; i < SITE_SLOTS && n < max; i++) {
+        if (i == lead_slot || !(slots[i].flags & FLAG_ACTIVE)) continue;
+        if (find(i) == root) out[n++] = i;
+    }
+    return n;
+}
+
+bool SiteCluster::mixed(uint8_t slot) {
+    uint8_t root = find(slot);
+    uint8_t seen = 0;
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        if (!(slots[i].flags & FLAG_ACTIVE) || find(i) != root) continue;
+        seen |= (slots[i].flags & FLAG_BLE) ? 2 : 1;
+    }
+    return seen == 3;
+}
+
+bool SiteCluster::saveSlot(uint8_t slot, SiteSlotState& out) {
+    if (!active(slot)) return false;
+    const Slot& s = slots[slot];
+    uint8_t root = find(slot);
+    memcpy(out.mac, s.mac, 6);
+    out.root = root;
+    out.lead = slots[root].lead;
+    out.site_id = slots[root].site_id;
+    out.ble = s.flags & FLAG_BLE;
+    out.passed = s.flags & FLAG_PASSED;
+    out.last_ms = s.last_ms;
+    out.peak_ms = s.peak_ms;
+    return true;
+}
+
+void SiteCluster::restoreSlot(uint8_t slot, const SiteSlotState& in) {
+    if (slot >= SITE_SLOTS) return;
+    Slot& s = slots[slot];
+    memcpy(s.mac, in.mac, 6);
+    s.flags = FLAG_ACTIVE | (in.ble ? FLAG_BLE : 0) | (in.passed ? FLAG_PASSED : 0);
+    s.parent = in.root < SITE_SLOTS ? in.root : slot;
+    s.size = 0;
+    s.lead = in.lead;
+    s.site_id = in.site_id;
+    s.tick = 0;
+    s.last_ms = in.last_ms;
+    s.peak_ms = in.peak_ms;
+}
+
+void SiteCluster::restoreDone() {
+    // Saved parents point straight at the root; anything else is a singleton
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        Slot& s = slots[i];
+        if (!(s.flags & FLAG_ACTIVE)) continue;
+        const Slot& r = slots[s.parent];
+        if (!(r.flags & FLAG_ACTIVE) || r.parent != s.parent) s.parent = i;
+    }
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        if (slots[i].flags & FLAG_ACTIVE) slots[slots[i].parent].size++;
+    }
+    uint16_t max_id = 0;
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        Slot& s = slots[i];
+        if (!(s.flags & FLAG_ACTIVE) || s.parent != i) continue;
+        if (s.lead != SITE_NONE && (s.lead >= SITE_SLOTS || !(slots[s.lead].flags & FLAG_ACTIVE) ||
+                                    slots[s.lead].parent != i)) {
+            s.lead = SITE_NONE;
+        }
+        if (s.site_id > max_id) max_id = s.site_id;
+    }
+    next_id = max_id + 1;
+    if (!next_id) next_id = 1;
+}
+
+uint16_t SiteCluster::sites() const {
+    uint16_t n = 0;
+    for (uint8_t i = 0; i < SITE_SLOTS; i++) {
+        if ((slots[i].flags & FLAG_ACTIVE) && slots[i].parent == i && slots[i].size > 1) n++;
+    }
+    return n;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file site_cluster.h
+ * @brief Groups tracked WiFi/BLE devices into physical sites
+ *
+ * One installation usually shows up as several radios: a Flock camera's
+ * WiFi BSSID plus its "FS Ext Battery" BLE advertiser, or a battery pair
+ * with consecutive addresses. Each is a separate tracked device, so each
+ * used to raise its own alert and log line. The site cluster joins them
+ * into one site on three kinds of evidence:
+ *
+ * - MAC adjacency: same OUI and low three bytes within SITE_MAC_ADJ (ESP32
+ *   style units derive their WiFi/AP/BT addresses as base +0/+1/+2, and
+ *   battery pairs in datasets/ sit 1-15 apart). Joined on first sighting.
+ * - co-occurrence: sighted within SITE_CO_MS of each other in SITE_CO_MIN
+ *   different seconds
+ * - RSSI co-variation: both filtered levels (rssi_track.h) have passed
+ *   their peak, and the peaks are within SITE_PEAK_MS of each other, i.e.
+ *   the same point of the road was closest to both. In tools/bench/site_bench
+ *   90% of co-located radios peak within 3 s of each other while under 0.2%
+ *   of radios at different installations do.
+ *
+ * Co-occurrence and co-variation must both hold, so radios that are merely
+ * heard at the same time (parked next to each other, or one ahead of the
+ * other along the road) stay apart. Evidence is gathered at most once per
+ * second per slot.
+ *
+ * Co-occurrence joins come after both radios are first heard, so a new
+ * device heard alongside an already alerted site can hold its own alert
+ * (alertedNearby(), up to SITE_HOLD_MS) until it is folded in or released.
+ *
+ * Sites are an incremental union-find over the tracked-device slots (union
+ * by size, path halving). Evidence for not-yet-joined pairs lives in a small
+ * table of candidate pairs; the least recently updated pair is replaced
+ * when it is full. A site whose members have all been quiet for the TTL is
+ * dissolved back into singletons. Each site carries the id it alerted under
+ * and the slot that raised the alert, so later members are folded into it
+ * instead of alerting again. Fixed memory, no allocation.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef SITE_CLUSTER_H
+#define SITE_CLUSTER_H
+
+#include <stdint.h>
+#include "rssi_track.h"
+
+#define SITE_SLOTS          64    // Tracked-device slots covered (MAX_TRACKED)
+#define SITE_PAIRS          32    // Candidate pairs collecting evidence
+#define SITE_MAC_ADJ        16    // Same OUI, low three bytes this close: one unit
+#define SITE_ADJ_MS      60000    // Adjacent partner must have been seen this recently
+#define SITE_CO_MS        2000    // Sighted this close together: co-occurring
+#define SITE_CO_MIN          4    // Co-occurring seconds before a join
+#define SITE_PEAK_MS      3000    // Closest points this close together: co-varying
+#define SITE_HOLD_MS     30000    // Longest a new device's alert waits for a join
+#define SITE_NEAR_MS      5000    // Alerted site heard this recently: hold for it
+
+#define SITE_NONE         0xFF    // No slot
+
+enum SiteReason : uint8_t {
+    SITE_JOIN_NONE = 0,
+    SITE_JOIN_MAC_ADJACENT,
+    SITE_JOIN_CO_OCCURRENCE,
+};
+
+const char* site_reason_name(SiteReason reason);
+
+// Outcome of add()/sight(): which site a join produced, if any
+struct SiteJoin {
+    SiteReason reason;      // SITE_JOIN_NONE: nothing joined
+    uint16_t   site_id;     // Id of the joined site (0: not alerted yet)
+    uint16_t   absorbed_id; // Id of an alerted site merged into it, else 0
+};
+
+// One active slot, for warm restarts (warm_snapshot.h)
+struct SiteSlotState {
+    uint8_t  mac[6];
+    uint8_t  root;       // Root slot of its site
+    uint8_t  lead;       // Site lead, valid at the root
+    uint16_t site_id;    // Valid at the root
+    bool     ble;
+    bool     passed;
+    uint32_t last_ms;
+    uint32_t peak_ms;
+};
+
+class SiteCluster {
+public:
+    SiteCluster();
+
+    void clear();
+
+    // First sighting of a tracked slot (or the first after its site expired).
+    // Joins a live site holding an adjacent MAC.
+    SiteJoin add(uint8_t slot, const uint8_t* mac, bool ble, uint32_t now);
+
+    // Every later sighting, with the slot's proximity track. Gathers
+    // evidence against the other live slots; joins at most once.
+    SiteJoin sight(uint8_t slot, const RssiTrack& track, uint32_t now);
+
+    // Dissolve sites whose members have all been quiet for ttl_ms;
+    // returns the number of sites dissolved
+    uint8_t expire(uint32_t now, uint32_t ttl_ms);
+
+    bool     active(uint8_t slot) const { return slot < SITE_SLOTS && (slots[slot].flags & FLAG_ACTIVE); }
+    uint8_t  find(uint8_t slot);
+    uint8_t  siteSize(uint8_t slot) { return slots[find(slot)].size; }
+    uint16_t siteId(uint8_t slot) { return slots[find(slot)].site_id; }
+    uint8_t  lead(uint8_t slot) { return slots[find(slot)].lead; }
+    bool     mixed(uint8_t slot);  // Site has both WiFi and BLE members
+
+    // True if a site other than the slot's has alerted, was heard within
+    // SITE_NEAR_MS and could still join it (closest points not already too
+    // far apart): the slot's alert is worth holding
+    bool alertedNearby(uint8_t slot, uint32_t now);
+
+    // Give the slot's site an id, with `slot` as the one that alerted
+    uint16_t assign(uint8_t slot);
+
+    // Slots in the same site as `slot`, lead first; returns the count
+    uint8_t members(uint8_t slot, uint8_t* out, uint8_t max);
+
+    // Warm restart: saveSlot() is false for inactive slots. Restore into a
+    // cleared cluster, then restoreDone() rebuilds sizes and the id counter
+    // and turns slots whose root was not restored into singletons.
+    bool saveSlot(uint8_t slot, SiteSlotState& out);
+    void restoreSlot(uint8_t slot, const SiteSlotState& in);
+    void restoreDone();
+
+    uint16_t sites() const;  // Live sites with more than one member
+    uint32_t joins[3] = {};  // By SiteReason
+    uint32_t pair_evictions = 0;
+
+private:
+    enum : uint8_t { FLAG_ACTIVE = 1, FLAG_BLE = 2, FLAG_PASSED = 4 };
+
+    struct Slot {
+        uint8_t  mac[6];
+        uint8_t  flags;
+        uint8_t  parent;    // Union-find parent (self: root)
+        uint8_t  size;      // Members, valid at the root
+        uint8_t  lead;      // Slot that alerted, valid at the root
+        uint16_t site_id;   // Valid at the root, 0 = not alerted
+        uint16_t tick;      // Second evidence was last gathered
+        uint32_t last_ms;
+        uint32_t peak_ms;   // Closest point once FLAG_PASSED, else a lower bound on it
+    };
+
+    struct Pair {
+        uint8_t  a, b;      // a < b
+        uint8_t  co;        // Co-occurring seconds, 0 = empty entry
+        uint16_t tick;      // Second of the last update
+    };
+
+    static bool peaksMayMatch(const Slot& a, const Slot& b);
+    Pair* pair(uint8_t a, uint8_t b);
+    void dropPairs(uint8_t slot);
+    SiteJoin join(uint8_t a, uint8_t b, SiteReason reason);
+
+    Slot slots[SITE_SLOTS];
+    Pair pairs[SITE_PAIRS];
+    uint16_t next_id;
+};
+
+#endif // SITE_CLUSTER_H
@@ -0,0 +1,262 @@
+/**
+ * @file status_led.cpp
+ * @brief Status LED task and its LEDC / RMT backends
+ *
+ * @see status_led.h
+ */
+
+#include "status_led.h"
+#include <string.h>
+#include "esp_idf_version.h"
+#include "driver/ledc.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include "driver/rmt_tx.h"
+#else
+#include "driver/rmt.h"
+#endif
+
+// Same speed group Arduino's ledcSetup() gives channels 0-7; timer 0 is only
+// shared with Arduino channel 1, which is ours
+#if SOC_LEDC_SUPPORT_HS_MODE
+#define LED_LEDC_MODE   LEDC_HIGH_SPEED_MODE
+#else
+#define LED_LEDC_MODE   LEDC_LOW_SPEED_MODE
+#endif
+#define LED_LEDC_TIMER  LEDC_TIMER_0
+#define LED_LEDC_FREQ   5000   // 5kHz, 8-bit
+
+// WS2812 bit timing
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#define LED_RMT_HZ      10000000   // 100ns ticks
+#define WS_T0H  4
+#define WS_T0L  9
+#define WS_T1H  8
+#define WS_T1L  5
+#else
+#define LED_RMT_CHANNEL RMT_CHANNEL_0
+#define LED_RMT_CLK_DIV 2          // 80MHz APB / 2: 25ns ticks
+#define WS_T0H  16
+#define WS_T0L  34
+#define WS_T1H  32
+#define WS_T1L  18
+#endif
+
+StatusLed status_led;
+
+static portMUX_TYPE led_mux = portMUX_INITIALIZER_UNLOCKED;
+
+StatusLed::StatusLed()
+    : effects(led_effects_default, LED_FX_COUNT),
+      task(nullptr),
+      backend(LED_NONE),
+      scale(255),
+      enabled(true),
+      manual(false),
+      manualColor{0, 0, 0},
+      last{0, 0, 0},
+      written(false),
+      channels{0, 0, 0},
+      rmtChannel(nullptr),
+      rmtEncoder(nullptr),
+      pixel{0, 0, 0}
+{
+}
+
+bool StatusLed::beginLedc(uint8_t pinR, uint8_t pinG, uint8_t pinB, uint8_t chR, uint8_t chG, uint8_t chB) {
+    ledc_timer_config_t timer = {};
+    timer.speed_mode = LED_LEDC_MODE;
+    timer.duty_resolution = LEDC_TIMER_8_BIT;
+    timer.timer_num = LED_LEDC_TIMER;
+    timer.freq_hz = LED_LEDC_FREQ;
+    timer.clk_cfg = LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer) != ESP_OK) return false;
+
+    const uint8_t pins[3] = { pinR, pinG, pinB };
+    channels[0] = chR;
+    channels[1] = chG;
+    channels[2] = chB;
+    for (int i = 0; i < 3; i++) {
+        ledc_channel_config_t ch = {};
+        ch.gpio_num = pins[i];
+        ch.speed_mode = LED_LEDC_MODE;
+        ch.channel = (ledc_channel_t)channels[i];
+        ch.intr_type = LEDC_INTR_DISABLE;
+        ch.timer_sel = LED_LEDC_TIMER;
+        ch.duty = 255;  // Active LOW: off
+        ch.hpoint = 0;
+        if (ledc_channel_config(&ch) != ESP_OK) return false;
+    }
+    // Already installed is fine (another user of fades)
+    esp_err_t err = ledc_fade_func_install(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return false;
+
+    backend = LED_LEDC;
+    return startTask();
+}
+
+bool StatusLed::beginWs2812(uint8_t pin) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    rmt_tx_channel_config_t cfg = {};
+    cfg.gpio_num = (gpio_num_t)pin;
+    cfg.clk_src = RMT_CLK_SRC_DEFAULT;
+    cfg.resolution_hz = LED_RMT_HZ;
+    cfg.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+    cfg.trans_queue_depth = 2;
+    rmt_channel_handle_t chan = nullptr;
+    if (rmt_new_tx_channel(&cfg, &chan) != ESP_OK) return false;
+
+    rmt_bytes_encoder_config_t enc = {};
+    enc.bit0.level0 = 1;
+    enc.bit0.duration0 = WS_T0H;
+    enc.bit0.level1 = 0;
+    enc.bit0.duration1 = WS_T0L;
+    enc.bit1.level0 = 1;
+    enc.bit1.duration0 = WS_T1H;
+    enc.bit1.level1 = 0;
+    enc.bit1.duration1 = WS_T1L;
+    enc.flags.msb_first = 1;
+    rmt_encoder_handle_t encoder = nullptr;
+    if (rmt_new_bytes_encoder(&enc, &encoder) != ESP_OK || rmt_enable(chan) != ESP_OK) return false;
+    rmtChannel = chan;
+    rmtEncoder = encoder;
+#else
+    rmt_config_t cfg = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin, LED_RMT_CHANNEL);
+    cfg.clk_div = LED_RMT_CLK_DIV;
+    if (rmt_config(&cfg) != ESP_OK || rmt_driver_install(cfg.channel, 0, 0) != ESP_OK) return false;
+#endif
+    backend = LED_WS2812;
+    return startTask();
+}
+
+bool StatusLed::startTask() {
+    if (task) return true;
+    return xTaskCreatePinnedToCore(taskEntry, "led", LED_TASK_STACK, this, LED_TASK_PRIORITY, &task, 1) == pdPASS;
+}
+
+void StatusLed::taskEntry(void* arg) {
+    static_cast<StatusLed*>(arg)->run();
+}
+
+void StatusLed::wake() {
+    if (task) xTaskNotifyGive(task);
+}
+
+void StatusLed::play(uint8_t effect, int8_t rssi) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&led_mux);
+    manual = false;
+    effects.play(effect, now, rssi);
+    portEXIT_CRITICAL(&led_mux);
+    wake();
+}
+
+void StatusLed::skip(uint8_t effect) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&led_mux);
+    bool skipped = effects.skip(effect, now);
+    portEXIT_CRITICAL(&led_mux);
+    if (skipped) wake();
+}
+
+void StatusLed::show(uint8_t r, uint8_t g, uint8_t b) {
+    portENTER_CRITICAL(&led_mux);
+    manual = true;
+    manualColor = { r, g, b };
+    portEXIT_CRITICAL(&led_mux);
+    wake();
+}
+
+void StatusLed::setScale(uint8_t level) {
+    scale = level;
+    wake();
+}
+
+void StatusLed::setEnabled(bool on) {
+    enabled = on;
+    wake();
+}
+
+void StatusLed::run() {
+    for (;;) {
+        uint32_t now = millis();
+        portENTER_CRITICAL(&led_mux);
+        bool fixed = manual;
+        LedColor color = manualColor;
+        LedSegment seg = effects.segment(now);
+        portEXIT_CRITICAL(&led_mux);
+
+        uint8_t level = LED_LEVEL_MAX;
+        uint32_t fade_ms = 0;
+        uint32_t wait_ms = 0;  // 0: until notified
+        if (!fixed) {
+            color = seg.color;
+            if (seg.ramping(now)) {
+                // Fade to where the ramp is one chunk (or frame) from now
+                uint32_t step = backend == LED_LEDC ? LED_FADE_CHUNK_MS : LED_FRAME_MS;
+                wait_ms = seg.start_ms + seg.ramp_ms - now;
+                if (wait_ms > step) wait_ms = step;
+                if (backend == LED_LEDC) {
+                    level = seg.levelAt(now + wait_ms);
+                    fade_ms = wait_ms;
+                } else {
+                    level = seg.levelAt(now);
+                }
+            } else {
+                level = seg.to;
+                if (!seg.forever) wait_ms = seg.end_ms - now;
+            }
+        }
+        output(color, level, fade_ms);
+
+        TickType_t ticks = wait_ms ? pdMS_TO_TICKS(wait_ms) : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+    }
+}
+
+void StatusLed::output(LedColor color, uint8_t level, uint32_t fade_ms) {
+    uint32_t k = enabled ? (uint32_t)level * scale / 255 : 0;
+    uint8_t rgb[3] = {
+        (uint8_t)(color.r * k / 255),
+        (uint8_t)(color.g * k / 255),
+        (uint8_t)(color.b * k / 255),
+    };
+    if (written && memcmp(rgb, last, sizeof(last)) == 0) return;
+
+    if (backend == LED_LEDC) writeLedc(rgb, fade_ms);
+    else if (backend == LED_WS2812) writeWs2812(rgb);
+    memcpy(last, rgb, sizeof(last));
+    written = true;
+}
+
+void StatusLed::writeLedc(const uint8_t rgb[3], uint32_t fade_ms) {
+    for (int i = 0; i < 3; i++) {
+        if (written && rgb[i] == last[i]) continue;
+        ledc_channel_t ch = (ledc_channel_t)channels[i];
+        uint32_t duty = 255 - rgb[i];  // Active LOW
+        // Both wait for a fade still running on the channel (at most one chunk)
+        if (fade_ms) ledc_set_fade_time_and_start(LED_LEDC_MODE, ch, duty, fade_ms, LEDC_FADE_NO_WAIT);
+        else ledc_set_duty_and_update(LED_LEDC_MODE, ch, duty, 0);
+    }
+}
+
+void StatusLed::writeWs2812(const uint8_t rgb[3]) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    rmt_channel_handle_t chan = (rmt_channel_handle_t)rmtChannel;
+    rmt_tx_wait_all_done(chan, -1);  // `pixel` is read during the transmit
+    memcpy(pixel, rgb, sizeof(pixel));           // This LED takes R, G, B order
+    rmt_transmit_config_t tx = {};
+    rmt_transmit(chan, (rmt_encoder_handle_t)rmtEncoder, pixel, sizeof(pixel), &tx);
+#else
+    // 24 items fit one RMT memory block, so they are copied before this returns
+    rmt_item32_t items[24];
+    memcpy(pixel, rgb, sizeof(pixel));  // This LED takes R, G, B order
+    for (int i = 0; i < 24; i++) {
+        bool one = pixel[i / 8] & (0x80 >> (i % 8));
+        items[i].level0 = 1;
+        items[i].duration0 = one ? WS_T1H : WS_T0H;
+        items[i].level1 = 0;
+        items[i].duration1 = one ? WS_T1L : WS_T0L;
+    }
+    rmt_write_items(LED_RMT_CHANNEL, items, 24, false);
+#endif
+}
@@ -0,0 +1,86 @@
+/**
+ * @file status_led.h
+ * @brief Status LED driver: LED effects played by hardware from a sleeping task
+ *
+ * Plays led_effects.h effects on one of two backends:
+ * - Three LEDC channels (CYD RGB LED, active LOW). Breathing ramps are
+ *   LEDC hardware fades, blinks are duty steps.
+ * - One WS2812 pixel on an RMT TX channel (Waveshare 1.47"). A write is a
+ *   24-bit RMT transmit that returns at once; interrupts stay on, unlike
+ *   a bit-banged show() that masks them for the whole frame and can upset
+ *   WiFi RX timing.
+ *
+ * A small "led" task owns the hardware. It programs one segment, then
+ * blocks until the segment ends or play()/skip()/show() notify it, so
+ * loop() spends nothing on the LED. Ramps are cut into fades of at most
+ * LED_FADE_CHUNK_MS (LEDC) or written every LED_FRAME_MS (WS2812, which
+ * has no hardware fade); a new effect is on the LED within one chunk.
+ *
+ * play(), skip(), show(), setScale() and setEnabled() may be called from
+ * any task.
+ */
+
+#ifndef STATUS_LED_H
+#define STATUS_LED_H
+
+#include <Arduino.h>
+#include "led_effects.h"
+
+#define LED_FADE_CHUNK_MS   100   // Longest LEDC fade (a new effect waits for the running one)
+#define LED_FRAME_MS        40    // WS2812 ramp update interval
+#define LED_TASK_STACK      2560
+#define LED_TASK_PRIORITY   1
+
+class StatusLed {
+public:
+    StatusLed();
+
+    // Backends; call one, once. LEDC pins are active LOW.
+    bool beginLedc(uint8_t pinR, uint8_t pinG, uint8_t pinB, uint8_t chR, uint8_t chG, uint8_t chB);
+    bool beginWs2812(uint8_t pin);
+
+    void play(uint8_t effect, int8_t rssi = -70);
+    // End `effect`'s hold early if it is playing (e.g. a drive-by departed)
+    void skip(uint8_t effect);
+    // Fixed colour until the next play() (boot LED test)
+    void show(uint8_t r, uint8_t g, uint8_t b);
+
+    // Brightness setting 0-255, and LED alerts on/off
+    void setScale(uint8_t level);
+    void setEnabled(bool on);
+
+    uint8_t current() const { return effects.current(); }
+
+private:
+    enum Backend : uint8_t { LED_NONE, LED_LEDC, LED_WS2812 };
+
+    bool startTask();
+    static void taskEntry(void* arg);
+    void run();
+    void wake();
+    // Drive the LED to `color` at `level` (0-255), fading over fade_ms on LEDC
+    void output(LedColor color, uint8_t level, uint32_t fade_ms);
+    void writeLedc(const uint8_t rgb[3], uint32_t fade_ms);
+    void writeWs2812(const uint8_t rgb[3]);
+
+    LedEffects effects;      // Shared with the callers of play()/skip(), under a spinlock
+    TaskHandle_t task;
+    Backend backend;
+
+    volatile uint8_t scale;
+    volatile bool enabled;
+    bool manual;             // show() colour instead of the effect
+    LedColor manualColor;
+    uint8_t last[3];         // Channel values written last
+    bool written;
+
+    uint8_t channels[3];
+    void* rmtChannel;
+    void* rmtEncoder;
+    uint8_t pixel[3];        // WS2812 bytes being sent (stays valid during the transmit)
+};
+
+// Global instance
+extern StatusLed status_led;
+
+#endif // STATUS_LED_H
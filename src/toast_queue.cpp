@@ -0,0 +1,107 @@
+/**
+ * @file toast_queue.cpp
+ * @brief Toast queue: priorities, expiry and reveal steps
+ *
+ * @see toast_queue.h
+ */
+
+#include "toast_queue.h"
+#include <string.h>
+
+ToastQueue::ToastQueue() : slots(), showing(-1), nextId(1), dropCount(0) {}
+
+// Ranks a above b: higher priority, then posted first
+static bool toast_before(const Toast& a, const Toast& b) {
+    if (a.priority != b.priority) return a.priority > b.priority;
+    return (int32_t)(b.posted_ms - a.posted_ms) > 0;
+}
+
+bool ToastQueue::post(const char* text, uint16_t color, ToastPriority priority, uint32_t duration_ms,
+                      uint32_t now_ms) {
+    int slot = -1;
+    for (int i = 0; i < TOAST_SLOTS; i++) {
+        if (slots[i].used && strncmp(slots[i].text, text, TOAST_TEXT_MAX - 1) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    bool repost = slot >= 0 && slots[slot].color == color;
+    if (slot < 0) {
+        for (int i = 0; i < TOAST_SLOTS; i++) {
+            if (!slots[i].used) {
+                slot = i;
+                break;
+            }
+        }
+    }
+    if (slot < 0) {
+        // Full: the lowest ranked toast makes room if the new one outranks it
+        Toast incoming;
+        incoming.priority = priority;
+        incoming.posted_ms = now_ms;
+        slot = 0;
+        for (int i = 1; i < TOAST_SLOTS; i++) {
+            if (toast_before(slots[slot], slots[i])) slot = i;
+        }
+        dropCount++;
+        if (!toast_before(incoming, slots[slot])) return false;
+    }
+
+    Toast& t = slots[slot];
+    if (repost) {
+        // Same message again: keep it on screen for another full duration
+        if (t.shown_ms) t.shown_ms = now_ms ? now_ms : 1;
+    } else {
+        t.id = nextId++;
+        t.shown_ms = 0;
+    }
+    strncpy(t.text, text, TOAST_TEXT_MAX - 1);
+    t.text[TOAST_TEXT_MAX - 1] = '\0';
+    t.color = color;
+    t.priority = priority;
+    t.used = true;
+    t.posted_ms = now_ms;
+    t.duration_ms = duration_ms;
+    return true;
+}
+
+const Toast* ToastQueue::frame(uint32_t now_ms) {
+    int best = -1;
+    for (int i = 0; i < TOAST_SLOTS; i++) {
+        Toast& t = slots[i];
+        if (!t.used) continue;
+        if (t.shown_ms ? now_ms - t.shown_ms >= t.duration_ms : now_ms - t.posted_ms >= TOAST_MAX_WAIT_MS) {
+            if (!t.shown_ms) dropCount++;
+            t.used = false;
+            continue;
+        }
+        if (best < 0 || toast_before(t, slots[best])) best = i;
+    }
+
+    if (best != showing) {
+        // Preempted toasts start over when they are back on top
+        if (showing >= 0 && slots[showing].used) slots[showing].shown_ms = 0;
+        showing = (int8_t)best;
+    }
+    if (best < 0) return nullptr;
+    Toast& t = slots[best];
+    if (!t.shown_ms) t.shown_ms = now_ms ? now_ms : 1;
+    return &t;
+}
+
+uint8_t ToastQueue::revealStep(const Toast& t, uint32_t now_ms) const {
+    uint32_t elapsed = t.shown_ms ? now_ms - t.shown_ms : 0;
+    if (elapsed >= TOAST_ANIM_MS) return TOAST_ANIM_STEPS;
+    return (uint8_t)(1 + elapsed * (TOAST_ANIM_STEPS - 1) / TOAST_ANIM_MS);
+}
+
+void ToastQueue::clear() {
+    for (int i = 0; i < TOAST_SLOTS; i++) slots[i].used = false;
+    showing = -1;
+}
+
+uint8_t ToastQueue::pending() const {
+    uint8_t n = 0;
+    for (int i = 0; i < TOAST_SLOTS; i++) n += slots[i].used;
+    return n;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file toast_queue.h
+ * @brief Queued, prioritised toast messages for the display overlay
+ *
+ * showAlert() used to draw its box and delay(2000) with the display mutex
+ * held, stalling loop() (LED strobe, channel hops, BLE scheduling) for two
+ * seconds. Now it posts a toast and returns. Each display frame asks
+ * frame() which toast, if any, to composite over the page and how far its
+ * reveal animation has got; all timing comes from the frame clock passed
+ * in, so nothing waits.
+ *
+ * Rules:
+ * - The highest priority toast is shown; equal priorities go in posting
+ *   order. A higher priority toast preempts the one on screen, which is
+ *   shown again from the start once it is back on top.
+ * - A toast stays up for its duration from when it was first shown. Toasts
+ *   still waiting after TOAST_MAX_WAIT_MS are dropped as stale.
+ * - Posting text that is already queued refreshes that toast instead of
+ *   adding a copy. When all slots are taken the lowest priority, oldest
+ *   toast makes room, unless the new one ranks lower still.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef TOAST_QUEUE_H
+#define TOAST_QUEUE_H
+
+#include <stdint.h>
+
+#define TOAST_SLOTS         4
+#define TOAST_TEXT_MAX      40      // Including the terminator
+#define TOAST_DEFAULT_MS    2000
+#define TOAST_MAX_WAIT_MS   10000
+#define TOAST_ANIM_MS       160     // Reveal time
+#define TOAST_ANIM_STEPS    4       // Reveal drawn in this many frames at most
+
+enum ToastPriority : uint8_t {
+    TOAST_INFO = 0,
+    TOAST_WARN,
+    TOAST_ALERT,
+};
+
+struct Toast {
+    char text[TOAST_TEXT_MAX];
+    uint16_t color;            // RGB565
+    uint8_t priority;
+    bool used;
+    uint32_t id;               // Changes whenever a toast is (re)posted
+    uint32_t posted_ms;
+    uint32_t shown_ms;         // 0 until on screen
+    uint32_t duration_ms;
+};
+
+class ToastQueue {
+public:
+    ToastQueue();
+
+    // False when dropped (queue full of higher priority toasts)
+    bool post(const char* text, uint16_t color, ToastPriority priority, uint32_t duration_ms, uint32_t now_ms);
+
+    // The toast to draw this frame (expiring old ones first), or nullptr
+    const Toast* frame(uint32_t now_ms);
+
+    // Reveal step of the toast frame() returned: 1..TOAST_ANIM_STEPS, the
+    // last meaning fully shown. Redraw only when it or the toast id changes.
+    uint8_t revealStep(const Toast& t, uint32_t now_ms) const;
+
+    void clear();
+    uint8_t pending() const;
+    uint32_t dropped() const { return dropCount; }
+
+private:
+    Toast slots[TOAST_SLOTS];
+    int8_t showing;            // Slot on screen at the last frame(), -1 if none
+    uint32_t nextId;
+    uint32_t dropCount;
+};
+
+#endif // TOAST_QUEUE_H
@@ -0,0 +1,57 @@
+/**
+ * @file trace_ring.cpp
+ * @brief Trace ring bookkeeping and trace point names
+ *
+ * @see trace_ring.h
+ */
+
+#include "trace_ring.h"
+#include <string.h>
+
+const char* const trace_point_names[TRACE_POINT_COUNT] = {
+    "process_event",
+    "display_update",
+    "mutex_wait",
+    "sd_flush",
+    "snapshot_write",
+    "snapshot_encode",
+    "ble_scan_start",
+    "ble_scan_stop",
+    "ble_scan_blocking",
+    "channel_hop",
+    "heartbeat",
+    "detect_beep",
+    "stats_output",
+    "geo_update",
+    "sigpack_check",
+    "queue_drop",
+    "detection",
+    "ble_match",
+    "queue_depth",
+};
+
+TraceRing::TraceRing()
+    : events(), head(0), cleared_at(0), recording(false), clock_fn(nullptr), track_fn(nullptr) {}
+
+void TraceRing::setSource(ClockFn clock, TrackFn track) {
+    clock_fn = clock;
+    track_fn = track;
+    recording = clock != nullptr && track != nullptr;
+}
+
+uint32_t TraceRing::count() const {
+    uint32_t n = head - cleared_at;
+    return n < TRACE_RING_EVENTS ? n : TRACE_RING_EVENTS;
+}
+
+uint32_t TraceRing::lost() const {
+    return head - cleared_at - count();
+}
+
+const TraceEvent& TraceRing::at(uint32_t i) const {
+    return events[(head - count() + i) & (TRACE_RING_EVENTS - 1)];
+}
+
+void TraceRing::clear() {
+    cleared_at = head;
+}
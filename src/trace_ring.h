@@ -0,0 +1,161 @@
+/**
+ * @file trace_ring.h
+ * @brief In-RAM event trace: begin/end spans and instants from every task
+ *
+ * The perf registry says how long things take on average; it cannot say why
+ * the queue overflowed at 12:03 or why the display froze for 300 ms. The
+ * trace ring keeps the last TRACE_RING_EVENTS events (span begin/end,
+ * instants and counter samples) with microsecond timestamps, the core and
+ * the task that recorded them. The serial "TRACE" command dumps it and
+ * tools/trace2chrome.py turns the dump into Chrome trace JSON, a timeline
+ * of both cores in chrome://tracing or ui.perfetto.dev.
+ *
+ * An event is 8 bytes. Writers reserve a slot with one atomic add and then
+ * fill it, so any task on either core can record without a lock; the
+ * oldest events are overwritten. The dump freezes recording first, so it
+ * does not race the writers (a writer preempted between reserving and
+ * filling its slot can leave one stale event; it is rare and harmless).
+ *
+ * The clock and the task/core lookup are supplied by the caller through
+ * setSource(), which keeps this file free of FreeRTOS. Trace points are
+ * the TRACE_* macros below so a build with -DTRACE_ENABLED=0 compiles
+ * every one of them out.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#ifndef TRACE_RING_EVENTS
+#define TRACE_RING_EVENTS 1024   // Power of two; 8 bytes each
+#endif
+
+// Event phases (Chrome trace "ph": B, E, i, C)
+enum TracePhase : uint8_t {
+    TRACE_PH_BEGIN = 0,
+    TRACE_PH_END,
+    TRACE_PH_INSTANT,
+    TRACE_PH_COUNTER,    // arg is the sampled value
+};
+
+// Trace points, in the order of trace_point_names[]. At most 64.
+enum TracePoint : uint8_t {
+    TRACE_PROCESS_EVENT = 0,   // detect: one queued event (arg: type)
+    TRACE_DISPLAY_UPDATE,      // loop: display.update()
+    TRACE_MUTEX_WAIT,          // any: waiting for displayMutex (end arg: 1 = taken)
+    TRACE_SD_FLUSH,            // display: detection log write
+    TRACE_SNAPSHOT_WRITE,      // loop: warm-restart snapshot store
+    TRACE_SNAPSHOT_ENCODE,     // detect: warm-restart snapshot encode
+    TRACE_BLE_SCAN_START,      // loop: pBLEScan->start()
+    TRACE_BLE_SCAN_STOP,       // loop: pBLEScan->stop()
+    TRACE_BLE_SCAN_BLOCKING,   // loop: legacy 1 s blocking scan
+    TRACE_CHANNEL_HOP,         // loop: esp_wifi_set_channel() (arg: channel)
+    TRACE_HEARTBEAT,           // loop: heartbeat_pulse()
+    TRACE_DETECT_BEEP,         // detect / loop: detection beep sequence
+    TRACE_STATS_OUTPUT,        // loop: [STATS] line and stats record
+    TRACE_GEO_UPDATE,          // loop: known-site query
+    TRACE_SIGPACK_CHECK,       // loop: signature pack poll / reload
+    TRACE_QUEUE_DROP,          // WiFi / BLE host: detection queue full (arg: type)
+    TRACE_DETECTION,           // detect: new device alerted (arg: type)
+    TRACE_BLE_MATCH,           // BLE host: matching advert queued
+    TRACE_QUEUE_DEPTH,         // detect: counter, events waiting
+    TRACE_POINT_COUNT
+};
+
+extern const char* const trace_point_names[TRACE_POINT_COUNT];
+
+struct TraceEvent {
+    uint32_t ts_us;      // Caller's clock, wraps every ~71 minutes
+    uint16_t arg;
+    uint8_t  point;      // TracePoint | phase << 6
+    uint8_t  track;      // core << 7 | task id
+
+    TracePoint tracePoint() const { return (TracePoint)(point & 0x3F); }
+    TracePhase phase() const { return (TracePhase)(point >> 6); }
+    uint8_t core() const { return track >> 7; }
+    uint8_t task() const { return track & 0x7F; }
+};
+
+class TraceRing {
+public:
+    typedef uint32_t (*ClockFn)();    // Microseconds
+    typedef uint8_t (*TrackFn)();     // core << 7 | task id of the caller
+
+    TraceRing();
+
+    void setSource(ClockFn clock, TrackFn track);
+
+    // Hot path: a few loads, one atomic add and an 8-byte store
+    inline void record(TracePoint p, TracePhase ph, uint16_t arg) {
+        if (recording) put(p, ph, arg, clock_fn());
+    }
+
+    // A span timed by the caller, recorded after the fact (e.g. only when it
+    // turned out long enough to matter). Events land out of order; readers
+    // sort by timestamp.
+    inline void recordSpan(TracePoint p, uint32_t begin_us, uint32_t end_us, uint16_t end_arg) {
+        if (!recording) return;
+        put(p, TRACE_PH_BEGIN, 0, begin_us);
+        put(p, TRACE_PH_END, end_arg, end_us);
+    }
+
+    // Dump: freeze() stops recording; read count() events oldest first with
+    // at(), then thaw(). lost() counts events overwritten before the dump.
+    void freeze() { recording = false; }
+    void thaw() { recording = clock_fn != nullptr && track_fn != nullptr; }
+    bool frozen() const { return !recording; }
+    uint32_t count() const;
+    uint32_t lost() const;
+    const TraceEvent& at(uint32_t i) const;
+
+    void clear();
+
+private:
+    inline void put(TracePoint p, TracePhase ph, uint16_t arg, uint32_t ts_us) {
+        uint32_t idx = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+        TraceEvent& e = events[idx & (TRACE_RING_EVENTS - 1)];
+        e.ts_us = ts_us;
+        e.arg = arg;
+        e.point = (uint8_t)(p | (ph << 6));
+        e.track = track_fn();
+    }
+
+    TraceEvent events[TRACE_RING_EVENTS];
+    uint32_t head;            // Events ever reserved
+    uint32_t cleared_at;      // head at the last clear()
+    volatile bool recording;
+    ClockFn clock_fn;
+    TrackFn track_fn;
+};
+
+static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0, "TRACE_RING_EVENTS must be a power of two");
+
+// The firmware's ring (main.cpp); the display handlers trace into it too
+extern TraceRing trace_ring;
+
+#if TRACE_ENABLED
+#define TRACE_BEGIN(p)           trace_ring.record((p), TRACE_PH_BEGIN, 0)
+#define TRACE_END(p)             trace_ring.record((p), TRACE_PH_END, 0)
+#define TRACE_END_ARG(p, a)      trace_ring.record((p), TRACE_PH_END, (uint16_t)(a))
+#define TRACE_BEGIN_ARG(p, a)    trace_ring.record((p), TRACE_PH_BEGIN, (uint16_t)(a))
+#define TRACE_INSTANT(p, a)      trace_ring.record((p), TRACE_PH_INSTANT, (uint16_t)(a))
+#define TRACE_COUNTER(p, v)      trace_ring.record((p), TRACE_PH_COUNTER, (uint16_t)(v))
+#define TRACE_SPAN(p, b, e, a)   trace_ring.recordSpan((p), (b), (e), (uint16_t)(a))
+#else
+#define TRACE_BEGIN(p)           do {} while (0)
+#define TRACE_END(p)             do {} while (0)
+#define TRACE_END_ARG(p, a)      do {} while (0)
+#define TRACE_BEGIN_ARG(p, a)    do {} while (0)
+#define TRACE_INSTANT(p, a)      do {} while (0)
+#define TRACE_COUNTER(p, v)      do {} while (0)
+#define TRACE_SPAN(p, b, e, a)   do {} while (0)
+#endif
+
+#endif // TRACE_RING_H
@@ -0,0 +1,41 @@
+/**
+ * @file tracked_device.h
+ * @brief Per-device tracking record shared by main.cpp, the 2.8" display and warm_snapshot
+ *
+ * One entry of main.cpp's open-addressed tracked_devices table. Times are
+ * millis() of the current boot; warm_snapshot stores them as ages and
+ * rebases them on restore.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef TRACKED_DEVICE_H
+#define TRACKED_DEVICE_H
+
+#include <stdint.h>
+#include "nmea_parser.h"
+#include "rssi_history.h"
+#include "rssi_track.h"
+
+struct TrackedDevice {
+    uint32_t mac_hash;           // FNV-1a hash (0 = empty slot)
+    uint8_t  mac[6];             // Full MAC for display/logging
+    int8_t   rssi_min;           // Weakest signal seen
+    int8_t   rssi_max;           // Strongest signal seen
+    int8_t   rssi_last;          // Most recent RSSI
+    int32_t  rssi_sum;           // Running sum for average
+    uint16_t hit_count;          // Total detections
+    uint8_t  last_channel;       // Channel last seen on
+    uint8_t  type;               // Last detection type
+    uint32_t first_seen;         // millis() of first detection
+    uint32_t last_seen;          // millis() of most recent detection
+    uint32_t probe_interval_sum; // Sum of inter-detection intervals (ms)
+    uint16_t probe_intervals;    // Count of intervals measured
+    GpsTag   first_fix;          // Position/UTC at first sighting
+    GpsTag   best_fix;           // Position/UTC at strongest RSSI
+    RssiTrack track;             // Filtered RSSI and drive-by phase
+    uint8_t  threat_score;       // Confidence rules' score at the latest sighting
+    RssiHistory history;         // Strongest RSSI per second, then per 4 s and 16 s
+};
+
+#endif // TRACKED_DEVICE_H
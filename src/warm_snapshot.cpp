@@ -0,0 +1,287 @@
+/**
+ * @file warm_snapshot.cpp
+ * @brief Snapshot encoder/decoder for warm restarts
+ *
+ * @see warm_snapshot.h
+ */
+
+#include "warm_snapshot.h"
+#include "sigpack.h"
+#include <string.h>
+
+static void wr16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void wr32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static uint16_t rd16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t rd32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+const char* snap_status_str(SnapStatus status) {
+    switch (status) {
+    case SNAP_OK:         return "ok";
+    case SNAP_ERR_SIZE:   return "bad size";
+    case SNAP_ERR_MAGIC:  return "bad magic";
+    case SNAP_ERR_FORMAT: return "unsupported format";
+    case SNAP_ERR_CRC:    return "CRC mismatch";
+    default:              return "unknown";
+    }
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+SnapshotWriter::SnapshotWriter(uint8_t* buffer, size_t capacity)
+    : buf(buffer), cap(capacity), pos(SNAP_HEADER_SIZE), record_start(SNAP_HEADER_SIZE),
+      section_start(0), section_records(0), sections(0), section_open(false), overflow(false),
+      section_full(true), dropped_records(0) {
+    if (cap < SNAP_HEADER_SIZE) pos = record_start = cap;
+}
+
+void SnapshotWriter::beginSection(uint8_t type, uint8_t version) {
+    section_records = 0;
+    overflow = false;
+    section_open = pos + SNAP_SECTION_SIZE <= cap;
+    section_full = !section_open;
+    if (!section_open) return;
+    section_start = pos;
+    buf[pos] = type;
+    buf[pos + 1] = version;
+    pos += SNAP_SECTION_SIZE;
+    record_start = pos;
+}
+
+void SnapshotWriter::endRecord() {
+    if (overflow || section_full) {
+        pos = record_start;
+        section_full = true;
+        overflow = false;
+        dropped_records++;
+        return;
+    }
+    section_records++;
+    record_start = pos;
+}
+
+void SnapshotWriter::endSection() {
+    if (!section_open) return;  // Its header did not fit
+    pos = record_start;  // Drop fields written after the last endRecord()
+    wr16(buf + section_start + 2, section_records);
+    wr32(buf + section_start + 4, (uint32_t)(pos - section_start - SNAP_SECTION_SIZE));
+    sections++;
+    section_open = false;
+    section_full = true;  // Until the next beginSection()
+}
+
+void SnapshotWriter::putBytes(const void* data, size_t len) {
+    if (overflow || section_full) return;
+    if (len > cap - pos) {
+        overflow = true;
+        return;
+    }
+    memcpy(buf + pos, data, len);
+    pos += len;
+}
+
+void SnapshotWriter::put8(uint8_t v) { putBytes(&v, 1); }
+void SnapshotWriter::put16(uint16_t v) { uint8_t b[2]; wr16(b, v); putBytes(b, 2); }
+void SnapshotWriter::put32(uint32_t v) { uint8_t b[4]; wr32(b, v); putBytes(b, 4); }
+
+void SnapshotWriter::putFloat(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, 4);
+    put32(bits);
+}
+
+void SnapshotWriter::putStr(const char* s) {
+    size_t len = s ? strlen(s) : 0;
+    if (len > 255) len = 255;
+    put8((uint8_t)len);
+    putBytes(s, len);
+}
+
+static void put_fix(SnapshotWriter& w, const GpsTag& fix) {
+    w.put32((uint32_t)fix.lat_e7);
+    w.put32((uint32_t)fix.lon_e7);
+    w.put32(fix.utc);
+    w.put8(fix.valid);
+}
+
+void SnapshotWriter::putDevice(uint8_t slot, const TrackedDevice& dev, uint32_t now) {
+    put8(slot);
+    putBytes(dev.mac, 6);
+    put8((uint8_t)dev.rssi_min);
+    put8((uint8_t)dev.rssi_max);
+    put8((uint8_t)dev.rssi_last);
+    put8(dev.threat_score);
+    put8(dev.last_channel);
+    put8(dev.type);
+    put16(dev.hit_count);
+    put16(dev.probe_intervals);
+    put32((uint32_t)dev.rssi_sum);
+    put32(dev.probe_interval_sum);
+    put32(now - dev.first_seen);
+    put32(now - dev.last_seen);
+    put_fix(*this, dev.first_fix);
+    put_fix(*this, dev.best_fix);
+    put16((uint16_t)dev.track.level_q8);
+    put16((uint16_t)dev.track.rate_q8);
+    put16((uint16_t)dev.track.peak_q8);
+    put16((uint16_t)dev.track.trough_q8);
+    put8(dev.track.hits);
+    put8(dev.track.phase);
+    put32(now - dev.track.last_ms);
+    put32(now - dev.track.peak_ms);
+}
+
+void SnapshotWriter::putSiteSlot(const SiteSlotState& state, uint32_t now) {
+    put8(state.root);
+    put8(state.lead);
+    put16(state.site_id);
+    put8((state.ble ? 1 : 0) | (state.passed ? 2 : 0));
+    put32(now - state.last_ms);
+    put32(now - state.peak_ms);
+}
+
+size_t SnapshotWriter::finish(const SnapHeader& header) {
+    if (cap < SNAP_HEADER_SIZE) return 0;
+    memcpy(buf, SNAP_MAGIC, 4);
+    wr16(buf + 4, SNAP_FORMAT);
+    wr16(buf + 6, sections);
+    wr32(buf + 8, header.seq);
+    wr32(buf + 12, header.clock_id);
+    wr32(buf + 16, header.clock_ms);
+    wr32(buf + 20, header.uptime_ms);
+    wr32(buf + 24, (uint32_t)(pos - SNAP_HEADER_SIZE));
+    uint32_t crc = sigpack_crc32(buf, 28);
+    wr32(buf + 28, sigpack_crc32(buf + SNAP_HEADER_SIZE, pos - SNAP_HEADER_SIZE, crc));
+    return pos;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+SnapshotReader::SnapshotReader()
+    : image(nullptr), image_len(0), next(0), pos(0), end(0), overrun(false), hdr() {}
+
+SnapStatus SnapshotReader::open(const uint8_t* img, size_t len) {
+    image = nullptr;
+    next = pos = end = 0;
+    overrun = false;
+    if (!img || len < SNAP_HEADER_SIZE) return SNAP_ERR_SIZE;
+    if (memcmp(img, SNAP_MAGIC, 4) != 0) return SNAP_ERR_MAGIC;
+    if (rd16(img + 4) != SNAP_FORMAT) return SNAP_ERR_FORMAT;
+    uint32_t payload = rd32(img + 24);
+    if (payload != len - SNAP_HEADER_SIZE) return SNAP_ERR_SIZE;
+    uint32_t crc = sigpack_crc32(img, 28);
+    if (sigpack_crc32(img + SNAP_HEADER_SIZE, payload, crc) != rd32(img + 28)) return SNAP_ERR_CRC;
+
+    hdr.seq = rd32(img + 8);
+    hdr.clock_id = rd32(img + 12);
+    hdr.clock_ms = rd32(img + 16);
+    hdr.uptime_ms = rd32(img + 20);
+    image = img;
+    image_len = len;
+    next = SNAP_HEADER_SIZE;
+    return SNAP_OK;
+}
+
+bool SnapshotReader::nextSection(uint8_t& type, uint8_t& version, uint16_t& count) {
+    if (!image || image_len - next < SNAP_SECTION_SIZE) return false;
+    const uint8_t* h = image + next;
+    uint32_t body = rd32(h + 4);
+    if (body > image_len - next - SNAP_SECTION_SIZE) {
+        next = image_len;  // The CRC matched, so only a writer bug gets here
+        return false;
+    }
+    type = h[0];
+    version = h[1];
+    count = rd16(h + 2);
+    pos = next + SNAP_SECTION_SIZE;
+    end = pos + body;
+    next = end;
+    overrun = false;
+    return true;
+}
+
+void SnapshotReader::getBytes(void* out, size_t len) {
+    if (overrun || len > end - pos) {
+        overrun = true;
+        memset(out, 0, len);
+        return;
+    }
+    memcpy(out, image + pos, len);
+    pos += len;
+}
+
+uint8_t SnapshotReader::get8() { uint8_t v; getBytes(&v, 1); return v; }
+uint16_t SnapshotReader::get16() { uint8_t b[2]; getBytes(b, 2); return rd16(b); }
+uint32_t SnapshotReader::get32() { uint8_t b[4]; getBytes(b, 4); return rd32(b); }
+
+float SnapshotReader::getFloat() {
+    uint32_t bits = get32();
+    float v;
+    memcpy(&v, &bits, 4);
+    return v;
+}
+
+void SnapshotReader::getStr(char* out, size_t cap) {
+    uint8_t len = get8();
+    size_t keep = len < cap ? len : cap - 1;
+    getBytes(out, keep);
+    out[keep] = '\0';
+    if (len > keep && !overrun) {
+        if ((size_t)(len - keep) > end - pos) overrun = true;
+        else pos += len - keep;
+    }
+}
+
+static GpsTag get_fix(SnapshotReader& r) {
+    GpsTag fix;
+    fix.lat_e7 = (int32_t)r.get32();
+    fix.lon_e7 = (int32_t)r.get32();
+    fix.utc = r.get32();
+    fix.valid = r.get8() != 0;
+    return fix;
+}
+
+uint8_t SnapshotReader::getDevice(TrackedDevice& dev, uint32_t base) {
+    memset(&dev, 0, sizeof(dev));
+    uint8_t slot = get8();
+    getBytes(dev.mac, 6);
+    dev.rssi_min = (int8_t)get8();
+    dev.rssi_max = (int8_t)get8();
+    dev.rssi_last = (int8_t)get8();
+    dev.threat_score = get8();
+    dev.last_channel = get8();
+    dev.type = get8();
+    dev.hit_count = get16();
+    dev.probe_intervals = get16();
+    dev.rssi_sum = (int32_t)get32();
+    dev.probe_interval_sum = get32();
+    dev.first_seen = base - get32();
+    dev.last_seen = base - get32();
+    dev.first_fix = get_fix(*this);
+    dev.best_fix = get_fix(*this);
+    dev.track.level_q8 = (int16_t)get16();
+    dev.track.rate_q8 = (int16_t)get16();
+    dev.track.peak_q8 = (int16_t)get16();
+    dev.track.trough_q8 = (int16_t)get16();
+    dev.track.hits = get8();
+    dev.track.phase = get8();
+    dev.track.last_ms = base - get32();
+    dev.track.peak_ms = base - get32();
+    return slot;
+}
+
+void SnapshotReader::getSiteSlot(SiteSlotState& state, uint32_t base) {
+    state.root = get8();
+    state.lead = get8();
+    state.site_id = get16();
+    uint8_t flags = get8();
+    state.ble = flags & 1;
+    state.passed = flags & 2;
+    state.last_ms = base - get32();
+    state.peak_ms = base - get32();
+}
@@ -0,0 +1,150 @@
+/**
+ * @file warm_snapshot.h
+ * @brief Versioned binary snapshot of tracking state for warm restarts
+ *
+ * A reboot or brown-out used to wipe the tracked-device table, the site
+ * groups, the channel memory and the display list, so after a restart mid
+ * route every camera still in range alerted again and the dwell policy had
+ * to relearn which channels carry cameras. main.cpp periodically encodes
+ * that state with SnapshotWriter, stores it (SD when present, else NVS) and
+ * decodes it with SnapshotReader in setup().
+ *
+ * Layout (little-endian):
+ *
+ *   header   32 B  magic "FYWS", format, section count, sequence number,
+ *                  clock id, clock ms, uptime ms, payload length, CRC-32
+ *                  of the header's first 28 bytes and the payload
+ *   sections 8 B header each (type, version, record count, body length)
+ *                  followed by the body
+ *
+ * Records are written field by field, so the image does not depend on
+ * struct padding and a section can be read back by a build whose structs
+ * have moved. Times are stored as ms before the snapshot was taken and
+ * rebased onto the new boot's millis() on restore, given the snapshot's
+ * age. The age comes from the RTC clock (clock ms), which only means
+ * something when the clock id matches the current boot's; the caller
+ * decides what to keep when it does not.
+ *
+ * The writer never overflows its buffer: a record that does not fit is
+ * dropped along with every record after it, and the section is closed with
+ * the records that did fit. Callers write the most valuable sections and
+ * records first. Readers skip section types and versions they do not know.
+ *
+ * No Arduino dependencies.
+ */
+
+#ifndef WARM_SNAPSHOT_H
+#define WARM_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tracked_device.h"
+#include "site_cluster.h"
+
+#define SNAP_MAGIC            "FYWS"
+#define SNAP_FORMAT           1
+#define SNAP_HEADER_SIZE      32
+#define SNAP_SECTION_SIZE     8
+#define SNAP_DEVICE_SIZE      77    // Bytes per putDevice() record
+#define SNAP_SITE_SLOT_SIZE   13    // Bytes per putSiteSlot() record
+
+// Section types
+#define SNAP_SEC_COUNTERS  1
+#define SNAP_SEC_DWELL     2
+#define SNAP_SEC_DEVICES   3    // Each record: a device, then its site slot if any
+#define SNAP_SEC_DISPLAY   4
+
+enum SnapStatus : uint8_t {
+    SNAP_OK = 0,
+    SNAP_ERR_SIZE,      // Truncated or inconsistent lengths
+    SNAP_ERR_MAGIC,
+    SNAP_ERR_FORMAT,    // Unsupported format version
+    SNAP_ERR_CRC,
+};
+
+const char* snap_status_str(SnapStatus status);
+
+struct SnapHeader {
+    uint32_t seq;        // Incremented per snapshot written
+    uint32_t clock_id;   // Identifies the RTC clock that clock_ms was read from
+    uint32_t clock_ms;   // RTC clock when taken
+    uint32_t uptime_ms;  // millis() when taken
+};
+
+class SnapshotWriter {
+public:
+    SnapshotWriter(uint8_t* buf, size_t cap);
+
+    void beginSection(uint8_t type, uint8_t version);
+    void endRecord();    // Commit the fields written since the last record
+    void endSection();   // Close with the committed records
+
+    void put8(uint8_t v);
+    void put16(uint16_t v);
+    void put32(uint32_t v);
+    void putFloat(float v);
+    void putBytes(const void* data, size_t len);
+    void putStr(const char* s);  // Length byte + up to 255 bytes, no NUL
+
+    // TrackedDevice / its site slot with times stored as ms before now. The
+    // site slot's MAC is the device's and is not written again.
+    void putDevice(uint8_t slot, const TrackedDevice& dev, uint32_t now);
+    void putSiteSlot(const SiteSlotState& state, uint32_t now);
+
+    // Fill in the header; returns the image size
+    size_t finish(const SnapHeader& header);
+
+    uint32_t dropped() const { return dropped_records; }  // Records that did not fit
+
+private:
+    uint8_t* buf;
+    size_t cap;
+    size_t pos;
+    size_t record_start;
+    size_t section_start;
+    uint16_t section_records;
+    uint16_t sections;
+    bool section_open;        // Section header written, not yet closed
+    bool overflow;            // Current record did not fit
+    bool section_full;        // Drop the rest of this section
+    uint32_t dropped_records;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader();
+
+    // Validate an image; sections are then read with nextSection()
+    SnapStatus open(const uint8_t* image, size_t len);
+    const SnapHeader& header() const { return hdr; }
+
+    // Advance to the next section; false at the end
+    bool nextSection(uint8_t& type, uint8_t& version, uint16_t& count);
+
+    uint8_t get8();
+    uint16_t get16();
+    uint32_t get32();
+    float getFloat();
+    void getBytes(void* out, size_t len);
+    void getStr(char* out, size_t cap);  // Always NUL-terminated, truncates
+
+    // Inverse of putDevice()/putSiteSlot(); stored ages are subtracted from
+    // base, the current millis() minus the snapshot's age. getDevice()
+    // returns the slot; getSiteSlot() leaves the MAC alone.
+    uint8_t getDevice(TrackedDevice& dev, uint32_t base);
+    void getSiteSlot(SiteSlotState& state, uint32_t base);
+
+    // False once a get ran past the end of the section (values read as 0)
+    bool ok() const { return !overrun; }
+
+private:
+    const uint8_t* image;
+    size_t image_len;
+    size_t next;          // Next section header
+    size_t pos;           // Read cursor in the current section
+    size_t end;           // End of the current section body
+    bool overrun;
+    SnapHeader hdr;
+};
+
+#endif // WARM_SNAPSHOT_H
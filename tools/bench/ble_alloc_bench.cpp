@@ -0,0 +1,479 @@
+/**
+ * @file ble_alloc_bench.cpp
+ * @brief Heap allocations per BLE advert, old and current onResult (Linux host)
+ *
+ * Replays a synthetic advert stream through two copies of the BLE scan
+ * callback body and counts every malloc/calloc/realloc made inside them:
+ *
+ * - old:      onResult as it was before the allocation-free rewrite
+ *             (NimBLEAddress::toString() + sscanf, getName() into a
+ *             std::string, two Arduino Strings for the debug display)
+ * - current:  handleAdvert() as in src/main.cpp (native address bytes,
+ *             BleMatcher name/payload pass into stack buffers, lossy debug
+ *             mailbox)
+ *
+ * Both run behind the real seen-cache (src/ble_seen_cache.cpp), so counts
+ * are per received and per forwarded advert like the firmware's probe.
+ *
+ * The NimBLE and Arduino types are host stand-ins that allocate the way the
+ * pinned libraries do on the target:
+ *
+ * - NimBLE-Arduino 1.4: getAddress() and haveName() do not allocate;
+ *   toString() formats into a char[18] and returns std::string (17
+ *   characters); getName() returns a std::string built from the AD field
+ * - libstdc++ std::string keeps up to 15 characters inline, on the 32-bit
+ *   target as on the host
+ * - arduino-esp32 2.x String keeps up to 13 characters inline (15-byte SSO
+ *   buffer) and grows its heap buffer with realloc
+ *
+ * malloc, calloc and realloc are interposed over glibc's, so allocations
+ * made inside libstdc++ are counted too.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/ble_alloc_bench.cpp src/ble_matcher.cpp \
+ *       src/ble_seen_cache.cpp -o ble_alloc_bench
+ * Run:
+ *   ./ble_alloc_bench [--adverts N] [--devices N] [--seed N]
+ */
+
+#include "ble_matcher.h"
+#include "ble_seen_cache.h"
+
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+// ============================================================================
+// ALLOCATION COUNTER
+// ============================================================================
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+
+static bool counting = false;
+static uint32_t allocs = 0;
+
+extern "C" void* malloc(size_t size) {
+    if (counting) allocs++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+    if (counting) allocs++;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+    if (counting) allocs++;
+    return __libc_realloc(p, size);
+}
+
+// ============================================================================
+// TARGET LIBRARY STAND-INS
+// ============================================================================
+
+// arduino-esp32 2.x WString: inline below SSO_MAX + 1 characters, else a
+// realloc'd buffer rounded up to 16 bytes
+class String {
+public:
+    explicit String(const char* c) {
+        size_t n = strlen(c);
+        if (n <= SSO_MAX) {
+            memcpy(sso, c, n + 1);
+        } else {
+            heap = (char*)realloc(nullptr, (n + 16) & ~(size_t)0xF);
+            memcpy(heap, c, n + 1);
+        }
+    }
+    String(const String& o) : String(o.c_str()) {}
+    ~String() { free(heap); }
+    const char* c_str() const { return heap ? heap : sso; }
+
+private:
+    static const size_t SSO_MAX = 13;
+    char sso[SSO_MAX + 1];
+    char* heap = nullptr;
+};
+
+class NimBLEAddress {
+public:
+    explicit NimBLEAddress(const uint8_t* native) { memcpy(m_address, native, 6); }
+    const uint8_t* getNative() const { return m_address; }
+    std::string toString() const {
+        char buffer[18];
+        snprintf(buffer, sizeof(buffer), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 m_address[5], m_address[4], m_address[3], m_address[2], m_address[1], m_address[0]);
+        return std::string(buffer);
+    }
+
+private:
+    uint8_t m_address[6];   // Little-endian, as NimBLE stores it
+};
+
+struct Advert {
+    uint8_t native[6];
+    uint8_t len;
+    uint8_t data[31];
+    int8_t rssi;
+    uint8_t kind;   // Index into kinds[]
+};
+
+class NimBLEAdvertisedDevice {
+public:
+    explicit NimBLEAdvertisedDevice(const Advert& a) : adv(a) {}
+    NimBLEAddress getAddress() const { return NimBLEAddress(adv.native); }
+    const uint8_t* getPayload() const { return adv.data; }
+    size_t getPayloadLength() const { return adv.len; }
+    int getRSSI() const { return adv.rssi; }
+    bool haveName() const { return findName() != nullptr; }
+    std::string getName() const {
+        const uint8_t* f = findName();
+        if (f && f[0] > 1) return std::string((const char*)f + 2, f[0] - 1);
+        return "";
+    }
+
+private:
+    // Complete (0x09) or shortened (0x08) local name AD structure
+    const uint8_t* findName() const {
+        for (uint8_t pos = 0; pos + 1 < adv.len && adv.data[pos]; pos += 1 + adv.data[pos]) {
+            if (adv.data[pos + 1] == 0x09 || adv.data[pos + 1] == 0x08) return &adv.data[pos];
+        }
+        return nullptr;
+    }
+
+    const Advert& adv;
+};
+
+// ============================================================================
+// SHARED FIRMWARE STATE
+// ============================================================================
+
+static const char* mac_prefixes[] = {
+    "58:8e:81", "cc:cc:cc", "ec:1b:bd", "90:35:ea", "04:0d:84",
+    "f0:82:c0", "1c:34:f1", "38:5b:44", "94:34:69", "b4:e3:f9",
+    "70:c9:4e", "3c:91:80", "d8:f3:bc", "80:30:49", "14:5a:fc",
+    "74:4c:a1", "08:3a:88", "9c:2f:9d", "94:08:53", "e4:aa:ea"
+};
+#define MAC_PREFIX_COUNT (sizeof(mac_prefixes) / sizeof(mac_prefixes[0]))
+
+static const char* device_name_patterns[] = { "fs ext battery", "penguin", "flock", "pigvision" };
+
+static const BleRule ble_payload_rules[] = {
+    { "penguin_mfg_id", BLE_RULE_MFG_ID, 0x09C8, 0, 0, {}, {} },
+};
+
+static bool check_device_name_pattern(const char* name) {
+    for (size_t i = 0; i < sizeof(device_name_patterns) / sizeof(device_name_patterns[0]); i++) {
+        if (strcasestr(name, device_name_patterns[i])) return true;
+    }
+    return false;
+}
+
+struct DetectionEvent {
+    uint8_t mac[6];
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t type;
+    const BleRule* rule;
+    int32_t mfg_id;
+};
+
+// Stand-ins for xQueueSend (copies into a preallocated ring) and the
+// display's showDebugBLE(String, String, int8_t), a no-op on both boards
+static DetectionEvent queue_ring[16];
+static uint32_t queue_sent = 0;
+static void queue_send(const DetectionEvent& evt) { queue_ring[queue_sent++ % 16] = evt; }
+static void showDebugBLE(String name, String mac, int8_t rssi) { (void)name; (void)mac; (void)rssi; }
+
+static uint32_t now_ms = 0;
+static uint32_t forwarded = 0;   // By the seen-cache, per path
+static uint32_t detected = 0;    // Events queued, per path
+
+// ============================================================================
+// OLD CALLBACK (before the allocation-free rewrite)
+// ============================================================================
+
+static BleSeenCache old_seen;
+
+static bool old_check_mac_prefix(const uint8_t* mac) {
+    char mac_str[9];
+    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x", mac[0], mac[1], mac[2]);
+    for (size_t i = 0; i < MAC_PREFIX_COUNT; i++) {
+        if (strncasecmp(mac_str, mac_prefixes[i], 8) == 0) return true;
+    }
+    return false;
+}
+
+static void old_on_result(NimBLEAdvertisedDevice* advertisedDevice) {
+    NimBLEAddress addr = advertisedDevice->getAddress();
+    if (!old_seen.check(addr.getNative(), advertisedDevice->getPayload(),
+                        (uint8_t)advertisedDevice->getPayloadLength(), now_ms)) {
+        return;
+    }
+    forwarded++;
+
+    std::string addrStr = addr.toString();
+    unsigned int m[6];
+    uint8_t mac[6];
+    sscanf(addrStr.c_str(), "%02x:%02x:%02x:%02x:%02x:%02x", &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]);
+    for (int i = 0; i < 6; i++) mac[i] = (uint8_t)m[i];
+
+    int rssi = advertisedDevice->getRSSI();
+    std::string name = "";
+    if (advertisedDevice->haveName()) {
+        name = advertisedDevice->getName();
+    }
+
+    bool mac_match = old_check_mac_prefix(mac);
+    bool name_match = !name.empty() && check_device_name_pattern(name.c_str());
+
+    if (!mac_match && !name_match) {
+        showDebugBLE(String(name.c_str()), String(addrStr.c_str()), rssi);
+        return;
+    }
+
+    DetectionEvent evt;
+    memcpy(evt.mac, mac, 6);
+    strncpy(evt.ssid, name.c_str(), 32);
+    evt.ssid[32] = '\0';
+    evt.rssi = rssi;
+    evt.channel = 0;
+    evt.type = mac_match ? 2 : 3;
+    evt.rule = nullptr;
+    evt.mfg_id = -1;
+    queue_send(evt);
+    detected++;
+}
+
+// ============================================================================
+// CURRENT CALLBACK (src/main.cpp handleAdvert)
+// ============================================================================
+
+static BleSeenCache cur_seen;
+static BleMatcher ble_matcher;
+static uint8_t mac_prefix_bytes[MAC_PREFIX_COUNT][3];
+
+struct BleDebugSample {
+    uint8_t mac[6];
+    char name[21];
+    int8_t rssi;
+};
+static BleDebugSample ble_debug_sample;
+static bool ble_debug_ready = false;
+
+static bool check_mac_prefix(const uint8_t* mac) {
+    for (size_t i = 0; i < MAC_PREFIX_COUNT; i++) {
+        if (mac[0] == mac_prefix_bytes[i][0] && mac[1] == mac_prefix_bytes[i][1] &&
+            mac[2] == mac_prefix_bytes[i][2]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void handle_advert(NimBLEAdvertisedDevice* advertisedDevice) {
+    NimBLEAddress addr = advertisedDevice->getAddress();
+    if (!cur_seen.check(addr.getNative(), advertisedDevice->getPayload(),
+                        (uint8_t)advertisedDevice->getPayloadLength(), now_ms)) {
+        return;
+    }
+    forwarded++;
+
+    const uint8_t* native = addr.getNative();
+    uint8_t mac[6];
+    for (int i = 0; i < 6; i++) mac[i] = native[5 - i];
+
+    char name[33];
+    int32_t company = -1;
+    const BleRule* rule = ble_matcher.match(advertisedDevice->getPayload(),
+                                            advertisedDevice->getPayloadLength(),
+                                            name, sizeof(name), &company);
+    int rssi = advertisedDevice->getRSSI();
+
+    bool mac_match = check_mac_prefix(mac);   // No signature pack: watchlist empty
+    bool name_match = name[0] && check_device_name_pattern(name);
+
+    if (!mac_match && !name_match && !rule) {
+        if (!ble_debug_ready) {
+            memcpy(ble_debug_sample.mac, mac, 6);
+            strncpy(ble_debug_sample.name, name, sizeof(ble_debug_sample.name) - 1);
+            ble_debug_sample.name[sizeof(ble_debug_sample.name) - 1] = '\0';
+            ble_debug_sample.rssi = rssi;
+            ble_debug_ready = true;
+        }
+        return;
+    }
+
+    DetectionEvent evt;
+    memcpy(evt.mac, mac, 6);
+    memcpy(evt.ssid, name, sizeof(evt.ssid));
+    evt.rssi = rssi;
+    evt.channel = 0;
+    evt.type = mac_match ? 2 : (name_match ? 3 : 5);
+    evt.rule = rule;
+    evt.mfg_id = company;
+    queue_send(evt);
+    detected++;
+}
+
+// ============================================================================
+// ADVERT STREAM
+// ============================================================================
+
+// Advertiser kinds on a busy street; names chosen around the inline limits
+// (String 13, std::string 15 characters)
+struct Kind {
+    const char* label;
+    int share;             // Percent of devices
+    const char* name;      // nullptr: no local name
+    uint16_t company;      // Manufacturer data company ID, 0: none
+    bool flock_oui;        // Address under a listed prefix
+};
+
+static const Kind kinds[] = {
+    { "phone, no name",       45, nullptr,                      0x004C, false },
+    { "wearable, 6 chars",    15, "Band 7",                     0,      false },
+    { "earbuds, 16 chars",    12, "Galaxy Buds2 Pro",           0x0075, false },
+    { "TV, 26 chars",         10, "[TV] Samsung 7 Series (55)", 0,      false },
+    { "tracker, 10 chars",    12, "WH-1000XM4",                 0x0157, false },
+    { "Penguin, 12 chars",     3, "Penguin-3101",               0x09C8, false },
+    { "FS battery, 14 chars",  3, "FS Ext Battery",             0,      true  },
+};
+#define KIND_COUNT (sizeof(kinds) / sizeof(kinds[0]))
+
+static void put_field(Advert& a, uint8_t type, const uint8_t* data, uint8_t n) {
+    if (a.len + 2 + n > (int)sizeof(a.data)) return;
+    a.data[a.len++] = n + 1;
+    a.data[a.len++] = type;
+    memcpy(&a.data[a.len], data, n);
+    a.len += n;
+}
+
+static Advert make_device(uint8_t k, std::mt19937& rng) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    const Kind& kind = kinds[k];
+
+    Advert a = {};
+    a.kind = k;
+    for (int i = 0; i < 6; i++) a.native[i] = byte(rng);
+    if (kind.flock_oui) {
+        a.native[5] = 0x58; a.native[4] = 0x8e; a.native[3] = 0x81;
+    }
+    uint8_t flags = 0x06;
+    put_field(a, 0x01, &flags, 1);
+    if (kind.company) {
+        uint8_t mfg[8] = { (uint8_t)(kind.company & 0xFF), (uint8_t)(kind.company >> 8) };
+        for (int i = 2; i < 8; i++) mfg[i] = byte(rng);
+        put_field(a, 0xFF, mfg, 8);
+    }
+    if (kind.name) put_field(a, 0x09, (const uint8_t*)kind.name, (uint8_t)strlen(kind.name));
+    return a;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+struct PathStats {
+    uint32_t forwarded, detected, allocs;
+};
+
+struct KindStats {
+    uint32_t received;
+    PathStats old_path, cur_path;
+};
+
+// One callback run on one advert, counters charged to `into`
+static void run(void (*callback)(NimBLEAdvertisedDevice*), NimBLEAdvertisedDevice& dev,
+                PathStats& into, PathStats& total) {
+    forwarded = detected = allocs = 0;
+    counting = true;
+    callback(&dev);
+    counting = false;
+    into.forwarded += forwarded;
+    into.detected += detected;
+    into.allocs += allocs;
+    total.forwarded += forwarded;
+    total.detected += detected;
+    total.allocs += allocs;
+}
+
+static double per(uint32_t allocs, uint32_t n) { return n ? (double)allocs / n : 0.0; }
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--adverts N] [--devices N] [--seed N]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    uint32_t adverts = 200000, devices = 150, seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--adverts")) adverts = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--devices")) devices = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoul(argv[++i], nullptr, 10);
+        else usage(argv[0]);
+    }
+    if (devices < 1) devices = 1;
+
+    for (size_t i = 0; i < MAC_PREFIX_COUNT; i++) {
+        unsigned a = 0, b = 0, c = 0;
+        sscanf(mac_prefixes[i], "%x:%x:%x", &a, &b, &c);
+        mac_prefix_bytes[i][0] = a; mac_prefix_bytes[i][1] = b; mac_prefix_bytes[i][2] = c;
+    }
+    ble_matcher.compile(ble_payload_rules, 1);
+
+    // The fleet follows the kinds' shares; devices advertise in random
+    // order, and some rotate a manufacturer data byte now and then, which
+    // gets them past the seen-cache
+    std::mt19937 rng(seed);
+    std::vector<Advert> fleet(devices);
+    uint8_t k = 0;
+    int cumulative = kinds[0].share;
+    for (uint32_t i = 0; i < devices; i++) {
+        while (k + 1 < (int)KIND_COUNT && i * 100 >= cumulative * devices) cumulative += kinds[++k].share;
+        fleet[i] = make_device(k, rng);
+    }
+    std::uniform_int_distribution<uint32_t> pick(0, devices - 1);
+    std::uniform_int_distribution<int> pct(0, 99);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    KindStats stats[KIND_COUNT] = {};
+    PathStats old_total = {}, cur_total = {};
+
+    for (uint32_t n = 0; n < adverts; n++) {
+        Advert& a = fleet[pick(rng)];
+        if (pct(rng) < 10 && a.len > 8 && a.data[4] == 0xFF) a.data[8] = byte(rng);
+        a.rssi = (int8_t)(-40 - pct(rng) / 2);
+        now_ms += 2;
+
+        NimBLEAdvertisedDevice dev(a);
+        KindStats& ks = stats[a.kind];
+        ks.received++;
+        run(old_on_result, dev, ks.old_path, old_total);
+        run(handle_advert, dev, ks.cur_path, cur_total);
+        ble_debug_ready = false;   // loop() drains the mailbox between adverts
+    }
+
+    printf("adverts %u, devices %u, forwarded %u (%.1f%%), detections old %u / new %u\n",
+           adverts, devices, cur_total.forwarded, cur_total.forwarded * 100.0 / adverts,
+           old_total.detected, cur_total.detected);
+    printf("%-22s %9s %9s %9s\n", "advertiser", "received", "old/fwd", "new/fwd");
+    for (size_t i = 0; i < KIND_COUNT; i++) {
+        const KindStats& ks = stats[i];
+        if (!ks.received) continue;
+        printf("%-22s %9u %9.2f %9.2f\n", kinds[i].label, ks.received,
+               per(ks.old_path.allocs, ks.old_path.forwarded), per(ks.cur_path.allocs, ks.cur_path.forwarded));
+    }
+    printf("%-22s %9u %9.2f %9.2f\n", "all", adverts,
+           per(old_total.allocs, old_total.forwarded), per(cur_total.allocs, cur_total.forwarded));
+    printf("per received advert: old %.2f, new %.2f\n",
+           per(old_total.allocs, adverts), per(cur_total.allocs, adverts));
+    return cur_total.allocs == 0 ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file ble_match_bench.cpp
+ * @brief BLE payload matcher benchmark on a synthetic advert stream (Linux host)
+ *
+ * Generates a stream of advertisements shaped like a busy street (phones,
+ * trackers, exposure notification beacons, wearables, a sprinkling of
+ * Penguin units) and times two matchers over it:
+ *
+ * - table:  BleMatcher from src/ble_matcher.cpp (one AD pass, binary search
+ *           keyed by company ID / service UUID)
+ * - naive:  for every rule, walk the AD structures looking for its field
+ *           (what per-rule NimBLE accessor calls amount to)
+ *
+ * Both must agree on every advert; the run aborts otherwise.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/ble_match_bench.cpp src/ble_matcher.cpp -o ble_match_bench
+ * Run:
+ *   ./ble_match_bench [--adverts N] [--rules N] [--seed N]
+ */
+
+#include "ble_matcher.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define ADV_MAX 31
+
+struct Advert {
+    uint8_t len;
+    uint8_t data[ADV_MAX];
+};
+
+struct BenchConfig {
+    uint32_t adverts = 200000;
+    uint32_t rules = 16;
+    uint32_t seed = 1;
+};
+
+// Append one AD structure; returns false if it doesn't fit in 31 bytes
+static bool put_field(Advert& a, uint8_t type, const uint8_t* data, uint8_t n) {
+    if (a.len + 2 + n > ADV_MAX) return false;
+    a.data[a.len++] = n + 1;
+    a.data[a.len++] = type;
+    memcpy(&a.data[a.len], data, n);
+    a.len += n;
+    return true;
+}
+
+static Advert make_advert(std::mt19937& rng) {
+    static const uint16_t companies[] = { 0x004C, 0x0006, 0x0075, 0x00E0, 0x0087, 0x0157 };
+    static const uint16_t services[] = { 0xFD6F, 0xFE9F, 0x180F, 0x181A, 0xFEAA };
+    std::uniform_int_distribution<int> pct(0, 99);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    Advert a;
+    a.len = 0;
+    uint8_t flags = 0x06;
+    put_field(a, 0x01, &flags, 1);
+
+    int kind = pct(rng);
+    uint8_t buf[ADV_MAX];
+    if (kind < 2) {
+        // Penguin: manufacturer data 0x09C8 + opaque bytes, name
+        buf[0] = 0xC8; buf[1] = 0x09;
+        for (int i = 2; i < 10; i++) buf[i] = byte(rng);
+        put_field(a, 0xFF, buf, 10);
+        put_field(a, 0x09, (const uint8_t*)"Penguin-3101", 12);
+    } else if (kind < 50) {
+        // Phone/tracker manufacturer data
+        uint16_t c = companies[pct(rng) % 6];
+        buf[0] = c & 0xFF; buf[1] = c >> 8;
+        uint8_t n = 4 + pct(rng) % 20;
+        for (int i = 2; i < n; i++) buf[i] = byte(rng);
+        put_field(a, 0xFF, buf, n);
+    } else if (kind < 75) {
+        // Service UUID list + service data (exposure notification, Eddystone)
+        uint16_t u = services[pct(rng) % 5];
+        buf[0] = u & 0xFF; buf[1] = u >> 8;
+        put_field(a, 0x03, buf, 2);
+        for (int i = 2; i < 20; i++) buf[i] = byte(rng);
+        put_field(a, 0x16, buf, 20);
+    } else {
+        // Wearable: name + battery service
+        uint8_t u[2] = { 0x0F, 0x18 };
+        put_field(a, 0x03, u, 2);
+        put_field(a, 0x09, (const uint8_t*)"Band 7", 6);
+    }
+    return a;
+}
+
+// Rule set: Penguin first, then filler rules on IDs that never appear so
+// every lookup pays for the full table
+static std::vector<BleRule> make_rules(uint32_t count) {
+    std::vector<BleRule> rules;
+    BleRule penguin = {};
+    penguin.name = "penguin_mfg_id";
+    penguin.kind = BLE_RULE_MFG_ID;
+    penguin.id = 0x09C8;
+    rules.push_back(penguin);
+
+    for (uint32_t i = 1; i < count; i++) {
+        BleRule r = {};
+        r.name = "filler";
+        r.kind = (uint8_t)(i % 4);
+        r.id = (uint16_t)(0x7000 + i);
+        if (r.kind == BLE_RULE_MFG_DATA || r.kind == BLE_RULE_SERVICE_DATA) {
+            r.len = 2;
+            r.value[0] = 0xAA; r.value[1] = 0x55;
+            r.mask[0] = 0xFF; r.mask[1] = 0xFF;
+        }
+        rules.push_back(r);
+    }
+    return rules;
+}
+
+// Per-rule scan: find the field the rule cares about, then compare
+static const BleRule* naive_match(const std::vector<BleRule>& rules, const Advert& a) {
+    for (const BleRule& r : rules) {
+        size_t pos = 0;
+        while (pos + 1 < a.len) {
+            uint8_t flen = a.data[pos];
+            if (flen == 0 || pos + 1 + flen > a.len) break;
+            uint8_t type = a.data[pos + 1];
+            const uint8_t* d = &a.data[pos + 2];
+            uint8_t dlen = flen - 1;
+            bool hit = false;
+
+            if ((r.kind == BLE_RULE_MFG_ID || r.kind == BLE_RULE_MFG_DATA) && type == 0xFF && dlen >= 2 &&
+                (d[0] | (d[1] << 8)) == r.id) {
+                hit = true;
+                for (uint8_t i = 0; r.kind == BLE_RULE_MFG_DATA && i < r.len; i++) {
+                    if (2 + r.offset + i >= dlen ||
+                        (d[2 + r.offset + i] & r.mask[i]) != (r.value[i] & r.mask[i])) hit = false;
+                }
+            } else if (r.kind == BLE_RULE_SERVICE_UUID && (type == 0x02 || type == 0x03)) {
+                for (uint8_t i = 0; i + 1 < dlen; i += 2) {
+                    if ((d[i] | (d[i + 1] << 8)) == r.id) hit = true;
+                }
+            } else if (r.kind == BLE_RULE_SERVICE_DATA && type == 0x16 && dlen >= 2 &&
+                       (d[0] | (d[1] << 8)) == r.id) {
+                hit = true;
+                for (uint8_t i = 0; i < r.len; i++) {
+                    if (2 + r.offset + i >= dlen ||
+                        (d[2 + r.offset + i] & r.mask[i]) != (r.value[i] & r.mask[i])) hit = false;
+                }
+            }
+            if (hit) return &r;
+            pos += 1 + flen;
+        }
+    }
+    return nullptr;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--adverts N] [--rules N] [--seed N]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--adverts")) cfg.adverts = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--rules")) cfg.rules = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed")) cfg.seed = strtoul(argv[++i], nullptr, 10);
+        else usage(argv[0]);
+    }
+    if (cfg.rules < 1) cfg.rules = 1;
+    if (cfg.rules > BLE_MATCHER_MAX_RULES) cfg.rules = BLE_MATCHER_MAX_RULES;
+
+    std::mt19937 rng(cfg.seed);
+    std::vector<Advert> stream(cfg.adverts);
+    for (Advert& a : stream) a = make_advert(rng);
+
+    std::vector<BleRule> rules = make_rules(cfg.rules);
+    BleMatcher matcher;
+    if (!matcher.compile(rules.data(), (uint16_t)rules.size())) {
+        fprintf(stderr, "compile failed\n");
+        return 1;
+    }
+
+    // Correctness: both matchers agree on every advert (rules are disjoint)
+    uint32_t hits = 0;
+    char name[33];
+    for (const Advert& a : stream) {
+        const BleRule* t = matcher.match(a.data, a.len, name, sizeof(name));
+        const BleRule* n = naive_match(rules, a);
+        if (t != n) {
+            fprintf(stderr, "mismatch: table=%s naive=%s\n", t ? t->name : "-", n ? n->name : "-");
+            return 1;
+        }
+        if (t) hits++;
+    }
+
+    using clock = std::chrono::steady_clock;
+    const int passes = 5;
+    volatile uintptr_t sink = 0;
+
+    auto t0 = clock::now();
+    for (int p = 0; p < passes; p++) {
+        for (const Advert& a : stream) sink ^= (uintptr_t)matcher.match(a.data, a.len, name, sizeof(name));
+    }
+    auto t1 = clock::now();
+    for (int p = 0; p < passes; p++) {
+        for (const Advert& a : stream) sink ^= (uintptr_t)naive_match(rules, a);
+    }
+    auto t2 = clock::now();
+
+    double n = (double)cfg.adverts * passes;
+    double table_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double naive_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+
+    printf("adverts %u, rules %u, matches %u (%.2f%%)\n",
+           cfg.adverts, cfg.rules, hits, hits * 100.0 / cfg.adverts);
+    printf("%-8s %10s\n", "matcher", "ns/advert");
+    printf("%-8s %10.1f   (includes name extraction)\n", "table", table_ns);
+    printf("%-8s %10.1f\n", "naive", naive_ns);
+    (void)sink;
+    return 0;
+}
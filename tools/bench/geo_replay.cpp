@@ -0,0 +1,189 @@
+/**
+ * @file geo_replay.cpp
+ * @brief Replay a GPX track against a camera geo index (Linux host)
+ *
+ * Opens an index built by tools/geoindex.py through src/geo_index.cpp,
+ * reading the file with fseek/fread like the firmware reads SD, and feeds
+ * it every <trkpt> of a GPX track as a position fix:
+ *
+ * - checks each query against a brute-force scan of all sites
+ * - reports query latency (cached block vs block load), file reads per
+ *   block load, and the alerts a drive along the track would raise
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/geo_replay.cpp src/geo_index.cpp \
+ *       src/sigpack.cpp src/mac_watchlist.cpp src/ble_matcher.cpp src/rule_vm.cpp -o geo_replay
+ * Run:
+ *   ./geo_replay cameras.fygi drive.gpx [--radius M] [--sd-read-us N]
+ */
+
+#include "geo_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct FileCtx {
+    FILE* f;
+};
+
+static bool file_read(void* ctx, uint32_t offset, void* buf, uint32_t len) {
+    FILE* f = ((FileCtx*)ctx)->f;
+    return fseek(f, offset, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+struct Point {
+    int32_t lat_e7;
+    int32_t lon_e7;
+};
+
+// <trkpt lat=".." lon=".."> in any attribute order; nothing else is parsed
+static std::vector<Point> read_gpx(const char* path) {
+    std::vector<Point> pts;
+    FILE* f = fopen(path, "r");
+    if (!f) return pts;
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+
+    size_t pos = 0;
+    while ((pos = text.find("<trkpt", pos)) != std::string::npos) {
+        size_t end = text.find('>', pos);
+        std::string tag = text.substr(pos, end - pos);
+        size_t la = tag.find("lat=\"");
+        size_t lo = tag.find("lon=\"");
+        if (la != std::string::npos && lo != std::string::npos) {
+            double lat = atof(tag.c_str() + la + 5);
+            double lon = atof(tag.c_str() + lo + 5);
+            pts.push_back({ (int32_t)lround(lat * 1e7), (int32_t)lround(lon * 1e7) });
+        }
+        pos = end;
+    }
+    return pts;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s INDEX GPX [--radius M] [--sd-read-us N]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) usage(argv[0]);
+    const char* index_path = argv[1];
+    const char* gpx_path = argv[2];
+    uint32_t radius = 300;
+    double sd_read_us = 600;
+    for (int i = 3; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--radius")) radius = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--sd-read-us")) sd_read_us = atof(argv[++i]);
+        else usage(argv[0]);
+    }
+
+    FileCtx ctx = { fopen(index_path, "rb") };
+    if (!ctx.f) {
+        perror(index_path);
+        return 1;
+    }
+    fseek(ctx.f, 0, SEEK_END);
+    uint32_t file_len = ftell(ctx.f);
+
+    GeoIndex index;
+    SigPackStatus status = index.open(file_read, &ctx, file_len, true);
+    if (status != SIGPACK_OK) {
+        fprintf(stderr, "%s: %s\n", index_path, sigpack_status_str(status));
+        return 1;
+    }
+    if (radius > index.maxRadius()) {
+        fprintf(stderr, "radius clamped to the index maximum of %u m\n", index.maxRadius());
+        radius = index.maxRadius();
+    }
+
+    std::vector<Point> track = read_gpx(gpx_path);
+    if (track.empty()) {
+        fprintf(stderr, "%s: no track points\n", gpx_path);
+        return 1;
+    }
+
+    // Every site, for the brute-force reference (sites follow the slot table)
+    uint8_t hdr[GEO_INDEX_HEADER_SIZE];
+    file_read(&ctx, 0, hdr, sizeof(hdr));
+    uint32_t slots = hdr[16] | (hdr[17] << 8) | (hdr[18] << 16) | ((uint32_t)hdr[19] << 24);
+    std::vector<uint8_t> site_bytes((size_t)index.siteCount() * GEO_SITE_SIZE);
+    file_read(&ctx, GEO_INDEX_HEADER_SIZE + slots * GEO_SLOT_SIZE, site_bytes.data(), site_bytes.size());
+    std::vector<Point> sites(index.siteCount());
+    for (uint32_t i = 0; i < index.siteCount(); i++) {
+        memcpy(&sites[i].lat_e7, &site_bytes[i * GEO_SITE_SIZE], 4);
+        memcpy(&sites[i].lon_e7, &site_bytes[i * GEO_SITE_SIZE + 4], 4);
+    }
+
+    using clock = std::chrono::steady_clock;
+    std::vector<double> cached_ns, load_ns;
+    uint32_t mismatches = 0, truncated = 0, alerts = 0, in_range = 0;
+    int32_t last_lat = 0, last_lon = 0;
+    bool have_last = false;
+
+    for (const Point& p : track) {
+        GeoResult r;
+        uint32_t loads = index.blockLoads();
+        auto t0 = clock::now();
+        bool ok = index.query(p.lat_e7, p.lon_e7, radius, r);
+        auto t1 = clock::now();
+        if (!ok) {
+            fprintf(stderr, "read error\n");
+            return 1;
+        }
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        (index.blockLoads() != loads ? load_ns : cached_ns).push_back(ns);
+        truncated += r.truncated;
+
+        // Brute force with the same flat-earth distance
+        float lon_scale = 0.0111319f * cosf(p.lat_e7 * 1e-7f * (float)M_PI / 180.0f);
+        uint32_t expect = 0;
+        for (const Point& s : sites) {
+            float dy = (float)(s.lat_e7 - p.lat_e7) * 0.0111319f;
+            float dx = (float)(s.lon_e7 - p.lon_e7) * lon_scale;
+            expect += dx * dx + dy * dy <= (float)radius * radius;
+        }
+        if (expect != r.count && !r.truncated) mismatches++;
+
+        // One alert per newly nearest site, as the firmware does
+        if (r.count) {
+            in_range++;
+            if (!have_last || r.nearest.lat_e7 != last_lat || r.nearest.lon_e7 != last_lon) {
+                alerts++;
+                last_lat = r.nearest.lat_e7;
+                last_lon = r.nearest.lon_e7;
+                have_last = true;
+            }
+        }
+    }
+    fclose(ctx.f);
+
+    double reads_per_load = index.blockLoads() ? (double)index.reads() / index.blockLoads() : 0;
+    printf("%s: %u sites in %u cells, max radius %u m\n", index_path, index.siteCount(),
+           index.cellCount(), index.maxRadius());
+    printf("%s: %zu fixes, radius %u m\n", gpx_path, track.size(), radius);
+    printf("brute-force mismatches: %u (%u fixes in truncated blocks)\n", mismatches, truncated);
+    printf("fixes with a site in range: %u, alerts (new nearest site): %u\n", in_range, alerts);
+    printf("cached block:  %zu queries, p50 %.0f ns, p99 %.0f ns, max %.0f ns\n", cached_ns.size(),
+           percentile(cached_ns, 0.5), percentile(cached_ns, 0.99), percentile(cached_ns, 1.0));
+    printf("block load:    %zu queries, p50 %.0f ns, p99 %.0f ns, max %.0f ns\n", load_ns.size(),
+           percentile(load_ns, 0.5), percentile(load_ns, 0.99), percentile(load_ns, 1.0));
+    printf("reads per block load: %.1f (SD estimate @ %.0f us/read: %.1f ms)\n",
+           reads_per_load, sd_read_us, reads_per_load * sd_read_us / 1000);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,314 @@
+/**
+ * @file nmea_bench.cpp
+ * @brief NMEA parser check and benchmark (Linux host)
+ *
+ * Runs src/nmea_parser.cpp the way the firmware does, one byte at a time:
+ *
+ * - a table of hand-checked sentences (hemispheres, midnight rollover, bad
+ *   checksums, truncated and overlong lines, other sentence types)
+ * - every recorded NMEA file given, checking each fix the parser reports
+ *   against a floating-point parse of the same sentence and the number of
+ *   sentences it accepts against an independent checksum scan
+ * - parse cost per byte and what that is at the GPS's baud rate
+ *
+ * --tty reads a live device or the pty printed by tools/nmea_sim.py instead
+ * and prints each fix, for end-to-end runs without a receiver.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/nmea_bench.cpp src/nmea_parser.cpp -o nmea_bench
+ * Run:
+ *   ./nmea_bench tools/bench/drive_sample.nmea [--reps N] [--baud N]
+ *   ./nmea_bench --tty /dev/pts/5 [--seconds N]
+ */
+
+#include "nmea_parser.h"
+
+#include <chrono>
+#include <ctype.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+static std::string sentence(const char* body) {
+    uint8_t sum = 0;
+    for (const char* p = body; *p; p++) sum ^= (uint8_t)*p;
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+    return std::string("$") + body + tail;
+}
+
+static int feed_all(NmeaParser& p, const std::string& text) {
+    int updates = 0;
+    for (char c : text) updates += p.feed(c);
+    return updates;
+}
+
+static int failures = 0;
+
+static void expect(bool cond, const char* what) {
+    if (!cond) {
+        printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void self_test() {
+    const char* rmc = "GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W";
+    const char* gga = "GPGGA,123520,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,";
+    {
+        NmeaParser p;
+        expect(feed_all(p, sentence(rmc)) == 1, "RMC accepted");
+        const GpsFix& f = p.fix();
+        expect(f.valid, "RMC valid");
+        expect(f.lat_e7 == 481173000, "RMC latitude");
+        expect(f.lon_e7 == 115166667, "RMC longitude");
+        expect(f.utc == 764426119, "RMC date and time");
+        expect(f.speed_cms == 1152, "RMC speed");
+        expect(feed_all(p, sentence(gga)) == 1, "GGA accepted");
+        expect(f.utc == 764426120, "GGA time on RMC date");
+        expect(f.sats == 8 && f.hdop_x10 == 9 && f.alt_dm == 5454 && f.quality == 1, "GGA quality fields");
+        expect(p.sentences() == 2 && p.checksumErrors() == 0 && p.malformed() == 0, "RMC/GGA counters");
+    }
+    {
+        NmeaParser p;
+        feed_all(p, sentence("GNRMC,010203.00,A,3351.6500,S,15112.5000,W,0.0,,010120,,,A"));
+        expect(p.fix().lat_e7 == -338608333 && p.fix().lon_e7 == -1512083333, "S/W hemispheres, GN talker");
+    }
+    {
+        NmeaParser p;
+        feed_all(p, sentence("GPRMC,235959,A,4807.038,N,01131.000,E,0,0,311224,,"));
+        feed_all(p, sentence("GPGGA,000001,4807.038,N,01131.000,E,1,05,1.2,10.0,M,,M,,"));
+        expect(p.fix().utc == 1735689601, "GGA after midnight rolls the date");
+    }
+    {
+        NmeaParser p;
+        std::string s = sentence(rmc);
+        s[10] = '9';
+        expect(feed_all(p, s) == 0 && p.checksumErrors() == 1, "corrupted byte fails checksum");
+        expect(!p.fix().valid, "no fix from a bad sentence");
+    }
+    {
+        NmeaParser p;
+        std::string s = sentence(rmc);
+        for (size_t i = s.find('*'); i < s.size(); i++) s[i] = tolower(s[i]);
+        expect(feed_all(p, s) == 1, "lower-case checksum digits");
+    }
+    {
+        NmeaParser p;
+        feed_all(p, sentence("GPRMC,123519,V,,,,,,,230394,,,N"));
+        expect(!p.fix().valid && p.fix().utc == 764426119 && p.sentences() == 1, "RMC status V: time, no fix");
+    }
+    {
+        NmeaParser p;
+        std::string s = sentence(rmc);
+        std::string text = s.substr(0, 20) + "\r\n" + sentence(gga);
+        expect(feed_all(p, text) == 1 && p.malformed() == 1, "truncated line dropped, next one parsed");
+        text = s.substr(0, 30) + sentence(gga);
+        expect(feed_all(p, text) == 1 && p.malformed() == 2, "'$' mid-sentence restarts");
+    }
+    {
+        NmeaParser p;
+        feed_all(p, sentence("GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00"));
+        expect(p.ignored() == 1 && p.sentences() == 0, "other sentence types ignored");
+        std::string longline = "GPRMC," + std::string(100, '1');
+        feed_all(p, sentence(longline.c_str()));
+        expect(p.malformed() == 1, "overlong sentence dropped");
+        feed_all(p, sentence("GPRMC,123519,A,48x7.038,N,01131.000,E,0,0,230394,,"));
+        expect(p.malformed() == 2 && !p.fix().valid, "bad coordinate rejected");
+        const char noise[] = "\xff\x00garbage*12\r\n";
+        feed_all(p, std::string(noise, sizeof(noise) - 1));
+        expect(p.sentences() == 0, "noise without '$' ignored");
+    }
+}
+
+// Independent reference: every "$...*hh" with a good checksum, parsed with strtod
+struct RefSentence {
+    size_t end;        // Offset just past the checksum
+    bool position;     // Carries a fix
+    double lat, lon;
+};
+
+static double ref_coord(const std::string& v, const std::string& hemi) {
+    double x = strtod(v.c_str(), nullptr);
+    double deg = floor(x / 100);
+    double r = deg + (x - deg * 100) / 60;
+    return hemi == "S" || hemi == "W" ? -r : r;
+}
+
+static std::vector<RefSentence> reference(const std::string& text) {
+    std::vector<RefSentence> out;
+    size_t pos = 0;
+    while ((pos = text.find('$', pos)) != std::string::npos) {
+        size_t star = text.find_first_of("*$\r\n", pos + 1);
+        if (star == std::string::npos || text[star] != '*' || star + 2 >= text.size() ||
+            star - pos - 1 > NMEA_MAX_SENTENCE) {
+            pos++;
+            continue;
+        }
+        std::string body = text.substr(pos + 1, star - pos - 1);
+        uint8_t sum = 0;
+        for (char c : body) sum ^= (uint8_t)c;
+        unsigned check;
+        if (sscanf(text.substr(star + 1, 2).c_str(), "%2x", &check) != 1 || check != sum) {
+            pos++;
+            continue;
+        }
+        std::vector<std::string> f;
+        size_t a = 0;
+        for (size_t b; (b = body.find(',', a)) != std::string::npos; a = b + 1) f.push_back(body.substr(a, b - a));
+        f.push_back(body.substr(a));
+        bool rmc = f[0].size() == 5 && f[0].compare(2, 3, "RMC") == 0 && f.size() >= 10;
+        bool gga = f[0].size() == 5 && f[0].compare(2, 3, "GGA") == 0 && f.size() >= 10;
+        if (rmc || gga) {
+            RefSentence r = { star + 3, false, 0, 0 };
+            if (rmc && f[2] == "A") {
+                r.position = true;
+                r.lat = ref_coord(f[3], f[4]);
+                r.lon = ref_coord(f[5], f[6]);
+            } else if (gga && atoi(f[6].c_str()) > 0) {
+                r.position = true;
+                r.lat = ref_coord(f[2], f[3]);
+                r.lon = ref_coord(f[4], f[5]);
+            }
+            out.push_back(r);
+        }
+        pos = star;
+    }
+    return out;
+}
+
+static bool read_file(const char* path, std::string& text) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+static int run_tty(const char* path, int seconds) {
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 5;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    NmeaParser p;
+    uint32_t fixes = 0;
+    auto stop = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    char buf[256];
+    while (std::chrono::steady_clock::now() < stop) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0) break;
+        for (ssize_t i = 0; i < n; i++) {
+            if (!p.feed(buf[i])) continue;
+            const GpsFix& f = p.fix();
+            if (!f.valid) continue;
+            fixes++;
+            printf("fix %.7f %.7f utc %u sats %u hdop %.1f speed %.1f m/s\n", f.lat_e7 * 1e-7,
+                   f.lon_e7 * 1e-7, f.utc, f.sats, f.hdop_x10 / 10.0, f.speed_cms / 100.0);
+        }
+    }
+    close(fd);
+    printf("%s: %u fixes, %u sentences, %u checksum errors, %u malformed, %u ignored\n", path, fixes,
+           p.sentences(), p.checksumErrors(), p.malformed(), p.ignored());
+    return fixes ? 0 : 1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [FILE.nmea...] [--reps N] [--baud N]\n"
+                    "       %s --tty PATH [--seconds N]\n", prog, prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> files;
+    const char* tty = nullptr;
+    int seconds = 30;
+    uint32_t reps = 200;
+    uint32_t baud = 9600;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+            continue;
+        }
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--tty")) tty = argv[++i];
+        else if (!strcmp(argv[i], "--seconds")) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--reps")) reps = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--baud")) baud = strtoul(argv[++i], nullptr, 10);
+        else usage(argv[0]);
+    }
+    if (tty) return run_tty(tty, seconds);
+
+    self_test();
+    printf("self-test: %s\n", failures ? "FAILED" : "passed");
+
+    for (const char* path : files) {
+        std::string text;
+        if (!read_file(path, text)) {
+            perror(path);
+            return 1;
+        }
+        std::vector<RefSentence> ref = reference(text);
+
+        // Byte-at-a-time pass, checking each update against the reference
+        NmeaParser p;
+        size_t next = 0;
+        uint32_t mismatches = 0, fixes = 0;
+        double worst_err = 0;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (!p.feed(text[i])) continue;
+            while (next < ref.size() && ref[next].end < i + 1) next++;
+            if (next == ref.size() || ref[next].end != i + 1) {
+                mismatches++;  // Parser accepted something the reference did not
+                continue;
+            }
+            const RefSentence& r = ref[next++];
+            const GpsFix& f = p.fix();
+            if (f.valid != r.position) {
+                mismatches++;
+                continue;
+            }
+            if (!f.valid) continue;
+            fixes++;
+            double err = fmax(fabs(f.lat_e7 * 1e-7 - r.lat), fabs(f.lon_e7 * 1e-7 - r.lon));
+            if (err > worst_err) worst_err = err;
+            if (err > 1.5e-7) mismatches++;
+        }
+        if (p.sentences() != ref.size()) mismatches++;
+
+        using clock = std::chrono::steady_clock;
+        volatile uint32_t sink = 0;
+        auto t0 = clock::now();
+        for (uint32_t r = 0; r < reps; r++) {
+            NmeaParser q;
+            for (char c : text) sink += q.feed(c);
+        }
+        auto t1 = clock::now();
+        (void)sink;
+        double ns_byte = std::chrono::duration<double, std::nano>(t1 - t0).count() / ((double)reps * text.size());
+
+        printf("%s: %zu bytes, %u sentences (%u fixes), %u checksum errors, %u malformed, %u ignored\n",
+               path, text.size(), p.sentences(), fixes, p.checksumErrors(), p.malformed(), p.ignored());
+        printf("  reference mismatches: %u, worst position error %.1e deg\n", mismatches, worst_err);
+        printf("  %.1f ns/byte; at %u baud (%u B/s) that is %.4f%% of one host core\n", ns_byte, baud,
+               baud / 10, ns_byte * (baud / 10) / 1e7);
+        if (mismatches) failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file oui_index_bench.cpp
+ * @brief Flash OUI index check and benchmark against the SD oui.csv search (Linux host)
+ *
+ * Loads an index built by tools/mkflashindex.py through the firmware parser
+ * and:
+ *
+ * - confirms every prefix in oui.csv resolves to the same vendor the SD
+ *   lookup returns (first match, text after the first comma)
+ * - times vendor lookups through FlashIndex vs the byte-offset binary search
+ *   that DisplayHandler::lookupOUIFromSD runs over oui.csv
+ * - counts the seeks and 512 B sectors the SD search touches per lookup,
+ *   which is what dominates on the device (each is an SPI sector read)
+ *
+ * The host reads oui.csv from the page cache, so the SD column here is the
+ * search alone; --sd-read-us turns the sector count into a device estimate.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/oui_index_bench.cpp src/flash_index.cpp \
+ *       src/sigpack.cpp src/mac_watchlist.cpp src/ble_matcher.cpp src/rule_vm.cpp -o oui_index_bench
+ * Run:
+ *   ./oui_index_bench fyindex.bin oui.csv [--queries N] [--seed N] [--sd-read-us N]
+ */
+
+#include "flash_index.h"
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+struct SdStats {
+    uint64_t seeks = 0;
+    uint64_t sectors = 0;
+};
+
+// Port of lookupOUIFromSD: binary search on byte offsets, resyncing to the
+// first line starting at or after mid. prefix is "aa:bb:cc", lower case.
+static bool sd_lookup(FILE* f, long file_size, const char* prefix, char* out, size_t out_size,
+                      SdStats& stats) {
+    long low = 0, high = file_size;
+    char line[128];
+    std::set<long> touched;
+    bool found = false;
+
+    while (low < high) {
+        long mid = (low + high) / 2;
+        fseek(f, mid > 0 ? mid - 1 : 0, SEEK_SET);
+        stats.seeks++;
+        int c = 0;
+        if (mid > 0) {
+            while ((c = fgetc(f)) != EOF && c != '\n') {}
+        }
+        long line_start = ftell(f);
+        if (c == EOF || line_start >= high || !fgets(line, sizeof(line), f)) {
+            high = mid;
+            continue;
+        }
+        for (long s = mid / 512; s <= ftell(f) / 512; s++) touched.insert(s);
+        size_t len = strcspn(line, "\r\n");
+        line[len] = '\0';
+        if (len < 8) {
+            high = mid;
+            continue;
+        }
+
+        int cmp = strncasecmp(prefix, line, 8);
+        if (cmp == 0) {
+            const char* comma = strchr(line, ',');
+            if (comma) snprintf(out, out_size, "%s", comma + 1);
+            found = comma != nullptr;
+            break;
+        } else if (cmp < 0) {
+            high = mid;
+        } else {
+            low = ftell(f);
+        }
+    }
+    stats.sectors += touched.size();
+    return found;
+}
+
+static std::string trim(const char* s) {
+    std::string r(s);
+    size_t a = r.find_first_not_of(" \t");
+    size_t b = r.find_last_not_of(" \t");
+    return a == std::string::npos ? "" : r.substr(a, b - a + 1);
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s INDEX OUI_CSV [--queries N] [--seed N] [--sd-read-us N]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) usage(argv[0]);
+    const char* index_path = argv[1];
+    const char* csv_path = argv[2];
+    uint32_t queries = 200000;
+    uint32_t seed = 1;
+    double sd_read_us = 600;
+    for (int i = 3; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--queries")) queries = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--sd-read-us")) sd_read_us = atof(argv[++i]);
+        else usage(argv[0]);
+    }
+
+    FILE* f = fopen(index_path, "rb");
+    if (!f) {
+        perror(index_path);
+        return 1;
+    }
+    std::vector<uint8_t> image;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) image.insert(image.end(), buf, buf + n);
+    fclose(f);
+
+    FlashIndex index;
+    SigPackStatus status = index.attach(image.data(), image.size(), true);
+    if (status != SIGPACK_OK) {
+        fprintf(stderr, "%s: %s\n", index_path, sigpack_status_str(status));
+        return 1;
+    }
+
+    FILE* csv = fopen(csv_path, "rb");
+    if (!csv) {
+        perror(csv_path);
+        return 1;
+    }
+    fseek(csv, 0, SEEK_END);
+    long csv_size = ftell(csv);
+
+    // Every distinct prefix in the CSV, in file order
+    std::vector<std::string> prefixes;
+    std::vector<std::string> vendors;
+    rewind(csv);
+    char line[128];
+    while (fgets(line, sizeof(line), csv)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* comma = strchr(line, ',');
+        if (!comma || comma - line != 8) continue;
+        *comma = '\0';
+        if (!prefixes.empty() && strcasecmp(prefixes.back().c_str(), line) == 0) continue;
+        prefixes.push_back(line);
+        vendors.push_back(trim(comma + 1));
+    }
+
+    uint32_t mismatches = 0;
+    for (size_t i = 0; i < prefixes.size(); i++) {
+        unsigned a, b, c;
+        sscanf(prefixes[i].c_str(), "%x:%x:%x", &a, &b, &c);
+        uint8_t mac[3] = { (uint8_t)a, (uint8_t)b, (uint8_t)c };
+        const char* v = index.vendor(mac);
+        if (!v || vendors[i] != v) mismatches++;
+    }
+
+    // Half known prefixes, half random (mostly unassigned) ones
+    std::mt19937 rng(seed);
+    std::vector<std::array<uint8_t, 3>> probes(queries);
+    std::vector<std::string> probe_text(queries);
+    for (uint32_t i = 0; i < queries; i++) {
+        unsigned a, b, c;
+        if (i & 1) {
+            sscanf(prefixes[rng() % prefixes.size()].c_str(), "%x:%x:%x", &a, &b, &c);
+        } else {
+            uint32_t r = rng();
+            a = r & 0xFF; b = (r >> 8) & 0xFF; c = (r >> 16) & 0xFF;
+        }
+        probes[i] = { (uint8_t)a, (uint8_t)b, (uint8_t)c };
+        char text[9];
+        snprintf(text, sizeof(text), "%02x:%02x:%02x", a, b, c);
+        probe_text[i] = text;
+    }
+
+    using clock = std::chrono::steady_clock;
+    volatile uintptr_t sink = 0;
+    uint32_t index_hits = 0;
+    auto t0 = clock::now();
+    for (const auto& p : probes) {
+        const char* v = index.vendor(p.data());
+        index_hits += v != nullptr;
+        sink += (uintptr_t)v;
+    }
+    auto t1 = clock::now();
+    SdStats sd;
+    uint32_t sd_hits = 0;
+    char vendor[96];
+    for (const auto& p : probe_text) sd_hits += sd_lookup(csv, csv_size, p.c_str(), vendor, sizeof(vendor), sd);
+    auto t2 = clock::now();
+    (void)sink;
+    fclose(csv);
+
+    double index_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / queries;
+    double sd_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / queries;
+    double sectors = (double)sd.sectors / queries;
+
+    printf("%s: %u OUIs, %zu bytes (signature pack %zu bytes)\n", index_path, index.ouiCount(),
+           index.imageSize(), index.packSize());
+    printf("prefixes matching %s: %zu/%zu\n", csv_path, prefixes.size() - mismatches, prefixes.size());
+    printf("hits (of %u):         index %u, SD search %u\n", queries, index_hits, sd_hits);
+    printf("flash index:          %.1f ns/lookup\n", index_ns);
+    printf("SD binary search:     %.1f ns/lookup on host, %.1f seeks, %.1f sectors\n",
+           sd_ns, (double)sd.seeks / queries, sectors);
+    printf("SD estimate @ %.0f us/sector: %.1f ms/lookup\n", sd_read_us, sectors * sd_read_us / 1000);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file perf_bench.cpp
+ * @brief Histogram percentile error and recording cost (Linux host)
+ *
+ * Feeds src/perf_registry.cpp log-normal samples shaped like the firmware's
+ * latencies (sniffer callback ~2 us, event processing ~150 us, SD flushes
+ * ~20 ms with a long tail) and compares the reported p50/p90/p99 with the
+ * exact values from the sorted samples. The reported value is the upper
+ * edge of a power-of-two bucket, so it should never be below the exact one
+ * and at most twice it.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/perf_bench.cpp src/perf_registry.cpp -o perf_bench
+ * Run:
+ *   ./perf_bench [--samples N] [--seed N]
+ */
+
+#include "perf_registry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Shape {
+    const char* name;
+    double median;   // In the histogram's unit
+    double sigma;    // Of the underlying normal
+};
+
+static const Shape shapes[] = {
+    { "sniffer_cb (ns)",    2000, 0.5 },
+    { "process_event (us)",  150, 0.8 },
+    { "sd_write (us)",     20000, 1.2 },
+};
+
+int main(int argc, char** argv)
+{
+    size_t samples = 200000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--samples") && i + 1 < argc) samples = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: %s [--samples N] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    const uint8_t pcts[] = { 50, 90, 99 };
+    bool bounded = true;
+
+    printf("%-20s %6s %10s %10s %7s\n", "shape", "pct", "exact", "reported", "ratio");
+    for (const Shape& shape : shapes) {
+        std::lognormal_distribution<double> dist(log(shape.median), shape.sigma);
+        std::vector<uint32_t> values(samples);
+        PerfHistogram h;
+        h.clear();
+        for (size_t i = 0; i < samples; i++) {
+            values[i] = (uint32_t)std::min(dist(rng), 4e9);
+            h.record(values[i]);
+        }
+        std::sort(values.begin(), values.end());
+        for (uint8_t pct : pcts) {
+            size_t rank = (samples * pct + 99) / 100;
+            uint32_t exact = values[rank ? rank - 1 : 0];
+            uint32_t reported = h.percentile(pct);
+            double ratio = exact ? (double)reported / exact : 1.0;
+            if (reported < exact || ratio > 2.0) bounded = false;
+            printf("%-20s %5u%% %10u %10u %7.2f\n", shape.name, pct, exact, reported, ratio);
+        }
+        if (h.count != samples || h.max != values.back()) bounded = false;
+    }
+    printf("percentiles within [exact, 2x exact]: %s\n", bounded ? "yes" : "NO");
+
+    // Recording cost: what the sniffer callback pays per frame
+    std::vector<uint32_t> input(1 << 16);
+    std::lognormal_distribution<double> dist(log(2000), 0.5);
+    for (uint32_t& v : input) v = (uint32_t)dist(rng);
+    PerfHistogram h;
+    h.clear();
+    const size_t rounds = 400;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (uint32_t v : input) h.record(v);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (rounds * input.size());
+    printf("record: %.2f ns per sample, %u bytes per histogram (p50 %u)\n",
+           ns, (unsigned)sizeof(PerfHistogram), h.percentile(50));
+    return bounded ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file rssi_track_bench.cpp
+ * @brief RSSI proximity filter simulation and benchmark (Linux host)
+ *
+ * Drives src/rssi_track.cpp with simulated sightings and scores its events:
+ *
+ * - drive-bys: a camera passed at 8-25 m/s with a closest approach of
+ *   10-60 m; log-distance path loss, 4 dB shadowing and occasional deep
+ *   fades; sightings either as WiFi beacon bursts while the hopper is on the
+ *   camera's channel or as ~1 Hz BLE adverts (the seen-cache rate)
+ * - parked: the same radios at a fixed 30-80 m for two minutes, where any
+ *   approach or closest event is a false alarm
+ *
+ * A fixed regression case runs first: a steady 4 dB/s approach, then 19 s
+ * of silence (just under RSSI_RESET_MS) and the device back at the level it
+ * was last heard at. The rate must stay sane and no closest/depart pair
+ * may fire off the gap; the bench exits non-zero otherwise.
+ *
+ * The same sightings also go through a raw peak detector (closest point =
+ * first sighting 4 dB under the running raw maximum), which is roughly what
+ * the old rssi_max - rssi_min trend amounted to.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/rssi_track_bench.cpp src/rssi_track.cpp -o rssi_track_bench
+ * Run:
+ *   ./rssi_track_bench [--passes N] [--parked N] [--sigma DB] [--seed N]
+ */
+
+#include "rssi_track.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Sighting {
+    uint32_t ms;
+    int8_t rssi;
+};
+
+struct Sim {
+    std::mt19937 rng;
+    double sigma;
+    bool wifi;
+    uint32_t hop_phase;
+
+    double rssi_at(double d) {
+        std::normal_distribution<double> shadow(0, sigma);
+        std::uniform_real_distribution<double> u(0, 1);
+        double r = -35 - 27 * log10(std::max(d, 1.0)) + shadow(rng);
+        if (u(rng) < 0.03) r -= 12;  // Deep fade
+        return r;
+    }
+
+    // Sighting times over [t0, t1] ms: beacon bursts on a ~1 s hop cycle, or ~1 Hz BLE
+    std::vector<uint32_t> times(uint32_t t0, uint32_t t1) {
+        std::vector<uint32_t> out;
+        std::uniform_real_distribution<double> u(0, 1);
+        if (wifi) {
+            for (uint32_t t = t0 + hop_phase; t < t1; t += 1000) {
+                for (uint32_t b = 0; b < 250; b += 102) {
+                    if (u(rng) < 0.7) out.push_back(t + b);
+                }
+            }
+        } else {
+            std::exponential_distribution<double> gap(1.0 / 1000);
+            for (double t = t0 + gap(rng); t < t1; t += 250 + gap(rng) * 0.75) {
+                if (u(rng) < 0.8) out.push_back((uint32_t)t);
+            }
+        }
+        return out;
+    }
+};
+
+struct Score {
+    uint32_t runs = 0, approach_early = 0, closest = 0, depart = 0, false_events = 0;
+    std::vector<double> peak_err_s, latency_s;
+};
+
+static double pct(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+// Raw peak detector: closest at the first sighting 4 dB under the raw maximum
+struct RawPeak {
+    int8_t max = -128;
+    uint32_t max_ms = 0, hits = 0;
+    bool fired = false;
+    bool update(int8_t rssi, uint32_t ms) {
+        hits++;
+        if (rssi > max) {
+            max = rssi;
+            max_ms = ms;
+            fired = false;  // A new maximum re-arms it: each later dip is another "closest"
+            return false;
+        }
+        if (!fired && hits >= RSSI_MIN_HITS && rssi <= max - 4) {
+            fired = true;
+            return true;
+        }
+        return false;
+    }
+};
+
+// Approach, long silence, same level again: nothing happened, so the only
+// acceptable event is the approach itself
+static bool long_gap_case() {
+    RssiTrack t = {};
+    uint32_t ms = 100000;
+    t.reset(-90, ms);
+    for (int i = 1; i <= 40; i++) {   // -90 -> -50 dBm over 10 s
+        ms += 250;
+        t.update((int8_t)(-90 + i), ms);
+    }
+    bool ok = true;
+    ms += 19000;
+    for (int i = 0; i < 20; i++) {    // Back at -50 dBm for 5 s
+        RssiEvent e = t.update(-50, ms);
+        if (e == RSSI_EVENT_CLOSEST || e == RSSI_EVENT_DEPART) ok = false;
+        if (t.rate_q8 > 8 * 256 || t.rate_q8 < -8 * 256) ok = false;
+        ms += 250;
+    }
+    printf("long gap: level %d dBm, rate %+.1f dB/s, phase %s: %s\n", t.levelDbm(),
+           t.rateDeciDbPerS() / 10.0, rssi_phase_name((RssiPhase)t.phase), ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--passes N] [--parked N] [--sigma DB] [--seed N]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    uint32_t passes = 2000, parked = 1000, seed = 1;
+    double sigma = 4;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--passes")) passes = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--parked")) parked = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--sigma")) sigma = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoul(argv[++i], nullptr, 10);
+        else usage(argv[0]);
+    }
+
+    if (!long_gap_case()) return 1;
+
+    Sim sim{ std::mt19937(seed), sigma, true, 0 };
+    std::uniform_real_distribution<double> u(0, 1);
+    Score filt[2], raw[2];  // [wifi, ble]
+    const uint32_t base = 100000;  // Keep times positive
+    std::vector<Sighting> all;
+
+    for (uint32_t p = 0; p < passes; p++) {
+        sim.wifi = p & 1;
+        sim.hop_phase = (uint32_t)(u(sim.rng) * 1000);
+        double v = 8 + u(sim.rng) * 17;
+        double d0 = 10 + u(sim.rng) * 50;
+        double span_ms = 400 / v * 1000;  // From 400 m out to 400 m past
+        uint32_t cpa = base + (uint32_t)span_ms;
+
+        RssiTrack t = {};
+        RawPeak rp;
+        Score& fs = filt[sim.wifi ? 0 : 1];
+        Score& rs = raw[sim.wifi ? 0 : 1];
+        fs.runs++;
+        rs.runs++;
+        bool approached = false, closest = false, departed = false, raw_closest = false;
+        uint32_t last = base;
+        for (uint32_t ms : sim.times(base, base + (uint32_t)(2 * span_ms))) {
+            double x = ((double)ms - cpa) / 1000 * v;
+            double r = sim.rssi_at(sqrt(d0 * d0 + x * x));
+            if (r < -95) continue;  // Below sensitivity
+            int8_t rssi = (int8_t)lround(std::max(r, -127.0));
+            all.push_back({ ms, rssi });
+            RssiEvent e = t.hits ? t.update(rssi, ms) : (t.reset(rssi, ms), RSSI_EVENT_NONE);
+            if (e == RSSI_EVENT_APPROACH && !approached) {
+                approached = true;
+                fs.approach_early += ms < cpa;
+            } else if (e == RSSI_EVENT_CLOSEST && !closest) {
+                closest = true;
+                fs.closest++;
+                fs.peak_err_s.push_back(fabs((double)t.peak_ms - cpa) / 1000);
+                fs.latency_s.push_back(((double)ms - cpa) / 1000);
+            } else if (e == RSSI_EVENT_DEPART) {
+                departed = true;
+            }
+            if (rp.update(rssi, ms)) {
+                if (!raw_closest) {
+                    raw_closest = true;
+                    rs.closest++;
+                    rs.peak_err_s.push_back(fabs((double)rp.max_ms - cpa) / 1000);
+                    rs.latency_s.push_back(((double)ms - cpa) / 1000);
+                } else {
+                    rs.false_events++;
+                }
+            }
+            last = ms;
+        }
+        if (!departed && t.expire(last + RSSI_LOST_MS) == RSSI_EVENT_DEPART) departed = true;
+        fs.depart += departed;
+    }
+
+    // Parked devices: events are false alarms
+    uint32_t parked_filter[2] = { 0, 0 }, parked_raw[2] = { 0, 0 };
+    double parked_hours = parked * 120.0 / 3600;
+    for (uint32_t p = 0; p < parked; p++) {
+        sim.wifi = p & 1;
+        sim.hop_phase = (uint32_t)(u(sim.rng) * 1000);
+        double d = 30 + u(sim.rng) * 50;
+        RssiTrack t = {};
+        RawPeak rp;
+        for (uint32_t ms : sim.times(base, base + 120000)) {
+            double r = sim.rssi_at(d);
+            if (r < -95) continue;
+            int8_t rssi = (int8_t)lround(r);
+            RssiEvent e = t.hits ? t.update(rssi, ms) : (t.reset(rssi, ms), RSSI_EVENT_NONE);
+            parked_filter[sim.wifi ? 0 : 1] += e == RSSI_EVENT_APPROACH || e == RSSI_EVENT_CLOSEST;
+            parked_raw[sim.wifi ? 0 : 1] += rp.update(rssi, ms);
+        }
+    }
+
+    printf("%u drive-bys, %u parked devices, shadowing sigma %.1f dB\n\n", passes, parked, sigma);
+    const char* names[2] = { "WiFi bursts", "BLE ~1 Hz" };
+    for (int k = 0; k < 2; k++) {
+        Score& f = filt[k];
+        Score& r = raw[k];
+        printf("%s:\n", names[k]);
+        printf("  filter: approach before CPA %4.1f%%, closest %5.1f%%, depart %5.1f%%\n",
+               100.0 * f.approach_early / f.runs, 100.0 * f.closest / f.runs, 100.0 * f.depart / f.runs);
+        printf("          peak time error p50 %.1f s p90 %.1f s, closest reported p50 %+.1f s p90 %+.1f s after CPA\n",
+               pct(f.peak_err_s, 0.5), pct(f.peak_err_s, 0.9), pct(f.latency_s, 0.5), pct(f.latency_s, 0.9));
+        printf("          parked false events: %.1f per device-hour\n", parked_filter[k] / (parked_hours / 2));
+        printf("  raw:    closest %5.1f%%, extra closest events %.1f per pass\n",
+               100.0 * r.closest / r.runs, (double)r.false_events / r.runs);
+        printf("          peak time error p50 %.1f s p90 %.1f s, closest reported p50 %+.1f s p90 %+.1f s after CPA\n",
+               pct(r.peak_err_s, 0.5), pct(r.peak_err_s, 0.9), pct(r.latency_s, 0.5), pct(r.latency_s, 0.9));
+        printf("          parked false events: %.1f per device-hour\n", parked_raw[k] / (parked_hours / 2));
+    }
+
+    // Cost per update over the recorded sightings
+    using clock = std::chrono::steady_clock;
+    const uint32_t reps = 50;
+    volatile uint32_t sink = 0;
+    auto t0 = clock::now();
+    for (uint32_t r = 0; r < reps; r++) {
+        RssiTrack t = {};
+        t.reset(all[0].rssi, all[0].ms);
+        for (const Sighting& s : all) sink += t.update(s.rssi, s.ms);
+    }
+    auto t1 = clock::now();
+    (void)sink;
+    printf("\nupdate: %.1f ns (%zu sightings x %u), state %zu bytes\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / ((double)reps * all.size()),
+           all.size(), reps, sizeof(RssiTrack));
+    return 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file rule_bench.cpp
+ * @brief Confidence rule evaluator golden check and benchmark (Linux host)
+ *
+ * Loads a rule image compiled by tools/rulec.py and the golden sightings
+ * rulec.py --golden derives from datasets/, then:
+ *
+ * - golden: evaluates every sighting with src/rule_vm.cpp and compares the
+ *   score and matching rule with rulec.py's own AST evaluator. Any
+ *   difference fails the run.
+ * - legacy: for sightings before any hit-count bonus could apply, compares
+ *   the score with the formula the JSON emitters hardcoded (100 for
+ *   pattern + MAC, 85 for either, 70 otherwise). Informational: custom
+ *   rule sets are expected to differ.
+ * - corruption: flips every byte of the image (several patterns each) and
+ *   evaluates whatever load() still accepts
+ * - timing: ns per evaluation, and per byte of code (the bound is linear
+ *   in code size, at most RULE_MAX_CODE)
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/rule_bench.cpp src/rule_vm.cpp -o rule_bench
+ * Run:
+ *   python3 tools/rulec.py signatures/rules.txt -o rules.fyrb --golden datasets golden.tsv
+ *   ./rule_bench rules.fyrb golden.tsv
+ */
+
+#include "rule_vm.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct Sighting {
+    RuleFacts facts;
+    uint8_t mac[6];
+    std::string ssid, name;
+    int score, rule;
+};
+
+static std::vector<uint8_t> read_file(const char* path) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path, "rb");
+    if (!f) return data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    return data;
+}
+
+// Tab-separated, empty fields allowed (hence no strtok)
+static std::vector<std::string> split_tabs(const std::string& line) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    for (;;) {
+        size_t tab = line.find('\t', start);
+        out.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) return out;
+        start = tab + 1;
+    }
+}
+
+static bool read_golden(const char* path, std::vector<Sighting>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char buf[512];
+    while (fgets(buf, sizeof(buf), f)) {
+        if (buf[0] == '#') continue;
+        std::string line(buf);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        std::vector<std::string> col = split_tabs(line);
+        if (col.size() != 12) continue;
+
+        Sighting s = {};
+        s.facts.flags = (uint16_t)atoi(col[0].c_str());
+        s.facts.rssi = (int8_t)atoi(col[1].c_str());
+        s.facts.channel = (uint8_t)atoi(col[2].c_str());
+        s.facts.hits = (uint16_t)atoi(col[3].c_str());
+        s.facts.probe_ms = (uint32_t)strtoul(col[4].c_str(), nullptr, 10);
+        s.facts.mfg = atoi(col[5].c_str());
+        s.facts.ie_fp = (uint32_t)strtoul(col[6].c_str(), nullptr, 10);
+        sscanf(col[7].c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+               &s.mac[0], &s.mac[1], &s.mac[2], &s.mac[3], &s.mac[4], &s.mac[5]);
+        s.ssid = col[8];
+        s.name = col[9];
+        s.score = atoi(col[10].c_str());
+        s.rule = atoi(col[11].c_str());
+        out.push_back(s);
+    }
+    fclose(f);
+    // Pointers only once the vector has stopped moving
+    for (Sighting& s : out) {
+        s.facts.mac = s.mac;
+        s.facts.ssid = (s.facts.flags & (1 << RULE_FACT_WIFI)) ? s.ssid.c_str() : nullptr;
+        s.facts.name = (s.facts.flags & (1 << RULE_FACT_BLE)) ? s.name.c_str() : nullptr;
+    }
+    return true;
+}
+
+static int legacy_score(uint16_t flags) {
+    bool pattern = flags & ((1 << RULE_FACT_SSID_MATCH) | (1 << RULE_FACT_NAME_MATCH));
+    bool mac = flags & ((1 << RULE_FACT_OUI) | (1 << RULE_FACT_WATCHLIST));
+    return pattern && mac ? 100 : (pattern || mac ? 85 : 70);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s RULES.fyrb GOLDEN.tsv\n", argv[0]);
+        return 2;
+    }
+    std::vector<uint8_t> image = read_file(argv[1]);
+    std::vector<Sighting> sightings;
+    if (image.empty() || !read_golden(argv[2], sightings) || sightings.empty()) {
+        fprintf(stderr, "cannot read %s or %s\n", argv[1], argv[2]);
+        return 2;
+    }
+
+    RuleProgram prog;
+    RuleStatus status = prog.load(image.data(), image.size());
+    if (status != RULE_OK) {
+        printf("%s: %s\n", argv[1], rule_status_str(status));
+        return 1;
+    }
+    printf("%s: %u rules, %u bytes of code; %zu golden sightings\n\n",
+           argv[1], prog.ruleCount(), prog.codeSize(), sightings.size());
+
+    // Golden check
+    uint32_t mismatches = 0;
+    for (const Sighting& s : sightings) {
+        RuleResult r = prog.eval(s.facts);
+        if (r.score == s.score && r.rule == s.rule) continue;
+        if (++mismatches <= 5) {
+            printf("  MISMATCH %02x:%02x:%02x:%02x:%02x:%02x hits %u rssi %d: vm %u/%u, expected %d/%d\n",
+                   s.mac[0], s.mac[1], s.mac[2], s.mac[3], s.mac[4], s.mac[5],
+                   s.facts.hits, s.facts.rssi, r.score, r.rule, s.score, s.rule);
+        }
+    }
+    printf("golden:     %zu/%zu sightings agree with rulec.py\n", sightings.size() - mismatches, sightings.size());
+
+    // Legacy formula, on sightings below the STEADY bonus threshold
+    uint32_t early = 0, legacy_same = 0;
+    for (const Sighting& s : sightings) {
+        if (s.facts.hits >= 5) continue;
+        early++;
+        if (prog.eval(s.facts).score == legacy_score(s.facts.flags)) legacy_same++;
+    }
+    printf("legacy:     %u/%u early sightings score as the hardcoded emitters did\n", legacy_same, early);
+
+    // Corrupted images: load() must reject them or leave a program eval() can run
+    static const uint8_t flips[] = { 0x01, 0x80, 0xFF, 0x10 };
+    uint32_t tried = 0, accepted = 0;
+    uint64_t sink = 0;
+    std::vector<uint8_t> bad;
+    for (size_t i = 0; i < image.size(); i++) {
+        for (uint8_t flip : flips) {
+            bad = image;
+            bad[i] ^= flip;
+            tried++;
+            RuleProgram p;
+            if (p.load(bad.data(), bad.size()) != RULE_OK) continue;
+            accepted++;
+            for (size_t k = 0; k < sightings.size(); k += 97) sink += p.eval(sightings[k].facts).score;
+        }
+    }
+    for (size_t cut = 0; cut < image.size(); cut++) {
+        RuleProgram p;
+        tried++;
+        if (p.load(image.data(), cut) == RULE_OK) accepted++;
+    }
+    printf("corruption: %u damaged images, %u rejected, %u still valid programs (evaluated without fault)\n",
+           tried, tried - accepted, accepted);
+
+    // Timing
+    using clock = std::chrono::steady_clock;
+    const int rounds = 20;
+    auto t0 = clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const Sighting& s : sightings) sink += prog.eval(s.facts).score;
+    }
+    double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count() /
+                ((double)rounds * sightings.size());
+    printf("timing:     %.1f ns per evaluation, %.2f ns per code byte (%.0f ns at RULE_MAX_CODE)\n",
+           ns, ns / prog.codeSize(), ns / prog.codeSize() * RULE_MAX_CODE);
+
+    if (sink == 42) printf("\n");  // Keep the loops
+    return mismatches ? 1 : 0;
+}
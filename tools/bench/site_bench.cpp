@@ -0,0 +1,304 @@
+/**
+ * @file site_bench.cpp
+ * @brief Site correlation simulation and benchmark (Linux host)
+ *
+ * Drives src/site_cluster.cpp the way processingTask does (add on the first
+ * sighting, sight with the rssi_track.h level/rate afterwards, expire once a
+ * second) and scores the sites it builds:
+ *
+ * - drives: a road past 20 installations 80-400 m apart and 10-60 m off the
+ *   road, at 8-25 m/s. Each installation is a WiFi camera (beacon bursts
+ *   while the hopper is on its channel) plus an "FS Ext Battery" BLE
+ *   advertiser (~1 Hz), and half of them a second battery with an adjacent
+ *   address. 30% of cameras use ESP-style addresses (BLE = WiFi + 2).
+ * - parked: five minutes at an intersection with two installations 40-80 m
+ *   and 80-160 m away, which must stay two sites
+ *
+ * Path loss, shadowing and fades as in rssi_track_bench. Reports alerts per
+ * installation (one per tracked device before), installations whose radios
+ * all ended up in one site, joins across installations and time to join.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/site_bench.cpp src/site_cluster.cpp src/rssi_track.cpp -o site_bench
+ * Run:
+ *   ./site_bench [--drives N] [--parked N] [--sigma DB] [--seed N]
+ */
+
+#include "site_cluster.h"
+#include "rssi_track.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define HELD_MAX 8  // SITE_HELD_MAX in main.cpp: alert at once when full
+
+struct Radio {
+    uint8_t mac[6];
+    bool ble;
+    int site;        // Installation index
+    double x, d0;    // Position along the road, distance off it
+    uint32_t hop_phase;
+};
+
+struct Sighting {
+    uint32_t ms;
+    uint8_t radio;
+    int8_t rssi;
+    bool operator<(const Sighting& o) const { return ms < o.ms; }
+};
+
+struct Totals {
+    uint32_t installs_heard = 0, alerts = 0, devices_heard = 0;
+    uint32_t complete = 0, multi_radio = 0, cross_joins = 0;
+    uint32_t joins[3] = {}, held = 0, folded_held = 0;
+    std::vector<double> join_s, hold_s;
+    double cost_ns = 0;
+    uint32_t calls = 0;
+};
+
+static std::mt19937 rng;
+static double sigma = 4;
+
+static double uni(double a, double b) { return std::uniform_real_distribution<double>(a, b)(rng); }
+
+static double rssi_at(double d) {
+    double r = -35 - 27 * log10(std::max(d, 1.0)) + std::normal_distribution<double>(0, sigma)(rng);
+    if (uni(0, 1) < 0.03) r -= 12;  // Deep fade
+    return r;
+}
+
+static void random_mac(uint8_t* mac) {
+    for (int i = 0; i < 6; i++) mac[i] = (uint8_t)(rng() & 0xFF);
+    mac[0] &= 0xFC;  // Universal unicast
+}
+
+static void offset_mac(uint8_t* out, const uint8_t* base, int delta) {
+    memcpy(out, base, 6);
+    uint32_t low = ((uint32_t)base[3] << 16 | base[4] << 8 | base[5]) + delta;
+    out[3] = (uint8_t)(low >> 16);
+    out[4] = (uint8_t)(low >> 8);
+    out[5] = (uint8_t)low;
+}
+
+static void add_installation(std::vector<Radio>& radios, int site, double x, double d0) {
+    Radio cam = {};
+    random_mac(cam.mac);
+    cam.site = site;
+    cam.x = x;
+    cam.d0 = d0;
+    cam.hop_phase = (uint32_t)uni(0, 1000);
+    radios.push_back(cam);
+
+    Radio bat = cam;
+    bat.ble = true;
+    if (uni(0, 1) < 0.3) offset_mac(bat.mac, cam.mac, 2);
+    else random_mac(bat.mac);
+    radios.push_back(bat);
+
+    if (uni(0, 1) < 0.5) {
+        Radio pair = bat;
+        offset_mac(pair.mac, bat.mac, 1 + (int)uni(0, 15));
+        radios.push_back(pair);
+    }
+}
+
+// Sighting times over [t0, t1): beacon bursts on a ~1 s hop cycle, or ~1 Hz BLE
+static void sighting_times(const Radio& r, uint32_t t0, uint32_t t1, std::vector<uint32_t>& out) {
+    out.clear();
+    if (!r.ble) {
+        for (uint32_t t = t0 + r.hop_phase; t < t1; t += 1000) {
+            for (uint32_t b = 0; b < 250; b += 102) {
+                if (uni(0, 1) < 0.7) out.push_back(t + b);
+            }
+        }
+    } else {
+        std::exponential_distribution<double> gap(1.0 / 1000);
+        for (double t = t0 + gap(rng); t < t1; t += 250 + gap(rng) * 0.75) {
+            if (uni(0, 1) < 0.8) out.push_back((uint32_t)t);
+        }
+    }
+}
+
+// Run one scenario: `pos(ms)` is the observer's position along the road
+template <typename Pos>
+static void run(const std::vector<Radio>& radios, uint32_t duration_ms, Pos pos, Totals& tot) {
+    const uint32_t base = 100000;
+    std::vector<Sighting> all;
+    std::vector<uint32_t> times;
+    for (size_t i = 0; i < radios.size(); i++) {
+        sighting_times(radios[i], base, base + duration_ms, times);
+        for (uint32_t ms : times) {
+            double dx = radios[i].x - pos(ms - base);
+            double r = rssi_at(sqrt(radios[i].d0 * radios[i].d0 + dx * dx));
+            if (r < -95) continue;  // Below sensitivity
+            all.push_back({ ms, (uint8_t)i, (int8_t)lround(r) });
+        }
+    }
+    std::sort(all.begin(), all.end());
+
+    using clock = std::chrono::steady_clock;
+    SiteCluster sites;
+    std::vector<RssiTrack> tracks(radios.size(), RssiTrack{});
+    std::vector<uint32_t> first_ms(radios.size(), 0);
+    std::vector<uint8_t> pending;  // Alerts held for a possible join
+    uint32_t last_expire = base;
+    auto release = [&](uint32_t now, bool all_due) {
+        for (size_t k = 0; k < pending.size();) {
+            uint8_t p = pending[k];
+            if (sites.siteId(p)) {
+                tot.folded_held++;  // Joined an alerted site while held
+            } else if (all_due || now - first_ms[p] >= SITE_HOLD_MS || !sites.alertedNearby(p, now)) {
+                sites.assign(p);
+                tot.alerts++;
+                tot.hold_s.push_back((now - first_ms[p]) / 1000.0);
+            } else {
+                k++;
+                continue;
+            }
+            pending.erase(pending.begin() + k);
+        }
+    };
+    for (const Sighting& s : all) {
+        if (s.ms - last_expire >= 1000) {
+            last_expire = s.ms;
+            sites.expire(s.ms, 300000);
+            release(s.ms, false);
+        }
+        const Radio& r = radios[s.radio];
+        RssiTrack& t = tracks[s.radio];
+        SiteJoin j;
+        auto c0 = clock::now();
+        if (!t.hits) {
+            t.reset(s.rssi, s.ms);
+            first_ms[s.radio] = s.ms;
+            tot.devices_heard++;
+            j = sites.add(s.radio, r.mac, r.ble, s.ms);
+            if (!sites.siteId(s.radio)) {
+                if (pending.size() < HELD_MAX && sites.alertedNearby(s.radio, s.ms)) {
+                    pending.push_back(s.radio);
+                    tot.held++;
+                } else {
+                    sites.assign(s.radio);
+                    tot.alerts++;
+                }
+            }
+        } else {
+            t.update(s.rssi, s.ms);
+            j = sites.sight(s.radio, t, s.ms);
+        }
+        tot.cost_ns += std::chrono::duration<double, std::nano>(clock::now() - c0).count();
+        tot.calls++;
+        if (j.reason != SITE_JOIN_NONE) {
+            tot.joins[j.reason]++;
+            // Time since the later of the two radios was first heard
+            uint8_t m[SITE_SLOTS];
+            uint8_t n = sites.members(s.radio, m, SITE_SLOTS);
+            uint32_t latest = 0;
+            for (uint8_t k = 0; k < n; k++) latest = std::max(latest, first_ms[m[k]]);
+            tot.join_s.push_back((s.ms - latest) / 1000.0);
+        }
+    }
+    release(all.empty() ? base : all.back().ms, true);
+
+    // Score the final grouping per installation
+    int nsites = 0;
+    for (const Radio& r : radios) nsites = std::max(nsites, r.site + 1);
+    for (int site = 0; site < nsites; site++) {
+        int heard = 0, root = -1;
+        bool one = true;
+        for (size_t i = 0; i < radios.size(); i++) {
+            if (radios[i].site != site || !tracks[i].hits) continue;
+            heard++;
+            int ri = sites.find((uint8_t)i);
+            if (root < 0) root = ri;
+            else if (ri != root) one = false;
+        }
+        if (!heard) continue;
+        tot.installs_heard++;
+        if (heard > 1) {
+            tot.multi_radio++;
+            tot.complete += one;
+        }
+    }
+    for (size_t i = 0; i < radios.size(); i++) {
+        for (size_t k = i + 1; k < radios.size(); k++) {
+            if (!tracks[i].hits || !tracks[k].hits || radios[i].site == radios[k].site) continue;
+            if (sites.find((uint8_t)i) == sites.find((uint8_t)k)) {
+                tot.cross_joins++;
+                goto next_radio;  // Count each misplaced radio once
+            }
+        }
+    next_radio:;
+    }
+}
+
+static double pct(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static void report(const char* name, const Totals& t) {
+    printf("%s:\n", name);
+    printf("  installations heard %u, tracked devices %u, alerts %u (%.2f per installation, was %.2f)\n",
+           t.installs_heard, t.devices_heard, t.alerts,
+           (double)t.alerts / t.installs_heard, (double)t.devices_heard / t.installs_heard);
+    printf("  multi-radio installations fully joined %.1f%%, radios joined to another installation %u\n",
+           100.0 * t.complete / std::max(t.multi_radio, 1u), t.cross_joins);
+    printf("  joins: mac_adjacent %u, co_occurrence %u; join after second radio heard p50 %.1f s p90 %.1f s\n",
+           t.joins[SITE_JOIN_MAC_ADJACENT], t.joins[SITE_JOIN_CO_OCCURRENCE], pct(t.join_s, 0.5), pct(t.join_s, 0.9));
+    printf("  alerts held %u, folded while held %u; released alerts waited p50 %.1f s p90 %.1f s\n",
+           t.held, t.folded_held, pct(t.hold_s, 0.5), pct(t.hold_s, 0.9));
+    printf("  add/sight incl. filter: %.0f ns per sighting\n", t.cost_ns / std::max(t.calls, 1u));
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s [--drives N] [--parked N] [--sigma DB] [--seed N]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    uint32_t drives = 200, parked = 200, seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--drives")) drives = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--parked")) parked = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--sigma")) sigma = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoul(argv[++i], nullptr, 10);
+        else usage(argv[0]);
+    }
+    rng.seed(seed);
+
+    Totals drive, stop;
+    for (uint32_t d = 0; d < drives; d++) {
+        std::vector<Radio> radios;
+        double x = 400;
+        for (int s = 0; s < 20; s++) {
+            add_installation(radios, s, x, uni(10, 60));
+            x += uni(80, 400);
+        }
+        double v = uni(8, 25);
+        uint32_t duration = (uint32_t)((x + 400) / v * 1000);
+        run(radios, duration, [v](uint32_t ms) { return ms / 1000.0 * v; }, drive);
+    }
+    for (uint32_t p = 0; p < parked; p++) {
+        std::vector<Radio> radios;
+        add_installation(radios, 0, uni(40, 80), 5);
+        add_installation(radios, 1, -uni(80, 160), 5);
+        run(radios, 300000, [](uint32_t) { return 0.0; }, stop);
+    }
+
+    printf("%u drives past 20 installations, %u parked stops next to two, shadowing sigma %.1f dB\n\n",
+           drives, parked, sigma);
+    report("Driving", drive);
+    report("Parked", stop);
+
+    printf("\nstate %zu bytes\n", sizeof(SiteCluster));
+    return 0;
+}
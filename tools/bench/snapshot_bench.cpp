@@ -0,0 +1,318 @@
+/**
+ * @file snapshot_bench.cpp
+ * @brief Warm-restart snapshot round trip, robustness and cost (Linux host)
+ *
+ * Builds a full tracking state the way the firmware does (64 tracked
+ * devices fed through rssi_track, grouped by site_cluster, bandit channel
+ * memory after a few hundred hops), then encodes it with the section order
+ * main.cpp uses and checks:
+ *
+ * - round trip: every device, site slot and the channel memory read back
+ *   equal, and ages survive rebasing onto a new millis() timeline
+ * - capacity: records kept in the SD buffer (8 KB) and the NVS blob
+ *   (3968 B), stalest devices dropped first. Sites whose root did not fit
+ *   fall apart into singletons that keep their alerted id.
+ * - corruption: every single-byte flip and every truncation is rejected
+ * - timing: encode and decode+restore per snapshot
+ *
+ * The display section is written by the Arduino display handlers and is not
+ * part of this bench; it adds ~60-70 bytes per list entry.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/snapshot_bench.cpp src/warm_snapshot.cpp src/site_cluster.cpp \
+ *       src/rssi_track.cpp src/dwell_policy.cpp src/sigpack.cpp src/ble_matcher.cpp src/mac_watchlist.cpp \
+ *       src/rule_vm.cpp -o snapshot_bench
+ * Run:
+ *   ./snapshot_bench [--seed N]
+ */
+
+#include "warm_snapshot.h"
+#include "dwell_policy.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define TRACKED   64
+#define SD_MAX    8192   // SNAPSHOT_MAX_SIZE in main.cpp
+#define NVS_MAX   3968   // SNAPSHOT_NVS_MAX in main.cpp
+
+struct State {
+    TrackedDevice devices[TRACKED];
+    SiteCluster sites;
+    DwellPolicy* dwell;
+    uint32_t now;
+};
+
+static void build_state(State& st, std::mt19937& rng) {
+    memset(st.devices, 0, sizeof(st.devices));
+    st.sites.clear();
+    st.now = 3600000 + rng() % 1000000;  // An hour or so into a drive
+
+    DwellConfig cfg;
+    st.dwell = dwell_policy_create(DWELL_POLICY_BANDIT, cfg);
+    uint32_t t = 0;
+    uint8_t ch = 1;
+    for (int hop = 0; hop < 400; hop++) {
+        uint32_t dwell_ms = 200 + rng() % 800;
+        if ((ch == 1 || ch == 6 || ch == 11) && rng() % 4 == 0) st.dwell->noteDetection(ch, t);
+        t += dwell_ms;
+        DwellVisit visit = { ch, dwell_ms, (uint16_t)(rng() % 30) };
+        ch = st.dwell->nextChannel(visit, t);
+    }
+
+    std::uniform_int_distribution<int> rssi(-95, -40);
+    for (int i = 0; i < TRACKED; i++) {
+        TrackedDevice& d = st.devices[i];
+        // Pairs of adjacent addresses, so the cluster has multi-slot sites
+        uint8_t base_mac[6] = { 0x70, 0xc9, 0x4e, (uint8_t)rng(), (uint8_t)rng(), (uint8_t)(rng() & 0xF0) };
+        memcpy(d.mac, base_mac, 6);
+        if (i % 2 == 1) {
+            memcpy(d.mac, st.devices[i - 1].mac, 6);
+            d.mac[5] += 2;
+        }
+        d.mac_hash = 1 + i;
+        uint32_t first = st.now - rng() % 290000;
+        int8_t r0 = (int8_t)rssi(rng);
+        d.rssi_min = d.rssi_max = d.rssi_last = r0;
+        d.rssi_sum = r0;
+        d.hit_count = 1;
+        d.first_seen = d.last_seen = first;
+        d.first_fix = { 473000000 + (int32_t)(rng() % 100000), -1223000000 - (int32_t)(rng() % 100000),
+                        1790000000u + (uint32_t)(rng() % 100000), true };
+        d.best_fix = d.first_fix;
+        d.track.reset(r0, first);
+        d.threat_score = 70 + rng() % 31;
+        d.last_channel = 1 + rng() % 13;
+        d.type = rng() % 7;
+        st.sites.add(i, d.mac, d.type >= 2 && d.type != 4 && d.type != 6, first);
+
+        uint32_t ts = first;
+        int hits = 1 + rng() % 40;
+        for (int h = 1; h < hits && ts < st.now - 1000; h++) {
+            uint32_t gap = 100 + rng() % 3000;
+            ts += gap;
+            if (ts > st.now) break;
+            int8_t r = (int8_t)rssi(rng);
+            d.rssi_last = r;
+            if (r < d.rssi_min) d.rssi_min = r;
+            if (r > d.rssi_max) d.rssi_max = r;
+            d.rssi_sum += r;
+            d.hit_count++;
+            d.probe_interval_sum += gap;
+            d.probe_intervals++;
+            d.last_seen = ts;
+            d.track.update(r, ts);
+            st.sites.sight(i, d.track, ts);
+        }
+    }
+}
+
+// Same sections and order as encode_snapshot() in main.cpp
+static size_t encode(State& st, uint8_t* buf, size_t cap, uint32_t seq, uint32_t* dropped) {
+    SnapshotWriter w(buf, cap);
+    w.beginSection(SNAP_SEC_COUNTERS, 1);
+    for (int i = 0; i < 4; i++) w.put32(i * 7);
+    w.endRecord();
+    w.endSection();
+
+    float memory[DWELL_STATE_MAX];
+    uint8_t n = st.dwell->saveState(memory);
+    w.beginSection(SNAP_SEC_DWELL, 1);
+    w.putStr(st.dwell->name());
+    w.put8(n);
+    for (uint8_t i = 0; i < n; i++) w.putFloat(memory[i]);
+    w.endRecord();
+    w.endSection();
+
+    uint8_t order[TRACKED];
+    uint8_t live = 0;
+    for (uint8_t i = 0; i < TRACKED; i++) {
+        uint32_t age = st.now - st.devices[i].last_seen;
+        uint8_t j = live++;
+        for (; j > 0 && st.now - st.devices[order[j - 1]].last_seen > age; j--) order[j] = order[j - 1];
+        order[j] = i;
+    }
+    w.beginSection(SNAP_SEC_DEVICES, 1);
+    for (uint8_t i = 0; i < live; i++) {
+        SiteSlotState s;
+        bool in_site = st.sites.saveSlot(order[i], s);
+        w.putDevice(order[i], st.devices[order[i]], st.now);
+        w.put8(in_site);
+        if (in_site) w.putSiteSlot(s, st.now);
+        w.endRecord();
+    }
+    w.endSection();
+
+    SnapHeader hdr = { seq, 0x1234, 987654, st.now };
+    if (dropped) *dropped = w.dropped();
+    return w.finish(hdr);
+}
+
+struct Restored {
+    TrackedDevice devices[TRACKED];
+    bool present[TRACKED];
+    SiteCluster sites;
+    DwellPolicy* dwell;
+    uint16_t device_count, site_count;
+};
+
+static bool decode(const uint8_t* img, size_t len, uint32_t base, Restored& out) {
+    SnapshotReader r;
+    if (r.open(img, len) != SNAP_OK) return false;
+    memset(out.present, 0, sizeof(out.present));
+    out.sites.clear();
+    out.device_count = out.site_count = 0;
+    uint8_t type, version;
+    uint16_t count;
+    while (r.nextSection(type, version, count)) {
+        if (type == SNAP_SEC_DWELL) {
+            char name[16];
+            r.getStr(name, sizeof(name));
+            uint8_t n = r.get8();
+            float memory[DWELL_STATE_MAX];
+            for (uint8_t i = 0; i < n && i < DWELL_STATE_MAX; i++) memory[i] = r.getFloat();
+            if (!r.ok() || strcmp(name, out.dwell->name()) || !out.dwell->loadState(memory, n)) return false;
+        } else if (type == SNAP_SEC_DEVICES) {
+            // Slots are kept as saved here; main.cpp may move them and remaps
+            for (uint16_t i = 0; i < count; i++) {
+                TrackedDevice d;
+                SiteSlotState s;
+                uint8_t slot = r.getDevice(d, base);
+                bool in_site = r.get8();
+                if (in_site) r.getSiteSlot(s, base);
+                if (!r.ok() || slot >= TRACKED) return false;
+                out.devices[slot] = d;
+                out.present[slot] = true;
+                out.device_count++;
+                if (in_site) {
+                    memcpy(s.mac, d.mac, 6);
+                    out.sites.restoreSlot(slot, s);
+                    out.site_count++;
+                }
+            }
+            out.sites.restoreDone();
+        }
+    }
+    return true;
+}
+
+static bool same_device(const TrackedDevice& a, const TrackedDevice& b, uint32_t shift) {
+    return memcmp(a.mac, b.mac, 6) == 0 && a.rssi_min == b.rssi_min && a.rssi_max == b.rssi_max &&
+           a.rssi_last == b.rssi_last && a.rssi_sum == b.rssi_sum && a.hit_count == b.hit_count &&
+           a.last_channel == b.last_channel && a.type == b.type && a.threat_score == b.threat_score &&
+           a.probe_interval_sum == b.probe_interval_sum && a.probe_intervals == b.probe_intervals &&
+           b.first_seen == a.first_seen + shift && b.last_seen == a.last_seen + shift &&
+           a.first_fix.lat_e7 == b.first_fix.lat_e7 && a.first_fix.lon_e7 == b.first_fix.lon_e7 &&
+           a.first_fix.utc == b.first_fix.utc && a.first_fix.valid == b.first_fix.valid &&
+           a.best_fix.lat_e7 == b.best_fix.lat_e7 && a.best_fix.utc == b.best_fix.utc &&
+           a.track.level_q8 == b.track.level_q8 && a.track.rate_q8 == b.track.rate_q8 &&
+           a.track.peak_q8 == b.track.peak_q8 && a.track.trough_q8 == b.track.trough_q8 &&
+           a.track.hits == b.track.hits && a.track.phase == b.track.phase &&
+           b.track.last_ms == a.track.last_ms + shift && b.track.peak_ms == a.track.peak_ms + shift;
+}
+
+int main(int argc, char** argv) {
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = atoi(argv[++i]);
+    }
+    std::mt19937 rng(seed);
+    State st;
+    build_state(st, rng);
+    DwellConfig cfg;
+    Restored out;
+    out.dwell = dwell_policy_create(DWELL_POLICY_BANDIT, cfg);
+
+    // Round trip on the SD buffer, rebased onto a boot 42 s after the snapshot
+    std::vector<uint8_t> img(SD_MAX);
+    uint32_t dropped = 0;
+    size_t len = encode(st, img.data(), img.size(), 7, &dropped);
+    uint32_t boot_now = 1500;
+    uint32_t age = 42000;
+    uint32_t base = boot_now - age;
+    uint32_t shift = base - st.now;
+    if (!decode(img.data(), len, base, out)) {
+        printf("round trip: decode failed\n");
+        return 1;
+    }
+    int bad = 0;
+    for (int i = 0; i < TRACKED; i++) {
+        if (!out.present[i] || !same_device(st.devices[i], out.devices[i], shift)) bad++;
+    }
+    int site_bad = 0;
+    for (uint8_t i = 0; i < TRACKED; i++) {
+        SiteSlotState a, b;
+        bool ha = st.sites.saveSlot(i, a), hb = out.sites.saveSlot(i, b);
+        if (ha != hb) { site_bad++; continue; }
+        if (!ha) continue;
+        if (a.root != b.root || a.site_id != b.site_id || a.lead != b.lead ||
+            st.sites.siteSize(i) != out.sites.siteSize(i) || b.last_ms != a.last_ms + shift) {
+            site_bad++;
+        }
+    }
+    float m1[DWELL_STATE_MAX], m2[DWELL_STATE_MAX];
+    uint8_t n1 = st.dwell->saveState(m1), n2 = out.dwell->saveState(m2);
+    bool dwell_ok = n1 == n2 && memcmp(m1, m2, n1 * sizeof(float)) == 0;
+    printf("round trip: %u devices (%d differ), %u site slots in %u multi-radio sites (%d differ), channel memory %s\n",
+           out.device_count, bad, out.site_count, st.sites.sites(), site_bad, dwell_ok ? "equal" : "DIFFERS");
+
+    // Capacity
+    printf("capacity:   SD  %zu bytes for %u devices (%zu per device incl. site slot), %u dropped\n",
+           len, out.device_count, (len - SNAP_HEADER_SIZE) / TRACKED, dropped);
+    std::vector<uint8_t> nvs(NVS_MAX);
+    size_t nvs_len = encode(st, nvs.data(), nvs.size(), 8, &dropped);
+    Restored nvs_out;
+    nvs_out.dwell = dwell_policy_create(DWELL_POLICY_BANDIT, cfg);
+    bool nvs_ok = decode(nvs.data(), nvs_len, st.now, nvs_out);
+    uint32_t oldest_kept = 0;
+    for (int i = 0; i < TRACKED; i++) {
+        if (nvs_out.present[i] && st.now - st.devices[i].last_seen > oldest_kept) oldest_kept = st.now - st.devices[i].last_seen;
+    }
+    int fresher_dropped = 0;
+    for (int i = 0; i < TRACKED; i++) {
+        if (!nvs_out.present[i] && st.now - st.devices[i].last_seen < oldest_kept) fresher_dropped++;
+    }
+    printf("            NVS %zu bytes: %u devices and %u site slots kept, %u records dropped, %d fresher than a kept one%s\n",
+           nvs_len, nvs_out.device_count, nvs_out.site_count, dropped, fresher_dropped, nvs_ok ? "" : " (DECODE FAILED)");
+
+    // Corruption: the CRC must catch every flip and every truncation
+    uint32_t tried = 0, accepted = 0;
+    static const uint8_t flips[] = { 0x01, 0x80, 0xFF };
+    for (size_t i = 0; i < len; i++) {
+        for (uint8_t f : flips) {
+            std::vector<uint8_t> b(img.begin(), img.begin() + len);
+            b[i] ^= f;
+            SnapshotReader r;
+            tried++;
+            if (r.open(b.data(), len) == SNAP_OK) accepted++;
+        }
+    }
+    for (size_t cut = 0; cut < len; cut++) {
+        SnapshotReader r;
+        tried++;
+        if (r.open(img.data(), cut) == SNAP_OK) accepted++;
+    }
+    printf("corruption: %u damaged images, %u accepted\n", tried, accepted);
+
+    // Timing
+    using clock = std::chrono::steady_clock;
+    const int rounds = 20000;
+    uint64_t sink = 0;
+    auto t0 = clock::now();
+    for (int i = 0; i < rounds; i++) sink += encode(st, img.data(), img.size(), i, nullptr);
+    double enc_us = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / rounds;
+    t0 = clock::now();
+    for (int i = 0; i < rounds; i++) sink += decode(img.data(), len, base, out);
+    double dec_us = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / rounds;
+    printf("timing:     encode %.1f us, decode + restore %.1f us per %zu byte snapshot\n", enc_us, dec_us, len);
+
+    if (sink == 42) printf("\n");
+    delete st.dwell;
+    delete out.dwell;
+    delete nvs_out.dwell;
+    return (bad || site_bad || !dwell_ok || accepted || !nvs_ok) ? 1 : 0;
+}
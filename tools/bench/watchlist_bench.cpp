@@ -0,0 +1,138 @@
+/**
+ * @file watchlist_bench.cpp
+ * @brief Full-MAC watchlist check and benchmark against a signature pack (Linux host)
+ *
+ * Loads a pack built by tools/sigpack.py (with a MAC list from
+ * tools/watchlist.py) through the firmware parser and:
+ *
+ * - confirms every listed MAC is found (the Python builder and
+ *   src/mac_watchlist.cpp agree on hashing and bucket placement)
+ * - measures the filter false-positive rate on random unlisted MACs
+ * - times a lookup of an unlisted MAC via the cuckoo filter vs a binary
+ *   search of the exact table, and reports memory per 10k MACs
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/bench/watchlist_bench.cpp src/sigpack.cpp \
+ *       src/mac_watchlist.cpp src/ble_matcher.cpp src/rule_vm.cpp -o watchlist_bench
+ * Run:
+ *   ./watchlist_bench signatures.fysp [--queries N] [--seed N]
+ */
+
+#include "sigpack.h"
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Exact-table search as used when a pack has no filter section
+static bool exact_contains(const uint8_t* set, uint32_t count, const uint8_t* mac) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int c = memcmp(set + (size_t)mid * 6, mac, 6);
+        if (c == 0) return true;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "usage: %s PACK [--queries N] [--seed N]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) usage(argv[0]);
+    const char* path = argv[1];
+    uint32_t queries = 1000000;
+    uint32_t seed = 1;
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--queries")) queries = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed")) seed = strtoul(argv[++i], nullptr, 10);
+        else usage(argv[0]);
+    }
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    std::vector<uint8_t> image;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) image.insert(image.end(), buf, buf + n);
+    fclose(f);
+
+    SignaturePack pack;
+    SigPackStatus status = pack.load(image.data(), image.size());
+    if (status != SIGPACK_OK) {
+        fprintf(stderr, "%s: %s\n", path, sigpack_status_str(status));
+        return 1;
+    }
+    const MacWatchlist& wl = pack.watchlist();
+    if (!wl.attached() || pack.macCount() == 0) {
+        fprintf(stderr, "%s: no MAC watchlist in pack\n", path);
+        return 1;
+    }
+
+    // Listed MACs straight from the image's MAC section
+    std::vector<std::array<uint8_t, 6>> listed;
+    uint16_t sections = image[6] | (image[7] << 8);
+    for (uint16_t s = 0; s < sections; s++) {
+        const uint8_t* sec = image.data() + SIGPACK_HEADER_SIZE + s * SIGPACK_SECTION_SIZE;
+        if ((sec[0] | (sec[1] << 8)) != SIGPACK_SEC_MAC) continue;
+        uint32_t off = sec[8] | (sec[9] << 8) | (sec[10] << 16) | ((uint32_t)sec[11] << 24);
+        for (uint32_t i = 0; i < pack.macCount(); i++) {
+            std::array<uint8_t, 6> m;
+            memcpy(m.data(), image.data() + off + i * 6, 6);
+            listed.push_back(m);
+        }
+    }
+    const uint8_t* exact = listed[0].data();
+
+    uint32_t missing = 0;
+    for (const auto& m : listed) missing += !pack.matchMac(m.data());
+
+    // Random unlisted MACs
+    std::mt19937_64 rng(seed);
+    std::vector<std::array<uint8_t, 6>> probes;
+    probes.reserve(queries);
+    while (probes.size() < queries) {
+        uint64_t r = rng();
+        std::array<uint8_t, 6> m;
+        for (int i = 0; i < 6; i++) m[i] = r >> (8 * i);
+        if (exact_contains(exact, listed.size(), m.data())) continue;
+        probes.push_back(m);
+    }
+
+    uint32_t filter_pos = 0;
+    for (const auto& m : probes) filter_pos += wl.mayContain(m.data());
+
+    using clock = std::chrono::steady_clock;
+    volatile uint32_t sink = 0;
+    auto t0 = clock::now();
+    for (const auto& m : probes) sink += pack.matchMac(m.data());
+    auto t1 = clock::now();
+    for (const auto& m : probes) sink += exact_contains(exact, listed.size(), m.data());
+    auto t2 = clock::now();
+    (void)sink;
+
+    double macs = pack.macCount();
+    double filter_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / queries;
+    double exact_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / queries;
+
+    printf("%s: %u MACs, filter %u buckets\n", path, pack.macCount(), wl.bucketCount());
+    printf("listed MACs found:     %u/%u\n", pack.macCount() - missing, pack.macCount());
+    printf("false positive rate:   %u/%u = %.4f%% (filter only; exact table rejects all)\n",
+           filter_pos, queries, filter_pos * 100.0 / queries);
+    printf("memory per 10k MACs:   filter %.1f KB, exact %.1f KB\n",
+           wl.filterBytes() * 10000.0 / macs / 1024, 6 * 10000.0 / 1024);
+    printf("miss lookup:           filter+verify %.1f ns, binary search %.1f ns\n", filter_ns, exact_ns);
+    return missing ? 1 : 0;
+}
@@ -0,0 +1,390 @@
+/**
+ * @file display_sim.cpp
+ * @brief Off-target display renderer: golden images and per-page cost (Linux host)
+ *
+ * Links the real display handler (src/display_handler_28.cpp with
+ * -DCYD_DISPLAY, or src/display_handler_147.cpp with -DWAVESHARE_147)
+ * against host stand-ins for the Arduino core and TFT_eSPI (host/), which
+ * draw into an RGB565 framebuffer and count what would cross the SPI bus.
+ *
+ * Script, on a virtual clock:
+ * - boot: begin() with the boot animation (CYD: ends on the calibration
+ *   page, as there is no SD card with a calibration file)
+ * - main_empty: HOME before anything is detected
+ * - stream: a scripted drive past cameras and phones (WiFi and BLE
+ *   detections, proximity updates, channel hops) with update() every
+ *   FRAME_MS, on HOME; the frame cost is reported as mean and max
+ * - every page after the stream: the switch to it (setPage + first frame)
+ *   and a steady-state refresh one second later
+ * - toast: an alert composited over HOME
+ * - detail (CYD): a camera's detail view opened from LIST, then detail_live,
+ *   a 40 s pass of that camera with sightings every 250 ms feeding its RSSI
+ *   history while the view appends to its sparklines
+ *
+ * Each scene's final framebuffer is written as <out>/<board>_<scene>.png
+ * and hashed. --update writes the hashes to the golden file, otherwise
+ * they are checked against it and any difference fails the run.
+ *
+ * Build (one binary per board):
+ *   g++ -O2 -std=c++17 -DCYD_DISPLAY -DTRACE_ENABLED=0 -Itools/display_sim/host -Isrc \
+ *       tools/display_sim/display_sim.cpp tools/display_sim/host/arduino_host.cpp \
+ *       tools/display_sim/host/tft_host.cpp tools/display_sim/host/status_led_host.cpp \
+ *       src/display_handler_28.cpp src/toast_queue.cpp src/led_effects.cpp src/rssi_track.cpp \
+ *       src/rssi_history.cpp src/flash_index.cpp src/warm_snapshot.cpp src/sigpack.cpp \
+ *       src/ble_matcher.cpp src/mac_watchlist.cpp src/rule_vm.cpp -o display_sim_28
+ *   (WAVESHARE_147: -DWAVESHARE_147 and src/display_handler_147.cpp, -o display_sim_147)
+ * Run:
+ *   ./display_sim_28 [--out DIR] [--golden FILE] [--update] [--no-png]
+ */
+
+#if defined(CYD_DISPLAY)
+#include "display_handler_28.h"
+#define SIM_BOARD "28"
+#elif defined(WAVESHARE_147)
+#include "display_handler_147.h"
+#define SIM_BOARD "147"
+#else
+#error "Build with -DCYD_DISPLAY or -DWAVESHARE_147"
+#endif
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#define FRAME_MS 50   // update() period in the stream scene
+
+struct SimConfig {
+    std::string out = "display_sim_out";
+    std::string golden = "tools/display_sim/golden_" SIM_BOARD ".txt";
+    bool update = false;
+    bool png = true;
+};
+
+struct SceneResult {
+    std::string name;
+    TftStats cost;
+    uint32_t frames;
+    uint64_t max_bytes;     // Costliest frame
+    double host_us;         // Host time in the handler, all frames
+    uint32_t hash;
+};
+
+// One scripted sighting: at ms into the stream
+struct StreamEvent {
+    uint32_t at_ms;
+    const char* ssid;
+    const char* mac;
+    int8_t rssi;
+    const char* type;       // Detection method, "BLE", or nullptr for a proximity update
+    uint8_t phase;          // RssiPhase for proximity updates
+};
+
+static const StreamEvent stream_events[] = {
+    {   500, "Flock-A1B2C3",     "58:8e:81:a1:b2:c3", -78, "beacon",            0 },
+    {  1500, "Flock-A1B2C3",     "58:8e:81:a1:b2:c3", -66, nullptr,             RSSI_PHASE_APPROACHING },
+    {  2600, "Unknown",          "fc:fc:48:12:34:56", -71, "BLE",               0 },
+    {  3200, "Flock-A1B2C3",     "58:8e:81:a1:b2:c3", -52, nullptr,             RSSI_PHASE_APPROACHING },
+    {  4100, "hidden",           "ec:1b:bd:00:11:22", -74, "probe_request_mac", 0 },
+    {  5000, "Flock-A1B2C3",     "58:8e:81:a1:b2:c3", -58, nullptr,             RSSI_PHASE_PASSED },
+    {  6300, "Penguin-8837201",  "b4:e3:f9:42:42:01", -69, "probe_response",    0 },
+    {  7000, "FS Ext Battery",   "ec:1b:bd:7a:00:09", -61, "BLE",               0 },
+    {  7900, "Flock-A1B2C3",     "58:8e:81:a1:b2:c3", -80, nullptr,             RSSI_PHASE_DEPARTED },
+    {  8800, "Pigvision",        "ac:cf:85:10:20:30", -83, "beacon",            0 },
+    {  9700, "Unknown",          "24:0a:c4:99:88:77", -90, "BLE",               0 },
+    { 10500, "Penguin-8837201",  "b4:e3:f9:42:42:01", -55, nullptr,             RSSI_PHASE_APPROACHING },
+    { 11600, "hidden",           "3c:91:80:de:ad:01", -64, "frame_watchlist",   0 },
+    { 12400, "Flock-Z9Y8X7",     "90:35:ea:77:66:55", -72, "beacon",            0 },
+    { 13300, "Unknown",          "3c:06:30:ab:cd:ef", -67, "BLE",               0 },
+    { 14100, "Flock-Z9Y8X7",     "90:35:ea:77:66:55", -49, nullptr,             RSSI_PHASE_PASSED },
+    { 15000, "Flock-Z9Y8X7",     "90:35:ea:77:66:55", -77, nullptr,             RSSI_PHASE_DEPARTED },
+};
+
+#define STREAM_MS 16000
+
+#define DETAIL_MAC "b4:e3:f9:42:42:01"
+#define DETAIL_PASS_MS 40000
+
+static TFT_eSPI& tft() { return *TFT_eSPI::active(); }
+
+// Tracking records for the scripted MACs, kept as main.cpp keeps them
+// (std::map: the handler holds pointers to them)
+static std::map<std::string, TrackedDevice> sim_devices;
+
+static TrackedDevice* sighting(const char* mac, int8_t rssi) {
+    uint32_t now = millis();
+    auto ins = sim_devices.emplace(mac, TrackedDevice());
+    TrackedDevice& dev = ins.first->second;
+    if (ins.second) {
+        dev.mac_hash = 1;
+        dev.rssi_min = dev.rssi_max = rssi;
+        dev.first_seen = now;
+        dev.track.reset(rssi, now);
+    } else {
+        dev.track.update(rssi, now);
+    }
+    if (rssi < dev.rssi_min) dev.rssi_min = rssi;
+    if (rssi > dev.rssi_max) dev.rssi_max = rssi;
+    dev.rssi_last = rssi;
+    dev.rssi_sum += rssi;
+    dev.hit_count++;
+    dev.last_seen = now;
+    dev.history.record(rssi, now);
+    return &dev;
+}
+
+static void advance(uint32_t ms) { host_millis += ms; }
+
+// update() once, timed; returns its bus bytes
+static uint64_t frame(SceneResult& r) {
+    TftStats before = tft().stats();
+    auto t0 = std::chrono::steady_clock::now();
+    display.update();
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t bytes = (tft().stats() - before).bytes();
+    r.host_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+    r.frames++;
+    if (bytes > r.max_bytes) r.max_bytes = bytes;
+    return bytes;
+}
+
+class Scenes {
+public:
+    explicit Scenes(const SimConfig& cfg) : cfg(cfg) {}
+
+    // Run fn as one scene: cost is everything drawn inside it
+    template <typename Fn> void run(const char* name, Fn fn) {
+        SceneResult r = {};
+        r.name = name;
+        TftStats before = tft().stats();
+        fn(r);
+        r.cost = tft().stats() - before;
+        r.hash = tft().hash();
+        if (cfg.png) {
+            std::string path = cfg.out + "/" SIM_BOARD "_" + name + ".png";
+            if (!tft().writePng(path.c_str())) fprintf(stderr, "%s: write failed\n", path.c_str());
+        }
+        results.push_back(r);
+    }
+
+    std::vector<SceneResult> results;
+
+private:
+    const SimConfig& cfg;
+};
+
+static void add_detection(const StreamEvent& e) {
+    TrackedDevice* dev = sighting(e.mac, e.rssi);
+#if defined(CYD_DISPLAY)
+    display.addDetection(String(e.ssid), String(e.mac), e.rssi, String(e.type), dev);
+#else
+    (void)dev;
+    display.addDetection(String(e.ssid), String(e.mac), e.rssi, String(e.type));
+#endif
+}
+
+#if defined(CYD_DISPLAY)
+// One camera driven past: RSSI peaks mid-pass, frames drop out at random
+static void run_detail_pass(SceneResult& r) {
+    uint32_t start = millis();
+    uint32_t rng = 12345;
+    for (uint32_t t = 0; t < DETAIL_PASS_MS; t += FRAME_MS) {
+        host_millis = start + t;
+        if (t % 250 == 0) {
+            rng = rng * 1103515245 + 12345;
+            if ((rng >> 16) % 10 < 7) {
+                double d = ((double)t - DETAIL_PASS_MS / 2) / 8000.0;
+                int8_t rssi = (int8_t)(-88 + 40 * exp(-d * d) - (int)((rng >> 20) % 6));
+                sighting(DETAIL_MAC, rssi);
+            }
+        }
+        frame(r);
+    }
+}
+#endif
+
+static void run_stream(SceneResult& r) {
+    size_t next = 0;
+    uint8_t channel = 1;
+    uint32_t start = millis();
+    for (uint32_t t = 0; t < STREAM_MS; t += FRAME_MS) {
+        while (next < sizeof(stream_events) / sizeof(stream_events[0]) && stream_events[next].at_ms <= t) {
+            const StreamEvent& e = stream_events[next++];
+            if (e.type) {
+                add_detection(e);
+            } else {
+                sighting(e.mac, e.rssi);
+                display.updateProximity(String(e.mac), e.rssi, (RssiPhase)e.phase);
+            }
+        }
+        if (t % 300 == 0) {
+            channel = channel % 13 + 1;
+            display.updateChannelInfo(channel);
+        }
+        if (t % 4000 == 0) display.updateScanMode(t % 8000 != 0);
+        host_millis = start + t;
+        frame(r);
+    }
+}
+
+struct PageDef {
+    const char* name;
+    DisplayHandler::DisplayPage page;
+};
+
+static const PageDef pages[] = {
+    { "main",     DisplayHandler::PAGE_MAIN },
+    { "list",     DisplayHandler::PAGE_LIST },
+    { "stats",    DisplayHandler::PAGE_STATS },
+    { "settings", DisplayHandler::PAGE_SETTINGS },
+#if defined(CYD_DISPLAY)
+    { "calibrate", DisplayHandler::PAGE_CALIBRATE },
+#endif
+};
+
+static std::map<std::string, uint32_t> load_golden(const std::string& path) {
+    std::map<std::string, uint32_t> out;
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return out;
+    char name[64];
+    unsigned hv;
+    char line[160];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%63s %x", name, &hv) == 2) out[name] = hv;
+    }
+    fclose(f);
+    return out;
+}
+
+static bool save_golden(const std::string& path, const std::vector<SceneResult>& results) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "# display_sim golden framebuffer hashes (FNV-1a of RGB565), board %s\n", SIM_BOARD);
+    fprintf(f, "# Regenerate with --update after an intended UI change\n");
+    for (const SceneResult& r : results) fprintf(f, "%s %08x\n", r.name.c_str(), r.hash);
+    return fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&](void) -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (a == "--out") cfg.out = next();
+        else if (a == "--golden") cfg.golden = next();
+        else if (a == "--update") cfg.update = true;
+        else if (a == "--no-png") cfg.png = false;
+        else if (a == "--serial") host_serial_echo = true;
+        else if (a == "-h" || a == "--help") {
+            printf("usage: %s [--out DIR] [--golden FILE] [--update] [--no-png] [--serial]\n", argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "unknown option %s\n", a.c_str());
+            return 2;
+        }
+    }
+    if (cfg.png) mkdir(cfg.out.c_str(), 0755);
+
+    Scenes scenes(cfg);
+    host_millis = 1000;
+
+    scenes.run("boot", [](SceneResult& r) {
+        auto t0 = std::chrono::steady_clock::now();
+        display.begin(false);
+        r.host_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        r.frames = 1;
+        r.max_bytes = tft().stats().bytes();
+    });
+
+    scenes.run("main_empty", [](SceneResult& r) {
+        display.setPage(DisplayHandler::PAGE_MAIN);
+        frame(r);
+    });
+
+    scenes.run("stream", run_stream);
+
+    for (const PageDef& p : pages) {
+        scenes.run(p.name, [&](SceneResult& r) {
+            advance(FRAME_MS);
+            display.setPage(p.page);
+            frame(r);
+        });
+        std::string refresh = std::string(p.name) + "_refresh";
+        scenes.run(refresh.c_str(), [](SceneResult& r) {
+            advance(1001);
+            frame(r);
+        });
+    }
+
+    scenes.run("toast", [](SceneResult& r) {
+        display.setPage(DisplayHandler::PAGE_MAIN);
+        frame(r);
+        display.showAlert("FLOCK DETECTED");
+        for (int i = 0; i < 8; i++) {
+            advance(FRAME_MS);
+            frame(r);
+        }
+    });
+
+#if defined(CYD_DISPLAY)
+    advance(TOAST_DEFAULT_MS + FRAME_MS);
+    display.update();   // Toast gone, HOME back (not part of a scene)
+    scenes.run("detail", [](SceneResult& r) {
+        display.setPage(DisplayHandler::PAGE_LIST);
+        frame(r);
+        display.showDetail(DETAIL_MAC);
+        advance(FRAME_MS);
+        frame(r);
+    });
+    scenes.run("detail_live", run_detail_pass);
+#endif
+
+    printf("Board %s, %dx%d, SPI %.0f MHz\n\n", SIM_BOARD, tft().width(), tft().height(), SPI_FREQUENCY / 1e6);
+    printf("%-18s %6s %7s %7s %9s %8s %8s %9s %9s\n",
+           "scene", "frames", "calls", "windows", "KB", "bus_ms", "max_KB", "host_us", "hash");
+    for (const SceneResult& r : scenes.results) {
+        printf("%-18s %6u %7u %7u %9.1f %8.2f %8.1f %9.0f %08x\n",
+               r.name.c_str(), r.frames, r.cost.totalCalls(), r.cost.windows, r.cost.bytes() / 1024.0,
+               r.cost.busMs(), r.max_bytes / 1024.0, r.host_us, r.hash);
+    }
+
+    // Primitive mix over the whole run
+    TftStats all = tft().stats();
+    printf("\nPrimitive calls:");
+    for (int i = 0; i < TFT_PRIM_COUNT; i++) {
+        if (all.calls[i]) printf(" %s=%u", tft_primitive_names[i], all.calls[i]);
+    }
+    printf("\n");
+
+    if (cfg.update) {
+        if (!save_golden(cfg.golden, scenes.results)) {
+            fprintf(stderr, "%s: cannot write\n", cfg.golden.c_str());
+            return 1;
+        }
+        printf("Golden hashes written to %s\n", cfg.golden.c_str());
+        return 0;
+    }
+    std::map<std::string, uint32_t> golden = load_golden(cfg.golden);
+    if (golden.empty()) {
+        printf("No golden file %s (run with --update to create it)\n", cfg.golden.c_str());
+        return 0;
+    }
+    int diffs = 0;
+    for (const SceneResult& r : scenes.results) {
+        auto it = golden.find(r.name);
+        if (it == golden.end()) {
+            printf("NEW   %s\n", r.name.c_str());
+        } else if (it->second != r.hash) {
+            printf("DIFF  %s: %08x, golden %08x\n", r.name.c_str(), r.hash, it->second);
+            diffs++;
+        }
+    }
+    if (diffs) {
+        printf("%d scene(s) differ from %s\n", diffs, cfg.golden.c_str());
+        return 1;
+    }
+    printf("All scenes match %s\n", cfg.golden.c_str());
+    return 0;
+}
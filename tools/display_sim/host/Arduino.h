@@ -0,0 +1,245 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the Arduino core, enough to run the display handlers
+ *
+ * millis() is a virtual clock the simulator advances; delay() advances it
+ * too, so boot animations cost no wall time. FreeRTOS calls are no-ops
+ * (queues are always empty, tasks are never started), GPIO reads return
+ * idle levels and Serial goes to stderr only when host_serial_echo is set.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include "pins_arduino.h"
+
+using std::max;
+using std::min;
+
+// ============================================================================
+// Clock and board
+// ============================================================================
+
+extern uint32_t host_millis;
+extern bool host_serial_echo;
+
+inline uint32_t millis() { return host_millis; }
+inline uint32_t micros() { return host_millis * 1000; }
+inline void delay(uint32_t ms) { host_millis += ms; }
+uint32_t esp_random();
+
+#define IRAM_ATTR
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define FALLING 0x02
+#define RISING 0x01
+#define CHANGE 0x03
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return HIGH; }   // Buttons released, touch IRQ idle
+inline int analogRead(int) { return 2048; }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int, void (*)(), int) {}
+inline void detachInterrupt(int) {}
+
+inline double ledcSetup(uint8_t, double freq, uint8_t) { return freq; }
+inline void ledcAttachPin(uint8_t, uint8_t) {}
+inline void ledcWrite(uint8_t, uint32_t) {}
+inline double ledcWriteTone(uint8_t, double freq) { return freq; }
+
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ============================================================================
+// FreeRTOS
+// ============================================================================
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef int esp_err_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) (ms)
+#define portYIELD_FROM_ISR() do {} while (0)
+#define ESP_OK 0
+#define ESP_ERR_INVALID_STATE 0x103
+
+typedef struct { int owner; int count; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+#define portENTER_CRITICAL(m) (void)(m)
+#define portEXIT_CRITICAL(m) (void)(m)
+
+inline void vTaskDelay(TickType_t ticks) { host_millis += ticks; }
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+    if (handle) *handle = nullptr;   // Never runs: no touch or background tasks on the host
+    return pdPASS;
+}
+
+// Queues: created, always empty
+inline QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t) { static int q; return &q; }
+inline BaseType_t xQueueSend(QueueHandle_t, const void*, TickType_t) { return pdFALSE; }
+inline BaseType_t xQueueReceive(QueueHandle_t, void*, TickType_t) { return pdFALSE; }
+
+// ============================================================================
+// String
+// ============================================================================
+
+class String {
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& v) : s(v) {}
+    String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(double v, unsigned decimals = 2) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        s = buf;
+    }
+
+    unsigned length() const { return (unsigned)s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    const char* c_str() const { return s.c_str(); }
+    char charAt(unsigned i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned i) const { return charAt(i); }
+
+    int indexOf(char c, unsigned from = 0) const { return pos(s.find(c, from)); }
+    int indexOf(const String& v, unsigned from = 0) const { return pos(s.find(v.s, from)); }
+    int lastIndexOf(char c) const { return pos(s.rfind(c)); }
+    String substring(unsigned from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(unsigned from, unsigned to) const {
+        if (to > s.size()) to = (unsigned)s.size();
+        return from < to ? String(s.substr(from, to - from)) : String();
+    }
+    bool startsWith(const String& v) const { return s.compare(0, v.s.size(), v.s) == 0; }
+    bool endsWith(const String& v) const {
+        return s.size() >= v.s.size() && s.compare(s.size() - v.s.size(), v.s.size(), v.s) == 0;
+    }
+    bool equals(const String& v) const { return s == v.s; }
+    bool equalsIgnoreCase(const String& v) const { return strcasecmp(s.c_str(), v.s.c_str()) == 0; }
+    int compareTo(const String& v) const { return s.compare(v.s); }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+
+    void trim() {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+    void toLowerCase() { for (char& c : s) c = (char)tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : s) c = (char)toupper((unsigned char)c); }
+    void replace(const String& from, const String& to) {
+        if (from.s.empty()) return;
+        for (size_t p = 0; (p = s.find(from.s, p)) != std::string::npos; p += to.s.size()) s.replace(p, from.s.size(), to.s);
+    }
+    void remove(unsigned index, unsigned count = 0xFFFFFFFFu) { if (index < s.size()) s.erase(index, count); }
+    bool reserve(unsigned n) { s.reserve(n); return true; }
+    bool concat(const String& v) { s += v.s; return true; }
+
+    String& operator+=(const String& v) { s += v.s; return *this; }
+    String& operator+=(const char* v) { s += v; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned v) { s += std::to_string(v); return *this; }
+    String& operator+=(long v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v) { s += std::to_string(v); return *this; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    friend String operator+(const String& a, char b) { return String(a.s + b); }
+    friend String operator+(const String& a, int b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, unsigned b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, long b) { return String(a.s + std::to_string(b)); }
+    friend String operator+(const String& a, unsigned long b) { return String(a.s + std::to_string(b)); }
+
+    bool operator==(const String& v) const { return s == v.s; }
+    bool operator==(const char* v) const { return s == v; }
+    bool operator!=(const String& v) const { return s != v.s; }
+    bool operator!=(const char* v) const { return s != v; }
+    bool operator<(const String& v) const { return s < v.s; }
+
+private:
+    static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+    std::string s;
+};
+
+// ============================================================================
+// Print / Serial
+// ============================================================================
+
+#define DEC 10
+#define HEX 16
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len) {
+        size_t n = 0;
+        while (len--) n += write(*buf++);
+        return n;
+    }
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+    size_t print(const char* v) { return write(v); }
+    size_t print(const String& v) { return write(v.c_str()); }
+    size_t print(char v) { return write((uint8_t)v); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(long long v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned long long v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(double v, int digits = 2);
+
+    template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+    size_t println() { return write((const uint8_t*)"\r\n", 2); }
+
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HardwareSerial : public Print {
+public:
+    size_t write(uint8_t c) override { if (host_serial_echo) fputc(c, stderr); return 1; }
+    using Print::write;
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() {}
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,56 @@
+/**
+ * @file FS.h
+ * @brief Host stand-in for the Arduino FS File: never open
+ */
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+class File : public Print {
+public:
+    operator bool() const { return false; }
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t*, size_t) override { return 0; }
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t read(uint8_t*, size_t) { return 0; }
+    size_t readBytesUntil(char, char*, size_t) { return 0; }
+    String readStringUntil(char) { return String(); }
+    bool seek(uint32_t) { return false; }
+    size_t position() { return 0; }
+    size_t size() { return 0; }
+    void flush() {}
+    void close() {}
+};
+
+// No card: every operation fails, as with an empty slot
+class FS {
+public:
+    File open(const char*, const char* = FILE_READ, bool = false) { return File(); }
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char*) { return false; }
+    bool exists(const String&) { return false; }
+    bool remove(const char*) { return false; }
+    bool remove(const String&) { return false; }
+    bool rename(const char*, const char*) { return false; }
+    bool rename(const String&, const String&) { return false; }
+    bool mkdir(const char*) { return false; }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // HOST_FS_H
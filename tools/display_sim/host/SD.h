@@ -0,0 +1,26 @@
+/**
+ * @file SD.h
+ * @brief Host stand-in for the SPI SD library: no card inserted
+ */
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include <FS.h>
+#include <SPI.h>
+
+typedef enum { CARD_NONE, CARD_MMC, CARD_SD, CARD_SDHC, CARD_UNKNOWN } sdcard_type_t;
+
+class SDFS : public fs::FS {
+public:
+    bool begin(uint8_t = 0, SPIClass& = SPI, uint32_t = 4000000) { return false; }
+    void end() {}
+    sdcard_type_t cardType() { return CARD_NONE; }
+    uint64_t cardSize() { return 0; }
+    uint64_t totalBytes() { return 0; }
+    uint64_t usedBytes() { return 0; }
+};
+
+extern SDFS SD;
+
+#endif // HOST_SD_H
@@ -0,0 +1,24 @@
+/**
+ * @file SD_MMC.h
+ * @brief Host stand-in for the SDMMC library: no card inserted
+ */
+
+#ifndef HOST_SD_MMC_H
+#define HOST_SD_MMC_H
+
+#include <SD.h>
+
+class SDMMCFS : public fs::FS {
+public:
+    bool setPins(int, int, int, int = -1, int = -1, int = -1) { return true; }
+    bool begin(const char* = "/sdcard", bool = false, bool = false, int = 0, uint8_t = 5) { return false; }
+    void end() {}
+    sdcard_type_t cardType() { return CARD_NONE; }
+    uint64_t cardSize() { return 0; }
+    uint64_t totalBytes() { return 0; }
+    uint64_t usedBytes() { return 0; }
+};
+
+extern SDMMCFS SD_MMC;
+
+#endif // HOST_SD_MMC_H
@@ -0,0 +1,33 @@
+/**
+ * @file SPI.h
+ * @brief Host stand-in for the Arduino SPI bus: transfers read back zero
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#define HSPI 2
+#define VSPI 3
+#define SPI_MODE0 0
+#define MSBFIRST 1
+
+struct SPISettings {
+    SPISettings(uint32_t = 1000000, uint8_t = MSBFIRST, uint8_t = SPI_MODE0) {}
+};
+
+class SPIClass {
+public:
+    SPIClass(uint8_t = VSPI) {}
+    void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t) { return 0; }
+    uint16_t transfer16(uint16_t) { return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
@@ -0,0 +1,140 @@
+/**
+ * @file TFT_eSPI.h
+ * @brief Host TFT_eSPI: draws into an RGB565 framebuffer and counts SPI traffic
+ *
+ * Implements the subset of the TFT_eSPI API the display handlers use, with
+ * the library's own decomposition of each primitive (rectangles into fast
+ * lines, circles into spans, GLCD text into a window push or per-pixel
+ * writes) so the counters match what goes over the bus:
+ *
+ * - Every block write opens an address window: CASET + 4 bytes, RASET +
+ *   4 bytes, RAMWR, with the column/row commands skipped when unchanged
+ *   (TFT_eSPI caches them on ESP32).
+ * - Pixels are 2 bytes each.
+ *
+ * stats() is cumulative; the simulator takes differences around a frame.
+ * Font 1 (the 6x8 GLCD font) is the only font; it is all the handlers use.
+ */
+
+#ifndef HOST_TFT_ESPI_H
+#define HOST_TFT_ESPI_H
+
+#include <Arduino.h>
+#include <vector>
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH  240
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 320
+#endif
+#ifndef SPI_FREQUENCY
+#define SPI_FREQUENCY 40000000
+#endif
+
+#define TFT_BLACK       0x0000
+#define TFT_NAVY        0x000F
+#define TFT_DARKGREEN   0x03E0
+#define TFT_MAROON      0x7800
+#define TFT_DARKGREY    0x7BEF
+#define TFT_BLUE        0x001F
+#define TFT_GREEN       0x07E0
+#define TFT_CYAN        0x07FF
+#define TFT_RED         0xF800
+#define TFT_MAGENTA     0xF81F
+#define TFT_YELLOW      0xFFE0
+#define TFT_ORANGE      0xFDA0
+#define TFT_WHITE       0xFFFF
+
+enum TftPrimitive : uint8_t {
+    TFT_PRIM_FILL_SCREEN = 0,
+    TFT_PRIM_FILL_RECT,
+    TFT_PRIM_DRAW_RECT,
+    TFT_PRIM_HLINE,
+    TFT_PRIM_VLINE,
+    TFT_PRIM_LINE,
+    TFT_PRIM_FILL_CIRCLE,
+    TFT_PRIM_PIXEL,
+    TFT_PRIM_CHAR,
+    TFT_PRIM_COUNT,
+};
+
+struct TftStats {
+    uint32_t calls[TFT_PRIM_COUNT];   // Calls made by the caller (not nested ones)
+    uint32_t windows;                 // Address windows opened
+    uint64_t cmd_bytes;               // Window commands and their parameters
+    uint64_t pixel_bytes;             // RGB565 data
+    uint64_t pixels;                  // Pixels written, clipped ones included
+
+    uint64_t bytes() const { return cmd_bytes + pixel_bytes; }
+    uint32_t totalCalls() const;
+    // Bus time at SPI_FREQUENCY, ignoring DC toggles and gaps
+    double busMs() const { return bytes() * 8.0 * 1000.0 / SPI_FREQUENCY; }
+    TftStats operator-(const TftStats& o) const;
+};
+
+extern const char* const tft_primitive_names[TFT_PRIM_COUNT];
+
+class TFT_eSPI : public Print {
+public:
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+
+    void init();
+    void begin() { init(); }
+    void setRotation(uint8_t r);
+    int16_t width() const { return w; }
+    int16_t height() const { return h; }
+
+    void fillScreen(uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+
+    void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+    int16_t getCursorX() const { return cursor_x; }
+    int16_t getCursorY() const { return cursor_y; }
+    void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+    void setTextColor(uint16_t c, uint16_t bg) { textcolor = c; textbgcolor = bg; }
+    void setTextSize(uint8_t s) { textsize = s ? s : 1; }
+    void setTextWrap(bool wrap) { textwrap = wrap; }
+    int16_t textWidth(const char* s) const { return (int16_t)(strlen(s) * 6 * textsize); }
+    int16_t fontHeight() const { return 8 * textsize; }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Host side. The handlers keep their TFT_eSPI private: the simulator
+    // reaches it as the most recently constructed instance.
+    static TFT_eSPI* active();
+    const TftStats& stats() const { return st; }
+    const std::vector<uint16_t>& framebuffer() const { return fb; }
+    uint16_t pixel(int32_t x, int32_t y) const;
+    // Framebuffer as PNG (8-bit RGB, stored deflate blocks)
+    bool writePng(const char* path) const;
+    // FNV-1a of the framebuffer, for golden comparisons
+    uint32_t hash() const;
+
+private:
+    void drawChar(int32_t x, int32_t y, uint8_t c, uint16_t color, uint16_t bg, uint8_t size);
+    // One TFT_eSPI block write: window + count pixels of one colour
+    void block(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+    void setWindow(int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+    void count(TftPrimitive p) { if (!depth) st.calls[p]++; }
+
+    int16_t w, h;
+    uint8_t rotation;
+    std::vector<uint16_t> fb;          // Rotated view, row-major, w x h
+    int16_t cursor_x, cursor_y;
+    uint16_t textcolor, textbgcolor;
+    uint8_t textsize;
+    bool textwrap;
+    int32_t win_cols, win_rows;        // Cached CASET/RASET (-1: none)
+    uint8_t depth;                     // Nested primitive calls are not counted
+    TftStats st;
+};
+
+#endif // HOST_TFT_ESPI_H
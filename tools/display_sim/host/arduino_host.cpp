@@ -0,0 +1,66 @@
+/**
+ * @file arduino_host.cpp
+ * @brief Host Arduino core globals: virtual clock, Print, Serial, empty SD slots
+ *
+ * @see Arduino.h
+ */
+
+#include <Arduino.h>
+#include <SD.h>
+#include <SD_MMC.h>
+#include <SPI.h>
+
+uint32_t host_millis = 0;
+bool host_serial_echo = false;
+
+HardwareSerial Serial;
+SPIClass SPI;
+SDFS SD;
+SDMMCFS SD_MMC;
+
+// Deterministic, so session IDs and anything derived from them are stable
+uint32_t esp_random() {
+    static uint32_t x = 0x2545F491u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+size_t Print::print(long v, int base) {
+    if (base == DEC) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "%ld", v);
+        return write(buf);
+    }
+    return print((unsigned long)v, base);
+}
+
+size_t Print::print(unsigned long v, int base) {
+    char buf[72];
+    char* p = buf + sizeof(buf) - 1;
+    *p = 0;
+    if (base < 2) base = DEC;
+    do {
+        int d = (int)(v % base);
+        *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+        v /= base;
+    } while (v);
+    return write(p);
+}
+
+size_t Print::print(double v, int digits) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return write(buf);
+}
+
+size_t Print::printf(const char* fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return 0;
+    return write((const uint8_t*)buf, std::min<size_t>((size_t)n, sizeof(buf) - 1));
+}
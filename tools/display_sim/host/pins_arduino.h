@@ -0,0 +1,31 @@
+/**
+ * @file pins_arduino.h
+ * @brief Board build flags from platformio.ini that the display handlers use
+ *
+ * Keep in step with the esp32_cyd_28 and waveshare_s3_147 environments.
+ */
+
+#ifndef HOST_PINS_ARDUINO_H
+#define HOST_PINS_ARDUINO_H
+
+#if defined(CYD_DISPLAY)
+#define TFT_WIDTH       240
+#define TFT_HEIGHT      320
+#define TFT_BL          27
+#define TFT_BL2         21
+#define TOUCH_CS        33
+#define TOUCH_IRQ       36
+#define TOUCH_CLK       25
+#define TOUCH_MOSI      32
+#define TOUCH_MISO      39
+#define SPI_FREQUENCY   80000000
+#elif defined(WAVESHARE_147)
+#define TFT_WIDTH       172
+#define TFT_HEIGHT      320
+#define TFT_BL          48
+#define SPI_FREQUENCY   40000000
+#define RGB_LED_PIN     38
+#define SD_MMC_MODE     1
+#endif
+
+#endif // HOST_PINS_ARDUINO_H
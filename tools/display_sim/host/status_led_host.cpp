@@ -0,0 +1,47 @@
+/**
+ * @file status_led_host.cpp
+ * @brief Host StatusLed: effect state only, no task or LED backend
+ *
+ * Replaces src/status_led.cpp (LEDC/RMT) in the display simulator.
+ *
+ * @see status_led.h
+ */
+
+#include "status_led.h"
+
+StatusLed status_led;
+
+StatusLed::StatusLed()
+    : effects(led_effects_default, LED_FX_COUNT),
+      task(nullptr),
+      backend(LED_NONE),
+      scale(255),
+      enabled(true),
+      manual(false),
+      manualColor{0, 0, 0},
+      last{0, 0, 0},
+      written(false),
+      channels{0, 0, 0},
+      rmtChannel(nullptr),
+      rmtEncoder(nullptr),
+      pixel{0, 0, 0}
+{
+}
+
+bool StatusLed::beginLedc(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) { return true; }
+bool StatusLed::beginWs2812(uint8_t) { return true; }
+
+void StatusLed::play(uint8_t effect, int8_t rssi) {
+    manual = false;
+    effects.play(effect, millis(), rssi);
+}
+
+void StatusLed::skip(uint8_t effect) { effects.skip(effect, millis()); }
+
+void StatusLed::show(uint8_t r, uint8_t g, uint8_t b) {
+    manual = true;
+    manualColor = { r, g, b };
+}
+
+void StatusLed::setScale(uint8_t level) { scale = level; }
+void StatusLed::setEnabled(bool on) { enabled = on; }
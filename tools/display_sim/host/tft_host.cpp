@@ -0,0 +1,344 @@
+/**
+ * @file tft_host.cpp
+ * @brief Host TFT_eSPI framebuffer, bus accounting and PNG output
+ *
+ * @see TFT_eSPI.h
+ */
+
+#include "TFT_eSPI.h"
+
+// Classic 5x7 GLCD glyphs for ' '..'~', one byte per column, LSB at the top
+static const uint8_t glcd_font[95][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x56,0x20,0x50}, {0x00,0x08,0x07,0x03,0x00},
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x2A,0x1C,0x7F,0x1C,0x2A}, {0x08,0x08,0x3E,0x08,0x08},
+    {0x00,0x80,0x70,0x30,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x00,0x60,0x60,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x72,0x49,0x49,0x49,0x46}, {0x21,0x41,0x49,0x4D,0x33},
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x31}, {0x41,0x21,0x11,0x09,0x07},
+    {0x36,0x49,0x49,0x49,0x36}, {0x46,0x49,0x49,0x29,0x1E}, {0x00,0x00,0x14,0x00,0x00}, {0x00,0x40,0x34,0x00,0x00},
+    {0x00,0x08,0x14,0x22,0x41}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x59,0x09,0x06},
+    {0x3E,0x41,0x5D,0x59,0x4E}, {0x7C,0x12,0x11,0x12,0x7C}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+    {0x7F,0x41,0x41,0x41,0x3E}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x41,0x51,0x73},
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x1C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x26,0x49,0x49,0x49,0x32},
+    {0x03,0x01,0x7F,0x01,0x03}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+    {0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x59,0x49,0x4D,0x43}, {0x00,0x7F,0x41,0x41,0x41},
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x41,0x7F}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+    {0x00,0x03,0x07,0x08,0x00}, {0x20,0x54,0x54,0x78,0x40}, {0x7F,0x28,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x28},
+    {0x38,0x44,0x44,0x28,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x00,0x08,0x7E,0x09,0x02}, {0x18,0xA4,0xA4,0x9C,0x78},
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x40,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00},
+    {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x78,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+    {0xFC,0x18,0x24,0x24,0x18}, {0x18,0x24,0x24,0x18,0xFC}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x24},
+    {0x04,0x04,0x3F,0x44,0x24}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+    {0x44,0x28,0x10,0x28,0x44}, {0x4C,0x90,0x90,0x90,0x7C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+    {0x00,0x00,0x77,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x02,0x01,0x02,0x04,0x02},
+};
+
+const char* const tft_primitive_names[TFT_PRIM_COUNT] = {
+    "fillScreen", "fillRect", "drawRect", "hline", "vline", "line", "fillCircle", "pixel", "char",
+};
+
+// Primitives built from other primitives count once, as the outer call
+struct NestGuard {
+    uint8_t& depth;
+    explicit NestGuard(uint8_t& d) : depth(d) { depth++; }
+    ~NestGuard() { depth--; }
+};
+
+uint32_t TftStats::totalCalls() const {
+    uint32_t n = 0;
+    for (int i = 0; i < TFT_PRIM_COUNT; i++) n += calls[i];
+    return n;
+}
+
+TftStats TftStats::operator-(const TftStats& o) const {
+    TftStats d;
+    for (int i = 0; i < TFT_PRIM_COUNT; i++) d.calls[i] = calls[i] - o.calls[i];
+    d.windows = windows - o.windows;
+    d.cmd_bytes = cmd_bytes - o.cmd_bytes;
+    d.pixel_bytes = pixel_bytes - o.pixel_bytes;
+    d.pixels = pixels - o.pixels;
+    return d;
+}
+
+static TFT_eSPI* active_tft = nullptr;
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h)
+    : w(w), h(h), rotation(0), fb((size_t)w * h, TFT_BLACK), cursor_x(0), cursor_y(0),
+      textcolor(TFT_WHITE), textbgcolor(TFT_WHITE), textsize(1), textwrap(true),
+      win_cols(-1), win_rows(-1), depth(0), st() {
+    active_tft = this;
+}
+
+TFT_eSPI* TFT_eSPI::active() { return active_tft; }
+
+void TFT_eSPI::init() {
+    win_cols = win_rows = -1;
+}
+
+void TFT_eSPI::setRotation(uint8_t r) {
+    rotation = r & 3;
+    int16_t a = TFT_WIDTH, b = TFT_HEIGHT;
+    w = rotation & 1 ? b : a;
+    h = rotation & 1 ? a : b;
+    fb.assign((size_t)w * h, TFT_BLACK);   // The panel keeps its RAM; the sim starts clean
+    win_cols = win_rows = -1;
+}
+
+uint16_t TFT_eSPI::pixel(int32_t x, int32_t y) const {
+    if (x < 0 || y < 0 || x >= w || y >= h) return 0;
+    return fb[(size_t)y * w + x];
+}
+
+void TFT_eSPI::setWindow(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    int32_t cols = (x0 << 16) | x1;
+    int32_t rows = (y0 << 16) | y1;
+    st.windows++;
+    if (cols != win_cols) st.cmd_bytes += 5;   // CASET + 4
+    if (rows != win_rows) st.cmd_bytes += 5;   // RASET + 4
+    st.cmd_bytes += 1;                          // RAMWR
+    win_cols = cols;
+    win_rows = rows;
+}
+
+void TFT_eSPI::block(int32_t x, int32_t y, int32_t bw, int32_t bh, uint16_t color) {
+    if (x < 0) { bw += x; x = 0; }
+    if (y < 0) { bh += y; y = 0; }
+    if (x + bw > w) bw = w - x;
+    if (y + bh > h) bh = h - y;
+    if (bw < 1 || bh < 1) return;
+    setWindow(x, y, x + bw - 1, y + bh - 1);
+    uint64_t n = (uint64_t)bw * bh;
+    st.pixels += n;
+    st.pixel_bytes += n * 2;
+    for (int32_t j = 0; j < bh; j++) {
+        uint16_t* row = &fb[(size_t)(y + j) * w + x];
+        for (int32_t i = 0; i < bw; i++) row[i] = color;
+    }
+}
+
+void TFT_eSPI::fillScreen(uint32_t color) {
+    count(TFT_PRIM_FILL_SCREEN);
+    block(0, 0, w, h, (uint16_t)color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color) {
+    count(TFT_PRIM_FILL_RECT);
+    block(x, y, rw, rh, (uint16_t)color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t len, uint32_t color) {
+    count(TFT_PRIM_HLINE);
+    block(x, y, len, 1, (uint16_t)color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t len, uint32_t color) {
+    count(TFT_PRIM_VLINE);
+    block(x, y, 1, len, (uint16_t)color);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    count(TFT_PRIM_PIXEL);
+    block(x, y, 1, 1, (uint16_t)color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t rw, int32_t rh, uint32_t color) {
+    count(TFT_PRIM_DRAW_RECT);
+    NestGuard nest(depth);
+    drawFastHLine(x, y, rw, color);
+    drawFastHLine(x, y + rh - 1, rw, color);
+    drawFastVLine(x, y + 1, rh - 2, color);
+    drawFastVLine(x + rw - 1, y + 1, rh - 2, color);
+}
+
+void TFT_eSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+    count(TFT_PRIM_LINE);
+    NestGuard nest(depth);
+    // TFT_eSPI's Bresenham: each straight run is one block write
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+    if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+    int32_t dx = x1 - x0, dy = abs(y1 - y0);
+    int32_t err = dx >> 1, ystep = y0 < y1 ? 1 : -1;
+    int32_t run_start = x0, run_y = y0;
+    for (int32_t x = x0; x <= x1; x++) {
+        err -= dy;
+        if (err < 0 || x == x1) {
+            int32_t len = x - run_start + 1;
+            if (steep) drawFastVLine(run_y, run_start, len, color);
+            else drawFastHLine(run_start, run_y, len, color);
+            if (err < 0) {
+                err += dx;
+                run_y += ystep;
+            }
+            run_start = x + 1;
+        }
+    }
+}
+
+void TFT_eSPI::fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color) {
+    count(TFT_PRIM_FILL_CIRCLE);
+    NestGuard nest(depth);
+    int32_t x = 0, dx = 1, dy = r + r, p = -(r >> 1);
+    drawFastHLine(x0 - r, y0, dy + 1, color);
+    while (x < r) {
+        if (p >= 0) {
+            drawFastHLine(x0 - x, y0 + r, dx, color);
+            drawFastHLine(x0 - x, y0 - r, dx, color);
+            dy -= 2;
+            p -= dy;
+            r--;
+        }
+        dx += 2;
+        p += dx;
+        x++;
+        drawFastHLine(x0 - r, y0 + x, dy + 1, color);
+        drawFastHLine(x0 - r, y0 - x, dy + 1, color);
+    }
+}
+
+void TFT_eSPI::drawChar(int32_t x, int32_t y, uint8_t c, uint16_t color, uint16_t bg, uint8_t size) {
+    count(TFT_PRIM_CHAR);
+    NestGuard nest(depth);
+    const uint8_t* glyph = c >= 0x20 && c <= 0x7E ? glcd_font[c - 0x20] : glcd_font[0];
+    bool fillbg = bg != color;
+
+    if (size == 1 && fillbg && x >= 0 && y >= 0 && x + 6 <= w && y + 8 <= h) {
+        // Fast path: one 6x8 window, 48 pixels pushed
+        setWindow(x, y, x + 5, y + 7);
+        st.pixels += 48;
+        st.pixel_bytes += 96;
+        for (int32_t i = 0; i < 6; i++) {
+            uint8_t line = i < 5 ? glyph[i] : 0;
+            for (int32_t j = 0; j < 8; j++, line >>= 1) fb[(size_t)(y + j) * w + x + i] = line & 1 ? color : bg;
+        }
+        return;
+    }
+    for (int32_t i = 0; i < 5; i++) {
+        uint8_t line = glyph[i];
+        for (int32_t j = 0; j < 8; j++, line >>= 1) {
+            if (line & 1) {
+                if (size == 1) drawPixel(x + i, y + j, color);
+                else fillRect(x + i * size, y + j * size, size, size, color);
+            } else if (fillbg) {
+                if (size == 1) drawPixel(x + i, y + j, bg);
+                else fillRect(x + i * size, y + j * size, size, size, bg);
+            }
+        }
+    }
+    if (fillbg) fillRect(x + 5 * size, y, size, 8 * size, bg);
+}
+
+size_t TFT_eSPI::write(uint8_t c) {
+    if (c == '\r') return 1;
+    if (c == '\n') {
+        cursor_x = 0;
+        cursor_y += 8 * textsize;
+        return 1;
+    }
+    if (textwrap && cursor_x + 6 * textsize > w) {
+        cursor_x = 0;
+        cursor_y += 8 * textsize;
+    }
+    drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+    cursor_x += 6 * textsize;
+    return 1;
+}
+
+uint32_t TFT_eSPI::hash() const {
+    uint32_t hv = 2166136261u;
+    for (uint16_t px : fb) {
+        hv = (hv ^ (px & 0xFF)) * 16777619u;
+        hv = (hv ^ (px >> 8)) * 16777619u;
+    }
+    return hv;
+}
+
+// ============================================================================
+// PNG
+// ============================================================================
+
+static uint32_t crc_table[256];
+
+static uint32_t crc32(uint32_t crc, const uint8_t* p, size_t n) {
+    if (!crc_table[1]) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[i] = c;
+        }
+    }
+    crc = ~crc;
+    while (n--) crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+static void chunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> head;
+    put32(head, (uint32_t)data.size());
+    head.insert(head.end(), type, type + 4);
+    uint32_t crc = crc32(crc32(0, (const uint8_t*)type, 4), data.data(), data.size());
+    std::vector<uint8_t> tail;
+    put32(tail, crc);
+    fwrite(head.data(), 1, head.size(), f);
+    fwrite(data.data(), 1, data.size(), f);
+    fwrite(tail.data(), 1, tail.size(), f);
+}
+
+bool TFT_eSPI::writePng(const char* path) const {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(sig, 1, sizeof(sig), f);
+
+    std::vector<uint8_t> ihdr;
+    put32(ihdr, (uint32_t)w);
+    put32(ihdr, (uint32_t)h);
+    ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });   // 8-bit RGB
+    chunk(f, "IHDR", ihdr);
+
+    // Scanlines with filter byte 0, RGB565 widened to RGB888
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)h * (1 + w * 3));
+    for (int32_t y = 0; y < h; y++) {
+        raw.push_back(0);
+        for (int32_t x = 0; x < w; x++) {
+            uint16_t c = fb[(size_t)y * w + x];
+            raw.push_back((uint8_t)((((c >> 11) & 0x1F) * 527 + 23) >> 6));
+            raw.push_back((uint8_t)((((c >> 5) & 0x3F) * 259 + 33) >> 6));
+            raw.push_back((uint8_t)(((c & 0x1F) * 527 + 23) >> 6));
+        }
+    }
+
+    // zlib stream of stored (uncompressed) deflate blocks
+    std::vector<uint8_t> z = { 0x78, 0x01 };
+    for (size_t off = 0; off < raw.size() || off == 0; ) {
+        size_t n = std::min<size_t>(65535, raw.size() - off);
+        bool last = off + n >= raw.size();
+        z.push_back(last ? 1 : 0);
+        z.push_back(n & 0xFF);
+        z.push_back(n >> 8);
+        z.push_back(~n & 0xFF);
+        z.push_back((~n >> 8) & 0xFF);
+        z.insert(z.end(), raw.begin() + off, raw.begin() + off + n);
+        off += n;
+        if (last) break;
+    }
+    uint32_t a = 1, b = 0;
+    for (uint8_t v : raw) {
+        a = (a + v) % 65521;
+        b = (b + a) % 65521;
+    }
+    put32(z, (b << 16) | a);
+    chunk(f, "IDAT", z);
+    chunk(f, "IEND", {});
+    return fclose(f) == 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file dwell_sim.cpp
+ * @brief Offline channel dwell policy simulator (Linux host)
+ *
+ * Replays camera encounters whose WiFi channel is drawn from the `channel`
+ * column of wigle exports (datasets/Flock-*.csv by default) and runs every
+ * dwell policy from src/dwell_policy.cpp against the same encounter stream.
+ * Reports time-to-first-detection (TTFD) and miss rate per policy.
+ *
+ * Model: the radio ticks every 10 ms like loop(). Each encounter keeps one
+ * target in range for --window seconds, beaconing every 102.4 ms on its
+ * channel; each beacon is heard with probability --p-hear while the radio
+ * is tuned there. Background frames arrive per channel at fixed rates so the
+ * activity ladder has something to react to. Every channel switch costs
+ * --switch-ms of deaf time.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/dwell_sim/dwell_sim.cpp src/dwell_policy.cpp -o dwell_sim
+ * Run:
+ *   ./dwell_sim [--encounters N] [--window S] [--gap S] [--p-hear P] [--seed N]
+ *               [--bandit-decay F] [--bandit-explore F] [csv...]
+ */
+
+#include "dwell_policy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <glob.h>
+#include <random>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define TICK_MS 10
+#define BEACON_INTERVAL_US 102400
+
+struct SimConfig {
+    int encounters = 500;
+    double window_s = 15.0;
+    double gap_s = 20.0;
+    double p_hear = 0.5;
+    uint32_t switch_ms = 5;
+    uint32_t seed = 1;
+    float bandit_decay = BANDIT_DECAY;
+    float bandit_explore = BANDIT_EXPLORE;
+};
+
+// Background frames per second, typical urban 2.4 GHz mix
+static const double background_fps[DWELL_MAX_CHANNEL + 1] = {
+    0, 40, 8, 6, 6, 8, 60, 8, 6, 6, 8, 50, 4, 2
+};
+
+// Split one CSV line honouring double quotes
+static std::vector<std::string> split_csv(const std::string& line) {
+    std::vector<std::string> out;
+    std::string cur;
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') quoted = !quoted;
+        else if (c == ',' && !quoted) { out.push_back(cur); cur.clear(); }
+        else if (c != '\r') cur += c;
+    }
+    out.push_back(cur);
+    return out;
+}
+
+// Histogram of 2.4 GHz channels from the `channel` column
+static bool load_channels(const std::vector<std::string>& files, double hist[DWELL_MAX_CHANNEL + 1]) {
+    int rows = 0;
+    for (const std::string& path : files) {
+        std::ifstream in(path);
+        std::string line;
+        if (!std::getline(in, line)) continue;
+        std::vector<std::string> header = split_csv(line);
+        int col = -1;
+        for (size_t i = 0; i < header.size(); i++) {
+            if (header[i] == "channel") col = (int)i;
+        }
+        if (col < 0) {
+            fprintf(stderr, "%s: no channel column, skipped\n", path.c_str());
+            continue;
+        }
+        while (std::getline(in, line)) {
+            std::vector<std::string> f = split_csv(line);
+            if ((int)f.size() <= col) continue;
+            int ch = atoi(f[col].c_str());
+            if (ch >= 1 && ch <= DWELL_MAX_CHANNEL) {
+                hist[ch] += 1;
+                rows++;
+            }
+        }
+    }
+    return rows > 0;
+}
+
+struct SimResult {
+    std::vector<double> ttfd_ms;
+    int missed = 0;
+    uint32_t hops = 0;
+};
+
+static SimResult run(DwellPolicy& policy, const SimConfig& cfg, const double hist[DWELL_MAX_CHANNEL + 1]) {
+    std::mt19937 rng(cfg.seed);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    std::discrete_distribution<int> pick_channel(hist, hist + DWELL_MAX_CHANNEL + 1);
+
+    SimResult res;
+    uint32_t now = 1000;
+    uint8_t channel = 1;
+    uint32_t last_hop = now;
+    uint32_t deaf_until = now;
+    uint16_t frames = 0;
+
+    uint32_t window_ms = (uint32_t)(cfg.window_s * 1000);
+    uint32_t gap_ms = (uint32_t)(cfg.gap_s * 1000);
+
+    for (int e = 0; e < cfg.encounters; e++) {
+        uint8_t target = (uint8_t)pick_channel(rng);
+        uint32_t start = now + gap_ms;
+        uint32_t end = start + window_ms;
+        // Random beacon phase so encounters don't line up with hop boundaries
+        uint64_t next_beacon_us = (uint64_t)start * 1000 + (uint64_t)(uni(rng) * BEACON_INTERVAL_US);
+        bool found = false;
+
+        for (; now < end; now += TICK_MS) {
+            bool listening = (int32_t)(now - deaf_until) >= 0;
+
+            if (listening) {
+                double p_frame = background_fps[channel] * TICK_MS / 1000.0;
+                if (uni(rng) < p_frame) frames++;
+            }
+
+            // Target beacons during this tick
+            while (now >= start && next_beacon_us < (uint64_t)(now + TICK_MS) * 1000) {
+                if (listening && channel == target && uni(rng) < cfg.p_hear) {
+                    frames++;
+                    policy.noteDetection(channel, now);
+                    if (!found) {
+                        found = true;
+                        res.ttfd_ms.push_back(now - start);
+                    }
+                }
+                next_beacon_us += BEACON_INTERVAL_US;
+            }
+
+            uint32_t dwell = policy.dwellTime(channel, frames, now);
+            if (dwell != DWELL_HOLD && now - last_hop > dwell) {
+                DwellVisit visit = { channel, now - last_hop, frames };
+                channel = policy.nextChannel(visit, now);
+                frames = 0;
+                last_hop = now;
+                deaf_until = now + cfg.switch_ms;
+                res.hops++;
+            }
+        }
+        if (!found) res.missed++;
+    }
+    return res;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t idx = (size_t)(p * (v.size() - 1));
+    return v[idx];
+}
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&](void) -> const char* { return i + 1 < argc ? argv[++i] : "0"; };
+        if (a == "--encounters") cfg.encounters = atoi(next());
+        else if (a == "--window") cfg.window_s = atof(next());
+        else if (a == "--gap") cfg.gap_s = atof(next());
+        else if (a == "--p-hear") cfg.p_hear = atof(next());
+        else if (a == "--switch-ms") cfg.switch_ms = (uint32_t)atoi(next());
+        else if (a == "--seed") cfg.seed = (uint32_t)atoi(next());
+        else if (a == "--bandit-decay") cfg.bandit_decay = (float)atof(next());
+        else if (a == "--bandit-explore") cfg.bandit_explore = (float)atof(next());
+        else if (a == "-h" || a == "--help") {
+            printf("usage: %s [--encounters N] [--window S] [--gap S] [--p-hear P] "
+                   "[--switch-ms MS] [--seed N] [--bandit-decay F] [--bandit-explore F] [csv...]\n", argv[0]);
+            return 0;
+        } else files.push_back(a);
+    }
+
+    if (files.empty()) {
+        glob_t g;
+        if (glob("datasets/Flock-*.csv", 0, nullptr, &g) == 0) {
+            for (size_t i = 0; i < g.gl_pathc; i++) files.push_back(g.gl_pathv[i]);
+        }
+        globfree(&g);
+    }
+
+    double hist[DWELL_MAX_CHANNEL + 1] = {0};
+    if (!load_channels(files, hist)) {
+        fprintf(stderr, "No 2.4 GHz channel data found (pass wigle CSVs with a channel column)\n");
+        return 1;
+    }
+
+    double total = 0;
+    for (int ch = 1; ch <= DWELL_MAX_CHANNEL; ch++) total += hist[ch];
+    printf("Channel distribution (%d files):", (int)files.size());
+    for (int ch = 1; ch <= DWELL_MAX_CHANNEL; ch++) {
+        if (hist[ch] > 0) printf(" ch%d=%.1f%%", ch, 100.0 * hist[ch] / total);
+    }
+    printf("\n%d encounters, %.0fs window, %.0fs gap, p_hear=%.2f, switch=%ums\n\n",
+           cfg.encounters, cfg.window_s, cfg.gap_s, cfg.p_hear, cfg.switch_ms);
+
+    printf("%-8s %10s %10s %10s %10s %8s %8s\n",
+           "policy", "mean_ms", "p50_ms", "p90_ms", "p99_ms", "missed", "hops");
+
+    DwellConfig dc;
+    uint8_t kinds[] = { DWELL_POLICY_LADDER, DWELL_POLICY_BANDIT };
+    for (uint8_t kind : kinds) {
+        DwellPolicy* policy = dwell_policy_create(kind, dc);
+        if (kind == DWELL_POLICY_BANDIT) {
+            BanditDwellPolicy* bandit = static_cast<BanditDwellPolicy*>(policy);
+            bandit->decay = cfg.bandit_decay;
+            bandit->explore = cfg.bandit_explore;
+        }
+        SimResult r = run(*policy, cfg, hist);
+        double sum = 0;
+        for (double t : r.ttfd_ms) sum += t;
+        double mean = r.ttfd_ms.empty() ? 0 : sum / r.ttfd_ms.size();
+        printf("%-8s %10.0f %10.0f %10.0f %10.0f %7.1f%% %8u\n",
+               policy->name(), mean,
+               percentile(r.ttfd_ms, 0.5), percentile(r.ttfd_ms, 0.9), percentile(r.ttfd_ms, 0.99),
+               100.0 * r.missed / cfg.encounters, r.hops);
+        delete policy;
+    }
+    return 0;
+}
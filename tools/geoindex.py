@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+"""
+Camera site geo index builder.
+
+Reads the geolocated records in datasets/ and writes the grid index read by
+src/geo_index.cpp. Copy the output to the SD card root as /cameras.fygi.
+
+    Flock-*.csv, FS+Ext+Battery_*.csv, Penguin-*.csv   wigle exports (trilat, trilong)
+    Pigvision.csv                                      "lat, lon" coordinates column
+    maximum_dots.csv                                   longitude, latitude columns
+
+Kinds come from the SSID/name (wigle) or the file (Pigvision, maximum_dots).
+Records of the same kind closer than --merge metres collapse into one site,
+so a camera reported by a dozen wardrivers is one alert, not twelve.
+
+Cells are --radius metres tall and at least --radius metres wide at the
+highest latitude in the data, so a query of up to --radius metres only
+needs the 3x3 block of cells around the position. Cell lookup must match
+src/geo_index.cpp:
+
+    row = floor(lat_e7 / cell_lat_e7), col = floor(lon_e7 / cell_lon_e7)
+    h   = (row * 0x9E3779B1 mod 2^32) ^ (col * 0x85EBCA77 mod 2^32)
+    slot = (h ^ (h >> 15)) & (slots - 1), linear probing
+
+--track writes a GPX drive past the sites (for tools/bench/geo_replay).
+
+Usage:
+    python3 tools/geoindex.py datasets/*.csv -o cameras.fygi
+    python3 tools/geoindex.py datasets/*.csv --bbox 25,-81,27.5,-79.9 --radius 300 -o cameras.fygi
+    python3 tools/geoindex.py datasets/*.csv --track drive.gpx --track-kind penguin
+"""
+
+import argparse
+import csv
+import math
+import os
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = b'FYGI'
+FORMAT = 1
+HEADER = struct.Struct('<4sHHIIIIIIIIII')  # magic, format, reserved, sites, cells, slots,
+                                           # cell_lat, cell_lon, radius, built, payload, crc, reserved
+SLOT = struct.Struct('<iiII')              # row, col, first site, count
+SITE = struct.Struct('<iiBBH')             # lat_e7, lon_e7, kind, reserved, records
+
+KINDS = ['flock', 'fs_battery', 'penguin', 'pigvision', 'camera']
+M_PER_DEG = 111319.5
+MAX_PROBES = 32  # Firmware probe limit per cell
+
+
+def wigle_kind(row):
+    text = ((row.get('ssid') or '') + ' ' + (row.get('name') or '')).lower()
+    if 'penguin' in text:
+        return KINDS.index('penguin')
+    if 'fs ext battery' in text:
+        return KINDS.index('fs_battery')
+    if 'flock' in text:
+        return KINDS.index('flock')
+    return None
+
+
+def read_records(path):
+    """(lat, lon, kind) tuples from one dataset file."""
+    name = os.path.basename(path).lower()
+    out = []
+    with open(path, newline='', encoding='utf-8-sig', errors='replace') as f:
+        for row in csv.DictReader(f):
+            try:
+                if 'trilat' in row:
+                    kind = wigle_kind(row)
+                    lat, lon = float(row['trilat']), float(row['trilong'])
+                elif 'coordinates' in row:
+                    kind = KINDS.index('pigvision')
+                    lat, lon = (float(v) for v in row['coordinates'].split(','))
+                elif 'latitude' in row and 'longitude' in row:
+                    kind = KINDS.index('camera')
+                    lat, lon = float(row['latitude']), float(row['longitude'])
+                    if abs(lat) > 80 >= abs(lon):
+                        lat, lon = lon, lat  # Some rows have the columns swapped
+                else:
+                    sys.exit(f'{path}: unrecognised columns')
+            except (ValueError, TypeError):
+                continue
+            if kind is None or not (-90 <= lat <= 90 and -180 <= lon <= 180) or (lat == 0 and lon == 0):
+                continue
+            out.append((lat, lon, kind))
+    if not out:
+        print(f'{name}: no usable records', file=sys.stderr)
+    return out
+
+
+def merge_sites(records, merge_m):
+    """Collapse same-kind records within merge_m (grid snap) into centroid sites."""
+    step = merge_m / M_PER_DEG
+    groups = {}
+    for lat, lon, kind in records:
+        key = (kind, round(lat / step), round(lon / (step / max(math.cos(math.radians(lat)), 0.01))))
+        g = groups.setdefault(key, [0.0, 0.0, 0])
+        g[0] += lat
+        g[1] += lon
+        g[2] += 1
+    return [(g[0] / g[2], g[1] / g[2], kind, g[2]) for (kind, _, _), g in groups.items()]
+
+
+def cell_hash(row, col):
+    h = ((row * 0x9E3779B1) & 0xFFFFFFFF) ^ ((col * 0x85EBCA77) & 0xFFFFFFFF)
+    return h ^ (h >> 15)
+
+
+def build(sites, radius_m):
+    max_lat = max(abs(lat) for lat, _, _, _ in sites)
+    cell_lat = math.ceil(radius_m / M_PER_DEG * 1e7)
+    cell_lon = math.ceil(cell_lat / max(math.cos(math.radians(min(max_lat + 0.5, 89.0))), 0.01))
+
+    cells = {}
+    for lat, lon, kind, n in sites:
+        lat_e7, lon_e7 = round(lat * 1e7), round(lon * 1e7)
+        cells.setdefault((lat_e7 // cell_lat, lon_e7 // cell_lon), []).append((lat_e7, lon_e7, kind, n))
+
+    slots = 1
+    while slots < 2 * len(cells):
+        slots *= 2
+    table = [None] * slots
+    site_blob = b''
+    first = 0
+    worst = 0
+    for (row, col), members in sorted(cells.items()):
+        slot = cell_hash(row, col) & (slots - 1)
+        probes = 1
+        while table[slot] is not None:
+            slot = (slot + 1) & (slots - 1)
+            probes += 1
+        worst = max(worst, probes)
+        table[slot] = SLOT.pack(row, col, first, len(members))
+        for lat_e7, lon_e7, kind, n in members:
+            site_blob += SITE.pack(lat_e7, lon_e7, kind, 0, min(n, 0xFFFF))
+        first += len(members)
+    if worst > MAX_PROBES:
+        sys.exit(f'probe run of {worst} exceeds the firmware limit of {MAX_PROBES}')
+
+    payload = b''.join(s or SLOT.pack(0, 0, 0, 0) for s in table) + site_blob
+    header = HEADER.pack(MAGIC, FORMAT, 0, len(sites), len(cells), slots, cell_lat, cell_lon,
+                         radius_m, int(time.time()), len(payload), zlib.crc32(payload) & 0xFFFFFFFF, 0)
+    stats = {'cells': len(cells), 'slots': slots, 'cell_lat': cell_lat, 'cell_lon': cell_lon,
+             'worst_probe': worst, 'densest': max(len(m) for m in cells.values())}
+    return header + payload, stats
+
+
+def write_track(path, sites, kind, spacing_m, limit, max_hop_m=3000):
+    """GPX drive visiting sites of one kind in nearest-neighbour order."""
+    pts = [(lat, lon) for lat, lon, k, _ in sites if kind is None or k == kind]
+    if not pts:
+        sys.exit('no sites for --track')
+    # Start in the densest 0.05 degree bucket so the route has neighbours to visit
+    buckets = {}
+    for i, (lat, lon) in enumerate(pts):
+        buckets.setdefault((round(lat * 20), round(lon * 20)), []).append(i)
+    route = [pts.pop(max(buckets.values(), key=len)[0])]
+    while pts and len(route) < limit:
+        lat, lon = route[-1]
+        scale = math.cos(math.radians(lat))
+        i = min(range(len(pts)), key=lambda j: (pts[j][0] - lat) ** 2 + ((pts[j][1] - lon) * scale) ** 2)
+        hop = math.hypot(pts[i][0] - lat, (pts[i][1] - lon) * scale) * M_PER_DEG
+        if hop > max_hop_m:
+            break  # End of the cluster: don't drive across the state
+        route.append(pts.pop(i))
+
+    trkpts = []
+    for (a_lat, a_lon), (b_lat, b_lon) in zip(route, route[1:]):
+        dist = math.hypot((b_lat - a_lat) * M_PER_DEG,
+                          (b_lon - a_lon) * M_PER_DEG * math.cos(math.radians(a_lat)))
+        steps = max(1, int(dist / spacing_m))
+        for s in range(steps):
+            t = s / steps
+            # Offset 40 m north so the track passes by the sites rather than through them
+            trkpts.append((a_lat + (b_lat - a_lat) * t + 40 / M_PER_DEG, a_lon + (b_lon - a_lon) * t))
+    with open(path, 'w') as f:
+        f.write('<?xml version="1.0" encoding="UTF-8"?>\n<gpx version="1.1" creator="geoindex.py">\n'
+                '<trk><name>geoindex replay</name><trkseg>\n')
+        for lat, lon in trkpts:
+            f.write(f'<trkpt lat="{lat:.7f}" lon="{lon:.7f}"></trkpt>\n')
+        f.write('</trkseg></trk>\n</gpx>\n')
+    print(f'{path}: {len(trkpts)} points past {len(route)} sites')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build the camera site geo index')
+    parser.add_argument('csv', nargs='+', help='dataset CSV files')
+    parser.add_argument('-o', '--output', help='output index (copy to SD as /cameras.fygi)')
+    parser.add_argument('--radius', type=int, default=500, help='max query radius / cell size (m)')
+    parser.add_argument('--merge', type=float, default=30, help='merge same-kind records within (m)')
+    parser.add_argument('--bbox', help='lat1,lon1,lat2,lon2 region filter')
+    parser.add_argument('--kinds', help='comma-separated kinds to keep (%s)' % ','.join(KINDS))
+    parser.add_argument('--track', metavar='GPX', help='write a replay track past the sites')
+    parser.add_argument('--track-kind', choices=KINDS, help='only route past this kind')
+    parser.add_argument('--track-sites', type=int, default=200, help='sites visited by the track')
+    parser.add_argument('--track-spacing', type=float, default=15, help='metres between track points')
+    args = parser.parse_args()
+
+    records = [r for path in args.csv for r in read_records(path)]
+    if args.bbox:
+        lat1, lon1, lat2, lon2 = (float(v) for v in args.bbox.split(','))
+        records = [r for r in records if min(lat1, lat2) <= r[0] <= max(lat1, lat2)
+                   and min(lon1, lon2) <= r[1] <= max(lon1, lon2)]
+    if args.kinds:
+        keep = {KINDS.index(k.strip()) for k in args.kinds.split(',')}
+        records = [r for r in records if r[2] in keep]
+    if not records:
+        sys.exit('no records')
+    sites = merge_sites(records, args.merge)
+
+    if args.output:
+        image, stats = build(sites, args.radius)
+        with open(args.output, 'wb') as f:
+            f.write(image)
+        per_kind = ', '.join(f'{sum(1 for s in sites if s[2] == k)} {name}' for k, name in enumerate(KINDS))
+        print(f'{args.output}: {len(records)} records -> {len(sites)} sites ({per_kind})')
+        print(f'  {stats["cells"]} cells of {stats["cell_lat"] / 1e7:.5f} x {stats["cell_lon"] / 1e7:.5f} deg, '
+              f'{stats["slots"]} slots, worst probe {stats["worst_probe"]}, densest cell {stats["densest"]} sites, '
+              f'{len(image)} bytes')
+
+    if args.track:
+        kind = KINDS.index(args.track_kind) if args.track_kind else None
+        write_track(args.track, sites, kind, args.track_spacing, args.track_sites)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+Flash index builder.
+
+Builds the OUI vendor + signature index read by src/flash_index.cpp from the
+IEEE oui.csv (prefix,vendor; everything after the first comma is the
+vendor, as in the SD lookup) and, optionally, the signature pack sources
+(see tools/sigpack.py). The image is written to the `fyindex` data partition
+of partitions_cyd.csv, where the firmware maps it with esp_partition_mmap
+instead of searching oui.csv on SD.
+
+Layout (little-endian):
+
+    header  32 B  magic "FYIX", format, reserved, OUI count, names length,
+                  pack length, build time, payload length, CRC-32 of payload
+    keys    count x u32  OUI as 0x00AABBCC, sorted
+    names   count x u32  offset into the name blob
+    blob    NUL-terminated vendor names, deduplicated, padded to 4 bytes
+    pack    optional FYSP signature pack
+
+Usage:
+    python3 tools/mkflashindex.py                       # oui.csv + signatures/ -> fyindex.bin
+    python3 tools/mkflashindex.py --no-signatures -o fyindex.bin
+    python3 tools/mkflashindex.py --flash /dev/ttyUSB0  # build and write to the partition
+"""
+
+import argparse
+import csv
+import struct
+import subprocess
+import sys
+import time
+import zlib
+
+import sigpack
+
+MAGIC = b'FYIX'
+FORMAT = 1
+HEADER = struct.Struct('<4sHHIIIIII')  # magic, format, reserved, count, names, pack, built, payload, crc
+
+PARTITION_LABEL = 'fyindex'
+PARTITION_SUBTYPE = 0x40
+
+
+def read_oui(path):
+    """{oui (int): vendor} from prefix,vendor lines; first entry wins."""
+    ouis = {}
+    with open(path, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            prefix, _, vendor = line.rstrip('\r\n').partition(',')
+            parts = prefix.strip().replace('-', ':').split(':')
+            vendor = vendor.strip()
+            if len(parts) != 3 or not vendor:
+                continue
+            try:
+                key = int(''.join(parts), 16)
+            except ValueError:
+                continue  # Header line
+            ouis.setdefault(key, vendor)
+    return ouis
+
+
+def build(ouis, pack=b''):
+    keys = sorted(ouis)
+    blob = bytearray()
+    offsets = {}
+    name_offsets = []
+    for key in keys:
+        name = ouis[key]
+        if name not in offsets:
+            offsets[name] = len(blob)
+            blob += name.encode('utf-8')[:255] + b'\0'
+        name_offsets.append(offsets[name])
+    blob += b'\0' * (-len(blob) % 4)
+
+    payload = (struct.pack(f'<{len(keys)}I', *keys) + struct.pack(f'<{len(keys)}I', *name_offsets)
+               + bytes(blob) + pack)
+    header = HEADER.pack(MAGIC, FORMAT, 0, len(keys), len(blob), len(pack), int(time.time()),
+                         len(payload), zlib.crc32(payload) & 0xFFFFFFFF)
+    return header + payload
+
+
+def find_partition(path):
+    """(offset, size) of the fyindex partition in a partition table CSV."""
+    with open(path) as f:
+        rows = csv.reader(line for line in f if line.strip() and not line.lstrip().startswith('#'))
+        for row in rows:
+            row = [c.strip() for c in row]
+            if row[0] == PARTITION_LABEL:
+                if int(row[2], 0) != PARTITION_SUBTYPE:
+                    sys.exit(f'{path}: {PARTITION_LABEL} subtype must be 0x{PARTITION_SUBTYPE:02x}')
+                return int(row[3], 0), int(row[4], 0)
+    sys.exit(f'{path}: no {PARTITION_LABEL} partition')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build the flash-mapped OUI/signature index')
+    parser.add_argument('--oui', default='oui.csv', help='prefix,vendor CSV')
+    parser.add_argument('-s', '--source', default='signatures', help='signature pack CSV sources')
+    parser.add_argument('--no-signatures', action='store_true', help='OUI vendors only')
+    parser.add_argument('-o', '--output', default='fyindex.bin', help='output image')
+    parser.add_argument('--partitions', default='partitions_cyd.csv', help='partition table with fyindex')
+    parser.add_argument('--flash', metavar='PORT', help='write the image with esptool after building')
+    parser.add_argument('--baud', type=int, default=460800)
+    args = parser.parse_args()
+
+    ouis = read_oui(args.oui)
+    if not ouis:
+        sys.exit(f'{args.oui}: no OUI entries')
+    pack = b''
+    if not args.no_signatures:
+        pack, _ = sigpack.build(args.source, int(time.time()))
+    image = build(ouis, pack)
+
+    offset, size = find_partition(args.partitions)
+    if len(image) > size:
+        sys.exit(f'image is {len(image)} bytes, {PARTITION_LABEL} partition holds {size}')
+    with open(args.output, 'wb') as f:
+        f.write(image)
+    vendors = len(set(ouis.values()))
+    print(f'{args.output}: {len(ouis)} OUIs, {vendors} vendors, signature pack {len(pack)} bytes, '
+          f'{len(image)} bytes ({len(image) * 100 // size}% of {PARTITION_LABEL} at 0x{offset:x})')
+
+    command = [sys.executable, '-m', 'esptool', '--chip', 'esp32', '--port', args.flash or 'PORT',
+               '--baud', str(args.baud), 'write_flash', f'0x{offset:x}', args.output]
+    if not args.flash:
+        print('flash with: esptool.py ' + ' '.join(command[3:]))
+        return
+    sys.exit(subprocess.call(command))
+
+
+if __name__ == '__main__':
+    main()
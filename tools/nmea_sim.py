@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+GPS receiver stand-in.
+
+Turns a GPX track (e.g. from tools/geoindex.py --track) or a recorded NMEA
+log into the RMC/GGA stream a UART GPS would send, and either writes it to a
+file, serves it on a pseudo-terminal, or sends it out of a USB-UART adapter.
+
+    -o FILE    write the stream (a "recording" for tools/bench/nmea_bench)
+    --pty      open a pty, print its path and stream in real time; point
+               nmea_bench --tty or the GPS port of api/flockyou.py at it
+    --port DEV stream to a serial port, e.g. a USB-UART whose TX is wired
+               to the CYD's GPS input (GPIO 35, see README_CYD.md)
+
+--noise adds what a real receiver on a long wire produces: GSA/GSV filler,
+corrupted bytes and lines cut short. A recorded log is replayed as-is, one
+RMC-delimited epoch per --rate tick.
+
+Usage:
+    python3 tools/nmea_sim.py --gpx drive.gpx -o drive.nmea --noise 0.02
+    python3 tools/nmea_sim.py --gpx drive.gpx --pty --speedup 5
+    python3 tools/nmea_sim.py --nmea drive.nmea --port /dev/ttyUSB1 --baud 9600
+"""
+
+import argparse
+import math
+import os
+import random
+import re
+import sys
+import time
+from datetime import datetime, timedelta, timezone
+
+M_PER_DEG = 111319.5
+
+
+def checksum(body):
+    s = 0
+    for c in body.encode():
+        s ^= c
+    return f'${body}*{s:02X}\r\n'
+
+
+def nmea_coord(value, width, pos, neg):
+    a = abs(value)
+    deg = int(a)
+    minutes = (a - deg) * 60
+    return f'{deg:0{width}d}{minutes:07.4f}', pos if value >= 0 else neg
+
+
+def read_gpx(path):
+    with open(path) as f:
+        text = f.read()
+    pts = []
+    for tag in re.findall(r'<trkpt[^>]*>', text):
+        lat = re.search(r'lat="([-0-9.]+)"', tag)
+        lon = re.search(r'lon="([-0-9.]+)"', tag)
+        if lat and lon:
+            pts.append((float(lat.group(1)), float(lon.group(1))))
+    return pts
+
+
+def resample(pts, speed):
+    """One point per second along the track at a constant speed (m/s)."""
+    out = [pts[0]]
+    carry = 0.0
+    for (a_lat, a_lon), (b_lat, b_lon) in zip(pts, pts[1:]):
+        dist = math.hypot((b_lat - a_lat) * M_PER_DEG,
+                          (b_lon - a_lon) * M_PER_DEG * math.cos(math.radians(a_lat)))
+        t = speed - carry
+        while t <= dist:
+            f = t / dist
+            out.append((a_lat + (b_lat - a_lat) * f, a_lon + (b_lon - a_lon) * f))
+            t += speed
+        carry = dist - (t - speed)
+    return out
+
+
+def course(a, b):
+    dy = b[0] - a[0]
+    dx = (b[1] - a[1]) * math.cos(math.radians(a[0]))
+    return (math.degrees(math.atan2(dx, dy)) + 360) % 360
+
+
+def epochs_from_gpx(pts, speed, start, rng):
+    """List of per-second sentence lists, starting with a few no-fix seconds."""
+    epochs = []
+    for i in range(3):
+        t = start + timedelta(seconds=i)
+        hms, dmy = t.strftime('%H%M%S.00'), t.strftime('%d%m%y')
+        epochs.append([checksum(f'GPRMC,{hms},V,,,,,,,{dmy},,,N'),
+                       checksum(f'GPGGA,{hms},,,,,0,00,99.9,,M,,M,,')])
+    for i, (lat, lon) in enumerate(pts):
+        t = start + timedelta(seconds=i + 3)
+        hms, dmy = t.strftime('%H%M%S.00'), t.strftime('%d%m%y')
+        la, ns = nmea_coord(lat, 2, 'N', 'S')
+        lo, ew = nmea_coord(lon, 3, 'E', 'W')
+        heading = course(pts[i - 1], (lat, lon)) if i else 0
+        knots = speed / 0.514444
+        sats = rng.randint(6, 12)
+        hdop = rng.uniform(0.7, 2.0)
+        epochs.append([
+            checksum(f'GPRMC,{hms},A,{la},{ns},{lo},{ew},{knots:.2f},{heading:.1f},{dmy},,,A'),
+            checksum(f'GPGGA,{hms},{la},{ns},{lo},{ew},1,{sats:02d},{hdop:.1f},{rng.uniform(5, 40):.1f},M,-33.0,M,,'),
+        ])
+    return epochs
+
+
+def epochs_from_nmea(path):
+    epochs = [[]]
+    with open(path, newline='') as f:
+        for line in f:
+            if line.startswith('$') and line[3:6] == 'RMC' and epochs[-1]:
+                epochs.append([])
+            epochs[-1].append(line if line.endswith('\n') else line + '\r\n')
+    return [e for e in epochs if e]
+
+
+def add_noise(epochs, p, rng):
+    """GSA/GSV filler on every epoch; corrupt or truncate sentences with probability p."""
+    out = []
+    for lines in epochs:
+        noisy = list(lines)
+        noisy.append(checksum('GPGSA,A,3,04,05,09,12,,,,,,,,,2.5,1.3,2.1'))
+        noisy.append(checksum('GPGSV,2,1,08,04,40,083,46,05,17,308,41,09,07,344,39,12,28,142,44'))
+        for i, line in enumerate(noisy):
+            r = rng.random()
+            if r < p / 2:
+                j = rng.randrange(1, len(line) - 5)
+                noisy[i] = line[:j] + rng.choice('0123456789ABCDEF,.') + line[j + 1:]
+            elif r < p:
+                noisy[i] = line[:rng.randrange(2, len(line) - 3)]
+        out.append(noisy)
+    return out
+
+
+def open_sink(args):
+    if args.output:
+        return open(args.output, 'w', newline=''), None
+    if args.pty:
+        import tty
+        master, slave = os.openpty()
+        tty.setraw(slave)
+        print(f'GPS stand-in on {os.ttyname(slave)}', flush=True)
+        return os.fdopen(master, 'w', newline='', buffering=1), slave
+    import serial
+    return serial.Serial(args.port, args.baud), None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='NMEA GPS stand-in')
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('--gpx', help='GPX track to drive along')
+    src.add_argument('--nmea', help='recorded NMEA log to replay')
+    dst = parser.add_mutually_exclusive_group(required=True)
+    dst.add_argument('-o', '--output', help='write the stream to a file')
+    dst.add_argument('--pty', action='store_true', help='serve the stream on a pseudo-terminal')
+    dst.add_argument('--port', help='serial port to stream to')
+    parser.add_argument('--baud', type=int, default=9600, help='baud rate for --port')
+    parser.add_argument('--speed', type=float, default=13.4, help='drive speed along the GPX (m/s)')
+    parser.add_argument('--start', default='2026-01-01T12:00:00', help='UTC time of the first epoch')
+    parser.add_argument('--limit', type=int, help='stop after this many epochs')
+    parser.add_argument('--noise', type=float, default=0, help='probability a sentence is damaged')
+    parser.add_argument('--speedup', type=float, default=1, help='epochs per second when streaming')
+    parser.add_argument('--loop', action='store_true', help='repeat the stream until interrupted')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    if args.gpx:
+        pts = read_gpx(args.gpx)
+        if len(pts) < 2:
+            sys.exit(f'{args.gpx}: need at least two track points')
+        start = datetime.fromisoformat(args.start).replace(tzinfo=timezone.utc)
+        epochs = epochs_from_gpx(resample(pts, args.speed), args.speed, start, rng)
+    else:
+        epochs = epochs_from_nmea(args.nmea)
+    if args.limit:
+        epochs = epochs[:args.limit]
+    if args.noise:
+        epochs = add_noise(epochs, args.noise, rng)
+
+    sink, slave = open_sink(args)
+    try:
+        while True:
+            for lines in epochs:
+                data = ''.join(lines)
+                if args.output:
+                    sink.write(data)
+                    continue
+                sink.write(data if args.pty else data.encode())
+                time.sleep(1 / args.speedup)
+            if args.output or not args.loop:
+                break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sink.close()
+        if slave is not None:
+            os.close(slave)
+    if args.output:
+        print(f'{args.output}: {len(epochs)} epochs')
+
+
+if __name__ == '__main__':
+    main()
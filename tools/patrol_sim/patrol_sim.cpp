@@ -0,0 +1,321 @@
+/**
+ * @file patrol_sim.cpp
+ * @brief Offline patrol mode power/yield simulator (Linux host)
+ *
+ * Replays camera encounters through PatrolPolicy and PatrolMeter from
+ * src/patrol_policy.cpp and compares always-on scanning, a fixed duty cycle
+ * and the adaptive patrol policy on detections found, detection delay,
+ * charge used and detections per mAh.
+ *
+ * Input is a serial capture of the firmware (one JSON record per line, other
+ * lines ignored) recorded with scanning always on. Detection records
+ * ("mac_address" without a "type") become encounters: sightings of one MAC
+ * less than --regap seconds apart are one encounter, in range from its first
+ * sighting until its last, or for at least --window seconds. "geo_alert"
+ * records feed the known-site distance for --geo-hold seconds. Without a
+ * capture a synthetic drive is generated: 20-minute stretches alternating
+ * dense (camera every ~--dense-gap s) and sparse (~--sparse-gap s) areas,
+ * with --known of the cameras in the geo index.
+ *
+ * Model: 10 ms ticks like loop(). A camera in range is found once the radios
+ * have been on for --acquire-ms (a channel hop cycle) since it came into
+ * range or since the last wake; while found and in range it is re-detected
+ * every second, which holds the radios on. The backlight is lit at
+ * --brightness: always with scanning always on, else for PATROL_DISPLAY_MS
+ * after a detection.
+ *
+ * Build:
+ *   g++ -O2 -std=c++17 -Isrc tools/patrol_sim/patrol_sim.cpp src/patrol_policy.cpp -o patrol_sim
+ * Run:
+ *   ./patrol_sim [--hours H] [--window S] [--acquire-ms MS] [--brightness N] [--seed N] [capture.log]
+ */
+
+#include "patrol_policy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define TICK_MS 10
+#define REDETECT_MS 1000
+
+struct SimConfig {
+    double hours = 8.0;
+    double window_s = 10.0;
+    double regap_s = 60.0;
+    double geo_hold_s = 10.0;
+    double dense_gap_s = 90.0;
+    double sparse_gap_s = 900.0;
+    double known = 0.5;
+    uint32_t acquire_ms = 800;
+    uint8_t brightness = 128;
+    uint32_t seed = 1;
+};
+
+struct Encounter {
+    uint32_t start;
+    uint32_t end;
+};
+
+struct GeoPoint {
+    uint32_t at;
+    uint32_t meters;
+};
+
+struct Trace {
+    std::vector<Encounter> encounters;
+    std::vector<GeoPoint> geo;
+    uint32_t span_ms = 0;
+};
+
+// Value of "key" in a flat JSON line: string contents or the number text
+static bool json_field(const std::string& line, const char* key, std::string& out) {
+    std::string pat = std::string("\"") + key + "\":";
+    size_t p = line.find(pat);
+    if (p == std::string::npos) return false;
+    p += pat.size();
+    while (p < line.size() && line[p] == ' ') p++;
+    if (p < line.size() && line[p] == '"') {
+        size_t e = line.find('"', p + 1);
+        if (e == std::string::npos) return false;
+        out = line.substr(p + 1, e - p - 1);
+    } else {
+        size_t e = line.find_first_of(",}", p);
+        out = line.substr(p, e == std::string::npos ? std::string::npos : e - p);
+    }
+    return true;
+}
+
+static bool load_capture(const std::string& path, const SimConfig& cfg, Trace& trace) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "%s: cannot open\n", path.c_str());
+        return false;
+    }
+    struct Open { uint32_t first, last; };
+    std::map<std::string, Open> open;
+    uint32_t regap = (uint32_t)(cfg.regap_s * 1000);
+    uint32_t window = (uint32_t)(cfg.window_s * 1000);
+    auto close = [&](const Open& o) {
+        trace.encounters.push_back({ o.first, std::max(o.last, o.first + window) });
+    };
+
+    // A reboot restarts millis(): later records are offset past the earlier
+    // ones. Records from different tasks may be slightly out of order.
+    uint32_t offset = 0, prev = 0;
+    std::string line, v;
+    while (std::getline(in, line)) {
+        size_t brace = line.find('{');
+        if (brace == std::string::npos || !json_field(line, "timestamp", v)) continue;
+        uint32_t t = (uint32_t)strtoul(v.c_str(), nullptr, 10);
+        if (t + offset + regap < prev) offset = prev;
+        t += offset;
+        prev = std::max(prev, t);
+
+        std::string type;
+        bool typed = json_field(line, "type", type);
+        if (typed && type == "geo_alert" && json_field(line, "distance_m", v)) {
+            trace.geo.push_back({ t, (uint32_t)strtoul(v.c_str(), nullptr, 10) });
+        } else if (!typed && json_field(line, "mac_address", v)) {
+            auto it = open.find(v);
+            if (it != open.end() && t - it->second.last <= regap) {
+                it->second.last = t;
+            } else {
+                if (it != open.end()) close(it->second);
+                open[v] = { t, t };
+            }
+        }
+    }
+    trace.span_ms = prev;
+    for (auto& kv : open) close(kv.second);
+    std::sort(trace.encounters.begin(), trace.encounters.end(),
+              [](const Encounter& a, const Encounter& b) { return a.start < b.start; });
+    std::stable_sort(trace.geo.begin(), trace.geo.end(),
+                     [](const GeoPoint& a, const GeoPoint& b) { return a.at < b.at; });
+    trace.span_ms += window;
+    return !trace.encounters.empty();
+}
+
+// Synthetic drive: dense and sparse stretches; known sites approach at 15 m/s
+static void synth_drive(const SimConfig& cfg, Trace& trace) {
+    std::mt19937 rng(cfg.seed);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    const uint32_t stretch_ms = 20 * 60 * 1000;
+    trace.span_ms = (uint32_t)(cfg.hours * 3600 * 1000);
+
+    double t = 30000;
+    while (t < trace.span_ms) {
+        bool dense = ((uint32_t)t / stretch_ms) % 2 == 0;
+        double gap = dense ? cfg.dense_gap_s : cfg.sparse_gap_s;
+        t += -log(1.0 - uni(rng)) * gap * 1000;
+        if (t >= trace.span_ms) break;
+        uint32_t start = (uint32_t)t;
+        uint32_t len = (uint32_t)((cfg.window_s * (0.5 + uni(rng))) * 1000);
+        trace.encounters.push_back({ start, start + len });
+        if (uni(rng) < cfg.known) {
+            for (int s = 40; s >= -(int)(len / 1000); s--) {
+                uint32_t at = start - s * 1000;
+                trace.geo.push_back({ at, (uint32_t)(50 + 15 * std::max(s, 0)) });
+            }
+        }
+        t += len;
+    }
+    std::sort(trace.geo.begin(), trace.geo.end(),
+              [](const GeoPoint& a, const GeoPoint& b) { return a.at < b.at; });
+}
+
+struct SimResult {
+    int found = 0;
+    std::vector<double> delay_ms;
+    uint32_t sleeps = 0;
+    PatrolMeter meter;
+};
+
+static SimResult run(const char* mode, PatrolConfig pc, const SimConfig& cfg, const Trace& trace) {
+    bool patrol_on = strcmp(mode, "always-on") != 0;
+    PatrolPolicy policy;
+    policy.config = pc;
+    policy.begin(0);
+
+    SimResult res;
+    std::vector<int8_t> state(trace.encounters.size(), 0);   // 0 not found, 1 found
+    std::vector<uint32_t> last_seen(trace.encounters.size(), 0);
+    size_t first = 0;      // Encounters before this one have ended
+    size_t geo_at = 0;
+    uint32_t on_since = 0;
+    uint32_t geo_hold = (uint32_t)(cfg.geo_hold_s * 1000);
+    uint32_t last_geo = 0;
+    bool geo_valid = false;
+
+    for (uint32_t now = 0; now < trace.span_ms; now += TICK_MS) {
+        while (geo_at < trace.geo.size() && trace.geo[geo_at].at <= now) {
+            policy.setSiteDistance(trace.geo[geo_at].meters);
+            last_geo = trace.geo[geo_at].at;
+            geo_valid = true;
+            geo_at++;
+        }
+        if (geo_valid && now - last_geo > geo_hold) {
+            policy.setSiteDistance(PATROL_DISTANCE_UNKNOWN);
+            geo_valid = false;
+        }
+
+        while (first < trace.encounters.size() && trace.encounters[first].end <= now) first++;
+        for (size_t i = first; i < trace.encounters.size() && trace.encounters[i].start <= now; i++) {
+            const Encounter& e = trace.encounters[i];
+            if (now >= e.end) continue;
+            uint32_t listening_since = std::max(e.start, on_since);
+            if (now - listening_since < cfg.acquire_ms) continue;
+            if (!state[i]) {
+                state[i] = 1;
+                res.found++;
+                res.delay_ms.push_back(now - e.start);
+                policy.noteDetection(now, true);
+                last_seen[i] = now;
+            } else if (now - last_seen[i] >= REDETECT_MS) {
+                policy.noteDetection(now, false);
+                last_seen[i] = now;
+            }
+        }
+
+        res.meter.add(PATROL_POWER_SCAN, TICK_MS);
+        bool lit = !patrol_on || (res.found && now - policy.lastDetectionMs() < PATROL_DISPLAY_MS);
+        if (lit) res.meter.addDisplay(TICK_MS, cfg.brightness);
+
+        if (!patrol_on) continue;
+        uint32_t sleep_ms = policy.sleepDue(now);
+        if (!sleep_ms) continue;
+        sleep_ms -= sleep_ms % TICK_MS;
+        res.meter.add(PATROL_POWER_SLEEP, sleep_ms);
+        now += sleep_ms;
+        policy.woke(now, sleep_ms);
+        on_since = now;
+        res.sleeps++;
+        now -= TICK_MS;   // The loop's increment lands on the wake tick
+    }
+    return res;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t idx = (size_t)(p * (v.size() - 1));
+    return v[idx];
+}
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    std::string capture;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&](void) -> const char* { return i + 1 < argc ? argv[++i] : "0"; };
+        if (a == "--hours") cfg.hours = atof(next());
+        else if (a == "--window") cfg.window_s = atof(next());
+        else if (a == "--regap") cfg.regap_s = atof(next());
+        else if (a == "--geo-hold") cfg.geo_hold_s = atof(next());
+        else if (a == "--dense-gap") cfg.dense_gap_s = atof(next());
+        else if (a == "--sparse-gap") cfg.sparse_gap_s = atof(next());
+        else if (a == "--known") cfg.known = atof(next());
+        else if (a == "--acquire-ms") cfg.acquire_ms = (uint32_t)atoi(next());
+        else if (a == "--brightness") cfg.brightness = (uint8_t)atoi(next());
+        else if (a == "--seed") cfg.seed = (uint32_t)atoi(next());
+        else if (a == "-h" || a == "--help") {
+            printf("usage: %s [--hours H] [--window S] [--regap S] [--geo-hold S] [--dense-gap S] "
+                   "[--sparse-gap S] [--known F] [--acquire-ms MS] [--brightness N] [--seed N] [capture.log]\n",
+                   argv[0]);
+            return 0;
+        } else capture = a;
+    }
+
+    Trace trace;
+    if (!capture.empty()) {
+        if (!load_capture(capture, cfg, trace)) {
+            fprintf(stderr, "%s: no detection records\n", capture.c_str());
+            return 1;
+        }
+        printf("Capture %s: %zu encounters, %zu geo records, %.1f h\n",
+               capture.c_str(), trace.encounters.size(), trace.geo.size(), trace.span_ms / 3600000.0);
+    } else {
+        synth_drive(cfg, trace);
+        printf("Synthetic drive: %zu encounters, %.0f%% known sites, %.1f h\n",
+               trace.encounters.size(), cfg.known * 100, trace.span_ms / 3600000.0);
+    }
+    printf("acquire=%ums, brightness=%u, model scan/sleep/display = %.1f/%.1f/%.1f mA\n\n",
+           cfg.acquire_ms, cfg.brightness, PATROL_SCAN_MA_X10 / 10.0, PATROL_SLEEP_MA_X10 / 10.0,
+           PATROL_DISPLAY_MA_X10 / 10.0);
+
+    PatrolPowerModel model = {
+        { PATROL_SCAN_MA_X10, PATROL_IDLE_MA_X10, PATROL_SLEEP_MA_X10 }, PATROL_DISPLAY_MA_X10
+    };
+    PatrolConfig adaptive = PatrolPolicy().config;
+    // Same mean sleep as the adaptive range, no holds or proximity
+    PatrolConfig fixed = adaptive;
+    fixed.sleep_min_ms = fixed.sleep_max_ms = (adaptive.sleep_min_ms + adaptive.sleep_max_ms) / 2;
+    fixed.hold_ms = 0;
+    fixed.near_m = 0;
+    fixed.density_tau_ms = 0;
+
+    struct Mode { const char* name; PatrolConfig config; };
+    Mode modes[] = { { "always-on", adaptive }, { "fixed", fixed }, { "adaptive", adaptive } };
+
+    printf("%-10s %7s %7s %9s %9s %7s %8s %8s %9s\n",
+           "mode", "found", "missed", "p50_s", "p90_s", "on%", "avg_mA", "mAh/h", "det/mAh");
+    int total = (int)trace.encounters.size();
+    for (const Mode& m : modes) {
+        SimResult r = run(m.name, m.config, cfg, trace);
+        double hours = r.meter.totalMs() / 3600000.0;
+        printf("%-10s %7d %6.1f%% %9.1f %9.1f %6.1f%% %8.1f %8.1f %9.2f\n",
+               m.name, r.found, 100.0 * (total - r.found) / total,
+               percentile(r.delay_ms, 0.5) / 1000, percentile(r.delay_ms, 0.9) / 1000,
+               100.0 * r.meter.ms(PATROL_POWER_SCAN) / r.meter.totalMs(),
+               r.meter.averageMa(model), r.meter.mAh(model) / hours, r.meter.perMah(r.found, model));
+    }
+    return 0;
+}
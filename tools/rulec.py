@@ -0,0 +1,457 @@
+#!/usr/bin/env python3
+"""
+Confidence rule compiler.
+
+Compiles the rules language (signatures/rules.txt) into the bytecode run by
+src/rule_vm.cpp. tools/sigpack.py embeds the result as the pack's rules
+section; --header regenerates the built-in copy in src/rules_default.h.
+
+One rule per line, '#' starts a comment:
+
+    score N NAME: expr     first match sets threat_score (0-100) and
+                           detection_criteria (NAME)
+    bonus N NAME: expr     every match adds N (may be negative); the total
+                           is clamped to 0-100
+
+Expressions:
+
+    facts      wifi ble ssid_match name_match oui watchlist payload
+    fields     rssi hits probe_ms channel mfg ie_fp, compared with
+               < <= > >= == != against an integer (decimal or 0x hex)
+    strings    ssid ~ "text", name ~ "text"   case-insensitive substring
+    OUI        oui == aa:bb:cc, oui != aa:bb:cc
+    logic      not, and, or, parentheses (not > and > or)
+
+--golden turns the wigle exports in datasets/ into sightings (facts as the
+firmware would see them, at a few hit counts and signal levels) and writes
+them with the score this module's own AST evaluator gives each one, for
+tools/bench/rule_bench.cpp to check the firmware evaluator against.
+
+Usage:
+    python3 tools/rulec.py signatures/rules.txt -o rules.fyrb
+    python3 tools/rulec.py signatures/rules.txt --header src/rules_default.h
+    python3 tools/rulec.py signatures/rules.txt --golden datasets golden.tsv
+    python3 tools/rulec.py --dump rules.fyrb
+"""
+
+import argparse
+import csv
+import glob
+import os
+import re
+import struct
+import sys
+
+FORMAT = 1
+HEADER = struct.Struct('<BBHHH')        # format, rules, string table length, code length, reserved
+MAX_CODE = 2048
+MAX_STRINGS = 1024
+MAX_RULES = 64
+MAX_DEPTH = 32
+
+(OP_END, OP_FACT, OP_CMP, OP_SSID_HAS, OP_NAME_HAS, OP_OUI,
+ OP_AND, OP_OR, OP_NOT, OP_SCORE, OP_BONUS) = range(11)
+
+FACTS = ['wifi', 'ble', 'ssid_match', 'name_match', 'oui', 'watchlist', 'payload']
+FIELDS = ['rssi', 'hits', 'probe_ms', 'channel', 'mfg', 'ie_fp']
+CMPS = ['<', '<=', '>', '>=', '==', '!=']
+
+TOKEN = re.compile(r'\s*(?:(?P<oui>[0-9A-Fa-f]{2}:[0-9A-Fa-f]{2}:[0-9A-Fa-f]{2})'
+                   r'|(?P<num>-?0[xX][0-9A-Fa-f]+|-?\d+)'
+                   r'|(?P<str>"[^"]*")'
+                   r'|(?P<op><=|>=|==|!=|<|>|~|\(|\))'
+                   r'|(?P<word>[A-Za-z_][A-Za-z0-9_]*))')
+RULE = re.compile(r'^(score|bonus)\s+(-?\d+)\s+([A-Za-z0-9_]+)\s*:\s*(.+)$')
+
+
+class RuleError(Exception):
+    pass
+
+
+# --- Parsing -----------------------------------------------------------------
+# AST nodes are tuples: ('fact', i), ('cmp', field, cmp, value),
+# ('has', 'ssid'|'name', text), ('oui', bytes), ('not', a), ('and', a, b), ('or', a, b)
+
+def tokenize(text):
+    tokens, pos = [], 0
+    text = text.rstrip()
+    while pos < len(text):
+        m = TOKEN.match(text, pos)
+        if not m or m.end() == pos:
+            raise RuleError(f'unexpected {text[pos:].strip()[:12]!r}')
+        kind = m.lastgroup
+        value = m.group(kind)
+        tokens.append((kind, value))
+        pos = m.end()
+    return tokens
+
+
+class Parser:
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else (None, None)
+
+    def take(self, kind=None, value=None):
+        tok = self.peek()
+        if tok[0] is None or (kind and tok[0] != kind) or (value and tok[1] != value):
+            want = value or kind or 'more'
+            raise RuleError(f'expected {want}, got {tok[1]!r}' if tok[1] else f'expected {want}')
+        self.pos += 1
+        return tok[1]
+
+    def parse(self):
+        node = self.expr()
+        if self.peek()[0] is not None:
+            raise RuleError(f'unexpected {self.peek()[1]!r}')
+        return node
+
+    def expr(self):
+        node = self.conj()
+        while self.peek() == ('word', 'or'):
+            self.take()
+            node = ('or', node, self.conj())
+        return node
+
+    def conj(self):
+        node = self.unary()
+        while self.peek() == ('word', 'and'):
+            self.take()
+            node = ('and', node, self.unary())
+        return node
+
+    def unary(self):
+        if self.peek() == ('word', 'not'):
+            self.take()
+            return ('not', self.unary())
+        return self.primary()
+
+    def primary(self):
+        kind, value = self.peek()
+        if (kind, value) == ('op', '('):
+            self.take()
+            node = self.expr()
+            self.take('op', ')')
+            return node
+        word = self.take('word')
+        if word in ('ssid', 'name'):
+            self.take('op', '~')
+            text = self.take('str')[1:-1]
+            if not text:
+                raise RuleError(f'{word} ~ needs a non-empty string')
+            return ('has', word, text)
+        if word == 'oui' and self.peek() in (('op', '=='), ('op', '!=')):
+            cmp = self.take()
+            node = ('oui', bytes(int(b, 16) for b in self.take('oui').split(':')))
+            return ('not', node) if cmp == '!=' else node
+        if word in FACTS:
+            return ('fact', FACTS.index(word))
+        if word in FIELDS:
+            cmp = self.take('op')
+            if cmp not in CMPS:
+                raise RuleError(f'{word}: expected a comparison, got {cmp!r}')
+            if word in ('mfg', 'ie_fp') and cmp not in ('==', '!='):
+                raise RuleError(f'{word} can only be compared with == or !=')
+            value = int(self.take('num'), 0)
+            if word == 'ie_fp':
+                if not 0 <= value <= 0xFFFFFFFF:
+                    raise RuleError('ie_fp is a 32-bit value')
+                value = value - (1 << 32) if value >= 1 << 31 else value
+            elif not -(1 << 31) <= value < 1 << 31:
+                raise RuleError(f'{word}: {value} out of range')
+            return ('cmp', FIELDS.index(word), CMPS.index(cmp), value)
+        raise RuleError(f'unknown name {word!r}')
+
+
+def parse_rules(text):
+    """[(kind, value, name, ast)] in file order."""
+    rules = []
+    for lineno, line in enumerate(text.splitlines(), 1):
+        line = line.split('#', 1)[0].strip()
+        if not line:
+            continue
+        m = RULE.match(line)
+        try:
+            if not m:
+                raise RuleError('expected "score|bonus N NAME: expression"')
+            kind, value, name, expr = m.group(1), int(m.group(2)), m.group(3), m.group(4)
+            if kind == 'score' and not 0 <= value <= 100:
+                raise RuleError('score must be 0-100')
+            if kind == 'bonus' and not -128 <= value <= 127:
+                raise RuleError('bonus must be -128..127')
+            rules.append((kind, value, name, Parser(tokenize(expr)).parse()))
+        except RuleError as e:
+            sys.exit(f'line {lineno}: {e}')
+    if len(rules) > MAX_RULES:
+        sys.exit(f'{len(rules)} rules, firmware holds {MAX_RULES}')
+    return rules
+
+
+# --- Code generation ---------------------------------------------------------
+
+class Strings:
+    def __init__(self):
+        self.table = b''
+        self.offsets = {}
+
+    def add(self, text):
+        if text not in self.offsets:
+            self.offsets[text] = len(self.table)
+            self.table += text.encode() + b'\0'
+        return self.offsets[text]
+
+
+def emit(node, strings):
+    """Postfix code for one expression and its maximum stack depth."""
+    op = node[0]
+    if op == 'fact':
+        return bytes([OP_FACT, node[1]]), 1
+    if op == 'cmp':
+        return struct.pack('<BBBi', OP_CMP, node[1], node[2], node[3]), 1
+    if op == 'has':
+        code = OP_SSID_HAS if node[1] == 'ssid' else OP_NAME_HAS
+        return struct.pack('<BH', code, strings.add(node[2])), 1
+    if op == 'oui':
+        return bytes([OP_OUI]) + node[1], 1
+    if op == 'not':
+        code, depth = emit(node[1], strings)
+        return code + bytes([OP_NOT]), depth
+    a, da = emit(node[1], strings)
+    b, db = emit(node[2], strings)
+    return a + b + bytes([OP_AND if op == 'and' else OP_OR]), max(da, db + 1)
+
+
+def compile_rules(text):
+    """Compiled rule image for a rules file's text."""
+    rules = parse_rules(text)
+    strings = Strings()
+    code = b''
+    for kind, value, name, ast in rules:
+        expr, depth = emit(ast, strings)
+        if depth > MAX_DEPTH:
+            sys.exit(f'{name}: expression nests deeper than {MAX_DEPTH}')
+        op = OP_SCORE if kind == 'score' else OP_BONUS
+        code += expr + struct.pack('<BbH' if kind == 'bonus' else '<BBH', op, value, strings.add(name))
+    code += bytes([OP_END])
+    if len(code) > MAX_CODE or len(strings.table) > MAX_STRINGS:
+        sys.exit(f'{len(code)} bytes of code / {len(strings.table)} of strings, '
+                 f'firmware holds {MAX_CODE} / {MAX_STRINGS}')
+    return HEADER.pack(FORMAT, len(rules), len(strings.table), len(code), 0) + strings.table + code
+
+
+# --- Reference evaluator -----------------------------------------------------
+
+def eval_node(node, f):
+    op = node[0]
+    if op == 'fact':
+        return bool(f['flags'] >> node[1] & 1)
+    if op == 'cmp':
+        v = f[FIELDS[node[1]]]
+        if FIELDS[node[1]] == 'ie_fp' and v >= 1 << 31:
+            v -= 1 << 32
+        return [v < node[3], v <= node[3], v > node[3], v >= node[3], v == node[3], v != node[3]][node[2]]
+    if op == 'has':
+        text = f['ssid'] if node[1] == 'ssid' else f['name']
+        return text is not None and node[2].lower() in text.lower()
+    if op == 'oui':
+        return f['mac'][:3] == node[1]
+    if op == 'not':
+        return not eval_node(node[1], f)
+    if op == 'and':
+        return eval_node(node[1], f) and eval_node(node[2], f)
+    return eval_node(node[1], f) or eval_node(node[2], f)
+
+
+def evaluate(rules, f):
+    """(score, index of the score rule or None) for one sighting."""
+    score, rule, bonus = 0, None, 0
+    for i, (kind, value, _, ast) in enumerate(rules):
+        if not eval_node(ast, f):
+            continue
+        if kind == 'bonus':
+            bonus += value
+        elif rule is None:
+            score, rule = value, i
+    return max(0, min(100, score + bonus)), rule
+
+
+# --- Golden sightings from datasets/ ----------------------------------------
+
+def read_patterns(path, column):
+    if not os.path.exists(path):
+        return []
+    with open(path, newline='') as f:
+        return [row[column].strip().lower() for row in csv.DictReader(f) if row[column].strip()]
+
+
+def parse_mac(text):
+    return bytes(int(p, 16) for p in text.strip().split(':'))
+
+
+def golden(rules, datasets, sigdir, out_path):
+    ssid_patterns = read_patterns(os.path.join(sigdir, 'ssid_patterns.csv'), 'pattern')
+    name_patterns = read_patterns(os.path.join(sigdir, 'name_patterns.csv'), 'pattern')
+    ouis = {parse_mac(p) for p in read_patterns(os.path.join(sigdir, 'oui.csv'), 'prefix')}
+    macs = {parse_mac(p) for p in read_patterns(os.path.join(sigdir, 'macs.csv'), 'mac')}
+    mfg_ids = set()
+    if os.path.exists(os.path.join(sigdir, 'ble_rules.csv')):
+        with open(os.path.join(sigdir, 'ble_rules.csv'), newline='') as f:
+            mfg_ids = {int(r['id'], 0) for r in csv.DictReader(f) if r['kind'].strip().startswith('mfg')}
+
+    # Each device at a few points of a pass: first sighting, a few regular
+    # hits, many hits at a slow interval
+    stages = [(1, 0, -82), (6, 1200, -61), (25, 8000, -44)]
+    count = 0
+    with open(out_path, 'w') as out:
+        out.write('# flags\trssi\tchannel\thits\tprobe_ms\tmfg\tie_fp\tmac\tssid\tname\tscore\trule\n')
+        for path in sorted(glob.glob(os.path.join(datasets, '*.csv'))):
+            with open(path, newline='', encoding='utf-8-sig') as f:
+                rows = list(csv.DictReader(f))
+            if not rows or 'netid' not in rows[0]:
+                continue  # Not a wigle export (no radios)
+            for row in rows:
+                try:
+                    mac = parse_mac(row['netid'])
+                except ValueError:
+                    continue
+                ble = row.get('type') == 'BLE'
+                text = (row.get('name') if ble else row.get('ssid')) or ''
+                mfg = int(float(row['mfgrId'])) if ble and row.get('mfgrId') else -1
+                flags = 1 << FACTS.index('ble' if ble else 'wifi')
+                if ble and any(p in text.lower() for p in name_patterns):
+                    flags |= 1 << FACTS.index('name_match')
+                if not ble and any(p in text.lower() for p in ssid_patterns):
+                    flags |= 1 << FACTS.index('ssid_match')
+                if mac[:3] in ouis:
+                    flags |= 1 << FACTS.index('oui')
+                if mac in macs:
+                    flags |= 1 << FACTS.index('watchlist')
+                if mfg in mfg_ids:
+                    flags |= 1 << FACTS.index('payload')
+                # wigle keeps no IEs: stand in with one of three firmware
+                # fingerprints, chosen by address
+                ie_fp = 0 if ble else [0x5A17C0DE, 0x2B3C4D5E, 0xF10C4A11][mac[5] % 3]
+                channel = 0 if ble else int(row.get('channel') or 0)
+                for hits, probe_ms, rssi in stages:
+                    f = {'flags': flags, 'rssi': rssi, 'channel': channel, 'hits': hits,
+                         'probe_ms': probe_ms, 'mfg': mfg, 'ie_fp': ie_fp, 'mac': mac,
+                         'ssid': None if ble else text, 'name': text if ble else None}
+                    score, rule = evaluate(rules, f)
+                    out.write(f'{flags}\t{rssi}\t{channel}\t{hits}\t{probe_ms}\t{mfg}\t{ie_fp}\t'
+                              f'{mac.hex(":")}\t{f["ssid"] or ""}\t{f["name"] or ""}\t'
+                              f'{score}\t{255 if rule is None else rule}\n')
+                    count += 1
+    return count
+
+
+# --- Output ------------------------------------------------------------------
+
+def write_header(image, source, path):
+    lines = []
+    for i in range(0, len(image), 16):
+        lines.append('    ' + ', '.join(f'0x{b:02x}' for b in image[i:i + 16]) + ',')
+    fmt, rules, slen, clen, _ = HEADER.unpack_from(image)
+    with open(path, 'w') as f:
+        f.write(f'''/**
+ * @file rules_default.h
+ * @brief Built-in confidence rules ({source}, {rules} rules)
+ *
+ * Generated by tools/rulec.py; do not edit. Used until a signature pack
+ * with a rules section is loaded. Regenerate with:
+ *   python3 tools/rulec.py {source} --header src/rules_default.h
+ */
+
+#ifndef RULES_DEFAULT_H
+#define RULES_DEFAULT_H
+
+#include <stdint.h>
+
+static const uint8_t rules_default_image[{len(image)}] = {{
+''' + '\n'.join(lines) + '''
+};
+
+#endif // RULES_DEFAULT_H
+''')
+
+
+def dump(image):
+    fmt, rules, slen, clen, _ = HEADER.unpack_from(image)
+    strings = image[HEADER.size:HEADER.size + slen]
+    code = image[HEADER.size + slen:HEADER.size + slen + clen]
+    print(f'format {fmt}, {rules} rules, {slen} bytes of strings, {clen} bytes of code')
+
+    def string(off):
+        return strings[off:strings.index(b'\0', off)].decode()
+
+    pc, expr = 0, []
+    while pc < len(code):
+        op = code[pc]
+        if op == OP_END:
+            break
+        if op == OP_FACT:
+            expr.append(FACTS[code[pc + 1]])
+            pc += 2
+        elif op == OP_CMP:
+            field, cmp, value = struct.unpack_from('<BBi', code, pc + 1)
+            expr.append(f'{FIELDS[field]} {CMPS[cmp]} ' +
+                        (f'0x{value & 0xFFFFFFFF:08X}' if FIELDS[field] == 'ie_fp' else
+                         f'0x{value:04X}' if FIELDS[field] == 'mfg' and value >= 0 else str(value)))
+            pc += 7
+        elif op in (OP_SSID_HAS, OP_NAME_HAS):
+            expr.append(f'{"ssid" if op == OP_SSID_HAS else "name"} ~ "{string(struct.unpack_from("<H", code, pc + 1)[0])}"')
+            pc += 3
+        elif op == OP_OUI:
+            expr.append('oui == ' + code[pc + 1:pc + 4].hex(':'))
+            pc += 4
+        elif op in (OP_AND, OP_OR):
+            b, a = expr.pop(), expr.pop()
+            expr.append(f'({a} {"and" if op == OP_AND else "or"} {b})')
+            pc += 1
+        elif op == OP_NOT:
+            expr.append(f'not {expr.pop()}')
+            pc += 1
+        elif op in (OP_SCORE, OP_BONUS):
+            value, name = struct.unpack_from('<BH' if op == OP_SCORE else '<bH', code, pc + 1)
+            kind = 'score' if op == OP_SCORE else 'bonus'
+            print(f'  {kind} {value:4} {string(name)}: {expr.pop()}')
+            pc += 4
+        else:
+            sys.exit(f'bad opcode {op} at {pc}')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compile Flock-You confidence rules')
+    parser.add_argument('rules', nargs='?', help='rules source (signatures/rules.txt)')
+    parser.add_argument('-o', '--output', help='write the compiled image')
+    parser.add_argument('--header', help='write the image as a C header (src/rules_default.h)')
+    parser.add_argument('--golden', nargs=2, metavar=('DATASETS', 'OUT'),
+                        help='write dataset sightings with their expected scores')
+    parser.add_argument('-s', '--signatures', default='signatures',
+                        help='signature CSVs for the golden facts')
+    parser.add_argument('--dump', metavar='IMAGE', help='disassemble a compiled image')
+    args = parser.parse_args()
+
+    if args.dump:
+        dump(open(args.dump, 'rb').read())
+        return
+    if not args.rules:
+        parser.error('a rules file is required')
+
+    text = open(args.rules).read()
+    image = compile_rules(text)
+    _, rules, slen, clen, _ = HEADER.unpack_from(image)
+    print(f'{args.rules}: {rules} rules, {clen} bytes of code, {slen} bytes of strings')
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(image)
+    if args.header:
+        write_header(image, args.rules, args.header)
+    if args.golden:
+        n = golden(parse_rules(text), args.golden[0], args.signatures, args.golden[1])
+        print(f'{args.golden[1]}: {n} sightings')
+
+
+if __name__ == '__main__':
+    main()
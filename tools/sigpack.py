@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+Signature pack compiler.
+
+Builds the binary signature pack read by src/sigpack.cpp from CSV sources
+(see signatures/ for the defaults that mirror the built-in tables):
+
+    oui.csv            prefix,label         aa:bb:cc
+    macs.csv           mac,label            aa:bb:cc:dd:ee:ff (tools/watchlist.py
+                                            builds this from wigle exports)
+    ssid_patterns.csv  pattern,label        case-insensitive substring
+    name_patterns.csv  pattern,label        case-insensitive substring
+    ble_rules.csv      name,kind,id,offset,value,mask
+                       kind: mfg_id | mfg_data | service_uuid | service_data
+                       id: company ID / 16-bit UUID (0x09C8 or 2504)
+                       value/mask: hex bytes after the ID (mask defaults to ff..)
+    rules.txt          confidence rules (threat_score), compiled by tools/rulec.py
+
+Missing files produce empty sections. Copy the output to the SD card root
+as /signatures.fysp; the firmware picks it up at boot and on change.
+
+Usage:
+    python3 tools/sigpack.py [-s signatures] [-o signatures.fysp] [--version N]
+    python3 tools/sigpack.py --dump signatures.fysp
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+import time
+import zlib
+
+import rulec
+from watchlist import build_filter
+
+MAGIC = b'FYSP'
+FORMAT = 1
+HEADER = struct.Struct('<4sHHIIII')      # magic, format, sections, version, built, payload_len, crc
+SECTION = struct.Struct('<HHIII')        # type, reserved, count, offset, length
+BLE_RULE = struct.Struct('<BBBBHH8s8s16s')
+
+SEC_OUI, SEC_MAC, SEC_SSID, SEC_NAME, SEC_BLE, SEC_CUCKOO, SEC_RULES = 1, 2, 3, 4, 5, 6, 7
+SEC_NAMES = {SEC_OUI: 'oui', SEC_MAC: 'mac', SEC_SSID: 'ssid', SEC_NAME: 'name', SEC_BLE: 'ble',
+             SEC_CUCKOO: 'cuckoo', SEC_RULES: 'rules'}
+BLE_KINDS = {'mfg_id': 0, 'mfg_data': 1, 'service_uuid': 2, 'service_data': 3}
+
+MAX_PATTERNS = 64
+MAX_BLE_RULES = 32
+MAX_RULE_BYTES = 8
+MAX_PACK_BYTES = 256 * 1024
+
+
+def read_rows(path):
+    """Rows of a CSV with a header line; [] if the file doesn't exist."""
+    if not os.path.exists(path):
+        return []
+    with open(path, newline='') as f:
+        return [row for row in csv.DictReader(f) if any((v or '').strip() for v in row.values())]
+
+
+def parse_mac(text, octets):
+    parts = text.strip().replace('-', ':').split(':')
+    if len(parts) != octets:
+        raise ValueError(f'expected {octets} octets: {text!r}')
+    return bytes(int(p, 16) for p in parts)
+
+
+def pattern_section(rows, what):
+    patterns = [row['pattern'].strip().lower() for row in rows if row['pattern'].strip()]
+    if len(patterns) > MAX_PATTERNS:
+        sys.exit(f'{what}: {len(patterns)} patterns, firmware holds {MAX_PATTERNS}')
+    return len(patterns), b''.join(p.encode() + b'\0' for p in patterns)
+
+
+def ble_section(rows):
+    if len(rows) > MAX_BLE_RULES:
+        sys.exit(f'ble_rules: {len(rows)} rules, firmware holds {MAX_BLE_RULES}')
+    body = b''
+    for row in rows:
+        kind = BLE_KINDS[row['kind'].strip()]
+        value = bytes.fromhex((row.get('value') or '').replace(':', '').strip())
+        mask_text = (row.get('mask') or '').replace(':', '').strip()
+        mask = bytes.fromhex(mask_text) if mask_text else b'\xff' * len(value)
+        if len(value) > MAX_RULE_BYTES or len(mask) != len(value):
+            sys.exit(f'ble_rules: {row["name"]}: value/mask must be equal length <= {MAX_RULE_BYTES}')
+        name = row['name'].strip().encode()[:15]
+        body += BLE_RULE.pack(kind, int(row.get('offset') or 0), len(value), 0,
+                              int(row['id'], 0), 0, value, mask, name)
+    return len(rows), body
+
+
+def build(src, version):
+    ouis = sorted({parse_mac(r['prefix'], 3) for r in read_rows(os.path.join(src, 'oui.csv'))})
+    macs = sorted({parse_mac(r['mac'], 6) for r in read_rows(os.path.join(src, 'macs.csv'))})
+
+    sections = [
+        (SEC_OUI, len(ouis), b''.join(ouis)),
+        (SEC_MAC, len(macs), b''.join(macs)),
+        (SEC_SSID, *pattern_section(read_rows(os.path.join(src, 'ssid_patterns.csv')), 'ssid_patterns')),
+        (SEC_NAME, *pattern_section(read_rows(os.path.join(src, 'name_patterns.csv')), 'name_patterns')),
+        (SEC_BLE, *ble_section(read_rows(os.path.join(src, 'ble_rules.csv')))),
+    ]
+    if macs:
+        # Constant-time fast path in front of the exact MAC table
+        cuckoo = build_filter(macs)
+        sections.append((SEC_CUCKOO, cuckoo.buckets, cuckoo.pack()))
+    rules_path = os.path.join(src, 'rules.txt')
+    if os.path.exists(rules_path):
+        rules = rulec.compile_rules(open(rules_path).read())
+        sections.append((SEC_RULES, rules[1], rules))
+
+    offset = HEADER.size + SECTION.size * len(sections)
+    table, data = b'', b''
+    for sec_type, count, body in sections:
+        table += SECTION.pack(sec_type, 0, count, offset + len(data), len(body))
+        data += body
+    payload = table + data
+    header = HEADER.pack(MAGIC, FORMAT, len(sections), version, int(time.time()),
+                         len(payload), zlib.crc32(payload) & 0xFFFFFFFF)
+    return header + payload, sections
+
+
+def dump(path):
+    image = open(path, 'rb').read()
+    magic, fmt, count, version, built, payload_len, crc = HEADER.unpack_from(image)
+    ok = zlib.crc32(image[HEADER.size:]) & 0xFFFFFFFF == crc
+    print(f'{path}: {magic.decode()} format {fmt}, version {version}, '
+          f'built {time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(built))} UTC, '
+          f'{len(image)} bytes, CRC {"ok" if ok else "BAD"}')
+    for i in range(count):
+        sec_type, _, n, off, length = SECTION.unpack_from(image, HEADER.size + i * SECTION.size)
+        body = image[off:off + length]
+        print(f'  {SEC_NAMES.get(sec_type, sec_type):5} {n:6} entries {length:7} bytes')
+        if sec_type in (SEC_SSID, SEC_NAME):
+            print('        ' + ', '.join(p.decode() for p in body.split(b'\0')[:n]))
+        elif sec_type == SEC_BLE:
+            for j in range(n):
+                kind, rel, ln, _, rid, _, value, mask, name = BLE_RULE.unpack_from(body, j * BLE_RULE.size)
+                kind_name = [k for k, v in BLE_KINDS.items() if v == kind][0]
+                rule_name = name.rstrip(b'\0').decode()
+                print(f'        {rule_name}: {kind_name} 0x{rid:04X}'
+                      + (f' +{rel} {value[:ln].hex()}/{mask[:ln].hex()}' if ln else ''))
+        elif sec_type == SEC_RULES:
+            rulec.dump(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compile a Flock-You signature pack')
+    parser.add_argument('-s', '--source', default='signatures', help='directory with the CSV sources')
+    parser.add_argument('-o', '--output', default='signatures.fysp', help='output pack')
+    parser.add_argument('--version', type=int, default=None,
+                        help='pack content version (default: build time, so newer packs compare higher)')
+    parser.add_argument('--dump', metavar='PACK', help='print the contents of an existing pack')
+    args = parser.parse_args()
+
+    if args.dump:
+        dump(args.dump)
+        return
+
+    version = args.version if args.version is not None else int(time.time())
+    image, sections = build(args.source, version)
+    if len(image) > MAX_PACK_BYTES:
+        sys.exit(f'pack is {len(image)} bytes, firmware accepts {MAX_PACK_BYTES}')
+    with open(args.output, 'wb') as f:
+        f.write(image)
+    summary = ', '.join(f'{n} {SEC_NAMES[t]}' for t, n, _ in sections)
+    print(f'{args.output}: version {version}, {len(image)} bytes ({summary})')
+
+
+if __name__ == '__main__':
+    main()
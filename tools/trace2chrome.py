@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+Event trace to Chrome trace JSON.
+
+Reads the firmware's trace dump (serial "TRACE" command: a "trace" header,
+"trace_events" chunks and "trace_end", see src/trace_ring.h) from a capture
+of the serial output or straight from the board, and writes Chrome trace
+JSON for chrome://tracing or https://ui.perfetto.dev. Each core is a
+process and each task a thread, so the two cores read as two timelines.
+
+Begin/end pairs become complete events; an end whose begin was overwritten
+in the ring is dropped and a begin still open at the dump is closed at the
+last event. Several dumps in one capture are joined into one timeline
+(timestamps are unwrapped across the 71-minute esp_timer wrap).
+
+The longest spans are printed as a summary.
+
+Usage:
+    python3 tools/trace2chrome.py capture.log -o trace.json
+    python3 tools/trace2chrome.py --port /dev/ttyUSB0 -o trace.json
+"""
+
+import argparse
+import json
+import sys
+import time
+
+WRAP = 1 << 32
+PHASES = ('B', 'E', 'i', 'C')
+
+
+def read_dumps(lines):
+    """Yield (header, events) per complete dump found in the lines"""
+    header, events = None, []
+    for line in lines:
+        line = line.strip()
+        if not line.startswith('{"type":"trace'):
+            continue
+        try:
+            rec = json.loads(line)
+        except json.JSONDecodeError:
+            continue
+        kind = rec.get('type')
+        if kind == 'trace':
+            header, events = rec, []
+        elif kind == 'trace_events' and header is not None:
+            events.extend(rec['e'])
+        elif kind == 'trace_end' and header is not None:
+            if len(events) != rec.get('events', len(events)):
+                print(f"warning: dump at {header['now_us']} us has {len(events)} of {rec['events']} events "
+                      "(lines lost on the serial link?)", file=sys.stderr)
+            yield header, events
+            header, events = None, []
+
+
+def read_board(port, baud, timeout):
+    import serial  # pyserial
+
+    with serial.Serial(port, baud, timeout=0.5) as ser:
+        ser.reset_input_buffer()
+        ser.write(b'TRACE\n')
+        lines = []
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            line = ser.readline().decode('utf-8', errors='ignore')
+            if line:
+                lines.append(line)
+                if line.startswith('{"type":"trace_end"'):
+                    break
+        return lines
+
+
+def convert(dumps):
+    trace = []
+    spans = []          # (dur_us, name, task, start_us)
+    stats = {'events': 0, 'lost': 0, 'orphan_ends': 0, 'open_begins': 0}
+    named = set()
+    epoch = 0
+    prev_now = None
+
+    for header, events in dumps:
+        now = header['now_us']
+        if prev_now is not None and now < prev_now:
+            epoch += WRAP
+        prev_now = now
+        now_full = epoch + now
+        points = header['points']
+        tasks = header['tasks']
+        stats['events'] += len(events)
+        stats['lost'] += header.get('lost', 0)
+
+        def task_name(t):
+            return tasks[t] if t < len(tasks) else 'other'
+
+        # Absolute time: how long before the dump each event happened
+        rows = []
+        for ts, point, phase, core, task, arg in events:
+            full = now_full - ((now - ts) % WRAP)
+            rows.append((full, point, phase, core, task, arg))
+        rows.sort(key=lambda r: r[0])
+
+        for core in {r[3] for r in rows}:
+            if ('p', core) not in named:
+                named.add(('p', core))
+                trace.append({'ph': 'M', 'name': 'process_name', 'pid': core, 'tid': 0,
+                              'args': {'name': f'Core {core}'}})
+        for core, task in {(r[3], r[4]) for r in rows}:
+            if ('t', core, task) not in named:
+                named.add(('t', core, task))
+                trace.append({'ph': 'M', 'name': 'thread_name', 'pid': core, 'tid': task,
+                              'args': {'name': task_name(task)}})
+
+        open_spans = {}  # task -> stack of (point, start, core, arg)
+        last_ts = rows[-1][0] if rows else now_full
+        for full, point, phase, core, task, arg in rows:
+            name = points[point] if point < len(points) else f'point{point}'
+            ph = PHASES[phase]
+            if ph == 'B':
+                open_spans.setdefault(task, []).append((point, full, core, arg))
+            elif ph == 'E':
+                stack = open_spans.get(task, [])
+                for i in range(len(stack) - 1, -1, -1):
+                    if stack[i][0] == point:
+                        _, start, bcore, barg = stack.pop(i)
+                        args = {}
+                        if barg:
+                            args['arg'] = barg
+                        if arg:
+                            args['end_arg'] = arg
+                        trace.append({'ph': 'X', 'name': name, 'pid': bcore, 'tid': task,
+                                      'ts': start, 'dur': full - start, 'args': args})
+                        spans.append((full - start, name, task_name(task), start))
+                        break
+                else:
+                    stats['orphan_ends'] += 1
+            elif ph == 'i':
+                trace.append({'ph': 'i', 's': 't', 'name': name, 'pid': core, 'tid': task,
+                              'ts': full, 'args': {'arg': arg}})
+            else:
+                trace.append({'ph': 'C', 'name': name, 'pid': core, 'tid': task,
+                              'ts': full, 'args': {name: arg}})
+        for task, stack in open_spans.items():
+            for point, start, core, arg in stack:
+                stats['open_begins'] += 1
+                name = points[point] if point < len(points) else f'point{point}'
+                trace.append({'ph': 'X', 'name': name, 'pid': core, 'tid': task, 'ts': start,
+                              'dur': last_ts - start, 'args': {'arg': arg, 'open_at_dump': True}})
+
+    # Start the timeline at 0
+    stamped = [e for e in trace if 'ts' in e]
+    if stamped:
+        t0 = min(e['ts'] for e in stamped)
+        for e in stamped:
+            e['ts'] -= t0
+        spans = [(d, n, t, s - t0) for d, n, t, s in spans]
+    return trace, spans, stats
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Convert a firmware trace dump to Chrome trace JSON')
+    ap.add_argument('capture', nargs='?', help='serial capture containing one or more TRACE dumps')
+    ap.add_argument('--port', help='request a dump from the board on this serial port instead')
+    ap.add_argument('--baud', type=int, default=115200)
+    ap.add_argument('--timeout', type=float, default=15.0, help='seconds to wait for the dump')
+    ap.add_argument('-o', '--output', default='trace.json')
+    ap.add_argument('--top', type=int, default=10, help='longest spans to list')
+    args = ap.parse_args()
+
+    if args.port:
+        lines = read_board(args.port, args.baud, args.timeout)
+    elif args.capture:
+        with open(args.capture, encoding='utf-8', errors='ignore') as f:
+            lines = f.readlines()
+    else:
+        ap.error('give a capture file or --port')
+
+    dumps = list(read_dumps(lines))
+    if not dumps:
+        sys.exit('No complete trace dump found (send "TRACE" on the serial port)')
+    trace, spans, stats = convert(dumps)
+
+    with open(args.output, 'w') as f:
+        json.dump({'traceEvents': trace, 'displayTimeUnit': 'ms'}, f)
+    span_ns = dumps[-1][0].get('span_ns')
+    print(f"{args.output}: {len(dumps)} dump(s), {stats['events']} events, {stats['lost']} overwritten, "
+          f"{stats['orphan_ends']} ends without a begin, {stats['open_begins']} spans open at the dump"
+          + (f"; a span costs {span_ns} ns on the board" if span_ns else ''))
+    if spans and args.top:
+        print("Longest spans:")
+        for dur, name, task, start in sorted(spans, reverse=True)[:args.top]:
+            print(f"  {dur / 1000:9.2f} ms  {name:<18} {task:<16} at {start / 1e6:.3f} s")
+
+
+if __name__ == '__main__':
+    main()
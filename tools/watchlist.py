@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Full-MAC watchlist builder.
+
+Extracts device MACs from wigle-format CSV exports (the `netid` column, as in
+datasets/) and writes them as a signature source (mac,label) for
+tools/sigpack.py, which embeds them as a cuckoo filter plus the sorted exact
+table. Also reports filter memory and measured false-positive rate.
+
+The cuckoo filter here is the reference for src/mac_watchlist.cpp; the hash,
+fingerprint and alternate-bucket rules must stay identical:
+
+    z   = splitmix64(mac48 ^ (seed * 0x9E3779B97F4A7C15))
+    i1  = (z >> 32) % buckets
+    fp  = z & 0xFFFF                (0 -> 1, 0 marks an empty slot)
+    alt = ((fp * 0x5BD1E995 mod 2^32) % buckets + buckets - i) % buckets
+
+alt(alt(i)) == i for any bucket count, so the table can be sized to the
+data instead of the next power of two.
+
+Usage:
+    python3 tools/watchlist.py datasets/Penguin-*.csv -o signatures/macs.csv --label Penguin
+    python3 tools/watchlist.py datasets/*.csv --type BLE --report
+"""
+
+import argparse
+import csv
+import random
+import re
+import struct
+import sys
+
+BUCKET_SIZE = 4
+FP_BITS = 16
+MAX_KICKS = 500
+DEFAULT_LOAD = 0.95
+MASK64 = (1 << 64) - 1
+
+FILTER_HEADER = struct.Struct('<IIBBH')  # buckets, seed, bucket size, fingerprint bits, reserved
+
+
+def splitmix64(x):
+    z = (x + 0x9E3779B97F4A7C15) & MASK64
+    z = ((z ^ (z >> 30)) * 0xBF58476D1CE4E5B9) & MASK64
+    z = ((z ^ (z >> 27)) * 0x94D049BB133111EB) & MASK64
+    return z ^ (z >> 31)
+
+
+def mac_hash(mac, seed, buckets):
+    z = splitmix64(int.from_bytes(mac, 'big') ^ ((seed * 0x9E3779B97F4A7C15) & MASK64))
+    fp = z & 0xFFFF or 1
+    return (z >> 32) % buckets, fp
+
+
+def alt_bucket(i, fp, buckets):
+    return (((fp * 0x5BD1E995) & 0xFFFFFFFF) % buckets + buckets - i) % buckets
+
+
+class CuckooFilter:
+    def __init__(self, buckets, seed):
+        self.buckets = buckets
+        self.seed = seed
+        self.table = [[0] * BUCKET_SIZE for _ in range(buckets)]
+        self.rng = random.Random(seed)
+
+    def _place(self, i, fp):
+        bucket = self.table[i]
+        for s in range(BUCKET_SIZE):
+            if bucket[s] == 0:
+                bucket[s] = fp
+                return True
+        return False
+
+    def insert(self, mac):
+        i1, fp = mac_hash(mac, self.seed, self.buckets)
+        i2 = alt_bucket(i1, fp, self.buckets)
+        if self._place(i1, fp) or self._place(i2, fp):
+            return True
+        i = self.rng.choice((i1, i2))
+        for _ in range(MAX_KICKS):
+            s = self.rng.randrange(BUCKET_SIZE)
+            fp, self.table[i][s] = self.table[i][s], fp
+            i = alt_bucket(i, fp, self.buckets)
+            if self._place(i, fp):
+                return True
+        return False
+
+    def contains(self, mac):
+        i1, fp = mac_hash(mac, self.seed, self.buckets)
+        return fp in self.table[i1] or fp in self.table[alt_bucket(i1, fp, self.buckets)]
+
+    def pack(self):
+        body = b''.join(struct.pack('<4H', *bucket) for bucket in self.table)
+        return FILTER_HEADER.pack(self.buckets, self.seed, BUCKET_SIZE, FP_BITS, 0) + body
+
+    def size_bytes(self):
+        return FILTER_HEADER.size + self.buckets * BUCKET_SIZE * FP_BITS // 8
+
+
+def build_filter(macs, seed=1, load=DEFAULT_LOAD):
+    """Smallest filter (growing 5% per failed attempt) holding every MAC."""
+    buckets = max(1, int(len(macs) / (BUCKET_SIZE * load)) + 1)
+    while True:
+        f = CuckooFilter(buckets, seed)
+        if all(f.insert(mac) for mac in macs):
+            return f
+        buckets = int(buckets * 1.05) + 1
+
+
+def parse_mac(text):
+    parts = text.strip().replace('-', ':').split(':')
+    if len(parts) != 6:
+        return None
+    try:
+        return bytes(int(p, 16) for p in parts)
+    except ValueError:
+        return None
+
+
+def read_wigle(paths, dev_type, pattern):
+    """Unique MACs from wigle CSVs, filtered by type and ssid/name regex."""
+    regex = re.compile(pattern, re.IGNORECASE) if pattern else None
+    macs = set()
+    for path in paths:
+        with open(path, newline='', encoding='utf-8', errors='replace') as f:
+            for row in csv.DictReader(f):
+                if dev_type != 'any':
+                    t = (row.get('type') or '').upper()
+                    is_ble = t in ('BLE', 'BT')
+                    if (dev_type == 'BLE') != is_ble:
+                        continue
+                if regex and not (regex.search(row.get('ssid') or '') or regex.search(row.get('name') or '')):
+                    continue
+                mac = parse_mac(row.get('netid') or '')
+                if mac:
+                    macs.add(mac)
+    return sorted(macs)
+
+
+def report(macs, seed, load, queries):
+    f = build_filter(macs, seed, load)
+    rng = random.Random(seed ^ 0x5EED)
+    members = set(macs)
+    fps = tested = 0
+    while tested < queries:
+        mac = rng.getrandbits(48).to_bytes(6, 'big')
+        if mac in members:
+            continue
+        tested += 1
+        fps += f.contains(mac)
+    missing = sum(not f.contains(mac) for mac in macs)
+
+    n = len(macs)
+    filter_bytes = f.size_bytes()
+    exact_bytes = n * 6
+    print(f'MACs: {n}')
+    print(f'Filter: {f.buckets} buckets x {BUCKET_SIZE} x {FP_BITS} bit = {filter_bytes} bytes '
+          f'(load {n / (f.buckets * BUCKET_SIZE):.1%}, {filter_bytes * 8 / n:.1f} bits/MAC)')
+    print(f'Exact table: {exact_bytes} bytes')
+    print(f'Per 10k MACs: filter {filter_bytes * 10000 / n / 1024:.1f} KB, '
+          f'exact {exact_bytes * 10000 / n / 1024:.1f} KB')
+    print(f'False positives: {fps}/{queries} = {fps / queries:.4%} '
+          f'(theory ~{2 * BUCKET_SIZE / 2 ** FP_BITS:.4%}), each costs one exact-table search')
+    print(f'False negatives: {missing}')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build a full-MAC watchlist from wigle CSV exports')
+    parser.add_argument('csv', nargs='+', help='wigle-format CSV files')
+    parser.add_argument('--type', choices=('BLE', 'WIFI', 'any'), default='any', help='device type filter')
+    parser.add_argument('--match', help='regex on ssid/name columns (case-insensitive)')
+    parser.add_argument('-o', '--output', help='write mac,label CSV (signature source for sigpack.py)')
+    parser.add_argument('--label', default='watchlist', help='label column value')
+    parser.add_argument('--report', action='store_true', help='print filter memory and false-positive rate')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--load', type=float, default=DEFAULT_LOAD, help='target filter load factor')
+    parser.add_argument('--queries', type=int, default=200000, help='random lookups for the FPR estimate')
+    args = parser.parse_args()
+
+    macs = read_wigle(args.csv, args.type, args.match)
+    if not macs:
+        sys.exit('no MACs found')
+
+    if args.output:
+        with open(args.output, 'w', newline='') as f:
+            w = csv.writer(f)
+            w.writerow(['mac', 'label'])
+            for mac in macs:
+                w.writerow([':'.join(f'{b:02x}' for b in mac), args.label])
+        print(f'{args.output}: {len(macs)} MACs')
+
+    if args.report or not args.output:
+        report(macs, args.seed, args.load, args.queries)
+
+
+if __name__ == '__main__':
+    main()